@@ -0,0 +1,24 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dpi_array.h"
+
+size_t dpi_array_byte_stride(const svOpenArrayHandle arr, uint64_t len) {
+  if (len < 2 || !svGetArrayPtr(arr)) {
+    return 0;
+  }
+  int low = svLow(arr, 1);
+  const uint8_t *elem0 = (const uint8_t *)svGetArrElemPtr1(arr, low);
+  const uint8_t *elem1 = (const uint8_t *)svGetArrElemPtr1(arr, low + 1);
+  // The low element must be at the start of the storage, or the array base
+  // can't be used as the start of the message.
+  if (!elem0 || !elem1 || elem0 != (const uint8_t *)svGetArrayPtr(arr)) {
+    return 0;
+  }
+  ptrdiff_t stride = elem1 - elem0;
+  if (stride != 1 && stride != (ptrdiff_t)sizeof(svBitVecVal)) {
+    return 0;
+  }
+  return (size_t)stride;
+}
@@ -0,0 +1,46 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_DV_DPI_COMMON_DPI_ARRAY_DPI_ARRAY_H_
+#define OPENTITAN_HW_DV_DPI_COMMON_DPI_ARRAY_DPI_ARRAY_H_
+
+/**
+ * Helpers for accessing `bit [7:0]` open arrays passed through DPI.
+ *
+ * The implementation-independent way to access an open array is one element
+ * at a time, through svGetArrElemPtr1() or svGetBitArrElem1VecVal(). For long
+ * messages that is slow, so models that marshal whole messages first check
+ * whether the simulator exposes the array's storage in a layout they know.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "svdpi.h"
+
+/**
+ * Get the distance in bytes between the elements of a `bit [7:0]` open array,
+ * if the simulator gives direct access to its storage.
+ *
+ * Simulators store each element either as a byte or as an svBitVecVal. If the
+ * result is non-zero, element `i` (counting from the low index) is at
+ * `svGetArrayPtr(arr) + i * stride`. Returns 0 if the layout is not one of
+ * these, or can't be told from an array of this length, in which case the
+ * elements must be accessed one by one.
+ *
+ * @param arr The open array
+ * @param len Number of elements that will be accessed
+ * @return 1, sizeof(svBitVecVal) or 0
+ */
+size_t dpi_array_byte_stride(const svOpenArrayHandle arr, uint64_t len);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // OPENTITAN_HW_DV_DPI_COMMON_DPI_ARRAY_DPI_ARRAY_H_
@@ -0,0 +1,169 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dpi_checkpoint.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <svdpi.h>
+
+struct dpi_checkpoint_entry {
+  char *name;
+  void *ctx;
+  const struct dpi_checkpoint_ops *ops;
+  svScope scope;
+};
+
+// Registered contexts, in registration order
+static struct dpi_checkpoint_entry *entries;
+static size_t num_entries;
+static size_t cap_entries;
+
+void dpi_checkpoint_register(const char *name, void *ctx,
+                             const struct dpi_checkpoint_ops *ops) {
+  assert(name && ctx && ops);
+
+  if (num_entries == cap_entries) {
+    cap_entries = cap_entries ? 2 * cap_entries : 8;
+    entries = (struct dpi_checkpoint_entry *)realloc(
+        entries, cap_entries * sizeof(struct dpi_checkpoint_entry));
+    assert(entries);
+  }
+
+  struct dpi_checkpoint_entry *entry = &entries[num_entries++];
+  entry->name = strdup(name);
+  assert(entry->name);
+  entry->ctx = ctx;
+  entry->ops = ops;
+  entry->scope = svGetScope();
+}
+
+void dpi_checkpoint_unregister(void *ctx) {
+  for (size_t i = 0; i < num_entries; ++i) {
+    if (entries[i].ctx == ctx) {
+      free(entries[i].name);
+      memmove(&entries[i], &entries[i + 1],
+              (num_entries - i - 1) * sizeof(struct dpi_checkpoint_entry));
+      --num_entries;
+      return;
+    }
+  }
+}
+
+// Append len bytes from src at *pos in buf (if they fit), advancing *pos
+static void put_bytes(void *buf, size_t buf_len, size_t *pos, const void *src,
+                      size_t len) {
+  if (*pos + len <= buf_len) {
+    memcpy((uint8_t *)buf + *pos, src, len);
+  }
+  *pos += len;
+}
+
+static void put_u32(void *buf, size_t buf_len, size_t *pos, uint32_t val) {
+  put_bytes(buf, buf_len, pos, &val, sizeof(val));
+}
+
+static bool get_u32(const void *buf, size_t len, size_t *pos, uint32_t *val) {
+  if (len - *pos < sizeof(*val)) {
+    return false;
+  }
+  memcpy(val, (const uint8_t *)buf + *pos, sizeof(*val));
+  *pos += sizeof(*val);
+  return true;
+}
+
+// The layout is a count of entries, followed by each entry as a
+// length-prefixed name and a length-prefixed blob of model state.
+size_t dpi_checkpoint_save(void *buf, size_t buf_len) {
+  size_t pos = 0;
+  put_u32(buf, buf_len, &pos, num_entries);
+
+  for (size_t i = 0; i < num_entries; ++i) {
+    const struct dpi_checkpoint_entry *entry = &entries[i];
+    uint32_t name_len = strlen(entry->name);
+    put_u32(buf, buf_len, &pos, name_len);
+    put_bytes(buf, buf_len, &pos, entry->name, name_len);
+
+    // Reserve space for the state length, then ask the model to write its
+    // state after it.
+    size_t len_pos = pos;
+    pos += sizeof(uint32_t);
+    size_t avail = pos < buf_len ? buf_len - pos : 0;
+    size_t state_len = entry->ops->save(
+        entry->ctx, avail ? (uint8_t *)buf + pos : NULL, avail);
+    if (state_len == (size_t)-1) {
+      fprintf(stderr,
+              "DPI checkpoint: %s can't be saved in its current state.\n",
+              entry->name);
+      return (size_t)-1;
+    }
+    put_u32(buf, buf_len, &len_pos, state_len);
+    pos += state_len;
+  }
+
+  return pos;
+}
+
+bool dpi_checkpoint_restore(const void *buf, size_t len) {
+  size_t pos = 0;
+  uint32_t count;
+  if (!get_u32(buf, len, &pos, &count)) {
+    fprintf(stderr, "DPI checkpoint: Truncated checkpoint data.\n");
+    return false;
+  }
+  if (count != num_entries) {
+    fprintf(stderr,
+            "DPI checkpoint: Checkpoint has %u DPI models, but the simulation "
+            "has %zu.\n",
+            count, num_entries);
+    return false;
+  }
+
+  for (size_t i = 0; i < num_entries; ++i) {
+    const struct dpi_checkpoint_entry *entry = &entries[i];
+
+    uint32_t name_len, state_len;
+    if (!get_u32(buf, len, &pos, &name_len) || len - pos < name_len) {
+      fprintf(stderr, "DPI checkpoint: Truncated checkpoint data.\n");
+      return false;
+    }
+    const char *name = (const char *)buf + pos;
+    pos += name_len;
+    if (name_len != strlen(entry->name) ||
+        memcmp(name, entry->name, name_len) != 0) {
+      fprintf(stderr,
+              "DPI checkpoint: Checkpoint has DPI model `%.*s' where the "
+              "simulation has `%s'.\n",
+              (int)name_len, name, entry->name);
+      return false;
+    }
+
+    if (!get_u32(buf, len, &pos, &state_len) || len - pos < state_len) {
+      fprintf(stderr, "DPI checkpoint: Truncated checkpoint data.\n");
+      return false;
+    }
+    if (!entry->ops->restore(entry->ctx, (const uint8_t *)buf + pos,
+                             state_len)) {
+      fprintf(stderr, "DPI checkpoint: Failed to restore state for %s.\n",
+              entry->name);
+      return false;
+    }
+    pos += state_len;
+
+    // The restored chandle in the SystemVerilog model points at a context
+    // from the process that saved the checkpoint. Point it at ours instead.
+    svScope prev_scope = svSetScope(entry->scope);
+    entry->ops->rebind(entry->ctx);
+    svSetScope(prev_scope);
+  }
+
+  if (pos != len) {
+    fprintf(stderr, "DPI checkpoint: Unexpected trailing checkpoint data.\n");
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,97 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_DV_DPI_COMMON_DPI_CHECKPOINT_DPI_CHECKPOINT_H_
+#define OPENTITAN_HW_DV_DPI_COMMON_DPI_CHECKPOINT_DPI_CHECKPOINT_H_
+
+/**
+ * A registry of live DPI model contexts, used to save and restore their state
+ * as part of a simulation checkpoint.
+ *
+ * The simulator saves and restores the SystemVerilog side of each DPI model
+ * (including the chandle that points at its C context), but knows nothing
+ * about the C context itself. Host resources such as ptys, FIFOs and sockets
+ * can't be carried across processes anyway, so a restored simulation runs the
+ * initial blocks as usual to create fresh contexts and then:
+ *
+ *  1. restores each context's protocol state from the checkpoint, and
+ *  2. calls back into the SystemVerilog module to replace the stale chandle
+ *     with the new context.
+ *
+ * Contexts are matched up by registration order and name, which is stable as
+ * long as the checkpoint is restored into the same simulation binary.
+ *
+ * Models must register from a function that was imported with the "context"
+ * property, so that the registry can remember the calling scope.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Callbacks that a DPI model provides for its contexts
+ */
+struct dpi_checkpoint_ops {
+  /**
+   * Serialize the state of ctx into buf, which has space for buf_len bytes.
+   *
+   * @return the number of bytes needed (which may be more than buf_len, in
+   *         which case nothing useful was written), or (size_t)-1 if the
+   *         model can't be saved in its current state.
+   */
+  size_t (*save)(void *ctx, void *buf, size_t buf_len);
+
+  /**
+   * Restore the state of ctx from len bytes at buf, as written by save().
+   *
+   * @return true on success
+   */
+  bool (*restore)(void *ctx, const void *buf, size_t len);
+
+  /**
+   * Point the SystemVerilog side of the model at ctx. This is called with
+   * the scope that was active when the context was registered.
+   */
+  void (*rebind)(void *ctx);
+};
+
+/**
+ * Register a DPI model context
+ *
+ * @param name Name of the model instance, used to check checkpoints match
+ * @param ctx The context (as returned to SystemVerilog as a chandle)
+ * @param ops Callbacks for the context. Must outlive the registration.
+ */
+void dpi_checkpoint_register(const char *name, void *ctx,
+                             const struct dpi_checkpoint_ops *ops);
+
+/**
+ * Remove a context from the registry (e.g. when it is closed)
+ */
+void dpi_checkpoint_unregister(void *ctx);
+
+/**
+ * Save the state of all registered contexts to buf
+ *
+ * @return the number of bytes needed (which may be more than buf_len), or
+ *         (size_t)-1 if some model can't be saved.
+ */
+size_t dpi_checkpoint_save(void *buf, size_t buf_len);
+
+/**
+ * Restore the state of all registered contexts from len bytes at buf, as
+ * written by dpi_checkpoint_save(), and rebind them to SystemVerilog.
+ *
+ * @return true on success. On failure, an error has been printed to stderr.
+ */
+bool dpi_checkpoint_restore(const void *buf, size_t len);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+#endif  // OPENTITAN_HW_DV_DPI_COMMON_DPI_CHECKPOINT_DPI_CHECKPOINT_H_
@@ -0,0 +1,534 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dpi_io.h"
+
+// Strictly speaking, versions of C older than C23 might not declare
+// strdup in string.h. With e.g. glibc, this macro tells it to declare
+// what we need.
+#define __STDC_WANT_LIB_EXT2__ 1
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+/**
+ * Single-producer, single-consumer ring buffer
+ *
+ * head and tail count bytes written and read since the ring was created, so
+ * the ring holds head - tail bytes. Each is only written by one side.
+ */
+#define RING_SIZE 4096
+
+struct dpi_io_ring {
+  size_t head;
+  size_t tail;
+  char buf[RING_SIZE];
+};
+
+struct dpi_io_chan {
+  int fd;
+  int flags;
+  char *display_name;
+  // Simulation side to I/O thread
+  struct dpi_io_ring tx;
+  // I/O thread to simulation side
+  struct dpi_io_ring rx;
+
+  // Set by the simulation side to ask the I/O thread to look at the channel
+  int kick;
+  // Set by the I/O thread when it stops reading because rx is full
+  int rx_paused;
+
+  // Only used by the I/O thread
+  unsigned int events;
+  bool watched;
+  bool dead;
+  // Only used by the simulation side
+  bool warned_drop;
+
+  // Protected by io_lock
+  bool closing;
+  bool closed;
+  struct dpi_io_chan *next;
+};
+
+// State of the I/O thread, protected by io_lock
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_cond = PTHREAD_COND_INITIALIZER;
+static struct dpi_io_chan *io_chans;
+static bool io_running;
+static pthread_t io_thread;
+static int io_wake_fds[2] = {-1, -1};
+static int io_wake_pending;
+#ifdef __linux__
+static int io_epfd = -1;
+#endif
+
+static size_t ring_used(const struct dpi_io_ring *ring) {
+  return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) -
+         __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Wake the I/O thread, unless it has already been woken and hasn't run yet
+ */
+static void io_wake(void) {
+  if (__atomic_exchange_n(&io_wake_pending, 1, __ATOMIC_SEQ_CST)) {
+    return;
+  }
+  char dummy = 0;
+  ssize_t rv;
+  do {
+    rv = write(io_wake_fds[1], &dummy, 1);
+  } while (rv == -1 && errno == EINTR);
+}
+
+static void chan_kick(struct dpi_io_chan *chan) {
+  __atomic_store_n(&chan->kick, 1, __ATOMIC_SEQ_CST);
+  io_wake();
+}
+
+static bool set_nonblocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+/**
+ * Tell the OS which events we want for chan (I/O thread only)
+ */
+static void chan_set_events(struct dpi_io_chan *chan, unsigned int events) {
+  if (chan->events == events) {
+    return;
+  }
+  chan->events = events;
+#ifdef __linux__
+  if (!chan->watched) {
+    return;
+  }
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.ptr = chan;
+  int rv = epoll_ctl(io_epfd, EPOLL_CTL_MOD, chan->fd, &ev);
+  assert(rv == 0 && "epoll_ctl failed");
+#endif
+}
+
+/**
+ * Stop all I/O on a channel whose file descriptor has failed
+ */
+static void chan_kill(struct dpi_io_chan *chan, const char *what, int err) {
+  if (err) {
+    fprintf(stderr, "%s: %s failed: %s\n", chan->display_name, what,
+            strerror(err));
+  }
+  chan->dead = true;
+#ifdef __linux__
+  if (chan->watched) {
+    epoll_ctl(io_epfd, EPOLL_CTL_DEL, chan->fd, NULL);
+    chan->watched = false;
+  }
+#endif
+  chan->events = 0;
+}
+
+/**
+ * Fill the rx ring from the file descriptor (I/O thread only)
+ *
+ * @return true if the ring is full
+ */
+static bool chan_fill_rx(struct dpi_io_chan *chan) {
+  struct dpi_io_ring *ring = &chan->rx;
+  while (!chan->dead) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t space = RING_SIZE - ring_used(ring);
+    if (space == 0) {
+      return true;
+    }
+    size_t idx = head % RING_SIZE;
+    size_t chunk = RING_SIZE - idx < space ? RING_SIZE - idx : space;
+
+    ssize_t n = read(chan->fd, &ring->buf[idx], chunk);
+    if (n > 0) {
+      __atomic_store_n(&ring->head, head + n, __ATOMIC_SEQ_CST);
+    } else if (n == 0) {
+      chan_kill(chan, "read", 0);
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    } else if (errno != EINTR) {
+      chan_kill(chan, "read", errno);
+    }
+  }
+  return false;
+}
+
+/**
+ * Write out the tx ring (I/O thread only)
+ *
+ * @return true if the file descriptor can't take any more for now
+ */
+static bool chan_drain_tx(struct dpi_io_chan *chan) {
+  struct dpi_io_ring *ring = &chan->tx;
+  while (!chan->dead) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t used = ring_used(ring);
+    if (used == 0) {
+      return false;
+    }
+    size_t idx = tail % RING_SIZE;
+    size_t chunk = RING_SIZE - idx < used ? RING_SIZE - idx : used;
+
+    ssize_t n = write(chan->fd, &ring->buf[idx], chunk);
+    if (n > 0) {
+      __atomic_store_n(&ring->tail, tail + n, __ATOMIC_SEQ_CST);
+    } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    } else if (n == -1 && errno != EINTR) {
+      chan_kill(chan, "write", errno);
+    }
+  }
+  // Nothing will ever read what's left, so throw it away.
+  __atomic_store_n(&ring->tail, __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST),
+                   __ATOMIC_SEQ_CST);
+  return false;
+}
+
+/**
+ * Move data for one channel and decide what to wait for (I/O thread only)
+ */
+static void chan_service(struct dpi_io_chan *chan) {
+  __atomic_store_n(&chan->kick, 0, __ATOMIC_SEQ_CST);
+
+  unsigned int events = 0;
+  if ((chan->flags & DPI_IO_READ) && !chan->closing) {
+    bool full = chan_fill_rx(chan);
+    if (full) {
+      // Stop reading until the simulation side makes space. It kicks us
+      // when it sees rx_paused, so check again afterwards in case it made
+      // space before seeing the flag.
+      __atomic_store_n(&chan->rx_paused, 1, __ATOMIC_SEQ_CST);
+      if (ring_used(&chan->rx) < RING_SIZE) {
+        __atomic_store_n(&chan->rx_paused, 0, __ATOMIC_SEQ_CST);
+        full = chan_fill_rx(chan);
+      }
+    }
+    if (!full) {
+#ifdef __linux__
+      events |= EPOLLIN;
+#else
+      events |= POLLIN;
+#endif
+    }
+  }
+  if (chan->flags & DPI_IO_WRITE) {
+    if (chan_drain_tx(chan)) {
+#ifdef __linux__
+      events |= EPOLLOUT;
+#else
+      events |= POLLOUT;
+#endif
+    }
+  }
+
+  if (!chan->dead) {
+    chan_set_events(chan, events);
+  }
+}
+
+static void *io_thread_main(void *unused) {
+  (void)unused;
+  pthread_mutex_lock(&io_lock);
+  while (io_running) {
+    pthread_mutex_unlock(&io_lock);
+
+    // Wait for something to do. This is the only place that blocks.
+#ifdef __linux__
+    struct epoll_event evs[16];
+    int num_evs = epoll_wait(io_epfd, evs, 16, -1);
+#else
+    struct pollfd pfds[64];
+    struct dpi_io_chan *pchans[64];
+    int num_pfds = 0;
+    pfds[num_pfds].fd = io_wake_fds[0];
+    pfds[num_pfds].events = POLLIN;
+    pchans[num_pfds++] = NULL;
+    pthread_mutex_lock(&io_lock);
+    for (struct dpi_io_chan *chan = io_chans; chan && num_pfds < 64;
+         chan = chan->next) {
+      if (chan->events) {
+        pfds[num_pfds].fd = chan->fd;
+        pfds[num_pfds].events = chan->events;
+        pchans[num_pfds++] = chan;
+      }
+    }
+    pthread_mutex_unlock(&io_lock);
+    poll(pfds, num_pfds, -1);
+#endif
+
+    pthread_mutex_lock(&io_lock);
+
+    // Serve the descriptors that are ready...
+#ifdef __linux__
+    for (int i = 0; i < num_evs; ++i) {
+      struct dpi_io_chan *chan = (struct dpi_io_chan *)evs[i].data.ptr;
+      if (chan) {
+        chan_service(chan);
+      }
+    }
+#else
+    for (int i = 1; i < num_pfds; ++i) {
+      if (pfds[i].revents) {
+        chan_service(pchans[i]);
+      }
+    }
+#endif
+
+    // ...and any channels that the simulation side has kicked.
+    char drain[64];
+    while (read(io_wake_fds[0], drain, sizeof(drain)) > 0) {
+    }
+    __atomic_store_n(&io_wake_pending, 0, __ATOMIC_SEQ_CST);
+    for (struct dpi_io_chan *chan = io_chans; chan; chan = chan->next) {
+      if (__atomic_load_n(&chan->kick, __ATOMIC_SEQ_CST)) {
+        chan_service(chan);
+      }
+      if (chan->closing && !chan->closed) {
+        if (!chan->dead) {
+          chan_kill(chan, NULL, 0);
+        }
+        chan->closed = true;
+        pthread_cond_broadcast(&io_cond);
+      }
+    }
+  }
+  pthread_mutex_unlock(&io_lock);
+  return NULL;
+}
+
+/**
+ * Start the I/O thread (with io_lock held)
+ */
+static bool io_start(void) {
+  if (pipe(io_wake_fds) != 0) {
+    fprintf(stderr, "DPI I/O: Unable to create pipe: %s\n", strerror(errno));
+    return false;
+  }
+  set_nonblocking(io_wake_fds[0]);
+  set_nonblocking(io_wake_fds[1]);
+
+#ifdef __linux__
+  io_epfd = epoll_create1(EPOLL_CLOEXEC);
+  assert(io_epfd >= 0 && "epoll_create1 failed");
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  int rv = epoll_ctl(io_epfd, EPOLL_CTL_ADD, io_wake_fds[0], &ev);
+  assert(rv == 0 && "epoll_ctl failed");
+#endif
+
+  io_running = true;
+  if (pthread_create(&io_thread, NULL, io_thread_main, NULL) != 0) {
+    fprintf(stderr, "DPI I/O: Unable to create thread\n");
+    io_running = false;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Stop the I/O thread (with io_lock held, which is released)
+ */
+static void io_stop(void) {
+  io_running = false;
+  pthread_mutex_unlock(&io_lock);
+  __atomic_store_n(&io_wake_pending, 0, __ATOMIC_SEQ_CST);
+  io_wake();
+  pthread_join(io_thread, NULL);
+
+#ifdef __linux__
+  close(io_epfd);
+  io_epfd = -1;
+#endif
+  close(io_wake_fds[0]);
+  close(io_wake_fds[1]);
+  io_wake_fds[0] = io_wake_fds[1] = -1;
+  __atomic_store_n(&io_wake_pending, 0, __ATOMIC_SEQ_CST);
+}
+
+struct dpi_io_chan *dpi_io_chan_open(int fd, int flags,
+                                     const char *display_name) {
+  assert(flags & (DPI_IO_READ | DPI_IO_WRITE));
+
+  if (!set_nonblocking(fd)) {
+    fprintf(stderr, "%s: Unable to make fd non-blocking: %s\n", display_name,
+            strerror(errno));
+    return NULL;
+  }
+
+  struct dpi_io_chan *chan =
+      (struct dpi_io_chan *)calloc(1, sizeof(struct dpi_io_chan));
+  assert(chan);
+  chan->fd = fd;
+  chan->flags = flags;
+  chan->display_name = strdup(display_name);
+
+  pthread_mutex_lock(&io_lock);
+  if (!io_running && !io_start()) {
+    pthread_mutex_unlock(&io_lock);
+    free(chan->display_name);
+    free(chan);
+    return NULL;
+  }
+
+#ifdef __linux__
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.data.ptr = chan;
+  chan->watched = epoll_ctl(io_epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+  if (!chan->watched) {
+    // Regular files can't be used with epoll, but are always ready, so
+    // just write them from the I/O thread whenever we're kicked.
+    chan->dead = errno != EPERM;
+    if (chan->dead) {
+      fprintf(stderr, "%s: Unable to watch fd: %s\n", display_name,
+              strerror(errno));
+    } else {
+      chan->flags &= ~DPI_IO_READ;
+    }
+  }
+#endif
+
+  chan->next = io_chans;
+  io_chans = chan;
+  pthread_mutex_unlock(&io_lock);
+
+  // Start reading
+  chan_kick(chan);
+  return chan;
+}
+
+void dpi_io_chan_close(struct dpi_io_chan *chan) {
+  if (!chan) {
+    return;
+  }
+
+  pthread_mutex_lock(&io_lock);
+  chan->closing = true;
+  chan_kick(chan);
+  while (!chan->closed) {
+    pthread_cond_wait(&io_cond, &io_lock);
+  }
+
+  struct dpi_io_chan **link = &io_chans;
+  while (*link != chan) {
+    link = &(*link)->next;
+  }
+  *link = chan->next;
+
+  if (io_chans) {
+    pthread_mutex_unlock(&io_lock);
+  } else {
+    io_stop();
+  }
+
+  free(chan->display_name);
+  free(chan);
+}
+
+size_t dpi_io_chan_readable(const struct dpi_io_chan *chan) {
+  return ring_used(&chan->rx);
+}
+
+size_t dpi_io_chan_read(struct dpi_io_chan *chan, void *buf, size_t len) {
+  struct dpi_io_ring *ring = &chan->rx;
+  size_t used = ring_used(ring);
+  if (used == 0) {
+    return 0;
+  }
+
+  size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  size_t n = len < used ? len : used;
+  for (size_t i = 0; i < n; ++i) {
+    ((char *)buf)[i] = ring->buf[(tail + i) % RING_SIZE];
+  }
+  __atomic_store_n(&ring->tail, tail + n, __ATOMIC_SEQ_CST);
+
+  // If the I/O thread stopped reading because we were full, restart it.
+  if (__atomic_load_n(&chan->rx_paused, __ATOMIC_SEQ_CST)) {
+    __atomic_store_n(&chan->rx_paused, 0, __ATOMIC_SEQ_CST);
+    chan_kick(chan);
+  }
+  return n;
+}
+
+bool dpi_io_chan_read_byte(struct dpi_io_chan *chan, char *dat) {
+  return dpi_io_chan_read(chan, dat, 1) == 1;
+}
+
+/**
+ * Queue bytes in the transmit ring of a channel
+ *
+ * @param chan channel to write to
+ * @param buf bytes to write
+ * @param len number of bytes to write
+ * @param all if true, queue nothing unless all of the bytes fit
+ * @return number of bytes queued
+ */
+static size_t chan_write(struct dpi_io_chan *chan, const void *buf, size_t len,
+                         bool all) {
+  struct dpi_io_ring *ring = &chan->tx;
+  size_t used = ring_used(ring);
+  size_t n = len < RING_SIZE - used ? len : RING_SIZE - used;
+  if (all && n < len) {
+    n = 0;
+  }
+
+  if (n < len && !chan->warned_drop) {
+    fprintf(stderr,
+            "%s: Output buffer full (is anything reading?). Dropping "
+            "output.\n",
+            chan->display_name);
+    chan->warned_drop = true;
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  for (size_t i = 0; i < n; ++i) {
+    ring->buf[(head + i) % RING_SIZE] = ((const char *)buf)[i];
+  }
+  __atomic_store_n(&ring->head, head + n, __ATOMIC_SEQ_CST);
+
+  // If the I/O thread had emptied the ring before it could see our bytes, it
+  // has stopped writing, so tell it to start again. Otherwise it either
+  // will see them or is waiting for the fd to be writable.
+  if (__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head) {
+    chan_kick(chan);
+  }
+  return n;
+}
+
+size_t dpi_io_chan_write(struct dpi_io_chan *chan, const void *buf,
+                         size_t len) {
+  return chan_write(chan, buf, len, false);
+}
+
+bool dpi_io_chan_write_all(struct dpi_io_chan *chan, const void *buf,
+                           size_t len) {
+  return chan_write(chan, buf, len, true) == len;
+}
@@ -0,0 +1,127 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_DV_DPI_COMMON_DPI_IO_DPI_IO_H_
+#define OPENTITAN_HW_DV_DPI_COMMON_DPI_IO_DPI_IO_H_
+
+/**
+ * Buffered, asynchronous I/O on host file descriptors for DPI models
+ *
+ * DPI models that talk to the host (through a pty, FIFO or socket) are
+ * ticked on every clock edge, but almost always have nothing to do. Rather
+ * than making a non-blocking read() or write() on each tick, a model can
+ * open a channel on its file descriptor. A single I/O thread, shared by all
+ * channels, waits for the descriptors to become ready and moves data between
+ * them and a pair of ring buffers in each channel.
+ *
+ * The simulation side of a channel never makes a system call unless a ring
+ * changes between empty and non-empty (or full and not full), so checking an
+ * idle channel is just a couple of atomic loads.
+ *
+ * Each channel has one simulation-side user: the functions below must not be
+ * called concurrently on the same channel.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct dpi_io_chan;
+
+/** Read data arriving on the file descriptor into the channel */
+#define DPI_IO_READ 1
+/** Write data from the channel to the file descriptor */
+#define DPI_IO_WRITE 2
+
+/**
+ * Open a channel on a file descriptor
+ *
+ * The descriptor is switched to non-blocking mode. From now until the
+ * channel is closed, the I/O thread owns reads (with DPI_IO_READ) and
+ * writes (with DPI_IO_WRITE) on it.
+ *
+ * @param fd file descriptor to use
+ * @param flags DPI_IO_READ, DPI_IO_WRITE or both
+ * @param display_name name to use in messages
+ * @return the new channel, or NULL on error (after printing a message)
+ */
+struct dpi_io_chan *dpi_io_chan_open(int fd, int flags,
+                                     const char *display_name);
+
+/**
+ * Close a channel
+ *
+ * This waits for data written to the channel to be passed to the file
+ * descriptor (if possible without blocking), and then frees the channel. It
+ * does not close the file descriptor.
+ *
+ * @param chan channel to close (may be NULL)
+ */
+void dpi_io_chan_close(struct dpi_io_chan *chan);
+
+/**
+ * Get the number of bytes that can be read from a channel without waiting
+ *
+ * @param chan channel to check
+ * @return the number of bytes buffered
+ */
+size_t dpi_io_chan_readable(const struct dpi_io_chan *chan);
+
+/**
+ * Read buffered bytes from a channel without blocking
+ *
+ * @param chan channel to read from
+ * @param buf buffer to read into
+ * @param len maximum number of bytes to read
+ * @return number of bytes read, which is zero if none are buffered
+ */
+size_t dpi_io_chan_read(struct dpi_io_chan *chan, void *buf, size_t len);
+
+/**
+ * Read one buffered byte from a channel without blocking
+ *
+ * @param chan channel to read from
+ * @param dat byte read
+ * @return true if a byte was read
+ */
+bool dpi_io_chan_read_byte(struct dpi_io_chan *chan, char *dat);
+
+/**
+ * Queue bytes to be written to the file descriptor of a channel
+ *
+ * This doesn't block. The I/O thread writes the bytes in batches as the
+ * file descriptor accepts them. If the channel's buffer is full (because
+ * nothing is reading from the other end), the bytes that don't fit are
+ * dropped and a warning is printed the first time this happens.
+ *
+ * @param chan channel to write to
+ * @param buf bytes to write
+ * @param len number of bytes to write
+ * @return number of bytes queued
+ */
+size_t dpi_io_chan_write(struct dpi_io_chan *chan, const void *buf,
+                         size_t len);
+
+/**
+ * Queue a whole record to be written to the file descriptor of a channel
+ *
+ * Like dpi_io_chan_write(), but if the record doesn't fit in the channel's
+ * buffer then none of it is queued, so that a reader that expects records of
+ * a fixed size never sees part of one.
+ *
+ * @param chan channel to write to
+ * @param buf bytes to write
+ * @param len number of bytes to write
+ * @return true if the record was queued, false if it was dropped
+ */
+bool dpi_io_chan_write_all(struct dpi_io_chan *chan, const void *buf,
+                           size_t len);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+#endif  // OPENTITAN_HW_DV_DPI_COMMON_DPI_IO_DPI_IO_H_
@@ -24,14 +24,21 @@
 #include <unistd.h>
 
 /**
- * Simple buffer for passing data between TCP sockets and DPI modules
+ * Lock-free ring buffer for passing data between TCP sockets and DPI modules
+ *
+ * Each ring has exactly one producer and one consumer (the server thread and
+ * the simulation, one way round or the other). head and tail count the bytes
+ * written and read since the ring was created and are each only written by
+ * one side, so the ring holds head - tail bytes. The size is a power of two,
+ * so the counters can wrap freely.
  */
-#define BUFSIZE_BYTE 256
+#define TCP_SERVER_DEFAULT_BUF_SIZE 16384
 
 struct tcp_buf {
-  unsigned int rptr;
-  unsigned int wptr;
-  char buf[BUFSIZE_BYTE];
+  size_t head;
+  size_t tail;
+  size_t size;
+  char buf[];
 };
 
 /**
@@ -41,52 +48,90 @@ struct tcp_server_ctx {
   // Writeable by the host thread
   char *display_name;
   uint16_t listen_port;
+  enum tcp_server_send_policy send_policy;
   volatile bool socket_run;
+  // Number of clients the host thread has seen connect. The server thread
+  // doesn't receive from a client until this has caught up with conn_count.
+  unsigned conn_seen;
   // Writeable by the server thread
   struct tcp_buf *buf_in;
   struct tcp_buf *buf_out;
   int sfd;  // socket fd
   int cfd;  // client fd
+  // Set when the client socket won't take any more data until it says so
+  bool send_blocked;
+  // Number of clients accepted so far
+  unsigned conn_count;
   pthread_t sock_thread;
+  // Pipe used to wake the server thread when it is waiting in select()
+  int wake_fds[2];
 };
 
-static bool tcp_buffer_is_full(struct tcp_buf *buf) {
-  if (buf->wptr >= buf->rptr) {
-    return (buf->wptr - buf->rptr) == (BUFSIZE_BYTE - 1);
-  } else {
-    return (buf->rptr - buf->wptr) == 1;
-  }
+static size_t tcp_buffer_used(const struct tcp_buf *buf) {
+  return __atomic_load_n(&buf->head, __ATOMIC_SEQ_CST) -
+         __atomic_load_n(&buf->tail, __ATOMIC_SEQ_CST);
 }
 
-static bool tcp_buffer_is_empty(struct tcp_buf *buf) {
-  return (buf->wptr == buf->rptr);
+/**
+ * Get the contiguous free space at the head of a ring (producer only)
+ */
+static size_t tcp_buffer_write_space(struct tcp_buf *buf, char **dst) {
+  size_t head = __atomic_load_n(&buf->head, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE);
+  size_t off = head & (buf->size - 1);
+  size_t space = buf->size - (head - tail);
+  *dst = &buf->buf[off];
+  return (space < buf->size - off) ? space : buf->size - off;
 }
 
-static void tcp_buffer_put_byte(struct tcp_buf *buf, char dat) {
-  bool done = false;
-  while (!done) {
-    if (!tcp_buffer_is_full(buf)) {
-      buf->buf[buf->wptr++] = dat;
-      buf->wptr %= BUFSIZE_BYTE;
-      done = true;
-    }
-  }
+/**
+ * Publish len bytes written at the head of a ring (producer only)
+ *
+ * @return true if the ring was empty before (so the consumer may be waiting)
+ */
+static bool tcp_buffer_commit_write(struct tcp_buf *buf, size_t len) {
+  size_t head = __atomic_load_n(&buf->head, __ATOMIC_RELAXED);
+  __atomic_store_n(&buf->head, head + len, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&buf->tail, __ATOMIC_SEQ_CST) == head;
 }
 
-static bool tcp_buffer_get_byte(struct tcp_buf *buf, char *dat) {
-  if (tcp_buffer_is_empty(buf)) {
-    return false;
-  }
-  *dat = buf->buf[buf->rptr++];
-  buf->rptr %= BUFSIZE_BYTE;
-  return true;
+/**
+ * Get the contiguous data at the tail of a ring (consumer only)
+ */
+static size_t tcp_buffer_read_space(struct tcp_buf *buf, const char **src) {
+  size_t tail = __atomic_load_n(&buf->tail, __ATOMIC_RELAXED);
+  size_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+  size_t off = tail & (buf->size - 1);
+  size_t used = head - tail;
+  *src = &buf->buf[off];
+  return (used < buf->size - off) ? used : buf->size - off;
+}
+
+/**
+ * Release len bytes read from the tail of a ring (consumer only)
+ *
+ * @return true if the ring was full before (so the producer may be waiting)
+ */
+static bool tcp_buffer_commit_read(struct tcp_buf *buf, size_t len) {
+  size_t tail = __atomic_load_n(&buf->tail, __ATOMIC_RELAXED);
+  __atomic_store_n(&buf->tail, tail + len, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&buf->head, __ATOMIC_SEQ_CST) - tail == buf->size;
 }
 
-static struct tcp_buf *tcp_buffer_new(void) {
+static struct tcp_buf *tcp_buffer_new(size_t size) {
+  // Round up to a power of two so that offsets are a simple mask.
+  size_t pow2 = 1;
+  while (pow2 < size) {
+    pow2 <<= 1;
+  }
   struct tcp_buf *buf_new;
-  buf_new = (struct tcp_buf *)malloc(sizeof(struct tcp_buf));
-  buf_new->rptr = 0;
-  buf_new->wptr = 0;
+  buf_new = (struct tcp_buf *)malloc(sizeof(struct tcp_buf) + pow2);
+  if (!buf_new) {
+    return NULL;
+  }
+  buf_new->head = 0;
+  buf_new->tail = 0;
+  buf_new->size = pow2;
   return buf_new;
 }
 
@@ -95,6 +140,20 @@ static void tcp_buffer_free(struct tcp_buf **buf) {
   *buf = NULL;
 }
 
+/**
+ * Wake the server thread if it is waiting in select()
+ *
+ * @param ctx context object
+ */
+static void wake_server(struct tcp_server_ctx *ctx) {
+  char dummy = 0;
+  ssize_t rv;
+  do {
+    rv = write(ctx->wake_fds[1], &dummy, 1);
+  } while (rv == -1 && errno == EINTR);
+  // EAGAIN means the pipe is full of wakeups already, which is fine.
+}
+
 /**
  * Start a TCP server
  *
@@ -134,13 +193,16 @@ static int start(struct tcp_server_ctx *ctx) {
   }
 
   // stop tcp socket from buffering (buffering prevents timely responses to
-  // OpenOCD which severly limits debugging performance)
-  int tcp_nodelay = 1;
-  rv = setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &tcp_nodelay, sizeof(int));
-  if (rv != 0) {
-    fprintf(stderr, "%s: Unable to set socket nodelay: %s (%d)\n",
-            ctx->display_name, strerror(errno), errno);
-    return -1;
+  // OpenOCD which severly limits debugging performance). Accepted client
+  // sockets inherit this.
+  if (ctx->send_policy != kTcpServerSendNagle) {
+    int tcp_nodelay = 1;
+    rv = setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &tcp_nodelay, sizeof(int));
+    if (rv != 0) {
+      fprintf(stderr, "%s: Unable to set socket nodelay: %s (%d)\n",
+              ctx->display_name, strerror(errno), errno);
+      return -1;
+    }
   }
 
   // bind server
@@ -214,6 +276,11 @@ static int client_tryaccept(struct tcp_server_ctx *ctx) {
   ctx->cfd = cfd;
   assert(ctx->cfd > 0);
 
+  // Anything still in buf_in came from the previous client. Nothing is
+  // received from this one until the simulation has seen the new count and
+  // dropped that data (see tcp_server_read_buf()).
+  __atomic_add_fetch(&ctx->conn_count, 1, __ATOMIC_SEQ_CST);
+
   printf("%s: Accepted client connection\n", ctx->display_name);
 
   return 0;
@@ -234,51 +301,113 @@ static void stop(struct tcp_server_ctx *ctx) {
 }
 
 /**
- * Receive a byte from a connected client
+ * Check whether the simulation has seen the latest client connect
+ *
+ * @param ctx context object
+ * @return true if data from the client may be received into buf_in
+ */
+static bool conn_seen_by_host(struct tcp_server_ctx *ctx) {
+  return __atomic_load_n(&ctx->conn_seen, __ATOMIC_SEQ_CST) == ctx->conn_count;
+}
+
+/**
+ * Receive as much data from a connected client as fits into buf_in
  *
  * @param ctx context object
- * @param cmd byte received
- * @return true if a byte was read
  */
-static bool get_byte(struct tcp_server_ctx *ctx, char *cmd) {
+static void recv_data(struct tcp_server_ctx *ctx) {
   assert(ctx);
 
-  ssize_t num_read = read(ctx->cfd, cmd, 1);
+  while (ctx->cfd) {
+    char *dst;
+    size_t space = tcp_buffer_write_space(ctx->buf_in, &dst);
+    if (!space) {
+      return;
+    }
 
-  if (num_read == 0) {
-    return false;
-  }
-  if (num_read == -1) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      return false;
-    } else if (errno == EBADF) {
-      // Possibly client went away? Accept a new connection.
-      fprintf(stderr, "%s: Client disappeared.\n", ctx->display_name);
+    ssize_t num_read = recv(ctx->cfd, dst, space, 0);
+    if (num_read == 0) {
+      printf("%s: Remote disconnected.\n", ctx->display_name);
       tcp_server_client_close(ctx);
-      return false;
-    } else {
-      fprintf(stderr, "%s: Error while reading from client: %s (%d)\n",
-              ctx->display_name, strerror(errno), errno);
-      assert(0 && "Error reading from client");
+      return;
+    }
+    if (num_read == -1) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      } else if (errno == EBADF || errno == ECONNRESET) {
+        // Possibly client went away? Accept a new connection.
+        fprintf(stderr, "%s: Client disappeared.\n", ctx->display_name);
+        tcp_server_client_close(ctx);
+        return;
+      } else {
+        fprintf(stderr, "%s: Error while reading from client: %s (%d)\n",
+                ctx->display_name, strerror(errno), errno);
+        assert(0 && "Error reading from client");
+      }
+    }
+
+    tcp_buffer_commit_write(ctx->buf_in, num_read);
+    if ((size_t)num_read < space) {
+      return;
     }
   }
-  assert(num_read == 1);
-  return true;
 }
 
 /**
- * Send a byte to a connected client
+ * Set the TCP_CORK option on the client socket (if supported)
+ *
+ * While a socket is corked, the kernel holds back partial segments. Corking
+ * around a batch of sends makes them go out in as few packets as possible,
+ * and uncorking at the end pushes out whatever is left.
+ *
+ * @param ctx context object
+ * @param cork whether to cork or uncork
+ */
+static void set_cork(struct tcp_server_ctx *ctx, int cork) {
+#ifdef TCP_CORK
+  if (ctx->send_policy == kTcpServerSendCork) {
+    setsockopt(ctx->cfd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+  }
+#else
+  (void)ctx;
+  (void)cork;
+#endif
+}
+
+/**
+ * Send as much data from buf_out to a connected client as it will take
+ *
+ * Data is sent in as few send() calls as possible: normally one, or two if
+ * it wraps round the end of the ring.
  *
  * @param ctx context object
- * @param cmd byte to send
  */
-static void put_byte(struct tcp_server_ctx *ctx, char cmd) {
-  while (1) {
-    ssize_t num_written = send(ctx->cfd, &cmd, sizeof(cmd), MSG_NOSIGNAL);
+static void send_data(struct tcp_server_ctx *ctx) {
+  bool corked = false;
+  ctx->send_blocked = false;
+
+  while (ctx->cfd) {
+    const char *src;
+    size_t avail = tcp_buffer_read_space(ctx->buf_out, &src);
+    if (!avail) {
+      break;
+    }
+    if (!corked && tcp_buffer_used(ctx->buf_out) > avail) {
+      // The data wraps, so will take more than one send().
+      set_cork(ctx, 1);
+      corked = true;
+    }
+
+    ssize_t num_written = send(ctx->cfd, src, avail, MSG_NOSIGNAL);
     if (num_written == -1) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      if (errno == EINTR) {
         continue;
-      } else if (errno == EPIPE) {
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        ctx->send_blocked = true;
+        break;
+      } else if (errno == EPIPE || errno == ECONNRESET) {
         printf("%s: Remote disconnected.\n", ctx->display_name);
         tcp_server_client_close(ctx);
         break;
@@ -288,9 +417,12 @@ static void put_byte(struct tcp_server_ctx *ctx, char cmd) {
         assert(0 && "Error writing to client.");
       }
     }
-    if (num_written >= 1) {
-      break;
-    }
+
+    tcp_buffer_commit_read(ctx->buf_out, num_written);
+  }
+
+  if (corked && ctx->cfd) {
+    set_cork(ctx, 0);
   }
 }
 
@@ -303,6 +435,11 @@ static void ctx_free(struct tcp_server_ctx *ctx) {
   // Free the buffers
   tcp_buffer_free(&ctx->buf_in);
   tcp_buffer_free(&ctx->buf_out);
+  // Close the wakeup pipe
+  if (ctx->wake_fds[0] >= 0) {
+    close(ctx->wake_fds[0]);
+    close(ctx->wake_fds[1]);
+  }
   // Free the display name
   free(ctx->display_name);
   // Free the ctx
@@ -313,13 +450,17 @@ static void ctx_free(struct tcp_server_ctx *ctx) {
 /**
  * Thread function to create a new server instance
  *
+ * The thread sleeps in select() until something happens on the sockets or
+ * the simulation wakes it through wake_fds. The simulation only does that when
+ * it makes buf_out non-empty or buf_in non-full, so that the common case of
+ * reading from or writing to a ring doesn't need a system call.
+ *
  * @param ctx_void context object
  * @return Always returns NULL
  */
 static void *server_create(void *ctx_void) {
   // Cast to a server struct
   struct tcp_server_ctx *ctx = (struct tcp_server_ctx *)ctx_void;
-  struct timeval timeout;
 
   // Start the server
   int rv = start(ctx);
@@ -329,30 +470,51 @@ static void *server_create(void *ctx_void) {
     goto err_cleanup_return;
   }
 
-  // Initialise fd_set
-
   // Start waiting for connection / data
-  char xfer_data;
   while (ctx->socket_run) {
+    // Anything written while there was no client is stale by the time one
+    // connects, so drop it.
+    if (!ctx->cfd) {
+      const char *src;
+      size_t len;
+      while ((len = tcp_buffer_read_space(ctx->buf_out, &src)) != 0) {
+        tcp_buffer_commit_read(ctx->buf_out, len);
+      }
+    }
+
     // Initialise structure of fds
     fd_set read_fds;
+    fd_set write_fds;
     FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_SET(ctx->wake_fds[0], &read_fds);
+    int mfd = ctx->wake_fds[0];
     if (ctx->sfd) {
       FD_SET(ctx->sfd, &read_fds);
+      mfd = (ctx->sfd > mfd) ? ctx->sfd : mfd;
     }
     if (ctx->cfd) {
-      FD_SET(ctx->cfd, &read_fds);
+      // Only listen for data that there is space to receive. If buf_in is
+      // full, or still holds data from the previous client, the simulation
+      // wakes us when it reads something.
+      if (tcp_buffer_used(ctx->buf_in) < ctx->buf_in->size &&
+          conn_seen_by_host(ctx)) {
+        FD_SET(ctx->cfd, &read_fds);
+      }
+      if (ctx->send_blocked) {
+        FD_SET(ctx->cfd, &write_fds);
+      }
+      mfd = (ctx->cfd > mfd) ? ctx->cfd : mfd;
     }
-    // max fd num
-    int mfd = (ctx->cfd > ctx->sfd) ? ctx->cfd : ctx->sfd;
 
-    // Set timeout - 50us gives good performance; do it every time
-    // since select can trash it.
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 50;
+    // Only wait if there's nothing to send. Otherwise, just poll the sockets.
+    struct timeval timeout = {0, 0};
+    bool have_data = !ctx->send_blocked && ctx->cfd &&
+                     tcp_buffer_used(ctx->buf_out) != 0;
 
-    // Wait for socket activity or timeout
-    rv = select(mfd + 1, &read_fds, NULL, NULL, &timeout);
+    // Wait for socket activity or a wakeup
+    rv = select(mfd + 1, &read_fds, &write_fds, NULL,
+                have_data ? &timeout : NULL);
 
     if (rv < 0) {
       if (errno == EINTR) {
@@ -363,24 +525,28 @@ static void *server_create(void *ctx_void) {
       printf("%s: Socket read failed, port: %d\n", ctx->display_name,
              ctx->listen_port);
       tcp_server_client_close(ctx);
+      continue;
+    }
+
+    // Wakeup from the simulation
+    if (FD_ISSET(ctx->wake_fds[0], &read_fds)) {
+      char dummy[64];
+      while (read(ctx->wake_fds[0], dummy, sizeof(dummy)) > 0) {
+      }
     }
 
     // New connection
-    if (FD_ISSET(ctx->sfd, &read_fds)) {
+    if (ctx->sfd && FD_ISSET(ctx->sfd, &read_fds)) {
       client_tryaccept(ctx);
     }
 
     // New client data
-    if (FD_ISSET(ctx->cfd, &read_fds)) {
-      while (!tcp_buffer_is_full(ctx->buf_in) && get_byte(ctx, &xfer_data)) {
-        tcp_buffer_put_byte(ctx->buf_in, xfer_data);
-      }
+    if (ctx->cfd && conn_seen_by_host(ctx) && FD_ISSET(ctx->cfd, &read_fds)) {
+      recv_data(ctx);
     }
 
-    if (ctx->cfd != 0) {
-      while (tcp_buffer_get_byte(ctx->buf_out, &xfer_data)) {
-        put_byte(ctx, xfer_data);
-      }
+    if (ctx->cfd && (!ctx->send_blocked || FD_ISSET(ctx->cfd, &write_fds))) {
+      send_data(ctx);
     }
   }
 
@@ -396,13 +562,30 @@ err_cleanup_return:
 // Abstract interface functions
 struct tcp_server_ctx *tcp_server_create(const char *display_name,
                                          int listen_port) {
+  return tcp_server_create_opts(display_name, listen_port, NULL);
+}
+
+struct tcp_server_ctx *tcp_server_create_opts(
+    const char *display_name, int listen_port,
+    const struct tcp_server_opts *opts) {
+  size_t buf_size = TCP_SERVER_DEFAULT_BUF_SIZE;
+  enum tcp_server_send_policy send_policy = kTcpServerSendNoDelay;
+  if (opts) {
+    if (opts->buf_size) {
+      buf_size = opts->buf_size;
+    }
+    send_policy = opts->send_policy;
+  }
+
   struct tcp_server_ctx *ctx =
       (struct tcp_server_ctx *)calloc(1, sizeof(struct tcp_server_ctx));
   assert(ctx);
+  ctx->wake_fds[0] = -1;
+  ctx->wake_fds[1] = -1;
 
   // Create the buffers
-  struct tcp_buf *buf_in = tcp_buffer_new();
-  struct tcp_buf *buf_out = tcp_buffer_new();
+  struct tcp_buf *buf_in = tcp_buffer_new(buf_size);
+  struct tcp_buf *buf_out = tcp_buffer_new(buf_size);
   assert(buf_in);
   assert(buf_out);
 
@@ -413,31 +596,109 @@ struct tcp_server_ctx *tcp_server_create(const char *display_name,
   // Set up socket details
   ctx->socket_run = true;
   ctx->listen_port = listen_port;
+  ctx->send_policy = send_policy;
   ctx->display_name = strdup(display_name);
   assert(ctx->display_name);
 
+  if (pipe(ctx->wake_fds) != 0 ||
+      fcntl(ctx->wake_fds[0], F_SETFL, O_NONBLOCK) != 0 ||
+      fcntl(ctx->wake_fds[1], F_SETFL, O_NONBLOCK) != 0) {
+    fprintf(stderr, "%s: Unable to create wakeup pipe: %s (%d)\n",
+            ctx->display_name, strerror(errno), errno);
+    ctx_free(ctx);
+    return NULL;
+  }
+
   if (pthread_create(&ctx->sock_thread, NULL, server_create, (void *)ctx) !=
       0) {
     fprintf(stderr, "%s: Unable to create TCP socket thread\n",
             ctx->display_name);
     ctx_free(ctx);
-    free(ctx);
     return NULL;
   }
   return ctx;
 }
 
 bool tcp_server_read(struct tcp_server_ctx *ctx, char *dat) {
-  return tcp_buffer_get_byte(ctx->buf_in, dat);
+  return tcp_server_read_buf(ctx, dat, 1) == 1;
+}
+
+size_t tcp_server_read_buf(struct tcp_server_ctx *ctx, char *buf,
+                           size_t len) {
+  size_t done = 0;
+  bool was_full = false;
+
+  // If another client has connected, everything in buf_in came from the one
+  // that has gone away, so drop it. Return without data, so that a caller
+  // that checks tcp_server_connection_count() before every read never gets
+  // bytes from a client it hasn't seen yet.
+  unsigned conn_count = __atomic_load_n(&ctx->conn_count, __ATOMIC_SEQ_CST);
+  if (ctx->conn_seen != conn_count) {
+    const char *src;
+    size_t avail;
+    while ((avail = tcp_buffer_read_space(ctx->buf_in, &src)) != 0) {
+      tcp_buffer_commit_read(ctx->buf_in, avail);
+    }
+    __atomic_store_n(&ctx->conn_seen, conn_count, __ATOMIC_SEQ_CST);
+    wake_server(ctx);
+    return 0;
+  }
+
+  while (done < len) {
+    const char *src;
+    size_t avail = tcp_buffer_read_space(ctx->buf_in, &src);
+    if (!avail) {
+      break;
+    }
+    if (avail > len - done) {
+      avail = len - done;
+    }
+    memcpy(buf + done, src, avail);
+    was_full |= tcp_buffer_commit_read(ctx->buf_in, avail);
+    done += avail;
+  }
+
+  // If the ring was full, the server thread has stopped listening to the
+  // client and needs telling that there's space again.
+  if (was_full) {
+    wake_server(ctx);
+  }
+  return done;
 }
 
 void tcp_server_write(struct tcp_server_ctx *ctx, char dat) {
-  tcp_buffer_put_byte(ctx->buf_out, dat);
+  tcp_server_write_buf(ctx, &dat, 1);
+}
+
+void tcp_server_write_buf(struct tcp_server_ctx *ctx, const char *buf,
+                          size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    char *dst;
+    size_t space = tcp_buffer_write_space(ctx->buf_out, &dst);
+    if (!space) {
+      // Wait for the server thread to make some space.
+      continue;
+    }
+    if (space > len - done) {
+      space = len - done;
+    }
+    memcpy(dst, buf + done, space);
+    done += space;
+    if (tcp_buffer_commit_write(ctx->buf_out, space)) {
+      wake_server(ctx);
+    }
+  }
+}
+
+unsigned tcp_server_connection_count(struct tcp_server_ctx *ctx) {
+  return __atomic_load_n(&ctx->conn_count, __ATOMIC_SEQ_CST);
 }
 
 void tcp_server_close(struct tcp_server_ctx *ctx) {
   // Shut down the socket thread
   ctx->socket_run = false;
+  wake_server(ctx);
   pthread_join(ctx->sock_thread, NULL);
   ctx_free(ctx);
 }
@@ -451,4 +712,8 @@ void tcp_server_client_close(struct tcp_server_ctx *ctx) {
 
   close(ctx->cfd);
   ctx->cfd = 0;
+  ctx->send_blocked = false;
+  // If this was called from the simulation, the server thread needs to stop
+  // waiting on the old socket.
+  wake_server(ctx);
 }
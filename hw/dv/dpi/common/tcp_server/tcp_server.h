@@ -17,10 +17,46 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 struct tcp_server_ctx;
 
+/**
+ * When data written to the server is sent to the client
+ */
+enum tcp_server_send_policy {
+  /**
+   * Send data as soon as it is written, with Nagle's algorithm disabled
+   * (TCP_NODELAY). This gives the lowest latency for request/response
+   * protocols like OpenOCD's remote_bitbang, and is the default.
+   */
+  kTcpServerSendNoDelay = 0,
+  /**
+   * As kTcpServerSendNoDelay, but cork the socket (TCP_CORK, where supported)
+   * while sending a batch of data, so that it goes out in full-sized packets.
+   */
+  kTcpServerSendCork,
+  /**
+   * Leave Nagle's algorithm enabled, letting the kernel coalesce small writes
+   * at the cost of latency.
+   */
+  kTcpServerSendNagle,
+};
+
+/**
+ * Options for tcp_server_create_opts()
+ */
+struct tcp_server_opts {
+  /**
+   * Size of each of the receive and transmit buffers, in bytes. This is
+   * rounded up to a power of two. Zero selects the default (16 KiB).
+   */
+  size_t buf_size;
+  /** When to send data to the client */
+  enum tcp_server_send_policy send_policy;
+};
+
 /**
  * Non-blocking read of a byte from a connected client
  *
@@ -30,6 +66,16 @@ struct tcp_server_ctx;
  */
 bool tcp_server_read(struct tcp_server_ctx *ctx, char *dat);
 
+/**
+ * Non-blocking read of up to len bytes from a connected client
+ *
+ * @param ctx tcp server context object
+ * @param buf buffer to read into
+ * @param len maximum number of bytes to read
+ * @return number of bytes read, which is zero if none were available
+ */
+size_t tcp_server_read_buf(struct tcp_server_ctx *ctx, char *buf, size_t len);
+
 /**
  * Write a byte to a connected client
  *
@@ -41,6 +87,35 @@ bool tcp_server_read(struct tcp_server_ctx *ctx, char *dat);
  */
 void tcp_server_write(struct tcp_server_ctx *ctx, char dat);
 
+/**
+ * Write len bytes to a connected client
+ *
+ * As with tcp_server_write(), this only blocks while the buffer is full. The
+ * bytes are passed to the socket together, so writing a whole response with
+ * one call is much cheaper than writing it a byte at a time.
+ *
+ * @param ctx tcp server context object
+ * @param buf bytes to send
+ * @param len number of bytes to send
+ */
+void tcp_server_write_buf(struct tcp_server_ctx *ctx, const char *buf,
+                          size_t len);
+
+/**
+ * Get the number of clients that have connected so far
+ *
+ * A change in this number means that the client has gone away and another one
+ * has taken its place, so any per-client state should be reset. Data sent by
+ * the old client that hasn't been read yet is dropped by the next read, which
+ * returns nothing. All data returned by later reads comes from the new
+ * client, so a caller that checks this number before each read never mixes
+ * data from two clients.
+ *
+ * @param ctx tcp server context object
+ * @return number of accepted client connections
+ */
+unsigned tcp_server_connection_count(struct tcp_server_ctx *ctx);
+
 /**
  * Create a new TCP server instance
  *
@@ -51,6 +126,18 @@ void tcp_server_write(struct tcp_server_ctx *ctx, char dat);
 struct tcp_server_ctx *tcp_server_create(const char *display_name,
                                          int listen_port);
 
+/**
+ * Create a new TCP server instance with non-default options
+ *
+ * @param display_name C string description of server
+ * @param listen_port On which port the server should listen
+ * @param opts Server options, or NULL for the defaults
+ * @return A pointer to the created context struct
+ */
+struct tcp_server_ctx *tcp_server_create_opts(
+    const char *display_name, int listen_port,
+    const struct tcp_server_opts *opts);
+
 /**
  * Shut down the server and free all reserved memory
  *
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors (OpenTitan project).
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+'''Access the debug module of a simulation through dmidpi's native transport
+
+dmidpi can listen on a second port (set with +dmidpi_native_port=PORT) for
+whole DMI transactions, skipping the JTAG emulation that OpenOCD's
+remote_bitbang driver needs. This script is a client for that transport: it
+can read and write DMI registers directly, and read or load memory through
+the debug module's system bus access (SBA) registers.
+
+Each request is 6 bytes: an op (1 for a read, 2 for a write), a 7-bit DMI
+address and 32 bits of data (little-endian). Each response is 5 bytes: the
+DMI response code (0 for success) and 32 bits of data (little-endian).
+Requests can be sent in batches without waiting for the responses; they are
+run in order and the responses come back in order.
+
+Examples:
+
+    dmi_native.py --port=44854 read 0x11
+    dmi_native.py --port=44854 memread 0x10000000 16
+    dmi_native.py --port=44854 memload 0x10000000 image.bin
+
+'''
+
+import argparse
+import socket
+import struct
+import sys
+import time
+from typing import List, Sequence, Tuple
+
+DMI_OP_READ = 1
+DMI_OP_WRITE = 2
+
+# Debug module registers (RISC-V debug specification 0.13)
+DM_DMCONTROL = 0x10
+DM_SBCS = 0x38
+DM_SBADDRESS0 = 0x39
+DM_SBDATA0 = 0x3c
+
+SBCS_SBBUSYERROR = 1 << 22
+SBCS_SBREADONADDR = 1 << 20
+SBCS_SBACCESS_32 = 2 << 17
+SBCS_SBAUTOINCREMENT = 1 << 16
+SBCS_SBREADONDATA = 1 << 15
+SBCS_SBERROR_SHIFT = 12
+SBCS_SBERROR_MASK = 0x7
+
+# How many transactions to send before waiting for their responses
+BATCH_SIZE = 256
+
+
+class DmiError(Exception):
+    pass
+
+
+class NativeDmi:
+    '''A connection to dmidpi's native DMI transport'''
+
+    def __init__(self, host: str, port: int) -> None:
+        self._sock = socket.create_connection((host, port))
+        self._sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def close(self) -> None:
+        self._sock.close()
+
+    def _recv_exactly(self, length: int) -> bytes:
+        data = b''
+        while len(data) < length:
+            chunk = self._sock.recv(length - len(data))
+            if not chunk:
+                raise DmiError('Simulation closed the connection.')
+            data += chunk
+        return data
+
+    def batch(self, reqs: Sequence[Tuple[int, int, int]]) -> List[int]:
+        '''Run a list of (op, addr, data) transactions
+
+        Returns the data from each response. Raises DmiError if any
+        transaction fails.
+
+        '''
+        results = []
+        for start in range(0, len(reqs), BATCH_SIZE):
+            chunk = reqs[start:start + BATCH_SIZE]
+            self._sock.sendall(b''.join(struct.pack('<BBI', op, addr, data)
+                                        for op, addr, data in chunk))
+            rsps = self._recv_exactly(5 * len(chunk))
+            for idx, (op, addr, _) in enumerate(chunk):
+                resp, data = struct.unpack_from('<BI', rsps, 5 * idx)
+                if resp != 0:
+                    what = 'read' if op == DMI_OP_READ else 'write'
+                    raise DmiError(f'DMI {what} of address {addr:#x} failed '
+                                   f'(response {resp}).')
+                results.append(data)
+        return results
+
+    def read(self, addr: int) -> int:
+        return self.batch([(DMI_OP_READ, addr, 0)])[0]
+
+    def write(self, addr: int, data: int) -> None:
+        self.batch([(DMI_OP_WRITE, addr, data)])
+
+    def _check_sbcs(self) -> None:
+        sbcs = self.read(DM_SBCS)
+        sberror = (sbcs >> SBCS_SBERROR_SHIFT) & SBCS_SBERROR_MASK
+        if sberror or (sbcs & SBCS_SBBUSYERROR):
+            # Clear the errors (they are write-1-to-clear) for next time.
+            error_bits = ((SBCS_SBERROR_MASK << SBCS_SBERROR_SHIFT) |
+                          SBCS_SBBUSYERROR)
+            self.write(DM_SBCS, sbcs & error_bits)
+            raise DmiError(f'System bus access failed (sbcs = {sbcs:#x}). '
+                           'Was the simulation too slow for back-to-back '
+                           'accesses?')
+
+    def mem_read(self, addr: int, count: int) -> List[int]:
+        '''Read count 32-bit words from the system bus'''
+        self.write(DM_DMCONTROL, 1)
+        self.write(DM_SBCS, SBCS_SBACCESS_32 | SBCS_SBAUTOINCREMENT |
+                   SBCS_SBREADONADDR | SBCS_SBREADONDATA)
+        # Writing the address starts the first read, and each read of sbdata0
+        # starts the next one.
+        reqs = [(DMI_OP_WRITE, DM_SBADDRESS0, addr)]
+        reqs += [(DMI_OP_READ, DM_SBDATA0, 0)] * count
+        words = self.batch(reqs)[1:]
+        self._check_sbcs()
+        return words
+
+    def mem_write(self, addr: int, words: Sequence[int]) -> None:
+        '''Write 32-bit words to the system bus'''
+        self.write(DM_DMCONTROL, 1)
+        self.write(DM_SBCS, SBCS_SBACCESS_32 | SBCS_SBAUTOINCREMENT)
+        reqs = [(DMI_OP_WRITE, DM_SBADDRESS0, addr)]
+        reqs += [(DMI_OP_WRITE, DM_SBDATA0, word) for word in words]
+        self.batch(reqs)
+        self._check_sbcs()
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--host', default='localhost',
+                        help='Host the simulation is running on')
+    parser.add_argument('--port', type=int, required=True,
+                        help='Port of the native DMI transport')
+    subparsers = parser.add_subparsers(dest='cmd', required=True)
+
+    p_read = subparsers.add_parser('read', help='Read a DMI register')
+    p_read.add_argument('addr', type=lambda x: int(x, 0))
+
+    p_write = subparsers.add_parser('write', help='Write a DMI register')
+    p_write.add_argument('addr', type=lambda x: int(x, 0))
+    p_write.add_argument('data', type=lambda x: int(x, 0))
+
+    p_memread = subparsers.add_parser('memread',
+                                      help='Read words from the system bus')
+    p_memread.add_argument('addr', type=lambda x: int(x, 0))
+    p_memread.add_argument('count', type=lambda x: int(x, 0))
+
+    p_memload = subparsers.add_parser('memload',
+                                      help=('Load a binary file onto the '
+                                            'system bus'))
+    p_memload.add_argument('addr', type=lambda x: int(x, 0))
+    p_memload.add_argument('file', type=argparse.FileType('rb'))
+
+    args = parser.parse_args()
+
+    dmi = NativeDmi(args.host, args.port)
+    try:
+        if args.cmd == 'read':
+            print(f'{dmi.read(args.addr):#010x}')
+        elif args.cmd == 'write':
+            dmi.write(args.addr, args.data)
+        elif args.cmd == 'memread':
+            words = dmi.mem_read(args.addr, args.count)
+            for idx, word in enumerate(words):
+                print(f'{args.addr + 4 * idx:#010x}: {word:#010x}')
+        else:
+            data = args.file.read()
+            data += b'\0' * (-len(data) % 4)
+            words = [w for (w,) in struct.iter_unpack('<I', data)]
+            start = time.monotonic()
+            dmi.mem_write(args.addr, words)
+            elapsed = time.monotonic() - start
+            print(f'Loaded {len(data)} bytes in {elapsed:.3f} s.')
+    except DmiError as err:
+        print(f'Error: {err}', file=sys.stderr)
+        return 1
+    finally:
+        dmi.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
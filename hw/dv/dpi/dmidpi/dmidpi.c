@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dpi_checkpoint.h"
 #include "tcp_server.h"
 
 // IDCODE register
@@ -82,12 +83,101 @@ struct dmi_sig_values {
   uint8_t dmi_rst_n;
 };
 
+#define CMD_BUF_SIZE 256
+
+// Native DMI transport. A request is an op byte (1: read, 2: write), an
+// address byte and 32 bits of data (little-endian). A response is the DMI
+// response code followed by 32 bits of data (little-endian).
+#define NATIVE_REQ_SIZE 6
+#define NATIVE_RSP_SIZE 5
+#define NATIVE_RSP_BUF_SIZE (64 * NATIVE_RSP_SIZE)
+
 struct dmidpi_ctx {
   struct tcp_server_ctx *sock;
   struct jtag_ctx jtag;
   struct dmi_sig_values sig;
+  // Commands received from the client but not processed yet
+  char cmd_buf[CMD_BUF_SIZE];
+  size_t cmd_pos;
+  size_t cmd_len;
+  // Responses not sent to the client yet
+  char resp_buf[CMD_BUF_SIZE];
+  size_t resp_len;
+  // Native DMI transport (NULL if disabled)
+  struct tcp_server_ctx *native_sock;
+  // The connection count of native_sock when its state was last reset
+  unsigned native_conn;
+  // The request being received
+  uint8_t native_req[NATIVE_REQ_SIZE];
+  size_t native_req_len;
+  // Responses not sent to the client yet
+  char native_rsp_buf[NATIVE_RSP_BUF_SIZE];
+  size_t native_rsp_len;
+  // True if the outstanding DMI request came from the native transport
+  bool native_outstanding;
+  // True if the response to that request should be dropped (because it was
+  // issued before a checkpoint was restored)
+  bool native_discard;
+};
+
+// The part of the DMI state that is saved in a simulation checkpoint. The
+// socket belongs to the process that opened it, so a restored simulation keeps
+// its own (and drops any commands buffered from it).
+struct dmidpi_checkpoint {
+  struct jtag_ctx jtag;
+  struct dmi_sig_values sig;
+  bool native_outstanding;
 };
 
+static size_t dmidpi_checkpoint_save(void *ctx_void, void *buf,
+                                     size_t buf_len) {
+  struct dmidpi_ctx *ctx = (struct dmidpi_ctx *)ctx_void;
+  struct dmidpi_checkpoint state;
+  memset(&state, 0, sizeof(state));
+  state.jtag = ctx->jtag;
+  state.sig = ctx->sig;
+  state.native_outstanding = ctx->native_outstanding;
+  if (buf_len >= sizeof(state)) {
+    memcpy(buf, &state, sizeof(state));
+  }
+  return sizeof(state);
+}
+
+static bool dmidpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                      size_t len) {
+  struct dmidpi_ctx *ctx = (struct dmidpi_ctx *)ctx_void;
+  struct dmidpi_checkpoint state;
+  if (len != sizeof(state)) {
+    return false;
+  }
+  memcpy(&state, buf, sizeof(state));
+  ctx->jtag = state.jtag;
+  ctx->sig = state.sig;
+  ctx->cmd_pos = 0;
+  ctx->cmd_len = 0;
+  ctx->resp_len = 0;
+  ctx->native_req_len = 0;
+  ctx->native_rsp_len = 0;
+  ctx->native_outstanding = state.native_outstanding;
+  ctx->native_discard = state.native_outstanding;
+  return true;
+}
+
+static const struct dpi_checkpoint_ops dmidpi_checkpoint_ops = {
+    dmidpi_checkpoint_save, dmidpi_checkpoint_restore, dmidpi_set_ctx};
+
+/**
+ * Send any buffered responses to the client
+ *
+ * @param ctx dmidpi context object
+ */
+static void flush_resp(struct dmidpi_ctx *ctx) {
+  if (ctx->resp_len) {
+    tcp_server_write_buf(ctx->sock, ctx->resp_buf, ctx->resp_len);
+    ctx->resp_len = 0;
+  }
+}
+
 /**
  * Setup the correct shift register data
  *
@@ -305,8 +395,10 @@ static bool process_cmd_byte(struct dmidpi_ctx *ctx, char cmd) {
     return true;
   } else if (cmd == 'R') {
     // JTAG read, send tdo as response
-    char tdo_ascii = ctx->jtag.jtag_tdo + '0';
-    tcp_server_write(ctx->sock, tdo_ascii);
+    if (ctx->resp_len == sizeof(ctx->resp_buf)) {
+      flush_resp(ctx);
+    }
+    ctx->resp_buf[ctx->resp_len++] = ctx->jtag.jtag_tdo + '0';
   } else if (cmd == 'B') {
     // printf("DMI DPI: BLINK ON!\n");
   } else if (cmd == 'b') {
@@ -314,6 +406,7 @@ static bool process_cmd_byte(struct dmidpi_ctx *ctx, char cmd) {
   } else if (cmd == 'Q') {
     // quit (client disconnect)
     printf("DMI DPI: Remote disconnected.\n");
+    flush_resp(ctx);
     tcp_server_client_close(ctx->sock);
   } else {
     fprintf(stderr,
@@ -325,6 +418,109 @@ static bool process_cmd_byte(struct dmidpi_ctx *ctx, char cmd) {
   return false;
 }
 
+/**
+ * Send any buffered native transport responses to the client
+ *
+ * @param ctx dmidpi context object
+ */
+static void flush_native_rsp(struct dmidpi_ctx *ctx) {
+  if (ctx->native_rsp_len) {
+    tcp_server_write_buf(ctx->native_sock, ctx->native_rsp_buf,
+                         ctx->native_rsp_len);
+    ctx->native_rsp_len = 0;
+  }
+}
+
+/**
+ * Queue the response to a native transport request
+ *
+ * @param ctx dmidpi context object
+ */
+static void queue_native_rsp(struct dmidpi_ctx *ctx) {
+  if (ctx->native_rsp_len + NATIVE_RSP_SIZE > sizeof(ctx->native_rsp_buf)) {
+    flush_native_rsp(ctx);
+  }
+  char *rsp = &ctx->native_rsp_buf[ctx->native_rsp_len];
+  rsp[0] = ctx->sig.dmi_rsp_resp & 0x3;
+  for (int i = 0; i < 4; ++i) {
+    rsp[1 + i] = (ctx->sig.dmi_rsp_data >> (8 * i)) & 0xFF;
+  }
+  ctx->native_rsp_len += NATIVE_RSP_SIZE;
+}
+
+/**
+ * Forget everything about the current native transport client
+ *
+ * Called when the client goes away, so that the next one neither receives
+ * the rest of its responses nor has its first request mixed with a partial
+ * one.
+ *
+ * @param ctx dmidpi context object
+ */
+static void reset_native_client(struct dmidpi_ctx *ctx) {
+  ctx->native_req_len = 0;
+  ctx->native_rsp_len = 0;
+  // A request still in flight belonged to the old client.
+  ctx->native_discard = ctx->native_outstanding;
+}
+
+/**
+ * Drive a DMI transaction received on the native transport, if there is one
+ *
+ * @param ctx dmidpi context object
+ * @return true if a transaction was started
+ */
+static bool issue_native_req(struct dmidpi_ctx *ctx) {
+  if (!ctx->native_sock) {
+    return false;
+  }
+
+  // Check for a new client before reading, so that its data is never
+  // appended to a partial request from the previous one.
+  unsigned conn = tcp_server_connection_count(ctx->native_sock);
+  if (conn != ctx->native_conn) {
+    ctx->native_conn = conn;
+    reset_native_client(ctx);
+  }
+
+  ctx->native_req_len += tcp_server_read_buf(
+      ctx->native_sock, (char *)&ctx->native_req[ctx->native_req_len],
+      NATIVE_REQ_SIZE - ctx->native_req_len);
+  if (ctx->native_req_len < NATIVE_REQ_SIZE) {
+    return false;
+  }
+  ctx->native_req_len = 0;
+
+  uint8_t op = ctx->native_req[0];
+  if (op != 1 && op != 2) {
+    fprintf(stderr,
+            "DMI DPI: Protocol violation detected: unsupported native op %d. "
+            "Disconnecting.\n",
+            op);
+    tcp_server_client_close(ctx->native_sock);
+    reset_native_client(ctx);
+    return false;
+  }
+
+  uint32_t data = 0;
+  for (int i = 0; i < 4; ++i) {
+    data |= (uint32_t)ctx->native_req[2 + i] << (8 * i);
+  }
+
+  // The native transport has no equivalent of JTAG's Test-Logic-Reset, so
+  // make sure the DMI is out of reset.
+  ctx->sig.dmi_rst_n = 1;
+
+  ctx->jtag.dmi_outstanding = 1;
+  ctx->native_outstanding = true;
+  ctx->native_discard = false;
+  ctx->sig.dmi_req_valid = 1;
+  ctx->sig.dmi_req_addr = ctx->native_req[1] & 0x7F;
+  ctx->sig.dmi_req_op = op;
+  ctx->sig.dmi_req_data = data;
+  return true;
+}
+
 /**
  * Process DPI inputs from the design
  *
@@ -338,8 +534,15 @@ static void process_dmi_inputs(struct dmidpi_ctx *ctx) {
   // Always ready for a resp
   ctx->sig.dmi_rsp_ready = 1;
   if (ctx->sig.dmi_rsp_valid) {
-    ctx->jtag.dr_captured = (uint64_t)ctx->sig.dmi_rsp_data << 2;
-    ctx->jtag.dr_captured |= (uint64_t)ctx->sig.dmi_rsp_resp & 0x3;
+    if (ctx->native_outstanding) {
+      if (!ctx->native_discard) {
+        queue_native_rsp(ctx);
+      }
+      ctx->native_outstanding = false;
+    } else {
+      ctx->jtag.dr_captured = (uint64_t)ctx->sig.dmi_rsp_data << 2;
+      ctx->jtag.dr_captured |= (uint64_t)ctx->sig.dmi_rsp_resp & 0x3;
+    }
     // Clear req outstanding flag
     ctx->jtag.dmi_outstanding = 0;
   }
@@ -362,19 +565,34 @@ static void update_dmi_state(struct dmidpi_ctx *ctx) {
     return;
   }
 
+  // Transactions from the native transport don't need any JTAG emulation.
+  // Once there are none left to run, the client is waiting for responses.
+  if (issue_native_req(ctx)) {
+    return;
+  }
+  if (ctx->native_sock) {
+    flush_native_rsp(ctx);
+  }
+
+  // Process command bytes until a command completes. The responses to any
+  // reads along the way are sent together at the end.
   char done = 0;
   while (!done) {
-    // read a command byte
-    char cmd;
-    if (!tcp_server_read(ctx->sock, &cmd)) {
-      return;
+    if (ctx->cmd_pos == ctx->cmd_len) {
+      ctx->cmd_pos = 0;
+      ctx->cmd_len =
+          tcp_server_read_buf(ctx->sock, ctx->cmd_buf, sizeof(ctx->cmd_buf));
+      if (!ctx->cmd_len) {
+        break;
+      }
     }
-    // Process command bytes until a command completes
-    done = process_cmd_byte(ctx, cmd);
+    done = process_cmd_byte(ctx, ctx->cmd_buf[ctx->cmd_pos++]);
   }
+  flush_resp(ctx);
 }
 
-void *dmidpi_create(const char *display_name, int listen_port) {
+void *dmidpi_create(const char *display_name, int listen_port,
+                    int native_port) {
   // Create context
   struct dmidpi_ctx *ctx =
       (struct dmidpi_ctx *)calloc(1, sizeof(struct dmidpi_ctx));
@@ -392,6 +610,20 @@ void *dmidpi_create(const char *display_name, int listen_port) {
       "  remote_bitbang_port %d\n",
       display_name, listen_port, listen_port);
 
+  if (native_port) {
+    char *native_name = (char *)malloc(strlen(display_name) + 8);
+    assert(native_name);
+    sprintf(native_name, "%s native", display_name);
+    ctx->native_sock = tcp_server_create(native_name, native_port);
+    free(native_name);
+    printf(
+        "DMI: Native DMI transport for %s is listening on port %d. Use\n"
+        "hw/dv/dpi/dmidpi/dmi_native.py to connect.\n",
+        display_name, native_port);
+  }
+
+  dpi_checkpoint_register(display_name, ctx, &dmidpi_checkpoint_ops);
+
   return (void *)ctx;
 }
 
@@ -401,8 +633,13 @@ void dmidpi_close(void *ctx_void) {
     return;
   }
 
-  // Shut down the server
+  dpi_checkpoint_unregister(ctx);
+
+  // Shut down the servers
   tcp_server_close(ctx->sock);
+  if (ctx->native_sock) {
+    tcp_server_close(ctx->native_sock);
+  }
 
   free(ctx);
 }
@@ -18,9 +18,13 @@ extern "C" {
  *
  * @param display_name Name of the interface (for display purposes only)
  * @param listen_port Port to listen on
+ * @param native_port Port to listen on for the native DMI transport, which
+ *                    carries DMI transactions without JTAG emulation (0 to
+ *                    disable it)
  * @return an initialized struct dmidpi_ctx context object
  */
-void *dmidpi_create(const char *display_name, int listen_port);
+void *dmidpi_create(const char *display_name, int listen_port,
+                    int native_port);
 
 /**
  * Destructor: Close all connections and free all resources
@@ -46,6 +50,15 @@ void dmidpi_tick(void *ctx_void, svBit *dmi_req_valid,
                  const svBitVecVal *dmi_resp_data,
                  const svBitVecVal *dmi_resp_resp, svBit *dmi_reset_n);
 
+/**
+ * Point the chandle of the dmidpi module in the current scope at ctx_void
+ *
+ * Exported from dmidpi.sv and called when restoring a simulation checkpoint.
+ *
+ * @param ctx_void  a struct dmidpi_ctx context object
+ */
+void dmidpi_set_ctx(void *ctx_void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -4,7 +4,10 @@
 
 module dmidpi #(
   parameter string Name = "dmi0", // name of the interface (display only)
-  parameter int ListenPort = 44853 // TCP port to listen on
+  parameter int ListenPort = 44853, // TCP port to listen on
+  // TCP port for the native DMI transport (0 to disable it). This can be
+  // overridden at runtime with +dmidpi_native_port=PORT.
+  parameter int NativePort = 0
 )(
   input  bit        clk_i,
   input  bit        rst_ni,
@@ -21,8 +24,9 @@ module dmidpi #(
   output bit        dmi_rst_n
 );
 
-  import "DPI-C"
-  function chandle dmidpi_create(input string name, input int listen_port);
+  import "DPI-C" context
+  function chandle dmidpi_create(input string name, input int listen_port,
+                                 input int native_port);
 
   import "DPI-C"
   function void dmidpi_tick(input chandle ctx, output bit dmi_req_valid,
@@ -37,8 +41,21 @@ module dmidpi #(
 
   chandle ctx;
 
+  // Called when restoring a simulation checkpoint, to replace the restored
+  // chandle with the context created by this process.
+  export "DPI-C" function dmidpi_set_ctx;
+
+  function void dmidpi_set_ctx(chandle new_ctx);
+    ctx = new_ctx;
+  endfunction
+
   initial begin
-    ctx = dmidpi_create(Name, ListenPort);
+    int native_port;
+
+    native_port = NativePort;
+    void'($value$plusargs("dmidpi_native_port=%0d", native_port));
+
+    ctx = dmidpi_create(Name, ListenPort, native_port);
   end
 
   final begin
@@ -23,8 +23,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
-// The number of ticks of host_to_device_tick between making syscalls.
-#define TICKS_PER_SYSCALL 2048
+#include "dpi_checkpoint.h"
+#include "dpi_io.h"
 
 // This module currently is capable of implementing 32 GPIOs.
 #define NUM_GPIO 32
@@ -35,6 +35,10 @@
 #define SET_BIT(word, bit_idx) ((word) |= (1 << (bit_idx)))
 #define CLR_BIT(word, bit_idx) ((word) &= ~(1 << (bit_idx)))
 
+// Sizes of the records used in binary mode (see gpiodpi.h).
+#define BIN_D2H_SIZE 20
+#define BIN_H2D_SIZE 20
+
 struct gpiodpi_ctx {
   // The number of pins we're driving.
   int n_bits;
@@ -43,9 +47,11 @@ struct gpiodpi_ctx {
   uint32_t driven_pin_values;
   // Whether or not the pin is being driven weakly or strongly.
   uint32_t weak_pins;
-  // A counter of calls into the host_to_device_tick function; used to
-  // avoid excessive `read` syscalls to the pipe fd.
+  // A counter of calls into the host_to_device_tick function. In binary mode,
+  // this is the cycle number used in timestamps.
   uint32_t counter;
+  // The upper half of the 64-bit cycle number (only used in binary mode).
+  uint32_t counter_hi;
 
   // File descriptors and paths for the device-to-host and host-to-device
   // FIFOs.
@@ -53,8 +59,79 @@ struct gpiodpi_ctx {
   char dev_to_host_path[PATH_MAX];
   int host_to_dev_fifo;
   char host_to_dev_path[PATH_MAX];
+  // Buffered I/O channels on the FIFOs. Reads and writes are done by the
+  // shared I/O thread, so ticking doesn't need any syscalls.
+  struct dpi_io_chan *dev_to_host_chan;
+  struct dpi_io_chan *host_to_dev_chan;
+
+  // Whether we're using the binary protocol rather than text.
+  bool binary;
+  // The pin state in the last record sent to the host (binary mode).
+  uint32_t last_d2p_data;
+  uint32_t last_d2p_oe;
+  // A partially-received (or not yet due) host command (binary mode).
+  uint8_t h2d_cmd[BIN_H2D_SIZE];
+  size_t h2d_cmd_len;
 };
 
+/**
+ * The part of the GPIO state that is saved in a simulation checkpoint. The
+ * FIFOs belong to the process that opened them, so a restored simulation
+ * keeps its own.
+ */
+struct gpiodpi_checkpoint {
+  int n_bits;
+  uint32_t driven_pin_values;
+  uint32_t weak_pins;
+  uint32_t counter;
+  uint32_t counter_hi;
+  uint32_t last_d2p_data;
+  uint32_t last_d2p_oe;
+};
+
+static size_t gpiodpi_checkpoint_save(void *ctx_void, void *buf,
+                                      size_t buf_len) {
+  struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
+  struct gpiodpi_checkpoint state;
+  memset(&state, 0, sizeof(state));
+  state.n_bits = ctx->n_bits;
+  state.driven_pin_values = ctx->driven_pin_values;
+  state.weak_pins = ctx->weak_pins;
+  state.counter = ctx->counter;
+  state.counter_hi = ctx->counter_hi;
+  state.last_d2p_data = ctx->last_d2p_data;
+  state.last_d2p_oe = ctx->last_d2p_oe;
+  if (buf_len >= sizeof(state)) {
+    memcpy(buf, &state, sizeof(state));
+  }
+  return sizeof(state);
+}
+
+static bool gpiodpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                       size_t len) {
+  struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
+  struct gpiodpi_checkpoint state;
+  if (len != sizeof(state)) {
+    return false;
+  }
+  memcpy(&state, buf, sizeof(state));
+  if (state.n_bits != ctx->n_bits) {
+    return false;
+  }
+  ctx->driven_pin_values = state.driven_pin_values;
+  ctx->weak_pins = state.weak_pins;
+  ctx->counter = state.counter;
+  ctx->counter_hi = state.counter_hi;
+  ctx->last_d2p_data = state.last_d2p_data;
+  ctx->last_d2p_oe = state.last_d2p_oe;
+  // Any half-received command came from the old process's FIFO.
+  ctx->h2d_cmd_len = 0;
+  return true;
+}
+
+static const struct dpi_checkpoint_ops gpiodpi_checkpoint_ops = {
+    gpiodpi_checkpoint_save, gpiodpi_checkpoint_restore, gpiodpi_set_ctx};
+
 /**
  * Creates a new UNIX FIFO file at |path_buf|, and opens it with |flags|.
  *
@@ -91,12 +168,17 @@ static int open_fifo(char *path_buf, int flags) {
  * @arg wfifo the path to the "write" side (w.r.t the host).
  * @arg n_bits the number of pins supported.
  */
-static void print_usage(char *rfifo, char *wfifo, int n_bits) {
+static void print_usage(char *rfifo, char *wfifo, int n_bits, bool binary) {
   printf("\n");
   printf(
       "GPIO: FIFO pipes created at %s (read) and %s (write) for %d-bit wide "
       "GPIO.\n",
       rfifo, wfifo, n_bits);
+  if (binary) {
+    printf(
+        "GPIO: Using the binary protocol (see hw/dv/dpi/gpiodpi/README.md).\n");
+    return;
+  }
   printf(
       "GPIO: To measure the values of the pins as driven by the device, run\n");
   printf("$ cat %s  # '0' low, '1' high, 'X' floating\n", rfifo);
@@ -107,7 +189,7 @@ static void print_usage(char *rfifo, char *wfifo, int n_bits) {
          wfifo);
 }
 
-void *gpiodpi_create(const char *name, int n_bits) {
+void *gpiodpi_create(const char *name, int n_bits, int binary) {
   struct gpiodpi_ctx *ctx =
       (struct gpiodpi_ctx *)malloc(sizeof(struct gpiodpi_ctx));
   assert(ctx);
@@ -120,6 +202,11 @@ void *gpiodpi_create(const char *name, int n_bits) {
   ctx->driven_pin_values = 0;
   ctx->weak_pins = 0;
   ctx->counter = 0;
+  ctx->counter_hi = 0;
+  ctx->binary = binary != 0;
+  ctx->last_d2p_data = 0;
+  ctx->last_d2p_oe = 0;
+  ctx->h2d_cmd_len = 0;
 
   char cwd_buf[PATH_MAX];
   char *cwd = getcwd(cwd_buf, sizeof(cwd_buf));
@@ -142,19 +229,78 @@ void *gpiodpi_create(const char *name, int n_bits) {
     return NULL;
   }
 
-  int flags = fcntl(ctx->host_to_dev_fifo, F_GETFL, 0);
-  fcntl(ctx->host_to_dev_fifo, F_SETFL, flags | O_NONBLOCK);
+  ctx->dev_to_host_chan =
+      dpi_io_chan_open(ctx->dev_to_host_fifo, DPI_IO_WRITE, "GPIO");
+  ctx->host_to_dev_chan =
+      dpi_io_chan_open(ctx->host_to_dev_fifo, DPI_IO_READ, "GPIO");
+  if (!ctx->dev_to_host_chan || !ctx->host_to_dev_chan) {
+    return NULL;
+  }
+
+  print_usage(ctx->dev_to_host_path, ctx->host_to_dev_path, ctx->n_bits,
+              ctx->binary);
 
-  print_usage(ctx->dev_to_host_path, ctx->host_to_dev_path, ctx->n_bits);
+  dpi_checkpoint_register(name, ctx, &gpiodpi_checkpoint_ops);
 
   return (void *)ctx;
 }
 
+static void put_le32(uint8_t *buf, uint32_t val) {
+  for (int i = 0; i < 4; ++i) {
+    buf[i] = (val >> (8 * i)) & 0xff;
+  }
+}
+
+static uint32_t get_le32(const uint8_t *buf) {
+  uint32_t val = 0;
+  for (int i = 0; i < 4; ++i) {
+    val |= (uint32_t)buf[i] << (8 * i);
+  }
+  return val;
+}
+
+static uint64_t get_cycle(const struct gpiodpi_ctx *ctx) {
+  return ((uint64_t)ctx->counter_hi << 32) | ctx->counter;
+}
+
+/**
+ * Send the pin state to the host as a binary record.
+ */
+static void device_to_host_binary(struct gpiodpi_ctx *ctx, uint32_t data,
+                                  uint32_t oe) {
+  uint32_t pin_mask =
+      ctx->n_bits == 32 ? 0xffffffffu : ((1u << ctx->n_bits) - 1);
+  oe &= pin_mask;
+  data &= oe;
+
+  uint32_t changed = ((data ^ ctx->last_d2p_data) | (oe ^ ctx->last_d2p_oe));
+
+  uint8_t rec[BIN_D2H_SIZE];
+  uint64_t cycle = get_cycle(ctx);
+  put_le32(&rec[0], (uint32_t)cycle);
+  put_le32(&rec[4], (uint32_t)(cycle >> 32));
+  put_le32(&rec[8], data);
+  put_le32(&rec[12], oe);
+  put_le32(&rec[16], changed);
+  // A record is sent whole or not at all, so the host stream stays aligned.
+  // If it is dropped, the next record reports changes relative to the last
+  // one the host actually got.
+  if (dpi_io_chan_write_all(ctx->dev_to_host_chan, rec, sizeof(rec))) {
+    ctx->last_d2p_data = data;
+    ctx->last_d2p_oe = oe;
+  }
+}
+
 void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
                             svBitVecVal *gpio_oe) {
   struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
   assert(ctx);
 
+  if (ctx->binary) {
+    device_to_host_binary(ctx, gpio_data[0], gpio_oe[0]);
+    return;
+  }
+
   // Write 0, 1, or X (when oe is not set) for each GPIO pin, in big endian
   // order (i.e., pin 0 is the last character written). Finish it with a
   // newline.
@@ -171,8 +317,7 @@ void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
   }
   *pin_char = '\n';
 
-  ssize_t written = write(ctx->dev_to_host_fifo, gpio_str, ctx->n_bits + 1);
-  assert(written == ctx->n_bits + 1);
+  dpi_io_chan_write_all(ctx->dev_to_host_chan, gpio_str, ctx->n_bits + 1);
 }
 
 /**
@@ -211,16 +356,48 @@ static void set_bit_val(uint32_t *word, uint32_t idx, bool val) {
   }
 }
 
+/**
+ * Apply any binary host commands that are due by the current cycle.
+ */
+static void host_to_device_binary(struct gpiodpi_ctx *ctx) {
+  while (true) {
+    if (ctx->h2d_cmd_len < BIN_H2D_SIZE) {
+      ctx->h2d_cmd_len += dpi_io_chan_read(
+          ctx->host_to_dev_chan, &ctx->h2d_cmd[ctx->h2d_cmd_len],
+          BIN_H2D_SIZE - ctx->h2d_cmd_len);
+      if (ctx->h2d_cmd_len < BIN_H2D_SIZE) {
+        return;
+      }
+    }
+
+    uint64_t cycle = ((uint64_t)get_le32(&ctx->h2d_cmd[4]) << 32) |
+                     get_le32(&ctx->h2d_cmd[0]);
+    if (cycle > get_cycle(ctx)) {
+      // Not due yet: keep it until it is.
+      return;
+    }
+
+    uint32_t mask = get_le32(&ctx->h2d_cmd[8]);
+    uint32_t value = get_le32(&ctx->h2d_cmd[12]);
+    uint32_t weak = get_le32(&ctx->h2d_cmd[16]);
+    ctx->driven_pin_values = (ctx->driven_pin_values & ~mask) | (value & mask);
+    ctx->weak_pins = (ctx->weak_pins & ~mask) | (weak & mask);
+    ctx->h2d_cmd_len = 0;
+  }
+}
+
 uint32_t gpiodpi_host_to_device_tick(void *ctx_void, svBitVecVal *gpio_oe,
                                      svBitVecVal *gpio_pull_en,
                                      svBitVecVal *gpio_pull_sel) {
   struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
   assert(ctx);
 
-  if (ctx->counter % TICKS_PER_SYSCALL == 0) {
+  if (ctx->binary) {
+    host_to_device_binary(ctx);
+  } else if (dpi_io_chan_readable(ctx->host_to_dev_chan)) {
     char gpio_str[256];
-    ssize_t read_len =
-        read(ctx->host_to_dev_fifo, gpio_str, sizeof(gpio_str) - 1);
+    size_t read_len = dpi_io_chan_read(ctx->host_to_dev_chan, gpio_str,
+                                       sizeof(gpio_str) - 1);
     if (read_len > 0) {
       gpio_str[read_len] = '\0';
 
@@ -284,6 +461,9 @@ uint32_t gpiodpi_host_to_device_tick(void *ctx_void, svBitVecVal *gpio_oe,
 
 parse_loop_end:
   ctx->counter += 1;
+  if (ctx->counter == 0) {
+    ctx->counter_hi += 1;
+  }
   // The verilated module simulates logic, but the weak/strong inputs result
   // from the properties of the IO pads and the selection of external pull
   // resistors. Since the verilated model doesn't model the analog properties
@@ -305,6 +485,11 @@ void gpiodpi_close(void *ctx_void) {
     return;
   }
 
+  dpi_checkpoint_unregister(ctx);
+
+  dpi_io_chan_close(ctx->dev_to_host_chan);
+  dpi_io_chan_close(ctx->host_to_dev_chan);
+
   if (close(ctx->dev_to_host_fifo) != 0) {
     printf("GPIO: Failed to close FIFO file at %s: %s\n", ctx->dev_to_host_path,
            strerror(errno));
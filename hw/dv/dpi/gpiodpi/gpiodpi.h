@@ -17,12 +17,22 @@ extern "C" {
  * @param name a name to use when creating the inner FIFO.
  * @param n_bits number of bits to write in each direction; this must be at
  *        most 32 bits.
+ * @param binary if non-zero, use the binary protocol described below rather
+ *        than text.
  */
-void *gpiodpi_create(const char *name, int n_bits);
+void *gpiodpi_create(const char *name, int n_bits, int binary);
 
 /**
  * Attempt to post the current GPIO state to the outside world.
  *
+ * In text mode, this writes a line with a character for each pin ('0', '1'
+ * or 'X' if the device isn't driving it), starting with the highest pin.
+ *
+ * In binary mode, this writes a 20-byte record of five little-endian 32-bit
+ * words: the cycle number (low word, then high word), the pin values, the
+ * pins the device is driving and a mask of the pins that changed (in value or
+ * in whether they're driven) since the last record.
+ *
  * Intended to be called from SystemVerilog.
  */
 void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
@@ -37,6 +47,12 @@ void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
  * does the opposite. All other pins at left in an unspecified state. Invalid
  * commands are ignored.
  *
+ * In binary mode, each command is a 20-byte record of five little-endian
+ * 32-bit words: the cycle number at which to apply it (low word, then high
+ * word; a cycle that has passed means "now"), a mask of pins to update, their
+ * new values and whether each of them should be driven weakly. Commands are
+ * applied in order, so a host can queue up a timed pattern in advance.
+ *
  * Intended to be called from SystemVerilog.
  * @return the values to pull the GPIO pins to.
  */
@@ -49,6 +65,12 @@ uint32_t gpiodpi_host_to_device_tick(void *ctx_void, svBitVecVal *gpio_oe,
  */
 void gpiodpi_close(void *ctx_void);
 
+/**
+ * Exported from gpiodpi.sv. Points the chandle of the module in the current
+ * scope at ctx_void (used when restoring a simulation checkpoint).
+ */
+void gpiodpi_set_ctx(void *ctx_void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
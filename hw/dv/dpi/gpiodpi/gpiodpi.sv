@@ -17,8 +17,8 @@ module gpiodpi
   input  logic [N_GPIO-1:0] gpio_pull_en,
   input  logic [N_GPIO-1:0] gpio_pull_sel
 );
-   import "DPI-C" function
-     chandle gpiodpi_create(input string name, input int n_bits);
+   import "DPI-C" context function
+     chandle gpiodpi_create(input string name, input int n_bits, input int binary);
 
    import "DPI-C" function
      void gpiodpi_device_to_host(input chandle ctx, input logic [N_GPIO-1:0] gpio_d2p,
@@ -35,9 +35,24 @@ module gpiodpi
 
    chandle ctx;
 
+   // Called when restoring a simulation checkpoint, to replace the restored
+   // chandle with the context created by this process.
+   export "DPI-C" function gpiodpi_set_ctx;
+
+   function void gpiodpi_set_ctx(chandle new_ctx);
+     ctx = new_ctx;
+   endfunction
+
    function automatic void initialize();
+     int binary;
+
+     // Use the binary protocol (packed pin state with timestamps) rather than
+     // text if +gpiodpi_binary=1 is given
+     binary = 0;
+     void'($value$plusargs("gpiodpi_binary=%0d", binary));
+
      $display($time, "GPIO: creating gpiodpi");
-     ctx = gpiodpi_create(NAME, N_GPIO);
+     ctx = gpiodpi_create(NAME, N_GPIO, binary);
    endfunction
 
    // Allow being activated past initial time.
@@ -10,8 +10,26 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dpi_checkpoint.h"
 #include "tcp_server.h"
 
+// Kinds of decoded remote_bitbang commands, for batch mode
+enum jtagdpi_op_kind {
+  kJtagdpiOpWrite,  // bits = TCK/TMS/TDI, as for the '0'-'7' commands
+  kJtagdpiOpReset,  // bits = TRST/SRST, as for the 'r'-'u' commands
+  kJtagdpiOpRead,
+  kJtagdpiOpQuit,
+};
+
+struct jtagdpi_op {
+  uint8_t kind;
+  uint8_t bits;
+};
+
+// Must be a power of two
+#define OP_QUEUE_SIZE 1024
+#define RESP_BUF_SIZE 256
+
 struct jtagdpi_ctx {
   // Server context
   struct tcp_server_ctx *sock;
@@ -22,35 +40,108 @@ struct jtagdpi_ctx {
   uint8_t tdo;
   uint8_t trst_n;
   uint8_t srst_n;
-  // Lookahead buffer - non-zero if valid
-  char cmd;
+  // Commands received from the client but not processed yet
+  char cmd_buf[256];
+  size_t cmd_pos;
+  size_t cmd_len;
+  // In batch mode, commands are decoded as soon as they arrive and queued
+  // here, and the responses to reads are collected in resp_buf and sent
+  // together once the client has to wait for them.
+  bool batch;
+  struct jtagdpi_op ops[OP_QUEUE_SIZE];
+  unsigned int op_head;
+  unsigned int op_tail;
+  char resp_buf[RESP_BUF_SIZE];
+  size_t resp_len;
 };
 
-static bool lookahead(struct jtagdpi_ctx *ctx) {
-  // Look at the next command if available. Return true if it's an
-  // 'R', otherwise buffer it to return via get_cmd().
-  char cmd;
-  if (!tcp_server_read(ctx->sock, &cmd)) {
+// The part of the JTAG state that is saved in a simulation checkpoint. The
+// command buffer isn't saved: it holds data from a client connection, which
+// doesn't survive into the restored simulation.
+struct jtagdpi_checkpoint {
+  uint8_t tck;
+  uint8_t tms;
+  uint8_t tdi;
+  uint8_t tdo;
+  uint8_t trst_n;
+  uint8_t srst_n;
+};
+
+static size_t jtagdpi_checkpoint_save(void *ctx_void, void *buf,
+                                      size_t buf_len) {
+  struct jtagdpi_ctx *ctx = (struct jtagdpi_ctx *)ctx_void;
+  struct jtagdpi_checkpoint state;
+  state.tck = ctx->tck;
+  state.tms = ctx->tms;
+  state.tdi = ctx->tdi;
+  state.tdo = ctx->tdo;
+  state.trst_n = ctx->trst_n;
+  state.srst_n = ctx->srst_n;
+  if (buf_len >= sizeof(state)) {
+    memcpy(buf, &state, sizeof(state));
+  }
+  return sizeof(state);
+}
+
+static bool jtagdpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                       size_t len) {
+  struct jtagdpi_ctx *ctx = (struct jtagdpi_ctx *)ctx_void;
+  struct jtagdpi_checkpoint state;
+  if (len != sizeof(state)) {
     return false;
   }
-  if (cmd == 'R') {
-    return true;
-  } else {
-    ctx->cmd = cmd;
+  memcpy(&state, buf, sizeof(state));
+  ctx->tck = state.tck;
+  ctx->tms = state.tms;
+  ctx->tdi = state.tdi;
+  ctx->tdo = state.tdo;
+  ctx->trst_n = state.trst_n;
+  ctx->srst_n = state.srst_n;
+  ctx->cmd_pos = 0;
+  ctx->cmd_len = 0;
+  ctx->op_head = 0;
+  ctx->op_tail = 0;
+  ctx->resp_len = 0;
+  return true;
+}
+
+static const struct dpi_checkpoint_ops jtagdpi_checkpoint_ops = {
+    jtagdpi_checkpoint_save, jtagdpi_checkpoint_restore, jtagdpi_set_ctx};
+
+static bool fill_cmd_buf(struct jtagdpi_ctx *ctx) {
+  // Make sure there's at least one command in the buffer, pulling as many as
+  // are available from the socket in one go if it's empty.
+  if (ctx->cmd_pos == ctx->cmd_len) {
+    ctx->cmd_pos = 0;
+    ctx->cmd_len =
+        tcp_server_read_buf(ctx->sock, ctx->cmd_buf, sizeof(ctx->cmd_buf));
+  }
+  return ctx->cmd_pos < ctx->cmd_len;
+}
+
+static bool lookahead(struct jtagdpi_ctx *ctx) {
+  // Look at the next command if available. Return true (and consume it) if
+  // it's an 'R', otherwise leave it to return via get_cmd().
+  if (!fill_cmd_buf(ctx) || ctx->cmd_buf[ctx->cmd_pos] != 'R') {
     return false;
   }
+  ctx->cmd_pos++;
+  return true;
 }
 
 static bool get_cmd(struct jtagdpi_ctx *ctx, char *cmd) {
-  // Return a buffered command if available, or try to pull one from
-  // the socket.
-  if (ctx->cmd) {
-    *cmd = ctx->cmd;
-    ctx->cmd = 0;
-    return true;
-  } else {
-    return tcp_server_read(ctx->sock, cmd);
+  if (!fill_cmd_buf(ctx)) {
+    return false;
   }
+  *cmd = ctx->cmd_buf[ctx->cmd_pos++];
+  return true;
+}
+
+static void protocol_violation(char cmd) {
+  fprintf(stderr,
+          "JTAG DPI Protocol violation detected: unsupported command %c\n",
+          cmd);
+  exit(1);
 }
 
 /**
@@ -123,10 +214,7 @@ static void update_jtag_signals(struct jtagdpi_ctx *ctx) {
     // quit (client disconnect)
     act_quit = true;
   } else {
-    fprintf(stderr,
-            "JTAG DPI Protocol violation detected: unsupported command %c\n",
-            cmd);
-    exit(1);
+    protocol_violation(cmd);
   }
 
   // send tdo as response
@@ -141,8 +229,105 @@ static void update_jtag_signals(struct jtagdpi_ctx *ctx) {
   }
 }
 
+/**
+ * Decode as many received commands as fit into the op queue (batch mode)
+ */
+static void decode_cmds(struct jtagdpi_ctx *ctx) {
+  while (ctx->op_head - ctx->op_tail < OP_QUEUE_SIZE && fill_cmd_buf(ctx)) {
+    char cmd = ctx->cmd_buf[ctx->cmd_pos++];
+    struct jtagdpi_op op;
+    if (cmd >= '0' && cmd <= '7') {
+      op.kind = kJtagdpiOpWrite;
+      op.bits = cmd - '0';
+    } else if (cmd >= 'r' && cmd <= 'u') {
+      op.kind = kJtagdpiOpReset;
+      op.bits = cmd - 'r';
+    } else if (cmd == 'R') {
+      op.kind = kJtagdpiOpRead;
+      op.bits = 0;
+    } else if (cmd == 'Q') {
+      op.kind = kJtagdpiOpQuit;
+      op.bits = 0;
+    } else if (cmd == 'B' || cmd == 'b') {
+      continue;
+    } else {
+      protocol_violation(cmd);
+    }
+    ctx->ops[ctx->op_head++ & (OP_QUEUE_SIZE - 1)] = op;
+  }
+}
+
+static void flush_resp(struct jtagdpi_ctx *ctx) {
+  if (ctx->resp_len) {
+    tcp_server_write_buf(ctx->sock, ctx->resp_buf, ctx->resp_len);
+    ctx->resp_len = 0;
+  }
+}
+
+/**
+ * Update the JTAG signals from the op queue (batch mode)
+ *
+ * As in update_jtag_signals(), at most one change is made to the JTAG signals
+ * per call, but any number of reads are answered: those before the change
+ * (with the TDO value sampled this cycle) and, if the change is a rising edge
+ * of TCK, those straight after it (TDO only changes on the falling edge).
+ */
+static void update_jtag_signals_batch(struct jtagdpi_ctx *ctx) {
+  assert(ctx);
+
+  decode_cmds(ctx);
+
+  bool can_read = true;
+  bool changed = false;
+  while (ctx->op_tail != ctx->op_head) {
+    struct jtagdpi_op op = ctx->ops[ctx->op_tail & (OP_QUEUE_SIZE - 1)];
+    if (op.kind == kJtagdpiOpRead) {
+      if (!can_read) {
+        break;
+      }
+      if (ctx->resp_len == sizeof(ctx->resp_buf)) {
+        flush_resp(ctx);
+      }
+      ctx->resp_buf[ctx->resp_len++] = ctx->tdo + '0';
+      ctx->op_tail++;
+      continue;
+    }
+    if (changed) {
+      break;
+    }
+    ctx->op_tail++;
+    changed = true;
+
+    if (op.kind == kJtagdpiOpWrite) {
+      uint8_t tck = ctx->tck;
+      ctx->tdi = (op.bits >> 0) & 0x1;
+      ctx->tms = (op.bits >> 1) & 0x1;
+      ctx->tck = (op.bits >> 2) & 0x1;
+      can_read = !tck && ctx->tck;
+    } else if (op.kind == kJtagdpiOpReset) {
+      ctx->srst_n = !((op.bits >> 0) & 0x1);
+      ctx->trst_n = !((op.bits >> 1) & 0x1);
+      can_read = false;
+    } else {
+      // quit (client disconnect). Anything after this is from the old
+      // connection.
+      flush_resp(ctx);
+      printf("JTAG DPI: Remote disconnected.\n");
+      tcp_server_client_close(ctx->sock);
+      ctx->op_head = ctx->op_tail = 0;
+      ctx->cmd_pos = ctx->cmd_len = 0;
+      return;
+    }
+  }
+
+  // If we've run out of commands, the client is waiting for the responses.
+  if (ctx->op_tail == ctx->op_head) {
+    flush_resp(ctx);
+  }
+}
+
 void *jtagdpi_create(const char *display_name, int listen_port,
-                     int assert_srst) {
+                     int assert_srst, int batch) {
   struct jtagdpi_ctx *ctx =
       (struct jtagdpi_ctx *)calloc(1, sizeof(struct jtagdpi_ctx));
   assert(ctx);
@@ -151,6 +336,7 @@ void *jtagdpi_create(const char *display_name, int listen_port,
   ctx->sock = tcp_server_create(display_name, listen_port);
 
   reset_jtag_signals(ctx, assert_srst != 0);
+  ctx->batch = batch != 0;
 
   printf(
       "\n"
@@ -160,6 +346,11 @@ void *jtagdpi_create(const char *display_name, int listen_port,
       "  remote_bitbang host localhost\n"
       "  remote_bitbang port %d\n",
       display_name, listen_port, listen_port);
+  if (ctx->batch) {
+    printf("JTAG: Batched command processing enabled.\n");
+  }
+
+  dpi_checkpoint_register(display_name, ctx, &jtagdpi_checkpoint_ops);
 
   return (void *)ctx;
 }
@@ -169,6 +360,7 @@ void jtagdpi_close(void *ctx_void) {
   if (!ctx) {
     return;
   }
+  dpi_checkpoint_unregister(ctx);
   tcp_server_close(ctx->sock);
   free(ctx);
 }
@@ -181,7 +373,11 @@ void jtagdpi_tick(void *ctx_void, svBit *tck, svBit *tms, svBit *tdi,
   }
 
   ctx->tdo = tdo;
-  update_jtag_signals(ctx);
+  if (ctx->batch) {
+    update_jtag_signals_batch(ctx);
+  } else {
+    update_jtag_signals(ctx);
+  }
   *tdi = ctx->tdi;
   *tms = ctx->tms;
   *tck = ctx->tck;
@@ -20,10 +20,14 @@ struct jtagdpi_ctx;
  *
  * @param display_name Name of the JTAG interface (for display purposes only)
  * @param listen_port Port to listen on
+ * @param assert_srst Start with the system reset asserted if non-zero
+ * @param batch Process commands in batches if non-zero: decode everything
+ *              the client has sent up front and send the responses to reads
+ *              together, rather than handling one command per tick
  * @return an initialized struct jtagdpi_ctx context object
  */
 void *jtagdpi_create(const char *display_name, int listen_port,
-                     int assert_srst);
+                     int assert_srst, int batch);
 
 /**
  * Destructor: Close all connections and free all resources
@@ -51,6 +55,15 @@ void jtagdpi_close(void *ctx_void);
 void jtagdpi_tick(void *ctx_void, svBit *tck, svBit *tms, svBit *tdi,
                   svBit *trst_n, svBit *srst_n, const svBit tdo);
 
+/**
+ * Point the chandle of the jtagdpi module in the current scope at ctx_void
+ *
+ * Exported from jtagdpi.sv and called when restoring a simulation checkpoint.
+ *
+ * @param ctx_void  a struct jtagdpi_ctx context object
+ */
+void jtagdpi_set_ctx(void *ctx_void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -18,9 +18,9 @@ module jtagdpi #(
   output logic jtag_srst_n
 );
 
-  import "DPI-C"
+  import "DPI-C" context
   function chandle jtagdpi_create(input string name, input int listen_port,
-                                  input int assert_srst);
+                                  input int assert_srst, input int batch);
 
   import "DPI-C"
   function void jtagdpi_tick(input chandle ctx, output bit tck, output bit tms,
@@ -32,8 +32,16 @@ module jtagdpi #(
 
   chandle ctx;
 
+  // Called when restoring a simulation checkpoint, to replace the restored
+  // chandle with the context created by this process.
+  export "DPI-C" function jtagdpi_set_ctx;
+
+  function void jtagdpi_set_ctx(chandle new_ctx);
+    ctx = new_ctx;
+  endfunction
+
   function automatic void initialize();
-    int port, assert_srst;
+    int port, assert_srst, batch;
 
     assert (ctx == null);
 
@@ -45,7 +53,12 @@ module jtagdpi #(
     assert_srst = 0;
     void'($value$plusargs("jtagdpi_assert_srst=%0d", assert_srst));
 
-    ctx = jtagdpi_create(Name, port, assert_srst);
+    // Commands from the client can be decoded and answered in batches, which
+    // is much faster for long scans
+    batch = 0;
+    void'($value$plusargs("jtagdpi_batch=%0d", batch));
+
+    ctx = jtagdpi_create(Name, port, assert_srst, batch);
   endfunction
 
   initial begin
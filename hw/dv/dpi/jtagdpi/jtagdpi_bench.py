@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors (OpenTitan project).
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+'''Measure the JTAG throughput of a simulation with a jtagdpi module
+
+This connects to the jtagdpi server in a running simulation, in the same way
+as OpenOCD's remote_bitbang driver, and pushes a fixed number of data register
+scans through it. Each scan goes from Run-Test/Idle to Shift-DR, shifts the
+requested number of bits (sampling TDO for each one) and goes back to
+Run-Test/Idle. Like OpenOCD, the commands for a whole scan are sent before
+waiting for the responses.
+
+Run it once with the simulation started with +jtagdpi_batch=0 and once with
++jtagdpi_batch=1 to compare byte-wise and batched command processing, e.g.
+
+    jtagdpi_bench.py --port=44853 --scans=1000 --bits=64
+
+'''
+
+import argparse
+import socket
+import sys
+import time
+from typing import Tuple
+
+
+def clock(tms: int, tdi: int, sample: bool) -> bytes:
+    '''Commands for one TCK cycle, sampling TDO while TCK is low'''
+    low = bytes([ord('0') + (tms << 1) + tdi])
+    high = bytes([ord('4') + (tms << 1) + tdi])
+    return low + (b'R' if sample else b'') + high
+
+
+def scan_cmds(num_bits: int, pattern: int) -> Tuple[bytes, int]:
+    '''Commands for one DR scan and the number of responses they produce'''
+    # Run-Test/Idle -> Select-DR-Scan -> Capture-DR -> Shift-DR
+    cmds = clock(1, 0, False) + clock(0, 0, False) + clock(0, 0, False)
+    for bit in range(num_bits):
+        # The last bit is shifted on the way out to Exit1-DR
+        tms = 1 if bit == num_bits - 1 else 0
+        cmds += clock(tms, (pattern >> (bit % 32)) & 1, True)
+    # Exit1-DR -> Update-DR -> Run-Test/Idle
+    cmds += clock(1, 0, False) + clock(0, 0, False)
+    return (cmds, num_bits)
+
+
+def reset_cmds() -> bytes:
+    '''Commands to go to Test-Logic-Reset and then Run-Test/Idle'''
+    cmds = b''.join(clock(1, 0, False) for _ in range(5))
+    return cmds + clock(0, 0, False)
+
+
+def recv_exactly(sock: socket.socket, length: int) -> bytes:
+    data = b''
+    while len(data) < length:
+        chunk = sock.recv(length - len(data))
+        if not chunk:
+            raise ConnectionError('Simulation closed the connection.')
+        data += chunk
+    return data
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--host', default='localhost',
+                        help='Host the simulation is running on')
+    parser.add_argument('--port', type=int, default=44853,
+                        help='Port jtagdpi is listening on')
+    parser.add_argument('--scans', type=int, default=1000,
+                        help='Number of DR scans to run')
+    parser.add_argument('--bits', type=int, default=32,
+                        help='Number of bits in each scan')
+    args = parser.parse_args()
+
+    if args.scans < 1 or args.bits < 1:
+        print('--scans and --bits must be positive.', file=sys.stderr)
+        return 1
+
+    with socket.create_connection((args.host, args.port)) as sock:
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        sock.sendall(reset_cmds())
+
+        cmds, num_resp = scan_cmds(args.bits, 0xa5c3e10f)
+        start = time.monotonic()
+        for _ in range(args.scans):
+            sock.sendall(cmds)
+            recv_exactly(sock, num_resp)
+        elapsed = time.monotonic() - start
+
+        sock.sendall(b'Q')
+
+    total_bits = args.scans * args.bits
+    print(f'{args.scans} scans of {args.bits} bits in {elapsed:.3f} s')
+    print(f'{args.scans / elapsed:.1f} scans/s, '
+          f'{total_bits / elapsed:.1f} bits/s')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -11,7 +11,6 @@
 
 #include <assert.h>
 #include <errno.h>
-#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,6 +20,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "dpi_checkpoint.h"
+#include "dpi_io.h"
 #include "spidpi.h"
 #ifdef VERILATOR
 #include "verilator_sim_ctrl.h"
@@ -33,6 +34,7 @@ struct spidpi_ctx {
   char ptyname[64];
   int host;
   int device;
+  struct dpi_io_chan *chan;
   FILE *mon_file;
   char mon_pathname[PATH_MAX];
   void *mon;
@@ -51,6 +53,76 @@ struct spidpi_ctx {
   char buf[MAX_TRANSACTION];
 };
 
+// The part of the SPI host state that is saved in a simulation checkpoint.
+// The pty and monitor log belong to the process that opened them, so a
+// restored simulation keeps its own (and the monitor starts afresh).
+struct spidpi_checkpoint {
+  int tick;
+  int cpol;
+  int cpha;
+  int msbfirst;
+  int nout;
+  int bout;
+  int nin;
+  int bin;
+  int din;
+  int nmax;
+  char driving;
+  int state;
+  char buf[MAX_TRANSACTION];
+};
+
+static size_t spidpi_checkpoint_save(void *ctx_void, void *buf,
+                                     size_t buf_len) {
+  struct spidpi_ctx *ctx = (struct spidpi_ctx *)ctx_void;
+  struct spidpi_checkpoint state;
+  memset(&state, 0, sizeof(state));
+  state.tick = ctx->tick;
+  state.cpol = ctx->cpol;
+  state.cpha = ctx->cpha;
+  state.msbfirst = ctx->msbfirst;
+  state.nout = ctx->nout;
+  state.bout = ctx->bout;
+  state.nin = ctx->nin;
+  state.bin = ctx->bin;
+  state.din = ctx->din;
+  state.nmax = ctx->nmax;
+  state.driving = ctx->driving;
+  state.state = ctx->state;
+  memcpy(state.buf, ctx->buf, sizeof(state.buf));
+  if (buf_len >= sizeof(state)) {
+    memcpy(buf, &state, sizeof(state));
+  }
+  return sizeof(state);
+}
+
+static bool spidpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                      size_t len) {
+  struct spidpi_ctx *ctx = (struct spidpi_ctx *)ctx_void;
+  struct spidpi_checkpoint state;
+  if (len != sizeof(state)) {
+    return false;
+  }
+  memcpy(&state, buf, sizeof(state));
+  ctx->tick = state.tick;
+  ctx->cpol = state.cpol;
+  ctx->cpha = state.cpha;
+  ctx->msbfirst = state.msbfirst;
+  ctx->nout = state.nout;
+  ctx->bout = state.bout;
+  ctx->nin = state.nin;
+  ctx->bin = state.bin;
+  ctx->din = state.din;
+  ctx->nmax = state.nmax;
+  ctx->driving = state.driving;
+  ctx->state = state.state;
+  memcpy(ctx->buf, state.buf, sizeof(ctx->buf));
+  return true;
+}
+
+static const struct dpi_checkpoint_ops spidpi_checkpoint_ops = {
+    spidpi_checkpoint_save, spidpi_checkpoint_restore, spidpi_set_ctx};
+
 // SPI Host States
 #define SP_IDLE 0
 #define SP_CSFALL 1
@@ -64,7 +136,6 @@ struct spidpi_ctx {
 // #define CONTROL_TRACE
 
 void *spidpi_create(const char *name, int mode, int loglevel) {
-  int i;
   struct spidpi_ctx *ctx =
       (struct spidpi_ctx *)calloc(1, sizeof(struct spidpi_ctx));
   assert(ctx);
@@ -101,10 +172,8 @@ void *spidpi_create(const char *name, int mode, int loglevel) {
   rv = ttyname_r(ctx->device, ctx->ptyname, 64);
   assert(rv == 0 && "ttyname_r failed");
 
-  int cur_flags = fcntl(ctx->host, F_GETFL, 0);
-  assert(cur_flags != -1 && "Unable to read current flags.");
-  int new_flags = fcntl(ctx->host, F_SETFL, cur_flags | O_NONBLOCK);
-  assert(new_flags != -1 && "Unable to set FD flags");
+  ctx->chan = dpi_io_chan_open(ctx->host, DPI_IO_READ | DPI_IO_WRITE, "SPI");
+  assert(ctx->chan && "failed to open I/O channel for spi");
 
   printf(
       "\n"
@@ -128,6 +197,8 @@ void *spidpi_create(const char *name, int mode, int loglevel) {
       "$ tail -f %s\n",
       ctx->mon_pathname, ctx->mon_pathname);
 
+  dpi_checkpoint_register(name, ctx, &spidpi_checkpoint_ops);
+
   return (void *)ctx;
 }
 
@@ -151,26 +222,20 @@ char spidpi_tick(void *ctx_void, const svLogicVecVal *d2p_data) {
               d2p);
 
   if (ctx->state == SP_IDLE) {
-    int n = read(ctx->host, &(ctx->buf[ctx->nin]), ctx->nmax - ctx->nin);
-    if (n == -1) {
-      if (errno != EAGAIN) {
-        fprintf(stderr, "Read on SPI FIFO gave %s\n", strerror(errno));
-      }
-    } else {
-      ctx->nin += n;
-      if (ctx->nin == ctx->nmax) {
-        ctx->nout = 0;
-        ctx->nin = 0;
-        ctx->bout = ctx->msbfirst ? 0x80 : 0x01;
-        ctx->bin = ctx->msbfirst ? 0x80 : 0x01;
-        ctx->din = 0;
-        ctx->state = SP_CSFALL;
+    ctx->nin += dpi_io_chan_read(ctx->chan, &(ctx->buf[ctx->nin]),
+                                 ctx->nmax - ctx->nin);
+    if (ctx->nin == ctx->nmax) {
+      ctx->nout = 0;
+      ctx->nin = 0;
+      ctx->bout = ctx->msbfirst ? 0x80 : 0x01;
+      ctx->bin = ctx->msbfirst ? 0x80 : 0x01;
+      ctx->din = 0;
+      ctx->state = SP_CSFALL;
 #ifdef VERILATOR
 #ifdef CONTROL_TRACE
-        VerilatorSimCtrl::GetInstance().TraceOn();
+      VerilatorSimCtrl::GetInstance().TraceOn();
 #endif
 #endif
-      }
     }
   }
   // SPI clock toggles every 4th tick (i.e. freq=primary_frequency/8)
@@ -218,8 +283,8 @@ char spidpi_tick(void *ctx_void, const svLogicVecVal *d2p_data) {
         ctx->din = ctx->din | ((d2p & D2P_SDO) ? ctx->bin : 0);
         ctx->bin = (ctx->msbfirst) ? ctx->bin >> 1 : ctx->bin << 1;
         if (ctx->bin == 0) {
-          int rv = write(ctx->host, &(ctx->din), 1);
-          assert(rv == 1 && "write() failed.");
+          char dat = ctx->din;
+          dpi_io_chan_write(ctx->chan, &dat, 1);
           ctx->bin = (ctx->msbfirst) ? 0x80 : 0x01;
           ctx->din = 0;
         }
@@ -254,6 +319,10 @@ void spidpi_close(void *ctx_void) {
   if (!ctx) {
     return;
   }
+  dpi_checkpoint_unregister(ctx);
+  dpi_io_chan_close(ctx->chan);
+  close(ctx->host);
+  close(ctx->device);
   fclose(ctx->mon_file);
   free(ctx);
 }
@@ -24,6 +24,10 @@ void *spidpi_create(const char *name, int mode, int loglevel);
 char spidpi_tick(void *ctx_void, const svLogicVecVal *d2p_data);
 void spidpi_close(void *ctx_void);
 
+// Exported from spidpi.sv. Points the chandle of the module in the current
+// scope at ctx_void (used when restoring a simulation checkpoint).
+void spidpi_set_ctx(void *ctx_void);
+
 // monitor
 void monitor_spi(void *mon_void, FILE *mon_file, int loglevel, int tick,
                  int p2d, int d2p);
@@ -23,7 +23,7 @@ module spidpi
   input  logic spi_device_sdo_en_i
 
 );
-  import "DPI-C" function
+  import "DPI-C" context function
     chandle spidpi_create(input string name, input int mode, input int loglevel);
 
   import "DPI-C" function
@@ -34,6 +34,14 @@ module spidpi
 
   chandle ctx;
 
+  // Called when restoring a simulation checkpoint, to replace the restored
+  // chandle with the context created by this process.
+  export "DPI-C" function spidpi_set_ctx;
+
+  function void spidpi_set_ctx(chandle new_ctx);
+    ctx = new_ctx;
+  endfunction
+
   initial begin
     ctx = spidpi_create(NAME, MODE, LOG_LEVEL);
   end
@@ -17,13 +17,15 @@
 
 #include <assert.h>
 #include <errno.h>
-#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "dpi_checkpoint.h"
+#include "dpi_io.h"
+
 #define EXIT_STRING_MAX_LENGTH (64)
 
 // This keeps the necessary uart state.
@@ -33,10 +35,48 @@ struct uartdpi_ctx {
   int exittracker;
   int host;
   int device;
+  struct dpi_io_chan *chan;
   char tmp_read;
   FILE *log_file;
 };
 
+// The part of the uart state that is saved in a simulation checkpoint. The
+// pty and log file belong to the process that opened them, so a restored
+// simulation keeps its own.
+struct uartdpi_checkpoint {
+  int exittracker;
+  char tmp_read;
+};
+
+static size_t uartdpi_checkpoint_save(void *ctx_void, void *buf,
+                                      size_t buf_len) {
+  struct uartdpi_ctx *ctx = (struct uartdpi_ctx *)ctx_void;
+  struct uartdpi_checkpoint state;
+  memset(&state, 0, sizeof(state));
+  state.exittracker = ctx->exittracker;
+  state.tmp_read = ctx->tmp_read;
+  if (buf_len >= sizeof(state)) {
+    memcpy(buf, &state, sizeof(state));
+  }
+  return sizeof(state);
+}
+
+static bool uartdpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                       size_t len) {
+  struct uartdpi_ctx *ctx = (struct uartdpi_ctx *)ctx_void;
+  struct uartdpi_checkpoint state;
+  if (len != sizeof(state)) {
+    return false;
+  }
+  memcpy(&state, buf, sizeof(state));
+  ctx->exittracker = state.exittracker;
+  ctx->tmp_read = state.tmp_read;
+  return true;
+}
+
+static const struct dpi_checkpoint_ops uartdpi_checkpoint_ops = {
+    uartdpi_checkpoint_save, uartdpi_checkpoint_restore, uartdpi_set_ctx};
+
 void *uartdpi_create(const char *name, const char *log_file_path,
                      const char *exit_string) {
   struct uartdpi_ctx *ctx =
@@ -61,10 +101,10 @@ void *uartdpi_create(const char *name, const char *log_file_path,
   rv = ttyname_r(ctx->device, ctx->ptyname, 64);
   assert(rv == 0 && "ttyname_r failed");
 
-  int cur_flags = fcntl(ctx->host, F_GETFL, 0);
-  assert(cur_flags != -1 && "Unable to read current flags.");
-  int new_flags = fcntl(ctx->host, F_SETFL, cur_flags | O_NONBLOCK);
-  assert(new_flags != -1 && "Unable to set FD flags");
+  // Reads and writes on the host side of the pty are done by the shared I/O
+  // thread, so ticking an idle UART doesn't need any system calls.
+  ctx->chan = dpi_io_chan_open(ctx->host, DPI_IO_READ | DPI_IO_WRITE, "UART");
+  assert(ctx->chan && "failed to open I/O channel for uart");
 
   printf(
       "\n"
@@ -114,6 +154,8 @@ void *uartdpi_create(const char *name, const char *log_file_path,
   // Guarantee that at least one character in the exit string is null.
   ctx->exitstring[EXIT_STRING_MAX_LENGTH - 1] = '\0';
 
+  dpi_checkpoint_register(name, ctx, &uartdpi_checkpoint_ops);
+
   return (void *)ctx;
 }
 
@@ -123,6 +165,9 @@ void uartdpi_close(void *ctx_void) {
     return;
   }
 
+  dpi_checkpoint_unregister(ctx);
+
+  dpi_io_chan_close(ctx->chan);
   close(ctx->host);
   close(ctx->device);
 
@@ -143,8 +188,7 @@ int uartdpi_can_read(void *ctx_void) {
   if (ctx == NULL) {
     return 0;
   }
-  int rv = read(ctx->host, &ctx->tmp_read, 1);
-  return (rv == 1);
+  return dpi_io_chan_read_byte(ctx->chan, &ctx->tmp_read);
 }
 
 char uartdpi_read(void *ctx_void) {
@@ -160,8 +204,10 @@ int uartdpi_write(void *ctx_void, char c) {
     return 0;
   }
 
-  rv = write(ctx->host, &c, 1);
-  assert(rv == 1 && "Write to pseudo-terminal failed.");
+  // If nothing is reading from the pty, the channel's buffer eventually fills
+  // up and further output is dropped (with a warning), rather than stalling
+  // the simulation.
+  dpi_io_chan_write(ctx->chan, &c, 1);
 
   if (ctx->log_file) {
     rv = fwrite(&c, sizeof(char), 1, ctx->log_file);
@@ -28,6 +28,10 @@ char uartdpi_read(void *ctx_void);
 // Returns non-zero when exit string has been seen.
 int uartdpi_write(void *ctx_void, char c);
 
+// Exported from uartdpi.sv. Points the chandle of the module in the current
+// scope at ctx_void (used when restoring a simulation checkpoint).
+void uartdpi_set_ctx(void *ctx_void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -21,7 +21,7 @@ module uartdpi #(
   // Min cycles is 2 for fast test mode
   localparam int CYCLES_PER_SYMBOL = FREQ / BAUD;
 
-  import "DPI-C" function
+  import "DPI-C" context function
     chandle uartdpi_create(input string name, input string log_file_path, input string exit_string);
 
   import "DPI-C" function
@@ -39,6 +39,14 @@ module uartdpi #(
   chandle ctx;
   string log_file_path = DEFAULT_LOG_FILE;
 
+  // Called when restoring a simulation checkpoint, to replace the restored
+  // chandle with the context created by this process.
+  export "DPI-C" function uartdpi_set_ctx;
+
+  function void uartdpi_set_ctx(chandle new_ctx);
+    ctx = new_ctx;
+  endfunction
+
   function automatic void initialize();
     string plusarg_name = {"UARTDPI_LOG_", NAME};
     if (!$value$plusargs({plusarg_name, "=%s"}, log_file_path)) begin
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors (OpenTitan project).
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+'''Decode a usbdpi packet capture into the monitor's text log format
+
+With bit 0x10 set in its log level (e.g. +usbdpi_loglevel=0x11), usbdpi
+writes each packet seen by its monitor to <name>.pcapng rather than
+formatting it as text in <name>.log. That keeps the cost of logging out of
+the simulation, and the capture can be opened directly in Wireshark (which
+decodes it as LINKTYPE_USB_2_0).
+
+This script turns a capture back into the lines that the monitor would have
+written with log level 0x01, e.g.
+
+    usb_capture_decode.py usb0.pcapng > usb0-packets.log
+
+Other monitor messages (bus clashes, bit stuffing errors and the verbose
+0x02 output) are still written to <name>.log.
+
+'''
+
+import argparse
+import struct
+import sys
+from typing import BinaryIO, Iterator, List, Tuple
+
+PCAPNG_BLOCK_SHB = 0x0A0D0D0A
+PCAPNG_BLOCK_IDB = 0x00000001
+PCAPNG_BLOCK_EPB = 0x00000006
+PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D
+PCAPNG_OPT_END = 0
+PCAPNG_OPT_COMMENT = 1
+PCAPNG_OPT_EPB_FLAGS = 2
+PCAPNG_EPB_INBOUND = 1
+LINKTYPE_USB_2_0 = 288
+
+# The monitor's limit on the number of bytes in a packet
+MON_BYTES_SIZE = 1024
+
+USB_PID_OUT = 0xE1
+USB_PID_IN = 0x69
+USB_PID_SOF = 0xA5
+USB_PID_SETUP = 0x2D
+USB_PID_DATA0 = 0xC3
+USB_PID_DATA1 = 0x4B
+
+PID_NAMES = [
+    'Rsvd', 'OUT', 'ACK', 'DATA0', 'PING', 'SOF', 'NYET', 'DATA2',
+    'SPLIT', 'IN', 'NAK', 'DATA1', 'PRE/ERR', 'SETUP', 'STALL', 'MDATA'
+]
+
+DUMP_PREFIX = 'mon:          '
+
+# A packet from the capture: (SOP bit time, EOP bit time, driven by host,
+# PID, data bytes including any CRC)
+Packet = Tuple[int, int, bool, int, bytes]
+
+
+class CaptureError(Exception):
+    pass
+
+
+def crc5(value: int, bits: int) -> int:
+    crc = 0x1f
+    for _ in range(bits):
+        if (value ^ crc) & 1:
+            crc = (crc >> 1) ^ 0x14
+        else:
+            crc >>= 1
+        value >>= 1
+    return crc ^ 0x1f
+
+
+def crc16(data: bytes) -> int:
+    crc = 0xffff
+    for byte in data:
+        for _ in range(8):
+            if (byte ^ crc) & 1:
+                crc = (crc >> 1) ^ 0xA001
+            else:
+                crc >>= 1
+            byte >>= 1
+    return crc ^ 0xffff
+
+
+def decode_pid(pid: int) -> str:
+    if ((pid ^ 0xf0) >> 4) ^ (pid & 0xf):
+        return '???'
+    return PID_NAMES[pid & 0xf]
+
+
+def pid_2data(pid: int, d0: int, d1: int) -> str:
+    crcok = 'OK' if crc5(((d1 & 7) << 8) | d0, 11) == d1 >> 3 else 'BAD'
+    if pid == USB_PID_SOF:
+        return f'SOF {((d1 & 7) << 8) | d0:03x} (CRC5 {d1 >> 3:02x} {crcok})'
+    if pid in (USB_PID_SETUP, USB_PID_OUT, USB_PID_IN):
+        return (f'{decode_pid(pid)} {d0 & 0x7f}.{((d1 & 7) << 1) | d0 >> 7} '
+                f'(CRC5 {d1 >> 3:02x} {crcok})')
+    if pid in (USB_PID_DATA0, USB_PID_DATA1):
+        return (f'{decode_pid(pid)} {d0:02x}, {d1:02x} '
+                f'({"CRC16 BAD" if d0 | d1 else "NULL"})')
+    bad = '' if ((pid >> 4) ^ 0xf) == (pid & 0xf) else 'BAD PID '
+    return f'{bad}{decode_pid(pid)} {d0:02x}, {d1:02x} (CRC5 {crcok})'
+
+
+def dump_bytes(data: bytes) -> List[str]:
+    lines = []
+    for start in range(0, len(data), 16):
+        row = data[start:start + 16]
+        hexcols = ''.join(f'{b:02x} ' for b in row).ljust(16 * 3)
+        text = ''.join('.' if b < 0x20 or b >= 0x7f else chr(b) for b in row)
+        lines.append(DUMP_PREFIX + hexcols + text)
+    return lines
+
+
+def format_packet(pkt: Packet) -> str:
+    '''Format a packet as the monitor does with log level 0x01'''
+    sop, eop, host, pid, data = pkt
+    head = f'mon: {sop:8d} -- {eop:8d}: ({"H" if host else "D"}) SOP, PID'
+    if not data:
+        return f'{head} {decode_pid(pid)} EOP\n'
+    if len(data) == 1:
+        return f'{head} {decode_pid(pid)} {data[0]:02x} EOP\n'
+    if len(data) == 2:
+        return f'{head} {pid_2data(pid, data[0], data[1])}, EOP\n'
+
+    lines = [f'{head} {decode_pid(pid)}, EOP',
+             f'mon:     {"h->d" if host else "d->h"}:']
+    lines += dump_bytes(data[:-2])
+    out = '\n'.join(lines) + '\n'
+    more = '...' if len(data) == MON_BYTES_SIZE else ''
+    out += f'\n{DUMP_PREFIX}(CRC16 {data[-2]:02x} {data[-1]:02x}'
+    pkt_crc = data[-2] | (data[-1] << 8)
+    comp_crc = crc16(data[:-2])
+    if pkt_crc == comp_crc:
+        return out + f'{more} OK)\n'
+    return (out + f'{more} BAD)\nmon:           CRC16 {pkt_crc:04x} BAD '
+            f'expected {comp_crc:04x}\n')
+
+
+def read_blocks(f: BinaryIO) -> Iterator[Tuple[int, bytes]]:
+    '''Yield the type and body of each block in a little-endian pcapng file'''
+    while True:
+        hdr = f.read(8)
+        if not hdr:
+            return
+        if len(hdr) < 8:
+            raise CaptureError('Truncated block header.')
+        btype, blen = struct.unpack('<II', hdr)
+        if btype == PCAPNG_BLOCK_SHB:
+            magic = f.read(4)
+            if struct.unpack('<I', magic)[0] != PCAPNG_BYTE_ORDER_MAGIC:
+                raise CaptureError('Not a little-endian pcapng file.')
+            body = magic + f.read(blen - 16)
+        else:
+            body = f.read(blen - 12)
+        trailer = f.read(4)
+        if len(trailer) < 4 or struct.unpack('<I', trailer)[0] != blen:
+            # The simulation may have been killed mid-write.
+            return
+        yield (btype, body)
+
+
+def parse_options(opts: bytes) -> Iterator[Tuple[int, bytes]]:
+    pos = 0
+    while pos + 4 <= len(opts):
+        code, olen = struct.unpack_from('<HH', opts, pos)
+        if code == PCAPNG_OPT_END:
+            return
+        yield (code, opts[pos + 4:pos + 4 + olen])
+        pos += 4 + ((olen + 3) & ~3)
+
+
+def read_packets(f: BinaryIO) -> Iterator[Packet]:
+    tsresol_ok = False
+    for btype, body in read_blocks(f):
+        if btype == PCAPNG_BLOCK_IDB:
+            linktype = struct.unpack_from('<H', body)[0]
+            if linktype != LINKTYPE_USB_2_0:
+                raise CaptureError(f'Unexpected link type {linktype}.')
+            tsresol_ok = any(code == 9 and val == b'\x09'
+                             for code, val in parse_options(body[8:]))
+        elif btype == PCAPNG_BLOCK_EPB:
+            if not tsresol_ok:
+                raise CaptureError('Expected nanosecond timestamps.')
+            ts_hi, ts_lo, caplen = struct.unpack_from('<4xIII', body)
+            pkt = body[20:20 + caplen]
+            host = True
+            eop = None
+            for code, val in parse_options(body[20 + ((caplen + 3) & ~3):]):
+                if code == PCAPNG_OPT_EPB_FLAGS:
+                    flags = struct.unpack('<I', val)[0]
+                    host = (flags & 3) != PCAPNG_EPB_INBOUND
+                elif code == PCAPNG_OPT_COMMENT:
+                    text = val.decode()
+                    if text.startswith('eop '):
+                        eop = int(text[4:])
+            if eop is None:
+                raise CaptureError('Packet record without an EOP time.')
+            # Timestamps are in ns; the monitor counts full speed bit times.
+            sop = (((ts_hi << 32) | ts_lo) * 12 + 500) // 1000
+            yield (sop, eop, host, pkt[0], pkt[1:])
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('capture', type=argparse.FileType('rb'),
+                        help='pcapng file written by usbdpi')
+    args = parser.parse_args()
+
+    try:
+        for pkt in read_packets(args.capture):
+            sys.stdout.write(format_packet(pkt))
+    except CaptureError as err:
+        print(f'Error: {err}', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -6,6 +6,7 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "usb_utils.h"
@@ -26,6 +27,23 @@ typedef enum { M_NONE = 0, M_HOST, M_DEVICE } usbmon_driver_t;
 // Number of bytes in max output buffer line
 #define MAX_OBUF 80
 
+// Packet capture (pcapng) definitions
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0Au
+#define PCAPNG_BLOCK_IDB 0x00000001u
+#define PCAPNG_BLOCK_EPB 0x00000006u
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4Du
+#define PCAPNG_OPT_END 0
+#define PCAPNG_OPT_COMMENT 1
+#define PCAPNG_OPT_IF_TSRESOL 9
+#define PCAPNG_OPT_EPB_FLAGS 2
+// EPB flags for the direction of a packet
+#define PCAPNG_EPB_INBOUND 1u
+#define PCAPNG_EPB_OUTBOUND 2u
+// Link type for USB packets starting with the PID
+#define LINKTYPE_USB_2_0 288
+// Size of the stdio buffer for the capture file
+#define CAPTURE_BUF_SIZE (1u << 20)
+
 /**
  * USB monitor context
  */
@@ -34,6 +52,10 @@ struct usb_monitor_ctx {
    * Log file
    */
   FILE *file;
+  /**
+   * Packet capture file (NULL if not capturing)
+   */
+  FILE *capture;
   /**
    * Monitor state, reflecting the current state of the USB
    */
@@ -75,10 +97,103 @@ static inline void data_callback(usb_monitor_ctx_t *mon,
   }
 }
 
+// Round up to a multiple of 4 bytes, for pcapng block contents
+static inline size_t pcapng_pad(size_t n) { return (n + 3u) & ~(size_t)3u; }
+
+static inline uint8_t *put_opt(uint8_t *dp, uint16_t code, const void *val,
+                               uint16_t len) {
+  dp = set_le16(dp, code);
+  dp = set_le16(dp, len);
+  memcpy(dp, val, len);
+  memset(dp + len, 0, pcapng_pad(len) - len);
+  return dp + pcapng_pad(len);
+}
+
+// Write a complete pcapng block, filling in the total length at both ends
+static void pcapng_write_block(FILE *out, uint8_t *block, uint8_t *end) {
+  uint32_t len = (uint32_t)(end - block) + 4u;
+  set_le32(&block[4], len);
+  set_le32(end, len);
+  size_t written = fwrite(block, 1, len, out);
+  assert(written == len);
+}
+
+// Write the pcapng section and interface headers for a capture file
+static void pcapng_write_header(FILE *out) {
+  uint8_t block[64];
+  uint8_t *dp = block;
+
+  // Section Header Block, with an unspecified section length
+  dp = set_le32(dp, PCAPNG_BLOCK_SHB);
+  dp += 4;
+  dp = set_le32(dp, PCAPNG_BYTE_ORDER_MAGIC);
+  dp = set_le16(dp, 1u);
+  dp = set_le16(dp, 0u);
+  dp = set_le32(dp, 0xffffffffu);
+  dp = set_le32(dp, 0xffffffffu);
+  pcapng_write_block(out, block, dp);
+
+  // Interface Description Block, with nanosecond timestamps
+  dp = block;
+  dp = set_le32(dp, PCAPNG_BLOCK_IDB);
+  dp += 4;
+  dp = set_le16(dp, LINKTYPE_USB_2_0);
+  dp = set_le16(dp, 0u);
+  dp = set_le32(dp, 0u);
+  const uint8_t tsresol = 9u;
+  dp = put_opt(dp, PCAPNG_OPT_IF_TSRESOL, &tsresol, 1u);
+  dp = put_opt(dp, PCAPNG_OPT_END, NULL, 0u);
+  pcapng_write_block(out, block, dp);
+}
+
+/**
+ * Append a packet record to the capture file
+ *
+ * The packet data is the PID followed by the data bytes (including any CRC),
+ * as for LINKTYPE_USB_2_0. The timestamp is the start of the packet, the
+ * direction is held in the flags and the bit time of the end of the packet is
+ * held in a comment, so that usb_capture_decode.py can reproduce the text
+ * log exactly.
+ */
+static void capture_packet(usb_monitor_ctx_t *mon, uint32_t tick_bits) {
+  uint8_t block[MON_BYTES_SIZE + 96];
+  size_t nbytes = (mon->state == MS_GET_BYTES) ? mon->byte : 0u;
+
+  // USB full speed bit times are 1/12us.
+  uint64_t ts_ns = ((uint64_t)(uint32_t)mon->sopAt * 1000u) / 12u;
+
+  uint8_t *dp = block;
+  dp = set_le32(dp, PCAPNG_BLOCK_EPB);
+  dp += 4;
+  dp = set_le32(dp, 0u);  // Interface ID
+  dp = set_le32(dp, (uint32_t)(ts_ns >> 32));
+  dp = set_le32(dp, (uint32_t)ts_ns);
+  dp = set_le32(dp, (uint32_t)nbytes + 1u);
+  dp = set_le32(dp, (uint32_t)nbytes + 1u);
+  *dp = mon->lastpid;
+  memcpy(dp + 1, mon->bytes, nbytes);
+  memset(dp + 1 + nbytes, 0, pcapng_pad(nbytes + 1u) - (nbytes + 1u));
+  dp += pcapng_pad(nbytes + 1u);
+
+  uint8_t flags[4];
+  set_le32(flags, mon->driver == M_HOST ? PCAPNG_EPB_OUTBOUND
+                                        : PCAPNG_EPB_INBOUND);
+  dp = put_opt(dp, PCAPNG_OPT_EPB_FLAGS, flags, sizeof(flags));
+
+  char comment[16];
+  int n = snprintf(comment, sizeof(comment), "eop %u", tick_bits);
+  assert(n > 0 && n < (int)sizeof(comment));
+  dp = put_opt(dp, PCAPNG_OPT_COMMENT, comment, (uint16_t)n);
+  dp = put_opt(dp, PCAPNG_OPT_END, NULL, 0u);
+
+  pcapng_write_block(mon->capture, block, dp);
+}
+
 /**
  * Create and initialize a USB monitor instance
  */
 usb_monitor_ctx_t *usb_monitor_init(const char *filename,
+                                    const char *capture_filename,
                                     usb_monitor_data_callback_t data_cb,
                                     void *data_ctx) {
   usb_monitor_ctx_t *mon =
@@ -109,6 +224,24 @@ usb_monitor_ctx_t *usb_monitor_init(const char *filename,
       "$ tail -f %s\n",
       filename, filename);
 
+  if (capture_filename) {
+    mon->capture = fopen(capture_filename, "wb");
+    if (!mon->capture) {
+      fprintf(stderr, "USBDPI: Unable to open capture file at %s: %s\n",
+              capture_filename, strerror(errno));
+      fclose(mon->file);
+      free(mon);
+      return NULL;
+    }
+    // Packet records are only read after the simulation, so buffer lots.
+    setvbuf(mon->capture, NULL, _IOFBF, CAPTURE_BUF_SIZE);
+    pcapng_write_header(mon->capture);
+    printf(
+        "USBDPI: Capturing packets to %s instead of logging them. Use\n"
+        "hw/dv/dpi/usbdpi/usb_capture_decode.py to decode them.\n",
+        capture_filename);
+  }
+
   return mon;
 }
 
@@ -116,6 +249,9 @@ usb_monitor_ctx_t *usb_monitor_init(const char *filename,
  * Finalize a USB monitor
  */
 void usb_monitor_fin(usb_monitor_ctx_t *mon) {
+  if (mon->capture) {
+    fclose(mon->capture);
+  }
   fclose(mon->file);
   free(mon);
 }
@@ -263,7 +399,11 @@ void usb_monitor(usb_monitor_ctx_t *mon, int loglevel, uint32_t tick_bits,
 
   // EOP detection, calculate and check the CRC16 on any data field
   if ((mon->line & 0x3f) == ((SE0 << 4) | (SE0 << 2) | (DJ << 0))) {
-    if ((log || compact) && (mon->state == MS_GET_BYTES) && (mon->byte > 0)) {
+    if (mon->capture) {
+      // The packet record replaces the packet summary and data dump.
+      capture_packet(mon, tick_bits);
+    } else if ((log || compact) && (mon->state == MS_GET_BYTES) &&
+               (mon->byte > 0)) {
       uint32_t pkt_crc16, comp_crc16;
 
       if (compact && mon->byte == 2) {
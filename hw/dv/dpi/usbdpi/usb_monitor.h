@@ -30,11 +30,14 @@ typedef void (*usb_monitor_data_callback_t)(void *ctx_v,
  * Create and initialize a USB monitor instance
  *
  * @param  filename  Filename to be used for log file
+ * @param  capture_filename  Filename for a pcapng packet capture, which
+ *                   replaces the packet-level text log, or NULL
  * @param  data_cb   USB data callback function
  * @param  data_ctx  Context for data callback
  * @return           USB monitor context
  */
 usb_monitor_ctx_t *usb_monitor_init(const char *filename,
+                                    const char *capture_filename,
                                     usb_monitor_data_callback_t data_cb,
                                     void *data_ctx);
 
@@ -17,6 +17,8 @@ void usb_transfer_setup(usbdpi_ctx_t *ctx) {
     next = &ctx->transfer_pool[idx];
   }
   ctx->free = next;
+  ctx->nfree = USBDPI_MAX_TRANSFERS;
+  ctx->min_free = USBDPI_MAX_TRANSFERS;
 }
 
 // Allocate and initialize a transfer descriptor
@@ -24,6 +26,10 @@ usbdpi_transfer_t *transfer_alloc(usbdpi_ctx_t *ctx) {
   usbdpi_transfer_t *transfer = ctx->free;
   if (transfer) {
     ctx->free = transfer->next;
+    // Track the low water mark, to check the sizing of the pool
+    if (--ctx->nfree < ctx->min_free) {
+      ctx->min_free = ctx->nfree;
+    }
     transfer_init(transfer);
   }
   return transfer;
@@ -34,8 +40,13 @@ void transfer_release(usbdpi_ctx_t *ctx, usbdpi_transfer_t *transfer) {
   // Prepend this transfer descriptor to the list of free descriptors
   transfer->next = ctx->free;
   ctx->free = transfer;
+  ctx->nfree++;
+  assert(ctx->nfree <= USBDPI_MAX_TRANSFERS);
 }
 
+// Return the number of free transfer descriptors
+unsigned transfer_num_free(const usbdpi_ctx_t *ctx) { return ctx->nfree; }
+
 // Initialize a transfer descriptor
 void transfer_init(usbdpi_transfer_t *transfer) {
   // Not within a linked list
@@ -180,6 +191,75 @@ void transfer_send(usbdpi_ctx_t *ctx, usbdpi_transfer_t *transfer) {
   ctx->bit = 1;
 }
 
+// NRZI encode and bit-stuff a packet into line transitions (a set bit meaning
+// J <-> K), returning the number of line states
+static unsigned serialise_bytes(uint32_t *bits, const uint8_t *data,
+                                unsigned n, bool last) {
+  // The KK at the end of SYNC counts towards bit stuffing
+  unsigned ones = 1U;
+  unsigned nbits = 0U;
+  for (unsigned idx = 0U; idx < n; idx++) {
+    for (unsigned bit = 0U; bit < 8U; bit++) {
+      if (ones == 6U && !INSERT_ERR_BITSTUFF) {
+        // Stuffed bit, forcing a transition
+        bits[nbits >> 5] |= 1U << (nbits & 31U);
+        nbits++;
+        ones = 0U;
+      }
+      if ((data[idx] >> bit) & 1U) {
+        ones++;
+      } else {
+        bits[nbits >> 5] |= 1U << (nbits & 31U);
+        ones = 0U;
+      }
+      nbits++;
+    }
+  }
+  // Six trailing ones must be followed by a stuffed bit, but only the last
+  // packet in a transfer has one; the EOP of a token packet follows
+  // immediately
+  if (last && ones == 6U && !INSERT_ERR_BITSTUFF) {
+    bits[nbits >> 5] |= 1U << (nbits & 31U);
+    nbits++;
+  }
+  assert(nbits <= USBDPI_MAX_TX_BITS);
+  return nbits;
+}
+
+// Serialise the next packet of the transfer being sent, following its SYNC
+void transfer_serialise(usbdpi_ctx_t *ctx, const usbdpi_transfer_t *transfer) {
+  unsigned start = (unsigned)ctx->byte;
+  unsigned end = transfer->num_bytes;
+  if (start < transfer->data_start && transfer->data_start < end) {
+    end = transfer->data_start;
+  }
+  bool last = (end == transfer->num_bytes);
+  const uint8_t *data = &transfer->data[start];
+  assert(start < end);
+
+  if (start == 0U && end == 3U) {
+    // Token packet; index the cache by token type and endpoint
+    unsigned ep = (data[1] >> 7) | ((data[2] & 7U) << 1);
+    unsigned idx = ((data[0] & 0xcU) << 2) | ep;
+    usbdpi_token_bits_t *entry = &ctx->token_cache[idx];
+    if (!entry->nbits || entry->last != last ||
+        memcmp(entry->token, data, sizeof(entry->token))) {
+      memcpy(entry->token, data, sizeof(entry->token));
+      entry->last = last;
+      entry->bits = 0U;
+      entry->nbits = (uint8_t)serialise_bytes(&entry->bits, data, 3U, last);
+    }
+    ctx->tx_bits[0] = entry->bits;
+    ctx->tx_nbits = entry->nbits;
+  } else {
+    unsigned n = end - start;
+    memset(ctx->tx_bits, 0, ((n * 8U * 7U) / 6U + 32U) / 32U * 4U);
+    ctx->tx_nbits = (uint16_t)serialise_bytes(ctx->tx_bits, data, n, last);
+  }
+  ctx->tx_pos = 0U;
+  ctx->byte = (int)end;
+}
+
 // Construct and prepare to send a Status response;
 // Note: there is no requirement to call either transfer_init() or
 //       transfer_send() when using transfer_status()
@@ -26,6 +26,17 @@
 // Special value that denotes that this transfer does not include a data stage
 #define USBDPI_NO_DATA_STAGE ((uint8_t)~0U)
 
+// Maximal number of line states in a serialised packet, allowing for a stuffed
+// bit after every six bits
+#define USBDPI_MAX_TX_BITS ((USBDPI_MAX_DATA * 8U * 7U) / 6U + 1U)
+
+// Number of 32-bit words holding the line states of a serialised packet
+#define USBDPI_TX_BITS_WORDS ((USBDPI_MAX_TX_BITS + 31U) / 32U)
+
+// Number of entries in the cache of serialised token packets; indexed by the
+// token type and endpoint number
+#define USBDPI_TOKEN_CACHE_SIZE 0x40U
+
 // USB Transfer Types (Standard Endpoint Descriptor)
 #define USB_TRANSFER_TYPE_CONTROL 0U
 #define USB_TRANSFER_TYPE_ISOCHRONOUS 1U
@@ -67,6 +78,30 @@ struct usbdpi_transfer {
   uint8_t data[USBDPI_MAX_DATA];
 };
 
+/**
+ * Serialised form of a token packet, retained for reuse because the host
+ * sends the same few tokens (eg. IN polls of each stream) over and over
+ */
+typedef struct usbdpi_token_bits {
+  /**
+   * Token packet (PID and the two bytes holding ADDR, ENDP and CRC5)
+   */
+  uint8_t token[3];
+  /**
+   * Whether the token is the last packet of its transfer; only then is a
+   * stuffed bit appended after six trailing ones
+   */
+  bool last;
+  /**
+   * Number of line states (zero iff this entry is unused)
+   */
+  uint8_t nbits;
+  /**
+   * Line transitions, LSB first
+   */
+  uint32_t bits;
+} usbdpi_token_bits_t;
+
 /**
  * Set up all of the available transfer descriptors in a USB DPI context
  *
@@ -89,6 +124,14 @@ usbdpi_transfer_t *transfer_alloc(usbdpi_ctx_t *ctx);
  */
 void transfer_release(usbdpi_ctx_t *ctx, usbdpi_transfer_t *transfer);
 
+/**
+ * Return the number of free transfer descriptors
+ *
+ * @param  ctx       USB DPI context
+ * @return           Number of descriptors that may be allocated
+ */
+unsigned transfer_num_free(const usbdpi_ctx_t *ctx);
+
 /**
  * Initialize a transfer descriptor for use
  *
@@ -199,6 +242,18 @@ bool transfer_append(usbdpi_transfer_t *transfer, const uint8_t *dp, size_t n);
  */
 void transfer_send(usbdpi_ctx_t *ctx, usbdpi_transfer_t *transfer);
 
+/**
+ * Serialise the next packet of the transfer being sent, following its SYNC
+ *
+ * The packet that starts at ctx->byte is NRZI encoded and bit-stuffed into a
+ * sequence of line transitions in ctx->tx_bits, and ctx->byte is advanced to
+ * the end of the packet. Token packets are cached in their serialised form.
+ *
+ * @param  ctx       USB DPI context
+ * @param  transfer  Transfer descriptor being sent
+ */
+void transfer_serialise(usbdpi_ctx_t *ctx, const usbdpi_transfer_t *transfer);
+
 /**
  * Construct and prepare to send a Status response;
  *
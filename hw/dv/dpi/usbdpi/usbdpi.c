@@ -9,6 +9,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +17,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "dpi_checkpoint.h"
 #include "usb_utils.h"
 #include "usbdpi_test.h"
 
@@ -102,6 +104,76 @@ static void bus_reset(usbdpi_ctx_t *ctx) {
 static void usbdpi_data_callback(void *ctx_v, usbmon_data_type_t type,
                                  uint8_t d);
 
+// Relocate a pointer into the transfer pool of a context that lived at
+// old_base into the transfer pool of ctx, returning false if it doesn't point
+// at a transfer descriptor.
+static bool relocate_transfer(usbdpi_ctx_t *ctx, uintptr_t old_base,
+                              usbdpi_transfer_t **tr) {
+  if (!*tr) {
+    return true;
+  }
+  uintptr_t old_pool = old_base + offsetof(usbdpi_ctx_t, transfer_pool);
+  uintptr_t offset = (uintptr_t)*tr - old_pool;
+  if (offset % sizeof(usbdpi_transfer_t) ||
+      offset / sizeof(usbdpi_transfer_t) >= USBDPI_MAX_TRANSFERS) {
+    return false;
+  }
+  *tr = &ctx->transfer_pool[offset / sizeof(usbdpi_transfer_t)];
+  return true;
+}
+
+// The whole context is saved in a simulation checkpoint, preceded by the
+// address it lived at so that pointers into the transfer pool can be
+// relocated. The monitor belongs to the process that opened it, so a restored
+// simulation keeps its own.
+static size_t usbdpi_checkpoint_save(void *ctx_void, void *buf,
+                                     size_t buf_len) {
+  usbdpi_ctx_t *ctx = (usbdpi_ctx_t *)ctx_void;
+  uint64_t base = (uintptr_t)ctx;
+  size_t len = sizeof(base) + sizeof(*ctx);
+  if (buf_len >= len) {
+    memcpy(buf, &base, sizeof(base));
+    memcpy((uint8_t *)buf + sizeof(base), ctx, sizeof(*ctx));
+  }
+  return len;
+}
+
+static bool usbdpi_checkpoint_restore(void *ctx_void, const void *buf,
+                                      size_t len) {
+  usbdpi_ctx_t *ctx = (usbdpi_ctx_t *)ctx_void;
+  uint64_t base;
+  if (len != sizeof(base) + sizeof(*ctx)) {
+    return false;
+  }
+  memcpy(&base, buf, sizeof(base));
+
+  usbdpi_ctx_t *saved = (usbdpi_ctx_t *)malloc(sizeof(*saved));
+  assert(saved);
+  memcpy(saved, (const uint8_t *)buf + sizeof(base), sizeof(*saved));
+
+  bool ok = relocate_transfer(ctx, base, &saved->recving) &&
+            relocate_transfer(ctx, base, &saved->sending) &&
+            relocate_transfer(ctx, base, &saved->free);
+  for (unsigned i = 0U; ok && i < USBDPI_MAX_STREAMS; i++) {
+    ok = relocate_transfer(ctx, base, &saved->stream[i].received);
+  }
+  for (unsigned i = 0U; ok && i < USBDPI_MAX_TRANSFERS; i++) {
+    ok = relocate_transfer(ctx, base, &saved->transfer_pool[i].next);
+  }
+
+  if (ok) {
+    saved->loglevel = ctx->loglevel;
+    memcpy(saved->mon_pathname, ctx->mon_pathname, sizeof(ctx->mon_pathname));
+    saved->mon = ctx->mon;
+    memcpy(ctx, saved, sizeof(*ctx));
+  }
+  free(saved);
+  return ok;
+}
+
+static const struct dpi_checkpoint_ops usbdpi_checkpoint_ops = {
+    usbdpi_checkpoint_save, usbdpi_checkpoint_restore, usbdpi_set_ctx};
+
 /**
  * Create a USB DPI instance, returning a 'chandle' for later use
  */
@@ -132,11 +204,22 @@ void *usbdpi_create(const char *name, int loglevel) {
   int rv = snprintf(ctx->mon_pathname, FILENAME_MAX, "%s/%s.log", cwd, name);
   assert(rv <= FILENAME_MAX && rv > 0);
 
-  ctx->mon = usb_monitor_init(ctx->mon_pathname, usbdpi_data_callback, ctx);
+  // Packet capture file
+  char capture_pathname[FILENAME_MAX];
+  if (loglevel & LOG_CAPTURE) {
+    rv = snprintf(capture_pathname, FILENAME_MAX, "%s/%s.pcapng", cwd, name);
+    assert(rv <= FILENAME_MAX && rv > 0);
+  }
+
+  ctx->mon = usb_monitor_init(
+      ctx->mon_pathname, (loglevel & LOG_CAPTURE) ? capture_pathname : NULL,
+      usbdpi_data_callback, ctx);
 
   // Prepare the transfer descriptors for use
   usb_transfer_setup(ctx);
 
+  dpi_checkpoint_register(name, ctx, &usbdpi_checkpoint_ops);
+
   return (void *)ctx;
 }
 
@@ -1367,7 +1450,8 @@ uint8_t usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
       ctx->bit <<= 1;
       if (ctx->bit == 0x100) {
         ctx->bit = 1;
-        ctx->linebits = 1;  // The KK at end of SYNC counts for bit stuffing!
+        // Bit stuffing and NRZI encoding of the packet are done up front
+        transfer_serialise(ctx, ctx->sending);
         ctx->state = ST_SEND;
       }
       break;
@@ -1375,31 +1459,20 @@ uint8_t usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
     case ST_SEND: {
       const usbdpi_transfer_t *sending = ctx->sending;
       assert(sending);
-      if ((ctx->linebits & 0x3f) == 0x3f &&
-          !INSERT_ERR_BITSTUFF) {  // sent 6 ones
-        // bit stuff and force a transition
-        ctx->driving = inv_driving(ctx, d2p);
-        force_stat = 1;
-        ctx->linebits = (ctx->linebits << 1);
-      } else if (ctx->byte >= sending->num_bytes) {
+      if (ctx->tx_pos >= ctx->tx_nbits) {
         ctx->state = ST_EOP;
         ctx->driving = set_driving(ctx, d2p, 0, true);  // First SE0
         ctx->bit = 1;
         force_stat = 1;
       } else {
-        int nextbit = (sending->data[ctx->byte] & ctx->bit) ? 1 : 0;
-        if (nextbit == 0) {
+        // Data bits of 0 and stuffed bits are transitions
+        unsigned pos = ctx->tx_pos++;
+        if ((ctx->tx_bits[pos >> 5] >> (pos & 31U)) & 1U) {
           ctx->driving = inv_driving(ctx, d2p);
         }
-        ctx->linebits = (ctx->linebits << 1) | nextbit;
         force_stat = 1;
-        ctx->bit <<= 1;
-        if (ctx->bit == 0x100) {
-          ctx->bit = 1;
-          ctx->byte++;
-          if (ctx->byte == sending->data_start) {
-            ctx->state = ST_EOP0;
-          }
+        if (ctx->tx_pos >= ctx->tx_nbits && ctx->byte == sending->data_start) {
+          ctx->state = ST_EOP0;
         }
       }
     } break;
@@ -1473,6 +1546,11 @@ void usbdpi_close(void *ctx_void) {
   if (!ctx) {
     return;
   }
+  dpi_checkpoint_unregister(ctx);
+  if (ctx->loglevel & LOG_MON) {
+    printf("[usbdpi] At most %u of %u transfer descriptors were in use\n",
+           USBDPI_MAX_TRANSFERS - ctx->min_free, USBDPI_MAX_TRANSFERS);
+  }
   usb_monitor_fin(ctx->mon);
   free(ctx);
 }
@@ -47,8 +47,9 @@ typedef uint32_t svBitVecVal;
 #define SENSE_AT 20 * 8
 
 // Logging level (parameter to module)
-#define LOG_MON 0x01  // USB monitor logging (packet level)
-#define LOG_BIT 0x08  // bit level
+#define LOG_MON 0x01      // USB monitor logging (packet level)
+#define LOG_BIT 0x08      // bit level
+#define LOG_CAPTURE 0x10  // packet capture (pcapng) instead of packet log
 
 // Error insertion
 #define INSERT_ERR_CRC 0
@@ -143,10 +144,16 @@ typedef uint32_t svBitVecVal;
 // supported simultaneously
 #define USBDPI_MAX_STREAMS (USBDPI_MAX_ENDPOINTS - 1U)
 
+// Maximum number of received packets that each stream may hold, awaiting
+// transmission back to the device; the host model stops polling a stream for
+// IN packets whilst it has this many
+#define USBDPI_STREAM_MAX_QUEUED 2U
+
 // Maximum number of simultaneous transfer descriptors
-//   (The host model may simply avoid polling for further IN transfers
-//    whilst there are no further desciptors available)
-#define USBDPI_MAX_TRANSFERS 0x20U
+//   (those queued by each stream, plus those being sent and received, and
+//    a little slack)
+#define USBDPI_MAX_TRANSFERS \
+  (4U + USBDPI_MAX_STREAMS * USBDPI_STREAM_MAX_QUEUED)
 
 // Time intervals for common transactions, in bits
 // (allowing for bit stuffing and bus turnaround etc; for setting timeouts)
@@ -247,7 +254,6 @@ struct usbdpi_ctx {
   // Bus signalling state
   usbdpi_bus_state_t bus_state;
   uint32_t driving;
-  int linebits;
   int bit;
   int byte;
   /**
@@ -324,6 +330,17 @@ struct usbdpi_ctx {
    * Transfer currently being sent to the DUT (NULL iff none)
    */
   usbdpi_transfer_t *sending;
+  /**
+   * Line transitions of the packet being sent, serialised at the end of its
+   * SYNC, and the number of line states and the next one to be driven
+   */
+  uint32_t tx_bits[USBDPI_TX_BITS_WORDS];
+  uint16_t tx_nbits;
+  uint16_t tx_pos;
+  /**
+   * Serialised token packets, for reuse
+   */
+  usbdpi_token_bits_t token_cache[USBDPI_TOKEN_CACHE_SIZE];
 
   uint32_t last_pu;
   uint8_t lastrxpid;
@@ -388,6 +405,11 @@ struct usbdpi_ctx {
    * Linked-list of free transfer descriptors
    */
   usbdpi_transfer_t *free;
+  /**
+   * Number of free transfer descriptors, and the fewest there have been
+   */
+  uint8_t nfree;
+  uint8_t min_free;
 
   /**
    * Small pool of transfer descriptors
@@ -419,6 +441,12 @@ uint8_t usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p);
  */
 void usbdpi_diags(void *ctx_void, svBitVecVal *diags);
 
+/**
+ * Point the chandle of the usbdpi module in the current scope at ctx_void
+ * (exported from usbdpi.sv; used when restoring a simulation checkpoint)
+ */
+void usbdpi_set_ctx(void *ctx_void);
+
 /**
  * Calculate 5-bit CRC used to check token packets
  */
@@ -8,6 +8,10 @@
 // 0x01 -- monitor_usb (packet level)
 // 0x02 -- more verbose monitor
 // 0x08 -- bit level
+// 0x10 -- capture packets to <NAME>.pcapng (see usb_capture_decode.py) instead
+//         of logging them as text
+//
+// LOG_LEVEL can be overridden at runtime with +usbdpi_loglevel=N.
 
 module usbdpi #(
   parameter string NAME = "usb0",
@@ -36,7 +40,7 @@ module usbdpi #(
   input  logic pullupdp_d2p,
   input  logic pullupdn_d2p
 );
-  import "DPI-C" function
+  import "DPI-C" context function
     chandle usbdpi_create(input string name, input int loglevel);
 
   import "DPI-C" function
@@ -53,8 +57,22 @@ module usbdpi #(
 
   chandle ctx;
 
+  // Called when restoring a simulation checkpoint, to replace the restored
+  // chandle with the context created by this process.
+  export "DPI-C" function usbdpi_set_ctx;
+
+  function void usbdpi_set_ctx(chandle new_ctx);
+    ctx = new_ctx;
+  endfunction
+
   initial begin
-    ctx = usbdpi_create(NAME, LOG_LEVEL);
+    int loglevel;
+
+    // The logging (and packet capture) level can be customized at runtime
+    loglevel = LOG_LEVEL;
+    void'($value$plusargs("usbdpi_loglevel=%0d", loglevel));
+
+    ctx = usbdpi_create(NAME, loglevel);
   end
 
   final begin
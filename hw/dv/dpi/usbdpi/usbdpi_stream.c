@@ -39,6 +39,9 @@ static const char xfr_sym[] = {'C', 'X', 'B', 'I'};
 // Determine the next stream for which IN data packets shall be requested
 static inline unsigned in_stream_next(usbdpi_ctx_t *ctx);
 
+// Return the number of received packets queued by a stream
+static unsigned stream_num_queued(const usbdpi_stream_t *s);
+
 // Determine the next stream for which OUT data shall be sent
 static inline unsigned out_stream_next(usbdpi_ctx_t *ctx);
 
@@ -82,6 +85,15 @@ inline unsigned out_stream_next(usbdpi_ctx_t *ctx) {
   return id;
 }
 
+// Return the number of received packets queued by a stream
+unsigned stream_num_queued(const usbdpi_stream_t *s) {
+  unsigned n = 0U;
+  for (const usbdpi_transfer_t *tr = s->received; tr; tr = tr->next) {
+    n++;
+  }
+  return n;
+}
+
 // Initialize streaming state for the given number of streams
 bool streams_init(usbdpi_ctx_t *ctx, unsigned nstreams,
                   const uint8_t xfr_types[], bool retrieve, bool checking,
@@ -593,7 +605,12 @@ void streams_service(usbdpi_ctx_t *ctx) {
           printf("[usbdpi] IN considering #%u retrieve %u\n", id,
                  s->retrieve ? 1 : 0);
         }
-        if (s->retrieve) {
+        if (s->retrieve && stream_num_queued(s) >= USBDPI_STREAM_MAX_QUEUED) {
+          // Still trying to send the packets that we have; the device will
+          // hold onto its IN data until we have room for it, which keeps the
+          // number of transfer descriptors in use bounded
+          ctx->hostSt = HS_STREAMOUT;
+        } else if (s->retrieve) {
           // Ensure that a buffer is available for constructing a transfer
           usbdpi_transfer_t *tr = ctx->sending;
           if (!tr) {
@@ -0,0 +1,292 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Stress test and benchmark of the host side of the streaming test
+//
+// This runs the host model of usbdev_stream_test (streams_service) against a
+// simple model of the device software, with as many concurrent streams as
+// streams_init supports, for a given number of bus frames. The device model
+// checks all of the data that it receives and NAKs a proportion of the OUT
+// packets, so that the streams queue received packets and the host model has
+// to throttle its IN polling to keep within its pool of transfer descriptors.
+// The packets sent by the host are serialised as they would be for the bus.
+//
+// There is no simulator involved, so this is a quick way to check the
+// throughput of the host model and its resource usage over long runs. Build
+// it from this directory with all of these sources on one command line:
+//
+//   g++ -O2 -DUSBDPI_STANDALONE=1 -o usbdpi_stream_bench
+//       usbdpi_stream_bench.c usbdpi_stream.c usb_transfer.c usb_monitor.c
+//       usb_crc.c usb_utils.c
+//
+// and run it for a number of bus frames:
+//
+//   ./usbdpi_stream_bench 100000 > /dev/null
+//
+// Messages from the host model go to stdout; the results go to stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "usbdpi.h"
+
+// These must match the definitions in usbdpi_stream.c
+#define USBTST_LFSR_SEED(s) (uint8_t)(0x10U + (s)*7U)
+#define USBDPI_LFSR_SEED(s) (uint8_t)(0x9BU - (s)*7U)
+#define LFSR_ADVANCE(lfsr)     \
+  (uint8_t)(                   \
+      (uint8_t)((lfsr) << 1) ^ \
+      ((((lfsr) >> 1) ^ ((lfsr) >> 2) ^ ((lfsr) >> 3) ^ ((lfsr) >> 7)) & 1U))
+#define STREAM_SIGNATURE_HEAD 0x579EA01AU
+#define STREAM_SIGNATURE_TAIL 0x160AE975U
+
+// Bit intervals for the device to respond, and between packets
+#define TURNAROUND_BITS 16U
+
+// One in this many OUT packets is NAKed by the device
+#define OUT_NAK_RATE 8U
+
+// Device-side state of each stream
+typedef struct {
+  // Has the signature been accepted by the host?
+  bool sig_sent;
+  // DATAx PID of the next IN packet, and the next OUT packet expected
+  uint8_t in_toggle;
+  uint8_t out_toggle;
+  // LFSR for the IN data, and its state at the start of the pending packet
+  uint8_t in_lfsr;
+  uint8_t pending_lfsr;
+  // Length of the IN packet offered to the host (zero iff none)
+  unsigned pending_len;
+  // Expected OUT data is the IN data XORed with the host's LFSR
+  uint8_t chk_tst_lfsr;
+  uint8_t chk_dpi_lfsr;
+  // Statistics
+  unsigned long in_pkts;
+  unsigned long out_pkts;
+  unsigned long out_bytes;
+} dev_stream_t;
+
+static dev_stream_t dev[USBDPI_MAX_STREAMS];
+static unsigned long host_bits;
+static unsigned long naks;
+static uint32_t rand_state = 1U;
+
+static uint32_t next_rand(void) {
+  rand_state = rand_state * 1103515245U + 12345U;
+  return rand_state >> 8;
+}
+
+// Send the transfer that the host model has prepared, serialising each of its
+// packets for the bus
+static void bus_send(usbdpi_ctx_t *ctx) {
+  usbdpi_transfer_t *tr = ctx->sending;
+  assert(tr && ctx->state == ST_SYNC);
+  while (ctx->byte < (int)tr->num_bytes) {
+    transfer_serialise(ctx, tr);
+    // SYNC, packet and EOP
+    host_bits += 8U + ctx->tx_nbits + 3U;
+    ctx->tick_bits += 8U + ctx->tx_nbits + 3U;
+  }
+  ctx->state = ST_IDLE;
+}
+
+// The device responds to an IN token with data (or a NAK)
+static void dev_in(usbdpi_ctx_t *ctx, unsigned id) {
+  dev_stream_t *d = &dev[id];
+  usbdpi_transfer_t *rx = ctx->recving;
+  if (!rx) {
+    rx = transfer_alloc(ctx);
+    assert(rx);
+    ctx->recving = rx;
+  }
+  transfer_init(rx);
+
+  // Occasionally have no data ready
+  if (d->sig_sent && (next_rand() & 15U) == 0U) {
+    uint8_t pid = USB_PID_NAK;
+    transfer_append(rx, &pid, 1U);
+    ctx->lastrxpid = pid;
+  } else {
+    uint8_t *dp = transfer_data_start(rx, d->in_toggle, 0U);
+    if (!d->sig_sent) {
+      // The first packet carries only the stream signature
+      dp = set_le32(dp, STREAM_SIGNATURE_HEAD);
+      *dp++ = d->in_lfsr;
+      *dp++ = (uint8_t)id;
+      dp = set_le16(dp, 0U);
+      dp = set_le32(dp, 0x1000000U);
+      dp = set_le32(dp, STREAM_SIGNATURE_TAIL);
+    } else {
+      // Offer the same data again until it has been accepted
+      if (!d->pending_len) {
+        d->pending_len = 1U + next_rand() % USBDEV_MAX_PACKET_SIZE;
+        d->pending_lfsr = d->in_lfsr;
+      }
+      uint8_t lfsr = d->pending_lfsr;
+      for (unsigned idx = 0U; idx < d->pending_len; idx++) {
+        *dp++ = lfsr;
+        lfsr = LFSR_ADVANCE(lfsr);
+      }
+    }
+    transfer_data_end(rx, dp);
+    ctx->lastrxpid = d->in_toggle;
+  }
+  ctx->tick_bits += TURNAROUND_BITS + 8U + 8U * transfer_length(rx);
+  ctx->bus_state = kUsbBulkInData;
+}
+
+// The host model has ACKed or NAKed the IN data
+static void dev_in_status(usbdpi_ctx_t *ctx, unsigned id) {
+  dev_stream_t *d = &dev[id];
+  if (ctx->sending->data[0] != USB_PID_ACK) {
+    return;
+  }
+  d->in_toggle = DATA_TOGGLE_ADVANCE(d->in_toggle);
+  d->in_pkts++;
+  if (!d->sig_sent) {
+    d->sig_sent = true;
+  } else {
+    for (unsigned idx = 0U; idx < d->pending_len; idx++) {
+      d->in_lfsr = LFSR_ADVANCE(d->in_lfsr);
+    }
+    d->pending_len = 0U;
+  }
+}
+
+// The device receives OUT data from the host model
+static bool dev_out(usbdpi_ctx_t *ctx, unsigned id) {
+  dev_stream_t *d = &dev[id];
+  usbdpi_transfer_t *tr = ctx->sending;
+
+  ctx->tick_bits += TURNAROUND_BITS + 8U + 16U;
+  ctx->bus_state = kUsbBulkOutAck;
+  if (next_rand() % OUT_NAK_RATE == 0U) {
+    ctx->lastrxpid = USB_PID_NAK;
+    naks++;
+    return true;
+  }
+  ctx->lastrxpid = USB_PID_ACK;
+
+  if (transfer_data_pid(tr) != d->out_toggle) {
+    fprintf(stderr, "Stream %u: unexpected data toggle\n", id);
+    return false;
+  }
+  d->out_toggle = DATA_TOGGLE_ADVANCE(d->out_toggle);
+
+  const uint8_t *dp = transfer_data_field(tr);
+  unsigned len = transfer_length(tr) - tr->data_start - 3U;
+  for (unsigned idx = 0U; idx < len; idx++) {
+    uint8_t expected = d->chk_tst_lfsr ^ d->chk_dpi_lfsr;
+    if (dp[idx] != expected) {
+      fprintf(stderr, "Stream %u: OUT data 0x%02x, expected 0x%02x\n", id,
+              dp[idx], expected);
+      return false;
+    }
+    d->chk_tst_lfsr = LFSR_ADVANCE(d->chk_tst_lfsr);
+    d->chk_dpi_lfsr = LFSR_ADVANCE(d->chk_dpi_lfsr);
+  }
+  d->out_pkts++;
+  d->out_bytes += len;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long nframes = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000U;
+
+  usbdpi_ctx_t *ctx = (usbdpi_ctx_t *)calloc(1, sizeof(usbdpi_ctx_t));
+  assert(ctx);
+  ctx->mon = usb_monitor_init("/dev/null", NULL, NULL, NULL);
+  assert(ctx->mon);
+  usb_transfer_setup(ctx);
+  ctx->dev_address = USBDEV_ADDRESS;
+
+  // As many streams as the host model supports, all Bulk
+  const unsigned nstreams = USBDPI_MAX_STREAMS;
+  uint8_t xfr_types[USBDPI_MAX_STREAMS];
+  memset(xfr_types, USB_TRANSFER_TYPE_BULK, sizeof(xfr_types));
+  if (!streams_init(ctx, nstreams, xfr_types, true, true, true, true)) {
+    fprintf(stderr, "Unable to initialize %u streams\n", nstreams);
+    return 1;
+  }
+  for (unsigned id = 0U; id < nstreams; id++) {
+    ctx->ep_in[ctx->stream[id].ep_in].next_data = USB_PID_DATA0;
+    ctx->ep_out[ctx->stream[id].ep_out].next_data = USB_PID_DATA0;
+    dev[id].in_toggle = USB_PID_DATA0;
+    dev[id].out_toggle = USB_PID_DATA0;
+    dev[id].in_lfsr = USBTST_LFSR_SEED(id);
+    dev[id].chk_tst_lfsr = USBTST_LFSR_SEED(id);
+    dev[id].chk_dpi_lfsr = USBDPI_LFSR_SEED(id);
+  }
+
+  clock_t start = clock();
+  ctx->hostSt = HS_STARTFRAME;
+  for (unsigned long frame = 0U; frame < nframes; frame++) {
+    // Start Of Frame
+    ctx->frame_start = ctx->tick_bits;
+    if (!ctx->sending) {
+      ctx->sending = transfer_alloc(ctx);
+      assert(ctx->sending);
+    }
+    transfer_frame_start(ctx, ctx->sending, ++ctx->frame);
+    bus_send(ctx);
+    if (ctx->hostSt == HS_NEXTFRAME) {
+      ctx->hostSt = HS_STARTFRAME;
+    }
+
+    while (ctx->hostSt != HS_NEXTFRAME) {
+      usbdpi_host_state_t prev = ctx->hostSt;
+      streams_service(ctx);
+      switch (prev) {
+        case HS_STARTFRAME:
+        case HS_STREAMOUT:
+          if (ctx->hostSt == HS_WAITACK) {
+            bus_send(ctx);
+            if (!dev_out(ctx, ctx->stream_out)) {
+              return 1;
+            }
+          }
+          break;
+        case HS_STREAMIN:
+          if (ctx->hostSt == HS_WAIT_PKT) {
+            bus_send(ctx);
+            dev_in(ctx, ctx->stream_in);
+          }
+          break;
+        case HS_ACKIFDATA:
+          if (ctx->state == ST_SYNC) {
+            bus_send(ctx);
+            dev_in_status(ctx, ctx->stream_in);
+          }
+          break;
+        default:
+          break;
+      }
+      ctx->tick_bits += TURNAROUND_BITS;
+      assert(ctx->hostSt != HS_ERROR);
+    }
+  }
+  double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  unsigned long in_pkts = 0U, out_pkts = 0U, out_bytes = 0U;
+  for (unsigned id = 0U; id < nstreams; id++) {
+    in_pkts += dev[id].in_pkts;
+    out_pkts += dev[id].out_pkts;
+    out_bytes += dev[id].out_bytes;
+  }
+  fprintf(stderr, "%u streams, %lu frames\n", nstreams, nframes);
+  fprintf(stderr, "IN packets %lu, OUT packets %lu (%lu bytes), NAKs %lu\n",
+          in_pkts, out_pkts, out_bytes, naks);
+  fprintf(stderr, "Serialised %lu host bits\n", host_bits);
+  fprintf(stderr, "At most %u of %u transfer descriptors in use\n",
+          USBDPI_MAX_TRANSFERS - ctx->min_free, USBDPI_MAX_TRANSFERS);
+  fprintf(stderr, "%.3f s, %.0f frames/s, %.0f packets/s\n", secs,
+          nframes / secs, (in_pkts + out_pkts) / secs);
+
+  usb_monitor_fin(ctx->mon);
+  free(ctx);
+  return 0;
+}
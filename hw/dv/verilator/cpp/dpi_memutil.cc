@@ -5,6 +5,7 @@
 #include "dpi_memutil.h"
 
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
@@ -372,6 +373,66 @@ void DpiMemUtil::PrintMemRegions() const {
   }
 }
 
+std::string DpiMemUtil::GetLayoutDescription() const {
+  std::ostringstream oss;
+  for (const auto &pr : name_to_mem_) {
+    const MemArea &mem = *mem_areas_[pr.second];
+    oss << pr.first << ' ' << std::hex << base_addrs_[pr.second] << ' '
+        << mem.GetSizeBytes() << ' ' << std::dec << mem.GetWidth() << '\n';
+  }
+  return oss.str();
+}
+
+void DpiMemUtil::BenchmarkMemAreas() const {
+  typedef std::chrono::steady_clock clock;
+
+  std::cout << "Memory load benchmark (per-word DPI calls vs. block transfers):"
+            << std::endl;
+  for (const auto &pr : name_to_mem_) {
+    const MemArea &mem = *mem_areas_[pr.second];
+    uint32_t num_words = mem.GetSizeWords();
+
+    // Fill a physical image with an arbitrary pattern. The benchmark writes
+    // raw physical words, so this doesn't need to have valid ECC bits.
+    std::vector<uint8_t> image((size_t)num_words * SV_MEM_WIDTH_BYTES);
+    for (size_t i = 0; i < image.size(); ++i) {
+      image[i] = (uint8_t)(i * 0x9d + 0x5a);
+    }
+
+    try {
+      // Save the current contents, so that we can put them back afterwards.
+      std::vector<uint8_t> saved(image.size());
+      mem.ReadBlock(&saved[0], 0, num_words);
+
+      clock::time_point t0 = clock::now();
+      for (uint32_t i = 0; i < num_words; ++i) {
+        mem.WriteBlock(i, 1, &image[(size_t)i * SV_MEM_WIDTH_BYTES]);
+      }
+      clock::time_point t1 = clock::now();
+      mem.WriteBlock(0, num_words, &image[0]);
+      clock::time_point t2 = clock::now();
+
+      mem.WriteBlock(0, num_words, &saved[0]);
+
+      double word_us =
+          std::chrono::duration<double, std::micro>(t1 - t0).count();
+      double block_us =
+          std::chrono::duration<double, std::micro>(t2 - t1).count();
+
+      std::cout << "\t'" << pr.first << "' (" << num_words << " words of "
+                << mem.GetWidth() << " bits): per-word " << word_us
+                << " us, block " << block_us << " us";
+      if (block_us > 0) {
+        std::cout << " (" << word_us / block_us << "x)";
+      }
+      std::cout << std::endl;
+    } catch (const SVScoped::Error &err) {
+      std::cout << "\t'" << pr.first << "': skipped (no memory found at `"
+                << err.scope_name_ << "')." << std::endl;
+    }
+  }
+}
+
 void DpiMemUtil::LoadFileToNamedMem(bool verbose, const std::string &name,
                                     const std::string &filepath,
                                     MemImageType type) {
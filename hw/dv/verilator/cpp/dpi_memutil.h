@@ -58,6 +58,9 @@ class StagedMem {
  * These utilities require the corresponding DPI functions:
  * simutil_memload()
  * simutil_set_mem()
+ * simutil_get_mem()
+ * simutil_set_mem_block()
+ * simutil_get_mem_block()
  * to be defined somewhere as SystemVerilog functions.
  */
 class DpiMemUtil {
@@ -105,6 +108,22 @@ class DpiMemUtil {
    */
   void PrintMemRegions() const;
 
+  /**
+   * Return a string describing the name, LMA range and width of each
+   * registered memory region
+   *
+   * This is saved in simulation checkpoints so that a checkpoint can't be
+   * restored into a simulation with a different memory layout.
+   */
+  std::string GetLayoutDescription() const;
+
+  /**
+   * Time how long it takes to fill each registered memory region, first with
+   * one DPI call per word and then with block transfers, and print the
+   * results. The previous contents of each memory are restored afterwards.
+   */
+  void BenchmarkMemAreas() const;
+
   /**
    * Load the file at filepath into the named memory. If type is
    * kMemImageUnknown, the file type is determined from the path.
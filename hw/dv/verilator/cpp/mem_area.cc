@@ -16,6 +16,8 @@ extern "C" {
 void simutil_memload(const char *file);
 int simutil_set_mem(int index, const svBitVecVal *val);
 int simutil_get_mem(int index, svBitVecVal *val);
+int simutil_set_mem_block(int index, int count, const svBitVecVal *val);
+int simutil_get_mem_block(int index, int count, svBitVecVal *val);
 }
 
 MemArea::MemArea(const std::string &scope, uint32_t num_words,
@@ -27,27 +29,13 @@ MemArea::MemArea(const std::string &scope, uint32_t num_words,
 
 void MemArea::Write(uint32_t word_offset,
                     const std::vector<uint8_t> &data) const {
-  // This "mini buffer" is used to transfer each write to SystemVerilog.
-  // `simutil_set_mem` takes a fixed SV_MEM_WIDTH_BITS-bit vector but it will
-  // only use the bits required for the RAM width. As an example, for a 32-bit
-  // wide RAM only elements 3:0 of `minibuf` will be written to memory. Since
-  // the simulator may still read bits from minibuf it does not use, we must
-  // use a fixed allocation of the full bit vector size to avoid an out of
-  // bounds access.
-  uint8_t minibuf[SV_MEM_WIDTH_BYTES];
-  memset(minibuf, 0, sizeof minibuf);
-  assert(width_byte_ <= sizeof minibuf);
-
   uint32_t data_words = (data.size() + width_byte_ - 1) / width_byte_;
   assert(word_offset + data_words <= num_words_);
 
-  for (uint32_t i = 0; i < data_words; ++i) {
-    uint32_t dst_word = word_offset + i;
-    uint32_t phys_addr = ToPhysAddr(dst_word);
-
-    WriteBuffer(minibuf, data, i * width_byte_, dst_word);
-    WriteFromMinibuf(phys_addr, minibuf, dst_word);
-  }
+  WriteWords(word_offset, data_words,
+             [&](uint8_t *buf, uint32_t idx, uint32_t dst_word) {
+               WriteBuffer(buf, data, idx * width_byte_, dst_word);
+             });
 }
 
 std::vector<uint8_t> MemArea::Read(uint32_t word_offset,
@@ -57,23 +45,89 @@ std::vector<uint8_t> MemArea::Read(uint32_t word_offset,
   uint32_t num_bytes = width_byte_ * num_words;
   assert(num_words <= num_bytes);
 
-  // See Write for an explanation for this buffer.
-  uint8_t minibuf[SV_MEM_WIDTH_BYTES];
-  memset(minibuf, 0, sizeof minibuf);
-  assert(width_byte_ <= sizeof minibuf);
-
   std::vector<uint8_t> ret;
   ret.reserve(num_bytes);
 
-  for (uint32_t i = 0; i < num_words; ++i) {
-    uint32_t src_word = word_offset + i;
-    uint32_t phys_addr = ToPhysAddr(src_word);
+  ReadWords(word_offset, num_words,
+            [&](const uint8_t *buf, uint32_t src_word) {
+              ReadBuffer(ret, buf, src_word);
+            });
+
+  return ret;
+}
+
+void MemArea::WriteBlock(uint32_t phys_addr, uint32_t num_words,
+                         const uint8_t *buf) const {
+  // `simutil_set_mem_block` takes a fixed-size array of SV_MEM_BLOCK_WORDS
+  // entries, each of which is a SV_MEM_WIDTH_BITS-bit vector. It will only use
+  // the entries and bits that it needs, but the simulator may still read the
+  // rest of the array. To avoid out of bounds accesses, partial blocks are
+  // copied into a buffer of the full size first.
+  std::vector<uint8_t> staging;
 
-    ReadToMinibuf(minibuf, phys_addr);
-    ReadBuffer(ret, minibuf, src_word);
+  SVScoped scoped(scope_);
+  while (num_words) {
+    uint32_t count = std::min(num_words, (uint32_t)SV_MEM_BLOCK_WORDS);
+    int ok;
+
+    if (count == 1) {
+      ok = simutil_set_mem(phys_addr, (const svBitVecVal *)buf);
+    } else if (count == SV_MEM_BLOCK_WORDS) {
+      ok = simutil_set_mem_block(phys_addr, count, (const svBitVecVal *)buf);
+    } else {
+      staging.resize(SV_MEM_BLOCK_WORDS * SV_MEM_WIDTH_BYTES);
+      memcpy(&staging[0], buf, count * SV_MEM_WIDTH_BYTES);
+      ok = simutil_set_mem_block(phys_addr, count,
+                                 (const svBitVecVal *)&staging[0]);
+    }
+
+    if (!ok) {
+      std::ostringstream oss;
+      oss << "Could not set " << std::dec << count
+          << " memory word(s) at physical index 0x" << std::hex << phys_addr
+          << ".";
+      throw std::runtime_error(oss.str());
+    }
+
+    phys_addr += count;
+    num_words -= count;
+    buf += count * SV_MEM_WIDTH_BYTES;
   }
+}
 
-  return ret;
+void MemArea::ReadBlock(uint8_t *buf, uint32_t phys_addr,
+                        uint32_t num_words) const {
+  // See WriteBlock for an explanation of this buffer. When reading, the
+  // simulator may write to every entry of the array.
+  std::vector<uint8_t> staging;
+
+  SVScoped scoped(scope_);
+  while (num_words) {
+    uint32_t count = std::min(num_words, (uint32_t)SV_MEM_BLOCK_WORDS);
+    int ok;
+
+    if (count == 1) {
+      ok = simutil_get_mem(phys_addr, (svBitVecVal *)buf);
+    } else if (count == SV_MEM_BLOCK_WORDS) {
+      ok = simutil_get_mem_block(phys_addr, count, (svBitVecVal *)buf);
+    } else {
+      staging.resize(SV_MEM_BLOCK_WORDS * SV_MEM_WIDTH_BYTES);
+      ok = simutil_get_mem_block(phys_addr, count, (svBitVecVal *)&staging[0]);
+      memcpy(buf, &staging[0], count * SV_MEM_WIDTH_BYTES);
+    }
+
+    if (!ok) {
+      std::ostringstream oss;
+      oss << "Could not read " << std::dec << count
+          << " memory word(s) at physical index 0x" << std::hex << phys_addr
+          << ".";
+      throw std::runtime_error(oss.str());
+    }
+
+    phys_addr += count;
+    num_words -= count;
+    buf += count * SV_MEM_WIDTH_BYTES;
+  }
 }
 
 void MemArea::LoadVmem(const std::string &path) const {
@@ -101,23 +155,78 @@ void MemArea::ReadBuffer(std::vector<uint8_t> &data,
               std::back_inserter(data));
 }
 
-void MemArea::ReadToMinibuf(uint8_t *minibuf, uint32_t phys_addr) const {
-  SVScoped scoped(scope_);
-  if (!simutil_get_mem(phys_addr, (svBitVecVal *)minibuf)) {
-    std::ostringstream oss;
-    oss << "Could not read memory word at physical index 0x" << std::hex
-        << phys_addr << ".";
-    throw std::runtime_error(oss.str());
+void MemArea::WriteWords(uint32_t word_offset, uint32_t num_words,
+                         const WordWriter &writer) const {
+  assert(word_offset + num_words <= num_words_);
+
+  PrepareAccess();
+
+  // Words are generated into this buffer, one SV_MEM_WIDTH_BYTES entry per
+  // word, and then passed to SystemVerilog in physically contiguous runs.
+  // Each writer must fill every bit that will be used by the memory, but
+  // needn't clear bits further up.
+  std::vector<uint8_t> blockbuf(SV_MEM_BLOCK_WORDS * SV_MEM_WIDTH_BYTES, 0);
+
+  for (uint32_t chunk = 0; chunk < num_words; chunk += SV_MEM_BLOCK_WORDS) {
+    uint32_t chunk_words =
+        std::min(num_words - chunk, (uint32_t)SV_MEM_BLOCK_WORDS);
+
+    for (uint32_t i = 0; i < chunk_words; ++i) {
+      writer(&blockbuf[i * SV_MEM_WIDTH_BYTES], chunk + i,
+             word_offset + chunk + i);
+    }
+
+    ForEachPhysRun(word_offset + chunk, chunk_words,
+                   [&](uint32_t idx, uint32_t phys_addr, uint32_t count) {
+                     WriteBlock(phys_addr, count,
+                                &blockbuf[idx * SV_MEM_WIDTH_BYTES]);
+                   });
   }
 }
 
-void MemArea::WriteFromMinibuf(uint32_t phys_addr, const uint8_t *minibuf,
-                               uint32_t dst_word) const {
-  SVScoped scoped(scope_);
-  if (!simutil_set_mem(phys_addr, (const svBitVecVal *)minibuf)) {
-    std::ostringstream oss;
-    oss << "Could not set memory at byte offset 0x" << std::hex
-        << dst_word * width_byte_ << ".";
-    throw std::runtime_error(oss.str());
+void MemArea::ReadWords(uint32_t word_offset, uint32_t num_words,
+                        const WordReader &reader) const {
+  assert(word_offset + num_words <= num_words_);
+
+  PrepareAccess();
+
+  // See WriteWords for an explanation of this buffer.
+  std::vector<uint8_t> blockbuf(SV_MEM_BLOCK_WORDS * SV_MEM_WIDTH_BYTES, 0);
+
+  for (uint32_t chunk = 0; chunk < num_words; chunk += SV_MEM_BLOCK_WORDS) {
+    uint32_t chunk_words =
+        std::min(num_words - chunk, (uint32_t)SV_MEM_BLOCK_WORDS);
+
+    ForEachPhysRun(word_offset + chunk, chunk_words,
+                   [&](uint32_t idx, uint32_t phys_addr, uint32_t count) {
+                     ReadBlock(&blockbuf[idx * SV_MEM_WIDTH_BYTES], phys_addr,
+                               count);
+                   });
+
+    for (uint32_t i = 0; i < chunk_words; ++i) {
+      reader(&blockbuf[i * SV_MEM_WIDTH_BYTES], word_offset + chunk + i);
+    }
   }
 }
+
+void MemArea::ForEachPhysRun(
+    uint32_t word_offset, uint32_t num_words,
+    const std::function<void(uint32_t idx, uint32_t phys_addr, uint32_t count)>
+        &fn) const {
+  if (!num_words)
+    return;
+
+  uint32_t run_idx = 0;
+  uint32_t run_phys = ToPhysAddr(word_offset);
+
+  for (uint32_t i = 1; i < num_words; ++i) {
+    uint32_t phys_addr = ToPhysAddr(word_offset + i);
+    if (phys_addr != run_phys + (i - run_idx)) {
+      fn(run_idx, run_phys, i - run_idx);
+      run_idx = i;
+      run_phys = phys_addr;
+    }
+  }
+
+  fn(run_idx, run_phys, num_words - run_idx);
+}
@@ -6,6 +6,7 @@
 #define OPENTITAN_HW_DV_VERILATOR_CPP_MEM_AREA_H_
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -18,6 +19,11 @@
 // using the svBitVecVal type, we have to round up to the next 32-bit word.
 #define SV_MEM_WIDTH_BYTES (4 * ((SV_MEM_WIDTH_BITS + 31) / 32))
 
+// This is the number of memory words that can be passed in a single call to
+// simutil_set_mem_block or simutil_get_mem_block. It must match the size of
+// the unpacked array arguments of those functions in prim_util_memload.svh.
+#define SV_MEM_BLOCK_WORDS 256
+
 /**
  * A "memory area", representing a memory in the simulated design.
  */
@@ -43,7 +49,7 @@ class MemArea {
    *
    * This assumes that the result will fit in the memory. If the scope cannot
    * be set, this throws an SVScoped::Error. If a call to \c simutil_set_mem
-   * fails, this throws a \c std::runtime_error.
+   * or \c simutil_set_mem_block fails, this throws a \c std::runtime_error.
    *
    * @param word_offset The offset, in words, of the first word that should be
    *                    written.
@@ -61,7 +67,8 @@ class MemArea {
    * memory. Returns a vector with <tt>num_words * width_byte_</tt> elements.
    *
    * If the scope cannot be set, this throws an SVScoped::Error. If a call to
-   * simutil_get_mem fails, this throws a std::runtime_error.
+   * simutil_get_mem or simutil_get_mem_block fails, this throws a
+   * std::runtime_error.
    *
    * @param word_offset The offset, in words, of the first word that should be
    *                    written.
@@ -71,6 +78,43 @@ class MemArea {
   virtual std::vector<uint8_t> Read(uint32_t word_offset,
                                     uint32_t num_words) const;
 
+  /** Write physical memory words, starting at the given physical address
+   *
+   * This bypasses any address mapping, scrambling or ECC: each word is copied
+   * straight into the memory array. Words are passed to SystemVerilog in
+   * groups of up to \c SV_MEM_BLOCK_WORDS using \c simutil_set_mem_block
+   * (or \c simutil_set_mem for a single word), which needs far fewer DPI
+   * calls and scope changes than writing one word at a time.
+   *
+   * If the scope cannot be set, this throws an SVScoped::Error. If a DPI call
+   * fails, this throws a \c std::runtime_error.
+   *
+   * @param phys_addr The physical index of the first word to write.
+   *
+   * @param num_words The number of words to write.
+   *
+   * @param buf       Source buffer. This contains \p num_words entries, each
+   *                  of which is \c SV_MEM_WIDTH_BYTES bytes long.
+   */
+  void WriteBlock(uint32_t phys_addr, uint32_t num_words,
+                  const uint8_t *buf) const;
+
+  /** Read physical memory words, starting at the given physical address
+   *
+   * This is the counterpart of WriteBlock(). If the scope cannot be set, this
+   * throws an SVScoped::Error. If a DPI call fails, this throws a \c
+   * std::runtime_error.
+   *
+   * @param buf       Destination buffer. This must have space for \p
+   *                  num_words entries, each of which is \c
+   *                  SV_MEM_WIDTH_BYTES bytes long.
+   *
+   * @param phys_addr The physical index of the first word to read.
+   *
+   * @param num_words The number of words to read.
+   */
+  void ReadBlock(uint8_t *buf, uint32_t phys_addr, uint32_t num_words) const;
+
   /** Use \c simutil_memload to load a vmem file into the memory */
   virtual void LoadVmem(const std::string &path) const;
 
@@ -131,20 +175,57 @@ class MemArea {
     return logical_addr;
   }
 
-  /** Read the memory word at phys_addr into minibuf
+  /** Prepare for a batch of accesses
+   *
+   * This is called once at the start of each bulk read or write, before any
+   * calls to ToPhysAddr(), WriteBuffer() or ReadBuffer() for that access.
+   * Memories whose layout depends on state in the design (such as scrambling
+   * keys) can use it to take a snapshot of that state. The default
+   * implementation does nothing.
+   */
+  virtual void PrepareAccess() const {}
+
+  /** A callback that fills in \p buf with the physical contents of the
+   * memory word at logical address \p dst_word. \p idx is the index of the
+   * word within the current write (starting at zero).
+   */
+  typedef std::function<void(uint8_t *buf, uint32_t idx, uint32_t dst_word)>
+      WordWriter;
+
+  /** A callback that extracts logical data from \p buf, which holds the
+   * physical contents of the memory word at logical address \p src_word.
+   */
+  typedef std::function<void(const uint8_t *buf, uint32_t src_word)>
+      WordReader;
+
+  /** Write \p num_words logical words, starting at \p word_offset
+   *
+   * Each word is generated by \p writer and words that map to consecutive
+   * physical addresses are batched into a single call to WriteBlock().
+   */
+  void WriteWords(uint32_t word_offset, uint32_t num_words,
+                  const WordWriter &writer) const;
+
+  /** Read \p num_words logical words, starting at \p word_offset
    *
-   * minibuf should be at least SV_MEM_WIDTH_BYTES in size. See the
-   * implementation of MemArea::Write() for the details.
+   * Words that map to consecutive physical addresses are fetched with a
+   * single call to ReadBlock() and then passed to \p reader in logical
+   * order.
    */
-  void ReadToMinibuf(uint8_t *minibuf, uint32_t phys_addr) const;
+  void ReadWords(uint32_t word_offset, uint32_t num_words,
+                 const WordReader &reader) const;
 
-  /** Write from minibuf to the memory word at phys_addr
+ private:
+  /** Split \p num_words logical words, starting at \p word_offset, into runs
+   * of words with consecutive physical addresses.
    *
-   * minibuf should be at least SV_MEM_WIDTH_BYTES in size. See the
-   * implementation of MemArea::Write() for the details.
+   * For each run, calls \p fn with the index of the run's first word
+   * (relative to \p word_offset), its physical address and its length.
    */
-  void WriteFromMinibuf(uint32_t phys_addr, const uint8_t *minibuf,
-                        uint32_t dst_word) const;
+  void ForEachPhysRun(
+      uint32_t word_offset, uint32_t num_words,
+      const std::function<void(uint32_t idx, uint32_t phys_addr,
+                               uint32_t count)> &fn) const;
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_CPP_MEM_AREA_H_
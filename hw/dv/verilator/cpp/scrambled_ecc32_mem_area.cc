@@ -17,33 +17,12 @@
 static const uint32_t kScrMaxNonceWidth = 320;
 static const uint32_t kScrMaxNonceWidthByte = (kScrMaxNonceWidth + 7) / 8;
 
-// Functions to convert from integer address to/from a little-endian vector of
-// bytes, addr_width is given in bits
-static std::vector<uint8_t> AddrIntToBytes(uint32_t addr, uint32_t addr_width) {
-  uint32_t addr_width_bytes = (addr_width + 7) / 8;
-  std::vector<uint8_t> addr_bytes(addr_width_bytes);
-
-  for (uint32_t i = 0; i < addr_width_bytes; ++i) {
-    addr_bytes[i] = addr & 0xff;
-    addr >>= 8;
-  }
-
-  return addr_bytes;
-}
-
-static uint32_t AddrBytesToInt(const std::vector<uint8_t> &addr) {
-  assert(addr.size() <= 4);
+// Marks an entry in the physical address cache that hasn't been computed yet
+static const uint32_t kPhysAddrUnknown = ~(uint32_t)0;
 
-  uint32_t addr_out = 0;
-  int cur_shift = 0;
-
-  for (uint8_t byte : addr) {
-    addr_out |= ((uint32_t)byte << cur_shift);
-    cur_shift += 8;
-  }
-
-  return addr_out;
-}
+// The number of words whose keystream is computed together when there is a
+// miss in the keystream cache
+static const uint32_t kKeystreamBatchWords = 64;
 
 // Converts svBitVecVal (bit[m:n] SV type) into a byte vector
 static std::vector<uint8_t> ByteVecFromSV(svBitVecVal sv_val[],
@@ -150,6 +129,60 @@ uint32_t ScrambledEcc32MemArea::GetNonceWidthByte() const {
   return GetPrinceReplications() * 8;
 }
 
+void ScrambledEcc32MemArea::PrepareAccess() const {
+  std::vector<uint8_t> key = GetScrambleKey();
+  std::vector<uint8_t> nonce = GetScrambleNonce();
+
+  if (key == key_ && nonce == nonce_) {
+    return;
+  }
+
+  key_ = std::move(key);
+  nonce_ = std::move(nonce);
+  prince_key_ = prince_key_from_bytes(&key_[0]);
+
+  phys_addrs_.assign(num_words_, kPhysAddrUnknown);
+  keystream_.resize((size_t)num_words_ * GetPhysWidthByte());
+  keystream_valid_.assign(num_words_, false);
+}
+
+const uint8_t *ScrambledEcc32MemArea::GetKeystream(
+    uint32_t logical_addr) const {
+  assert(logical_addr < keystream_valid_.size());
+
+  uint32_t phys_width_byte = GetPhysWidthByte();
+  uint8_t *keystream = &keystream_[(size_t)logical_addr * phys_width_byte];
+
+  if (!keystream_valid_[logical_addr]) {
+    // Compute the keystream for an aligned batch of words with a single
+    // batched PRINCE call, since nearby words are likely to be needed next.
+    uint32_t first = logical_addr - (logical_addr % kKeystreamBatchWords);
+    uint32_t count = std::min(kKeystreamBatchWords, num_words_ - first);
+    uint32_t words_per_addr = scramble_keystream_words(GetPhysWidth());
+
+    uint32_t addrs[kKeystreamBatchWords];
+    for (uint32_t i = 0; i < count; ++i) {
+      addrs[i] = first + i;
+    }
+
+    std::vector<uint64_t> batch((size_t)count * words_per_addr);
+    scramble_keystream_batch(addrs, count, addr_width_, &nonce_[0],
+                             prince_key_, GetPhysWidth(), repeat_keystream_,
+                             &batch[0]);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      uint8_t *dst = &keystream_[(size_t)(first + i) * phys_width_byte];
+      for (uint32_t j = 0; j < phys_width_byte; ++j) {
+        dst[j] = (batch[(size_t)i * words_per_addr + j / 8] >> (8 * (j % 8))) &
+                 0xff;
+      }
+      keystream_valid_[first + i] = true;
+    }
+  }
+
+  return keystream;
+}
+
 void ScrambledEcc32MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
                                         const std::vector<uint8_t> &data,
                                         size_t start_idx,
@@ -159,28 +192,32 @@ void ScrambledEcc32MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
   ScrambleBuffer(buf, dst_word);
 }
 
-std::vector<uint8_t> ScrambledEcc32MemArea::ReadUnscrambled(
-    const uint8_t buf[SV_MEM_WIDTH_BYTES], uint32_t src_word) const {
-  std::vector<uint8_t> scrambled_data(buf, buf + GetPhysWidthByte());
-  return scramble_decrypt_data(scrambled_data, GetPhysWidth(), 39,
-                               AddrIntToBytes(src_word, addr_width_),
-                               addr_width_, GetScrambleNonce(),
-                               GetScrambleKey(), repeat_keystream_, false);
+void ScrambledEcc32MemArea::ReadUnscrambled(
+    uint8_t out[SV_MEM_WIDTH_BYTES], const uint8_t buf[SV_MEM_WIDTH_BYTES],
+    uint32_t src_word) const {
+  // Memory scrambling doesn't use the S&P layer, so decryption is just an XOR
+  // with the keystream for this address (see scramble_decrypt_data).
+  const uint8_t *keystream = GetKeystream(src_word);
+  for (uint32_t i = 0; i < GetPhysWidthByte(); ++i) {
+    out[i] = buf[i] ^ keystream[i];
+  }
 }
 
 void ScrambledEcc32MemArea::ReadBuffer(std::vector<uint8_t> &data,
                                        const uint8_t buf[SV_MEM_WIDTH_BYTES],
                                        uint32_t src_word) const {
-  std::vector<uint8_t> unscrambled_data = ReadUnscrambled(buf, src_word);
+  uint8_t unscrambled_data[SV_MEM_WIDTH_BYTES];
+  ReadUnscrambled(unscrambled_data, buf, src_word);
   // Strip integrity to give final result
-  Ecc32MemArea::ReadBuffer(data, &unscrambled_data[0], src_word);
+  Ecc32MemArea::ReadBuffer(data, unscrambled_data, src_word);
 }
 
 void ScrambledEcc32MemArea::ReadBufferWithIntegrity(
     EccWords &data, const uint8_t buf[SV_MEM_WIDTH_BYTES],
     uint32_t src_word) const {
-  std::vector<uint8_t> unscrambled_data = ReadUnscrambled(buf, src_word);
-  Ecc32MemArea::ReadBufferWithIntegrity(data, &unscrambled_data[0], src_word);
+  uint8_t unscrambled_data[SV_MEM_WIDTH_BYTES];
+  ReadUnscrambled(unscrambled_data, buf, src_word);
+  Ecc32MemArea::ReadBufferWithIntegrity(data, unscrambled_data, src_word);
 }
 
 void ScrambledEcc32MemArea::WriteBufferWithIntegrity(
@@ -192,21 +229,23 @@ void ScrambledEcc32MemArea::WriteBufferWithIntegrity(
 
 void ScrambledEcc32MemArea::ScrambleBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
                                            uint32_t dst_word) const {
-  std::vector<uint8_t> scramble_buf(buf, buf + GetPhysWidthByte());
-
-  // Scramble data with integrity
-  scramble_buf = scramble_encrypt_data(
-      scramble_buf, GetPhysWidth(), 39, AddrIntToBytes(dst_word, addr_width_),
-      addr_width_, GetScrambleNonce(), GetScrambleKey(), repeat_keystream_,
-      false);
-
-  // Copy scrambled data to write buffer
-  std::copy(scramble_buf.begin(), scramble_buf.end(), &buf[0]);
+  // Scramble data with integrity. As in ReadUnscrambled, this is an XOR with
+  // the keystream (see scramble_encrypt_data).
+  const uint8_t *keystream = GetKeystream(dst_word);
+  for (uint32_t i = 0; i < GetPhysWidthByte(); ++i) {
+    buf[i] ^= keystream[i];
+  }
 }
 
 uint32_t ScrambledEcc32MemArea::ToPhysAddr(uint32_t logical_addr) const {
-  // Scramble logical address to get physical address
-  return AddrBytesToInt(scramble_addr(AddrIntToBytes(logical_addr, addr_width_),
-                                      addr_width_, GetScrambleNonce(),
-                                      GetNonceWidth()));
+  assert(logical_addr < phys_addrs_.size());
+
+  uint32_t &phys_addr = phys_addrs_[logical_addr];
+  if (phys_addr == kPhysAddrUnknown) {
+    // Scramble logical address to get physical address
+    phys_addr = scramble_addr_u64(logical_addr, addr_width_, &nonce_[0],
+                                  GetNonceWidth());
+  }
+
+  return phys_addr;
 }
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "ecc32_mem_area.h"
+#include "scramble_model_u64.h"
 
 /**
  * A memory that implements scrambling over a 32-bit ECC integrity protection
@@ -33,12 +34,15 @@ class ScrambledEcc32MemArea : public Ecc32MemArea {
                         uint32_t width_32, bool repeat_keystream = true);
 
  private:
+  void PrepareAccess() const override;
+
   void WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
                    const std::vector<uint8_t> &data, size_t start_idx,
                    uint32_t dst_word) const override;
 
-  std::vector<uint8_t> ReadUnscrambled(const uint8_t buf[SV_MEM_WIDTH_BYTES],
-                                       uint32_t src_word) const;
+  void ReadUnscrambled(uint8_t out[SV_MEM_WIDTH_BYTES],
+                       const uint8_t buf[SV_MEM_WIDTH_BYTES],
+                       uint32_t src_word) const;
 
   void ReadBuffer(std::vector<uint8_t> &data,
                   const uint8_t buf[SV_MEM_WIDTH_BYTES],
@@ -56,6 +60,10 @@ class ScrambledEcc32MemArea : public Ecc32MemArea {
 
   uint32_t ToPhysAddr(uint32_t logical_addr) const override;
 
+  // Return the keystream for the given logical address, computing it if
+  // necessary. The result has GetPhysWidthByte() bytes.
+  const uint8_t *GetKeystream(uint32_t logical_addr) const;
+
   uint32_t GetPhysWidth() const;
   uint32_t GetPhysWidthByte() const;
   uint32_t GetPrinceReplications() const;
@@ -68,6 +76,21 @@ class ScrambledEcc32MemArea : public Ecc32MemArea {
   std::string scr_scope_;
   uint32_t addr_width_;
   bool repeat_keystream_;
+
+  // A snapshot of the scrambling key and nonce, taken by PrepareAccess() at
+  // the start of each bulk access. The caches below are only valid for this
+  // key and nonce and are cleared when either of them changes.
+  mutable std::vector<uint8_t> key_, nonce_;
+  mutable PrinceKey prince_key_;
+
+  // The physical address for each logical address, or kPhysAddrUnknown if it
+  // hasn't been computed yet.
+  mutable std::vector<uint32_t> phys_addrs_;
+
+  // The keystream for each logical address, stored as GetPhysWidthByte()
+  // bytes per word. keystream_valid_ shows which entries have been computed.
+  mutable std::vector<uint8_t> keystream_;
+  mutable std::vector<bool> keystream_valid_;
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_CPP_SCRAMBLED_ECC32_MEM_AREA_H_
@@ -0,0 +1,32 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// DPI functions for sim_trace_trigger.sv, which pass trace triggers through
+// to VerilatorSimCtrl.
+
+#include <svdpi.h>
+
+#include "verilator_sim_ctrl.h"
+
+extern "C" {
+
+svBit simutil_get_trace_trigger(const char *name, svBit *has_value,
+                                long long *value) {
+  bool trigger_has_value;
+  uint64_t trigger_value;
+  if (!VerilatorSimCtrl::GetInstance().GetTraceTrigger(
+          name, &trigger_has_value, &trigger_value)) {
+    return sv_0;
+  }
+
+  *has_value = trigger_has_value ? sv_1 : sv_0;
+  *value = (long long)trigger_value;
+  return sv_1;
+}
+
+void simutil_fire_trace_trigger(const char *name) {
+  VerilatorSimCtrl::GetInstance().FireTraceTrigger(name);
+}
+
+}  // extern "C"
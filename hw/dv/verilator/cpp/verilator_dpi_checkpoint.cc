@@ -0,0 +1,22 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "verilator_dpi_checkpoint.h"
+
+#include "dpi_checkpoint.h"
+
+bool VerilatorDpiCheckpoint::SaveCheckpoint(std::vector<uint8_t> &state) {
+  // Ask for the size first, then save into a buffer of that size
+  size_t len = dpi_checkpoint_save(nullptr, 0);
+  if (len == (size_t)-1) {
+    return false;
+  }
+  state.resize(len);
+  return dpi_checkpoint_save(state.data(), state.size()) == len;
+}
+
+bool VerilatorDpiCheckpoint::RestoreCheckpoint(
+    const std::vector<uint8_t> &state) {
+  return dpi_checkpoint_restore(state.data(), state.size());
+}
@@ -0,0 +1,27 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPENTITAN_HW_DV_VERILATOR_CPP_VERILATOR_DPI_CHECKPOINT_H_
+#define OPENTITAN_HW_DV_VERILATOR_CPP_VERILATOR_DPI_CHECKPOINT_H_
+
+//
+// A SimCtrlExtension that saves and restores the state of the DPI models
+// (uartdpi, gpiodpi, jtagdpi, dmidpi, spidpi, usbdpi) in simulation
+// checkpoints. See dpi_checkpoint.h for how this works.
+//
+
+#include "sim_ctrl_extension.h"
+
+class VerilatorDpiCheckpoint : public SimCtrlExtension {
+ public:
+  // Declared in SimCtrlExtension
+  bool SaveCheckpoint(std::vector<uint8_t> &state) override;
+  bool RestoreCheckpoint(const std::vector<uint8_t> &state) override;
+
+  // Nothing to do on the clock
+  unsigned long NextWakeupCycle(unsigned long cycle) override {
+    return kNoWakeup;
+  }
+};
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_CPP_VERILATOR_DPI_CHECKPOINT_H_
@@ -13,16 +13,7 @@
 #include <string>
 #include <vector>
 
-namespace {
-// An instruction to load the file at filepath to the memory called name. If
-// name is the empty string then type must be kMemImageElf and this is an
-// instruction to load an ELF file, picking memories by LMA.
-struct LoadArg {
-  std::string name;
-  std::string filepath;
-  MemImageType type;
-};
-}  // namespace
+typedef VerilatorMemUtil::LoadArg LoadArg;
 
 // Parse a meminit command-line argument and write the result to the
 // mem_arg output pointer. The command-line argument should be of the
@@ -92,15 +83,20 @@ static void PrintHelp() {
                "  Print registered memory regions\n\n"
                "--verbose-mem-load\n"
                "  Print a message for each memory load\n\n"
+               "--benchmark-mem-load\n"
+               "  Compare the time taken to fill each memory region with\n"
+               "  per-word and block DPI transfers, then exit\n\n"
                "-h|--help\n"
                "  Show help\n\n";
 }
 
-VerilatorMemUtil::VerilatorMemUtil() : allocation_(new DpiMemUtil()) {
+VerilatorMemUtil::VerilatorMemUtil()
+    : allocation_(new DpiMemUtil()), verbose_(false) {
   mem_util_ = allocation_.get();
 }
 
-VerilatorMemUtil::VerilatorMemUtil(DpiMemUtil *mem_util) : mem_util_(mem_util) {
+VerilatorMemUtil::VerilatorMemUtil(DpiMemUtil *mem_util)
+    : mem_util_(mem_util), verbose_(false) {
   assert(mem_util);
 }
 
@@ -113,12 +109,14 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
       {"otpinit", required_argument, nullptr, 'o'},
       {"meminit", required_argument, nullptr, 'l'},
       {"verbose-mem-load", no_argument, nullptr, 'V'},
+      {"benchmark-mem-load", no_argument, nullptr, 'B'},
       {"load-elf", required_argument, nullptr, 'E'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, no_argument, nullptr, 0}};
 
   std::vector<LoadArg> load_args;
   bool verbose = false;
+  bool benchmark = false;
 
   // Reset the command parsing index in-case other utils have already parsed
   // some arguments
@@ -173,6 +171,9 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
       case 'V':
         verbose = true;
         break;
+      case 'B':
+        benchmark = true;
+        break;
       case 'E':
         load_args.push_back(
             {.name = "", .filepath = optarg, .type = kMemImageElf});
@@ -190,14 +191,48 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
     }
   }
 
-  for (const LoadArg &arg : load_args) {
+  if (benchmark) {
+    try {
+      mem_util_->BenchmarkMemAreas();
+    } catch (const std::exception &err) {
+      std::cerr << "ERROR: " << err.what() << std::endl;
+      return false;
+    }
+    exit_app = true;
+    return true;
+  }
+
+  load_args_ = std::move(load_args);
+  verbose_ = verbose;
+  return LoadMemories();
+}
+
+bool VerilatorMemUtil::SaveCheckpoint(std::vector<uint8_t> &state) {
+  std::string layout = mem_util_->GetLayoutDescription();
+  state.assign(layout.begin(), layout.end());
+  return true;
+}
+
+bool VerilatorMemUtil::RestoreCheckpoint(const std::vector<uint8_t> &state) {
+  std::string layout = mem_util_->GetLayoutDescription();
+  if (std::string(state.begin(), state.end()) != layout) {
+    std::cerr << "ERROR: The checkpoint was saved with a different memory "
+                 "layout."
+              << std::endl;
+    return false;
+  }
+  return LoadMemories();
+}
+
+bool VerilatorMemUtil::LoadMemories() {
+  for (const LoadArg &arg : load_args_) {
     try {
       if (!arg.name.empty()) {
-        mem_util_->LoadFileToNamedMem(verbose, arg.name, arg.filepath,
+        mem_util_->LoadFileToNamedMem(verbose_, arg.name, arg.filepath,
                                       arg.type);
       } else {
         assert(arg.type == kMemImageElf);
-        mem_util_->LoadElfToMemories(verbose, arg.filepath);
+        mem_util_->LoadElfToMemories(verbose_, arg.filepath);
       }
     } catch (const std::exception &err) {
       std::cerr << "ERROR: " << err.what() << std::endl;
@@ -9,6 +9,8 @@
 //
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "dpi_memutil.h"
 #include "sim_ctrl_extension.h"
@@ -23,6 +25,19 @@ class VerilatorMemUtil : public SimCtrlExtension {
   // Declared in SimCtrlExtension
   bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
 
+  // The memory contents are part of the design state in a checkpoint. We
+  // save the memory layout, to check it when restoring, and then load any
+  // memory images from the command line again, so that they replace the
+  // contents from the checkpoint.
+  bool SaveCheckpoint(std::vector<uint8_t> &state) override;
+  bool RestoreCheckpoint(const std::vector<uint8_t> &state) override;
+
+  // Memories are only loaded before the simulation starts, so there is
+  // nothing to do on the clock
+  unsigned long NextWakeupCycle(unsigned long cycle) override {
+    return kNoWakeup;
+  }
+
   // Get underlying DpiMemUtil object
   DpiMemUtil *GetUnderlying() { return mem_util_; }
 
@@ -32,9 +47,27 @@ class VerilatorMemUtil : public SimCtrlExtension {
     return mem_util_->RegisterMemoryArea(name, base, mem_area);
   }
 
+  // An instruction to load the file at filepath to the memory called name.
+  // If name is the empty string then type must be kMemImageElf and this is an
+  // instruction to load an ELF file, picking memories by LMA.
+  struct LoadArg {
+    std::string name;
+    std::string filepath;
+    MemImageType type;
+  };
+
  private:
   DpiMemUtil *mem_util_;
   std::unique_ptr<DpiMemUtil> allocation_;
+
+  // Memory loads from the command line, kept to be applied again when
+  // restoring a checkpoint
+  std::vector<LoadArg> load_args_;
+  bool verbose_;
+
+  // Apply the loads in load_args_. On failure, print an error and return
+  // false.
+  bool LoadMemories();
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_CPP_VERILATOR_MEMUTIL_H_
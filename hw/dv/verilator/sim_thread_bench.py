@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors (OpenTitan project).
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+'''Compare the speed of Verilated chip simulations across thread settings
+
+The number of model threads is fixed when the model is verilated, so build
+one simulation binary for each thread count you want to compare, for example
+with
+
+    bazel build //hw:verilator --//hw:verilator_options=--threads,8
+
+and then run something like
+
+    sim_thread_bench.py --cycles=2000000 \\
+        --sim t4=build-t4/Vchip_sim_tb --sim t8=build-t8/Vchip_sim_tb \\
+        --affinity none= --affinity pinned=0-8 \\
+        -- --meminit=rom,rom.elf --meminit=flash,test.elf ...
+
+Each binary is run with each affinity setting (passed as --cpu-affinity; an
+empty setting leaves the threads unpinned) for the given number of cycles.
+The script prints the simulation speed of each run, along with the average
+number of threads that were busy.
+
+'''
+
+import argparse
+import re
+import shlex
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+_SPEED_RE = re.compile(r'^Simulation speed: ([0-9.e+]+) cycles/s')
+_THREADS_RE = re.compile(r'^Model threads: +([0-9]+)')
+_BUSY_RE = re.compile(r'\(([0-9.e+]+) threads busy on average\)')
+
+
+def parse_label_pair(text: str) -> Tuple[str, str]:
+    '''Parse a LABEL=VALUE argument'''
+    label, sep, value = text.partition('=')
+    if not sep or not label:
+        raise argparse.ArgumentTypeError(
+            f'Expected LABEL=VALUE, but got {text!r}.')
+    return (label, value)
+
+
+def run_one(sim: str, affinity: str, cycles: int,
+            sim_args: List[str]) -> Optional[Dict[str, float]]:
+    '''Run a simulation and return the statistics it printed'''
+    cmd = [sim, f'--term-after-cycles={cycles}']
+    if affinity:
+        cmd.append(f'--cpu-affinity={affinity}')
+    cmd += sim_args
+
+    proc = subprocess.run(cmd, stdin=subprocess.DEVNULL,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                          universal_newlines=True, check=False)
+
+    stats = {}
+    for line in proc.stdout.splitlines():
+        match = _SPEED_RE.match(line)
+        if match:
+            stats['speed'] = float(match.group(1))
+        match = _THREADS_RE.match(line)
+        if match:
+            stats['threads'] = float(match.group(1))
+        match = _BUSY_RE.search(line)
+        if match:
+            stats['busy'] = float(match.group(1))
+
+    if 'speed' not in stats:
+        print('Failed to get statistics from simulation (command: {})'
+              .format(' '.join(shlex.quote(arg) for arg in cmd)),
+              file=sys.stderr)
+        print(proc.stdout, file=sys.stderr)
+        return None
+
+    return stats
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--sim', type=parse_label_pair, action='append',
+                        required=True, metavar='LABEL=BINARY',
+                        help='Simulation binary to run (may be repeated)')
+    parser.add_argument('--affinity', type=parse_label_pair,
+                        action='append', metavar='LABEL=CPUS',
+                        help=('CPUs to pin the simulation threads to, as '
+                              'for --cpu-affinity (may be repeated). An '
+                              'empty list leaves them unpinned, which is '
+                              'the default.'))
+    parser.add_argument('--cycles', type=int, default=1000000,
+                        help='Number of cycles to simulate in each run')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help=('Number of times to run each configuration. '
+                              'The fastest run is reported.'))
+    parser.add_argument('sim_args', nargs='*',
+                        help='Extra arguments for the simulation binaries')
+
+    args = parser.parse_args()
+    affinities = args.affinity or [('unpinned', '')]
+
+    results = []
+    for sim_label, sim in args.sim:
+        for aff_label, affinity in affinities:
+            best = None
+            for _ in range(args.repeat):
+                stats = run_one(sim, affinity, args.cycles, args.sim_args)
+                if stats is None:
+                    return 1
+                if best is None or stats['speed'] > best['speed']:
+                    best = stats
+            assert best is not None
+            results.append((sim_label, aff_label, best))
+
+    print(f'{"Binary":<16} {"Affinity":<16} {"Threads":>7} '
+          f'{"Busy":>6} {"Cycles/s":>12}')
+    for sim_label, aff_label, stats in results:
+        print(f'{sim_label:<16} {aff_label:<16} '
+              f'{int(stats.get("threads", 0)):>7} '
+              f'{stats.get("busy", 0):>6.2f} {stats["speed"]:>12.1f}')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
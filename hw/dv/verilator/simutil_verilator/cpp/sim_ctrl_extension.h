@@ -5,8 +5,19 @@
 #ifndef OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
 #define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
 
+#include <cstdint>
+#include <vector>
+
 class SimCtrlExtension {
  public:
+  /**
+   * Returned by NextWakeupCycle() to stop OnClock() being called until the
+   * extension is woken explicitly or by a watched file descriptor.
+   *
+   * @see VerilatorSimCtrl::WakeExtension(), VerilatorSimCtrl::WatchFd()
+   */
+  static const unsigned long kNoWakeup = ~0UL;
+
   virtual ~SimCtrlExtension() = default;
 
   /**
@@ -35,14 +46,61 @@ class SimCtrlExtension {
   virtual void PreExec() {}
 
   /**
-   * Function to be called every clock cycle
+   * Function to be called on the rising clock edge of each cycle in which
+   * the extension is awake
+   *
+   * @see NextWakeupCycle()
    */
   virtual void OnClock(unsigned long sim_time) {}
 
+  /**
+   * Get the next cycle in which OnClock() should be called
+   *
+   * Every extension is awake in the first cycle of the simulation. After
+   * that, this is called after each call to OnClock(). Cycles in which no
+   * extension is awake cost only the evaluation of the design, so an
+   * extension that only needs to act now and then should return a later
+   * cycle (or kNoWakeup) here.
+   *
+   * The default wakes the extension on every cycle.
+   *
+   * @param cycle The current clock cycle
+   * @return The cycle to wake on (at least cycle + 1), or kNoWakeup
+   */
+  virtual unsigned long NextWakeupCycle(unsigned long cycle) {
+    return cycle + 1;
+  }
+
   /**
    * Function to be called after executing the simulation
    */
   virtual void PostExec() {}
+
+  /**
+   * Save extension state into a simulation checkpoint
+   *
+   * Called after the simulated design has been saved. State that lives
+   * outside the design (for example, in a C model behind a DPI interface)
+   * should be appended to |state|, which is passed back to
+   * RestoreCheckpoint() when the checkpoint is restored.
+   *
+   * @param state Buffer for the extension's state
+   * @return Return code, true == success
+   */
+  virtual bool SaveCheckpoint(std::vector<uint8_t> &state) { return true; }
+
+  /**
+   * Restore extension state from a simulation checkpoint
+   *
+   * Called after the simulated design has been restored, and after the
+   * initial blocks have run, with the data that SaveCheckpoint() wrote.
+   *
+   * @param state The extension's saved state
+   * @return Return code, true == success
+   */
+  virtual bool RestoreCheckpoint(const std::vector<uint8_t> &state) {
+    return true;
+  }
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_EXTENSION_H_
@@ -0,0 +1,111 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sim_ctrl_threads.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Parse a decimal CPU number from the start of |str|, setting |*end| to point
+// after it. Returns -1 if there isn't one.
+static int parse_cpu(const char *str, const char **end) {
+  if (!('0' <= *str && *str <= '9')) {
+    return -1;
+  }
+  char *num_end;
+  errno = 0;
+  unsigned long cpu = strtoul(str, &num_end, 10);
+  if (errno || cpu >= CPU_SETSIZE) {
+    return -1;
+  }
+  *end = num_end;
+  return cpu;
+}
+
+bool SimCtrlParseCpuList(const std::string &text, std::vector<int> *cpus) {
+  cpus->clear();
+
+  const char *pos = text.c_str();
+  while (*pos) {
+    int first = parse_cpu(pos, &pos);
+    int last = first;
+    if (first >= 0 && *pos == '-') {
+      last = parse_cpu(pos + 1, &pos);
+    }
+    if (first < 0 || last < first || (*pos && *pos != ',')) {
+      std::cerr << "ERROR: Bad CPU list: `" << text
+                << "'. Expected something like 0-3,8." << std::endl;
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back(cpu);
+    }
+    if (*pos == ',') {
+      ++pos;
+    }
+  }
+
+  if (cpus->empty()) {
+    std::cerr << "ERROR: Empty CPU list." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::vector<pid_t> SimCtrlGetThreadIds() {
+  pid_t self = syscall(SYS_gettid);
+  std::vector<pid_t> tids;
+
+  DIR *dir = opendir("/proc/self/task");
+  if (dir) {
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      pid_t tid = atoi(entry->d_name);
+      if (tid > 0 && tid != self) {
+        tids.push_back(tid);
+      }
+    }
+    closedir(dir);
+  }
+
+  std::sort(tids.begin(), tids.end());
+  tids.insert(tids.begin(), self);
+  return tids;
+}
+
+bool SimCtrlPinThreads(const std::vector<pid_t> &tids,
+                       const std::vector<int> &cpus) {
+  if (cpus.empty()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < tids.size(); ++i) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[i % cpus.size()], &set);
+    if (sched_setaffinity(tids[i], sizeof(set), &set) != 0) {
+      std::cerr << "ERROR: Failed to pin thread " << tids[i] << " to CPU "
+                << cpus[i % cpus.size()] << ": " << strerror(errno)
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+double SimCtrlGetProcessCpuTime() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+    return 0.0;
+  }
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,50 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_THREADS_H_
+#define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_THREADS_H_
+
+//
+// Helpers for placing the threads of a simulation on CPUs (Linux only).
+//
+// A multi-threaded Verilated model starts its worker threads when the model
+// is constructed, and a model built with --trace-threads starts a trace
+// writer thread when the trace file is opened. Verilator doesn't give us
+// handles to these threads, so we find them by listing the threads of the
+// process before and after they are started.
+//
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * Parse a list of CPUs like "0-3,8,10-11" into |cpus|
+ *
+ * @return false (and print an error) if |text| is malformed
+ */
+bool SimCtrlParseCpuList(const std::string &text, std::vector<int> *cpus);
+
+/**
+ * Get the IDs of all threads in this process, with the calling thread first
+ * and the others in ascending order.
+ */
+std::vector<pid_t> SimCtrlGetThreadIds();
+
+/**
+ * Pin each thread in |tids| to one CPU from |cpus|, going round |cpus| if
+ * there are more threads than CPUs.
+ *
+ * @return false (and print an error) if the affinity of a thread couldn't be
+ *         set
+ */
+bool SimCtrlPinThreads(const std::vector<pid_t> &tids,
+                       const std::vector<int> &cpus);
+
+/**
+ * Get the CPU time used by all threads of this process so far, in seconds
+ */
+double SimCtrlGetProcessCpuTime();
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_THREADS_H_
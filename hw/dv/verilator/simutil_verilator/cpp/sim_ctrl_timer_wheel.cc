@@ -0,0 +1,71 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sim_ctrl_timer_wheel.h"
+
+#include <algorithm>
+#include <cassert>
+
+SimCtrlTimerWheel::SimCtrlTimerWheel(size_t num_slots)
+    : slots_(num_slots), num_entries_(0), next_deadline_(kNever) {
+  assert(num_slots > 0);
+}
+
+void SimCtrlTimerWheel::Schedule(unsigned long cycle, size_t id) {
+  assert(cycle != kNever);
+  slots_[cycle % slots_.size()].push_back({cycle, id});
+  ++num_entries_;
+  next_deadline_ = std::min(next_deadline_, cycle);
+}
+
+void SimCtrlTimerWheel::PopDue(unsigned long cycle, std::vector<size_t> &ids) {
+  if (next_deadline_ > cycle) {
+    return;
+  }
+
+  // Everything due is between next_deadline_ and cycle, so we only need to
+  // look at the slots for those cycles (or all of them, if that's fewer).
+  size_t num_slots = slots_.size();
+  unsigned long first = next_deadline_;
+  unsigned long span = std::min<unsigned long>(cycle - first + 1, num_slots);
+  for (unsigned long c = first; c < first + span; ++c) {
+    std::vector<Entry> &slot = slots_[c % num_slots];
+    auto keep_end = std::stable_partition(
+        slot.begin(), slot.end(),
+        [cycle](const Entry &entry) { return entry.cycle > cycle; });
+    for (auto it = keep_end; it != slot.end(); ++it) {
+      ids.push_back(it->id);
+    }
+    num_entries_ -= slot.end() - keep_end;
+    slot.erase(keep_end, slot.end());
+  }
+
+  UpdateNextDeadline(cycle + 1);
+}
+
+void SimCtrlTimerWheel::UpdateNextDeadline(unsigned long from) {
+  next_deadline_ = kNever;
+  if (num_entries_ == 0) {
+    return;
+  }
+
+  // Look for an entry due in the next revolution of the wheel
+  size_t num_slots = slots_.size();
+  for (unsigned long c = from; c < from + num_slots; ++c) {
+    for (const Entry &entry : slots_[c % num_slots]) {
+      if (entry.cycle == c) {
+        next_deadline_ = c;
+        return;
+      }
+    }
+  }
+
+  // Everything is further out than that, so take the minimum over all the
+  // entries.
+  for (const std::vector<Entry> &slot : slots_) {
+    for (const Entry &entry : slot) {
+      next_deadline_ = std::min(next_deadline_, entry.cycle);
+    }
+  }
+}
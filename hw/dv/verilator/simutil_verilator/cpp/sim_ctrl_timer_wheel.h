@@ -0,0 +1,62 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_TIMER_WHEEL_H_
+#define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_TIMER_WHEEL_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * A hashed timer wheel, keyed by clock cycle
+ *
+ * Each entry is an (id, cycle) pair, stored in the slot for its cycle modulo
+ * the number of slots. Scheduling is constant time. Finding the next
+ * deadline usually only has to look at the next few slots, because entries
+ * are normally scheduled a short time into the future.
+ *
+ * The wheel doesn't support cancelling entries. Callers that need to
+ * reschedule an id should remember the cycle they last scheduled it for, and
+ * ignore popped entries that don't match.
+ */
+class SimCtrlTimerWheel {
+ public:
+  /** The deadline reported when the wheel is empty */
+  static const unsigned long kNever = ~0UL;
+
+  explicit SimCtrlTimerWheel(size_t num_slots = 256);
+
+  /**
+   * Schedule |id| for |cycle|
+   */
+  void Schedule(unsigned long cycle, size_t id);
+
+  /**
+   * Get the earliest scheduled cycle, or kNever if the wheel is empty
+   */
+  unsigned long NextDeadline() const { return next_deadline_; }
+
+  /**
+   * Remove all entries scheduled at or before |cycle| and append their ids
+   * to |ids|
+   */
+  void PopDue(unsigned long cycle, std::vector<size_t> &ids);
+
+ private:
+  struct Entry {
+    unsigned long cycle;
+    size_t id;
+  };
+
+  std::vector<std::vector<Entry>> slots_;
+  size_t num_entries_;
+  unsigned long next_deadline_;
+
+  /**
+   * Recompute next_deadline_, given that no entries are due before |from|.
+   */
+  void UpdateNextDeadline(unsigned long from);
+};
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_SIM_CTRL_TIMER_WHEEL_H_
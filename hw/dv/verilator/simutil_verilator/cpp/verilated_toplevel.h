@@ -9,6 +9,7 @@
 #error "TOPLEVEL_NAME must be set to the name of the toplevel."
 #endif
 
+#include <string>
 #include <verilated.h>
 
 #define STR(s) #s
@@ -43,6 +44,20 @@
 #endif
 #endif
 
+// VM_SAVABLE must be set by the user when calling Verilator with --savable.
+#ifdef VM_SAVABLE
+#include "verilated_save.h"
+#endif
+
+// Tracing only part of the hierarchy needs the dumpvars() support in the
+// tracers of Verilator 5.
+#if VM_TRACE == 1 && defined(VERILATOR_VERSION_INTEGER) && \
+    VERILATOR_VERSION_INTEGER >= 5000000
+#define TRACE_SCOPE_POSSIBLE 1
+#else
+#define TRACE_SCOPE_POSSIBLE 0
+#endif
+
 #if VM_TRACE == 1
 /**
  * "Base" for all tracers in Verilator with common functionality
@@ -67,6 +82,20 @@ class VerilatedTracer {
 
   void dump(vluint64_t timeui) { impl_->dump(timeui); }
 
+  /**
+   * Limit tracing to |hier| and the scopes below it
+   *
+   * This must be called before open(). Calling it more than once traces
+   * each of the given scopes.
+   */
+  void dumpvars(const std::string &hier) {
+#if TRACE_SCOPE_POSSIBLE
+    impl_->dumpvars(0, hier);
+#else
+    assert(0 && "Tracing a scope needs Verilator 5.");
+#endif
+  }
+
   operator VM_TRACE_CLASS_NAME *() const {
     assert(impl_);
     return impl_;
@@ -87,6 +116,7 @@ class VerilatedTracer {
   void open(const char *filename){};
   void close(){};
   void dump(vluint64_t timeui) {}
+  void dumpvars(const std::string &hier) {}
 };
 #endif  // VM_TRACE == 1
 
@@ -123,6 +153,11 @@ class VerilatedToplevel {
   virtual const char *name() const = 0;
   virtual void trace(VerilatedTracer &tfp, int levels, int options) = 0;
 
+#ifdef VM_SAVABLE
+  virtual void save(VerilatedSerialize &os) = 0;
+  virtual void restore(VerilatedDeserialize &os) = 0;
+#endif
+
   /**
    * Get the Verilator-generated device under test
    *
@@ -150,6 +185,14 @@ class TOPLEVEL_NAME : public VERILATED_TOPLEVEL_NAME, public VerilatedToplevel {
     assert(0 && "Tracing not enabled.");
 #endif
   }
+#ifdef VM_SAVABLE
+  void save(VerilatedSerialize &os) {
+    os << static_cast<VERILATED_TOPLEVEL_NAME &>(*this);
+  }
+  void restore(VerilatedDeserialize &os) {
+    os >> static_cast<VERILATED_TOPLEVEL_NAME &>(*this);
+  }
+#endif
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATED_TOPLEVEL_H_
@@ -4,6 +4,9 @@
 
 #include "verilator_sim_ctrl.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <getopt.h>
 #include <iostream>
 #include <signal.h>
@@ -15,6 +18,18 @@
 #define VM_TRACE 0
 #endif
 
+// This must be defined by the user when verilating with --savable
+#ifdef VM_SAVABLE
+#define CHECKPOINT_POSSIBLE 1
+#else
+#define CHECKPOINT_POSSIBLE 0
+#endif
+
+// Written after the design state in a checkpoint file, to catch files that
+// weren't written by VerilatorSimCtrl.
+static const char kCheckpointMagic[8] = {'O', 'T', 'S', 'I',
+                                         'M', 'C', 'K', '1'};
+
 /**
  * Get the current simulation time
  *
@@ -111,6 +126,16 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
   const struct option long_options[] = {
       {"term-after-cycles", required_argument, nullptr, 'c'},
       {"trace", optional_argument, nullptr, 't'},
+      {"save-checkpoint-at-cycle", required_argument, nullptr, 's'},
+      {"save-checkpoint-file", required_argument, nullptr, 'S'},
+      {"restore-checkpoint", required_argument, nullptr, 'R'},
+      {"trace-start", required_argument, nullptr, 'w'},
+      {"trace-stop", required_argument, nullptr, 'W'},
+      {"trace-scope", required_argument, nullptr, 'o'},
+      {"trace-ring", required_argument, nullptr, 'r'},
+      {"trace-trigger", required_argument, nullptr, 'g'},
+      {"cpu-affinity", required_argument, nullptr, 'a'},
+      {"trace-cpu-affinity", required_argument, nullptr, 'A'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, no_argument, nullptr, 0}};
 
@@ -145,6 +170,57 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
           return false;
         }
         break;
+      case 's':
+      case 'S':
+      case 'R':
+        if (!checkpoint_possible_) {
+          std::cerr << "ERROR: Checkpointing has not been enabled at compile "
+                       "time."
+                    << std::endl;
+          exit_app = true;
+          return false;
+        }
+        if (c == 's') {
+          if (!read_ul_arg(&save_checkpoint_cycle_, "save-checkpoint-at-cycle",
+                           optarg)) {
+            exit_app = true;
+            return false;
+          }
+          save_checkpoint_ = true;
+        } else if (c == 'S') {
+          save_checkpoint_path_.assign(optarg);
+        } else {
+          restore_checkpoint_path_.assign(optarg);
+        }
+        break;
+      case 'w':
+      case 'W':
+      case 'o':
+      case 'r':
+      case 'g':
+        if (!tracing_possible_) {
+          std::cerr << "ERROR: Tracing has not been enabled at compile time."
+                    << std::endl;
+          exit_app = true;
+          return false;
+        }
+        if (!ParseTraceArg(c, optarg)) {
+          exit_app = true;
+          return false;
+        }
+        break;
+      case 'a':
+        if (!SimCtrlParseCpuList(optarg, &cpu_affinity_)) {
+          exit_app = true;
+          return false;
+        }
+        break;
+      case 'A':
+        if (!SimCtrlParseCpuList(optarg, &trace_cpu_affinity_)) {
+          exit_app = true;
+          return false;
+        }
+        break;
       case 'h':
         PrintHelp();
         exit_app = true;
@@ -176,6 +252,41 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
   return true;
 }
 
+bool VerilatorSimCtrl::ParseTraceArg(int c, const char *arg) {
+  switch (c) {
+    case 'w':
+      return read_ul_arg(&trace_start_cycle_, "trace-start", arg);
+    case 'W':
+      return read_ul_arg(&trace_stop_cycle_, "trace-stop", arg);
+    case 'o':
+      if (!TRACE_SCOPE_POSSIBLE) {
+        std::cerr << "ERROR: Tracing a scope needs Verilator 5." << std::endl;
+        return false;
+      }
+      AddTraceScope(arg);
+      return true;
+    case 'r':
+      return read_ul_arg(&trace_ring_cycles_, "trace-ring", arg);
+    case 'g': {
+      // NAME or NAME=VALUE
+      const char *eq = strchr(arg, '=');
+      if (!eq) {
+        AddTraceTrigger(arg);
+        return true;
+      }
+      unsigned long value;
+      if (!read_ul_arg(&value, "trace-trigger", eq + 1)) {
+        return false;
+      }
+      AddTraceTrigger(std::string(arg, eq - arg), value);
+      return true;
+    }
+    default:
+      assert(0);
+      return false;
+  }
+}
+
 void VerilatorSimCtrl::RunSimulation() {
   RegisterSignalHandler();
 
@@ -198,7 +309,9 @@ void VerilatorSimCtrl::RunSimulation() {
   // Print simulation speed info
   PrintStatistics();
   // Print helper message for tracing
-  if (TracingEverEnabled()) {
+  if (TracingEverEnabled() && trace_ring_cycles_) {
+    FinishTraceRing();
+  } else if (TracingEverEnabled()) {
     std::cout << std::endl
               << "You can view the simulation traces by calling" << std::endl
               << "$ gtkwave " << GetTraceFileName() << std::endl;
@@ -217,6 +330,56 @@ void VerilatorSimCtrl::SetTimeout(unsigned int cycles) {
   term_after_cycles_ = cycles;
 }
 
+void VerilatorSimCtrl::SetCpuAffinity(const std::vector<int> &cpus) {
+  cpu_affinity_ = cpus;
+}
+
+void VerilatorSimCtrl::SetTraceCpuAffinity(const std::vector<int> &cpus) {
+  trace_cpu_affinity_ = cpus;
+}
+
+void VerilatorSimCtrl::SetTraceWindow(unsigned long start,
+                                      unsigned long stop) {
+  trace_start_cycle_ = start;
+  trace_stop_cycle_ = stop;
+}
+
+void VerilatorSimCtrl::AddTraceScope(const std::string &hier) {
+  trace_scopes_.push_back(hier);
+}
+
+void VerilatorSimCtrl::SetTraceRing(unsigned long cycles) {
+  trace_ring_cycles_ = cycles;
+}
+
+void VerilatorSimCtrl::AddTraceTrigger(const std::string &name) {
+  trace_triggers_.push_back({name, false, 0});
+}
+
+void VerilatorSimCtrl::AddTraceTrigger(const std::string &name,
+                                       uint64_t value) {
+  trace_triggers_.push_back({name, true, value});
+}
+
+bool VerilatorSimCtrl::GetTraceTrigger(const std::string &name,
+                                       bool *has_value,
+                                       uint64_t *value) const {
+  for (const TraceTriggerSpec &trigger : trace_triggers_) {
+    if (trigger.name == name) {
+      *has_value = trigger.has_value;
+      *value = trigger.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+void VerilatorSimCtrl::FireTraceTrigger(const std::string &name) {
+  std::cout << "Trace trigger " << name << " fired at cycle " << time_ / 2
+            << "." << std::endl;
+  TraceOn();
+}
+
 void VerilatorSimCtrl::RequestStop(bool simulation_success) {
   request_stop_ = true;
   simulation_success_ &= simulation_success;
@@ -224,6 +387,35 @@ void VerilatorSimCtrl::RequestStop(bool simulation_success) {
 
 void VerilatorSimCtrl::RegisterExtension(SimCtrlExtension *ext) {
   extension_array_.push_back(ext);
+  ext_wakeup_cycles_.push_back(SimCtrlExtension::kNoWakeup);
+}
+
+void VerilatorSimCtrl::WakeExtension(SimCtrlExtension *ext,
+                                     unsigned long cycle) {
+  ScheduleExtension(GetExtensionIndex(ext), std::max(cycle, time_ / 2 + 1));
+}
+
+void VerilatorSimCtrl::WatchFd(int fd, SimCtrlExtension *ext) {
+  struct pollfd pfd = {};
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  watched_fds_.push_back(pfd);
+  watched_fd_exts_.push_back(GetExtensionIndex(ext));
+}
+
+void VerilatorSimCtrl::UnwatchFd(int fd) {
+  for (size_t i = 0; i < watched_fds_.size();) {
+    if (watched_fds_[i].fd == fd) {
+      watched_fds_.erase(watched_fds_.begin() + i);
+      watched_fd_exts_.erase(watched_fd_exts_.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+void VerilatorSimCtrl::SetFdPollInterval(unsigned int cycles) {
+  fd_poll_interval_ = std::max(cycles, 1u);
 }
 
 VerilatorSimCtrl::VerilatorSimCtrl()
@@ -242,8 +434,25 @@ VerilatorSimCtrl::VerilatorSimCtrl()
       reset_duration_cycles_(2),
       request_stop_(false),
       simulation_success_(true),
+      cpu_time_begin_(0.0),
+      cpu_time_end_(0.0),
       tracer_(VerilatedTracer()),
-      term_after_cycles_(0) {
+      term_after_cycles_(0),
+      checkpoint_possible_(CHECKPOINT_POSSIBLE),
+      save_checkpoint_(false),
+      save_checkpoint_cycle_(0),
+      save_checkpoint_path_("sim.ckpt"),
+      fd_poll_interval_(256),
+      next_fd_poll_cycle_(0),
+      next_event_cycle_(0),
+      num_sim_threads_(0),
+      trace_start_cycle_(kNoCycle),
+      trace_stop_cycle_(kNoCycle),
+      trace_ring_cycles_(0),
+      trace_ring_segment_(0),
+      trace_ring_wrapped_(false),
+      trace_ring_switch_time_(0),
+      timed_out_(false) {
 }
 
 void VerilatorSimCtrl::RegisterSignalHandler() {
@@ -279,9 +488,41 @@ void VerilatorSimCtrl::PrintHelp() const {
   if (tracing_possible_) {
     std::cout << "-t|--trace\n"
                  "   --trace=FILE\n"
-                 "  Write a trace file from the start\n\n";
+                 "  Write a trace file from the start\n\n"
+                 "--trace-start=N\n"
+                 "  Start tracing at cycle N\n\n"
+                 "--trace-stop=N\n"
+                 "  Stop tracing at cycle N\n\n"
+                 "--trace-trigger=NAME\n"
+                 "--trace-trigger=NAME=VALUE\n"
+                 "  Start tracing when the sim_trace_trigger called NAME\n"
+                 "  fires (or matches VALUE). May be given more than once.\n\n"
+                 "--trace-ring=N\n"
+                 "  Only keep the last N (or more) cycles of the trace, and\n"
+                 "  only if the simulation fails or times out\n\n";
+    if (TRACE_SCOPE_POSSIBLE) {
+      std::cout << "--trace-scope=SCOPE\n"
+                   "  Only trace SCOPE (e.g. TOP.chip_sim_tb.u_dut) and the\n"
+                   "  scopes below it. May be given more than once.\n\n";
+    }
   }
-  std::cout << "-c|--term-after-cycles=N\n"
+  if (checkpoint_possible_) {
+    std::cout << "--save-checkpoint-at-cycle=N\n"
+                 "  Save the simulation state at cycle N and continue.\n"
+                 "  Combine with --term-after-cycles=N to stop there.\n\n"
+                 "--save-checkpoint-file=FILE\n"
+                 "  Checkpoint file to save (default: sim.ckpt)\n\n"
+                 "--restore-checkpoint=FILE\n"
+                 "  Resume the simulation from a checkpoint saved by this\n"
+                 "  simulation binary\n\n";
+  }
+  std::cout << "--cpu-affinity=CPUS\n"
+               "  Pin the thread evaluating the design and the worker threads\n"
+               "  of the model to CPUS (e.g. 0-3,8), one thread per CPU\n\n"
+               "--trace-cpu-affinity=CPUS\n"
+               "  Pin the trace writer threads of a model verilated with\n"
+               "  --trace-threads to CPUS\n\n"
+               "-c|--term-after-cycles=N\n"
                "  Terminate simulation after N cycles. 0 means no timeout.\n\n"
                "-h|--help\n"
                "  Show help\n\n"
@@ -322,6 +563,18 @@ void VerilatorSimCtrl::PrintStatistics() const {
             << "Simulation speed: " << speed_hz << " cycles/s "
             << "(" << speed_khz << " kHz)" << std::endl;
 
+  // CPU time over wallclock time is the average number of busy threads,
+  // which shows how well a multi-threaded model uses its threads.
+  double cpu_time_s = cpu_time_end_ - cpu_time_begin_;
+  double wall_time_s = GetExecutionTimeMs() / 1000.0;
+  std::cout << "Model threads:    " << num_sim_threads_ << std::endl
+            << "CPU time:         " << cpu_time_s << " s";
+  if (wall_time_s > 0) {
+    std::cout << " (" << cpu_time_s / wall_time_s
+              << " threads busy on average)";
+  }
+  std::cout << std::endl;
+
   int trace_size_byte;
   if (tracing_enabled_ && FileSize(GetTraceFileName(), trace_size_byte)) {
     std::cout << "Trace file size:  " << trace_size_byte << " B" << std::endl;
@@ -332,6 +585,144 @@ std::string VerilatorSimCtrl::GetTraceFileName() const {
   return trace_file_path_;
 }
 
+std::string VerilatorSimCtrl::GetTraceRingFileName(
+    unsigned int segment) const {
+  std::string path = GetTraceFileName();
+  size_t dot = path.rfind('.');
+  size_t slash = path.rfind('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    dot = path.size();
+  }
+  return path.insert(dot, "." + std::to_string(segment));
+}
+
+void VerilatorSimCtrl::FinishTraceRing() {
+  std::string newer = GetTraceRingFileName(trace_ring_segment_);
+  std::string older = GetTraceRingFileName(trace_ring_segment_ ^ 1);
+
+  if (WasSimulationSuccessful() && !timed_out_) {
+    remove(newer.c_str());
+    remove(older.c_str());
+    std::cout << std::endl
+              << "Simulation succeeded, so the ring trace has been deleted."
+              << std::endl;
+    return;
+  }
+
+  std::cout << std::endl
+            << "The trace ends with the last " << trace_ring_cycles_
+            << " or more cycles of the simulation. You can view it by "
+               "calling"
+            << std::endl;
+  if (trace_ring_wrapped_) {
+    std::cout << "$ gtkwave " << older << " (older)" << std::endl;
+  }
+  std::cout << "$ gtkwave " << newer << std::endl;
+}
+
+bool VerilatorSimCtrl::SaveCheckpoint(const std::string &path) {
+#ifdef VM_SAVABLE
+  // Collect the extension state first, so that we don't leave a partial
+  // checkpoint behind if an extension can't be saved.
+  std::vector<std::vector<uint8_t>> ext_states(extension_array_.size());
+  for (size_t i = 0; i < extension_array_.size(); ++i) {
+    if (!extension_array_[i]->SaveCheckpoint(ext_states[i])) {
+      std::cerr << "ERROR: Failed to save extension state for checkpoint."
+                << std::endl;
+      return false;
+    }
+  }
+
+  VerilatedSave os;
+  os.open(path.c_str());
+  if (!os.isOpen()) {
+    std::cerr << "ERROR: Unable to open checkpoint file `" << path
+              << "' for writing." << std::endl;
+    return false;
+  }
+
+  uint64_t time = time_;
+  os.write(&time, sizeof(time));
+  top_->save(os);
+
+  os.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+  uint64_t num_exts = ext_states.size();
+  os.write(&num_exts, sizeof(num_exts));
+  for (const std::vector<uint8_t> &state : ext_states) {
+    uint64_t state_len = state.size();
+    os.write(&state_len, sizeof(state_len));
+    if (state_len) {
+      os.write(state.data(), state_len);
+    }
+  }
+  os.close();
+
+  std::cout << "Saved checkpoint at cycle " << time_ / 2 << " to " << path
+            << std::endl;
+  return true;
+#else
+  assert(0 && "Checkpointing not enabled.");
+  return false;
+#endif
+}
+
+bool VerilatorSimCtrl::RestoreCheckpoint(const std::string &path) {
+#ifdef VM_SAVABLE
+  VerilatedRestore is;
+  is.open(path.c_str());
+  if (!is.isOpen()) {
+    std::cerr << "ERROR: Unable to open checkpoint file `" << path
+              << "' for reading." << std::endl;
+    return false;
+  }
+
+  uint64_t time;
+  is.read(&time, sizeof(time));
+  top_->restore(is);
+
+  char magic[sizeof(kCheckpointMagic)];
+  is.read(magic, sizeof(magic));
+  if (memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0) {
+    std::cerr << "ERROR: `" << path << "' is not a simulation checkpoint."
+              << std::endl;
+    return false;
+  }
+
+  uint64_t num_exts;
+  is.read(&num_exts, sizeof(num_exts));
+  if (num_exts != extension_array_.size()) {
+    std::cerr << "ERROR: Checkpoint `" << path << "' has state for "
+              << num_exts << " extensions, but " << extension_array_.size()
+              << " are registered." << std::endl;
+    return false;
+  }
+
+  for (SimCtrlExtension *ext : extension_array_) {
+    uint64_t state_len;
+    is.read(&state_len, sizeof(state_len));
+    std::vector<uint8_t> state(state_len);
+    if (state_len) {
+      is.read(state.data(), state_len);
+    }
+    if (!ext->RestoreCheckpoint(state)) {
+      std::cerr << "ERROR: Failed to restore extension state from checkpoint `"
+                << path << "'." << std::endl;
+      return false;
+    }
+  }
+  is.close();
+
+  time_ = time;
+  std::cout << "Restored checkpoint at cycle " << time_ / 2 << " from "
+            << path << std::endl;
+  return true;
+#else
+  assert(0 && "Checkpointing not enabled.");
+  return false;
+#endif
+}
+
 void VerilatorSimCtrl::Run() {
   assert(top_ && "Use SetTop() first.");
 
@@ -339,38 +730,93 @@ void VerilatorSimCtrl::Run() {
   if (tracing_possible_) {
     Verilated::traceEverOn(true);
     top_->trace(tracer_, 99, 0);
+    for (const std::string &hier : trace_scopes_) {
+      tracer_.dumpvars(hier);
+    }
+  }
+
+  // The model has started its worker threads by now, but DPI models haven't
+  // started any threads of their own yet.
+  std::vector<pid_t> sim_threads = SimCtrlGetThreadIds();
+  num_sim_threads_ = sim_threads.size();
+  if (!SimCtrlPinThreads(sim_threads, cpu_affinity_)) {
+    simulation_success_ = false;
+    time_begin_ = time_end_ = std::chrono::steady_clock::now();
+    return;
   }
 
   // Evaluate all initial blocks, including the DPI setup routines
   top_->eval();
 
+  // Restoring a checkpoint replaces the state of the design, but we still
+  // need the initial blocks above to have created fresh DPI contexts.
+  bool restored = false;
+  if (!restore_checkpoint_path_.empty()) {
+    if (!RestoreCheckpoint(restore_checkpoint_path_)) {
+      simulation_success_ = false;
+      top_->final();
+      time_begin_ = time_end_ = std::chrono::steady_clock::now();
+      return;
+    }
+    restored = true;
+  }
+
   std::cout << std::endl
             << "Simulation running, end by pressing CTRL-c." << std::endl;
 
   time_begin_ = std::chrono::steady_clock::now();
-  UnsetReset();
+  cpu_time_begin_ = SimCtrlGetProcessCpuTime();
+  if (!restored) {
+    UnsetReset();
+  }
   Trace();
 
   unsigned long start_reset_cycle_ = initial_reset_delay_cycles_;
   unsigned long end_reset_cycle_ = start_reset_cycle_ + reset_duration_cycles_;
 
+  // Every extension is awake in the first cycle
+  unsigned long first_cycle = time_ / 2;
+  for (size_t i = 0; i < extension_array_.size(); ++i) {
+    ScheduleExtension(i, first_cycle);
+  }
+  next_fd_poll_cycle_ = first_cycle;
+  next_event_cycle_ = first_cycle;
+
   while (1) {
     unsigned long cycle_ = time_ / 2;
 
-    if (cycle_ == start_reset_cycle_) {
-      SetReset();
-    } else if (cycle_ == end_reset_cycle_) {
-      UnsetReset();
+    // Most cycles only need the design to be evaluated. Reset, extensions
+    // and checkpoints are only looked at from next_event_cycle_ onwards.
+    bool event_cycle = cycle_ >= next_event_cycle_;
+
+    if (event_cycle) {
+      // Save at the start of a cycle, so that a restored simulation picks up
+      // at the top of this loop.
+      if (save_checkpoint_ && time_ == 2 * save_checkpoint_cycle_) {
+        if (!SaveCheckpoint(save_checkpoint_path_)) {
+          RequestStop(false);
+          break;
+        }
+      }
+
+      if (cycle_ == start_reset_cycle_) {
+        SetReset();
+      } else if (cycle_ == end_reset_cycle_) {
+        UnsetReset();
+      }
+
+      if (cycle_ == trace_start_cycle_) {
+        TraceOn();
+      } else if (cycle_ == trace_stop_cycle_) {
+        TraceOff();
+      }
     }
 
     *sig_clk_ = !*sig_clk_;
 
-    // Call all extension on-clock methods
-    if (*sig_clk_) {
-      for (auto it = extension_array_.begin(); it != extension_array_.end();
-           ++it) {
-        (*it)->OnClock(time_);
-      }
+    // Call the on-clock methods of the extensions that are awake
+    if (event_cycle && *sig_clk_) {
+      RunExtensions(cycle_);
     }
 
     top_->eval();
@@ -391,18 +837,104 @@ void VerilatorSimCtrl::Run() {
     if (term_after_cycles_ && (time_ / 2 >= term_after_cycles_)) {
       std::cout << "Simulation timeout of " << term_after_cycles_
                 << " cycles reached, shutting down simulation." << std::endl;
+      timed_out_ = true;
       break;
     }
+
+    if (event_cycle) {
+      next_event_cycle_ =
+          GetNextEventCycle(time_ / 2, start_reset_cycle_, end_reset_cycle_);
+    }
   }
 
   top_->final();
   time_end_ = std::chrono::steady_clock::now();
+  cpu_time_end_ = SimCtrlGetProcessCpuTime();
 
   if (TracingEverEnabled()) {
     tracer_.close();
   }
 }
 
+size_t VerilatorSimCtrl::GetExtensionIndex(SimCtrlExtension *ext) const {
+  auto it = std::find(extension_array_.begin(), extension_array_.end(), ext);
+  assert(it != extension_array_.end() && "Use RegisterExtension() first.");
+  return it - extension_array_.begin();
+}
+
+void VerilatorSimCtrl::ScheduleExtension(size_t idx, unsigned long cycle) {
+  if (cycle >= ext_wakeup_cycles_[idx]) {
+    return;
+  }
+  ext_wakeup_cycles_[idx] = cycle;
+  ext_wakeups_.Schedule(cycle, idx);
+  next_event_cycle_ = std::min(next_event_cycle_, cycle);
+}
+
+void VerilatorSimCtrl::RunExtensions(unsigned long cycle) {
+  if (!watched_fds_.empty() && cycle >= next_fd_poll_cycle_) {
+    next_fd_poll_cycle_ = cycle + fd_poll_interval_;
+    if (poll(watched_fds_.data(), watched_fds_.size(), 0) > 0) {
+      for (size_t i = 0; i < watched_fds_.size(); ++i) {
+        if (watched_fds_[i].revents) {
+          ScheduleExtension(watched_fd_exts_[i], cycle);
+        }
+      }
+    }
+  }
+
+  due_exts_.clear();
+  ext_wakeups_.PopDue(cycle, due_exts_);
+
+  // Call extensions in the order they were registered, as we did before they
+  // could sleep. Entries for extensions that have since been rescheduled to
+  // an earlier cycle have already fired, and are skipped.
+  std::sort(due_exts_.begin(), due_exts_.end());
+  due_exts_.erase(std::unique(due_exts_.begin(), due_exts_.end()),
+                  due_exts_.end());
+  for (size_t idx : due_exts_) {
+    if (ext_wakeup_cycles_[idx] > cycle) {
+      continue;
+    }
+    ext_wakeup_cycles_[idx] = SimCtrlExtension::kNoWakeup;
+
+    SimCtrlExtension *ext = extension_array_[idx];
+    ext->OnClock(time_);
+
+    unsigned long next = ext->NextWakeupCycle(cycle);
+    if (next != SimCtrlExtension::kNoWakeup) {
+      ScheduleExtension(idx, std::max(next, cycle + 1));
+    }
+  }
+}
+
+unsigned long VerilatorSimCtrl::GetNextEventCycle(
+    unsigned long cycle, unsigned long start_reset_cycle,
+    unsigned long end_reset_cycle) const {
+  unsigned long next = ext_wakeups_.NextDeadline();
+  auto consider = [cycle, &next](unsigned long candidate) {
+    if (candidate >= cycle) {
+      next = std::min(next, candidate);
+    }
+  };
+
+  consider(start_reset_cycle);
+  consider(end_reset_cycle);
+  if (!watched_fds_.empty()) {
+    consider(std::max(next_fd_poll_cycle_, cycle));
+  }
+  // The timeout is checked at the end of the cycle before it
+  if (term_after_cycles_) {
+    consider(term_after_cycles_ - 1);
+  }
+  if (save_checkpoint_) {
+    consider(save_checkpoint_cycle_);
+  }
+  consider(trace_start_cycle_);
+  consider(trace_stop_cycle_);
+  return next;
+}
+
 std::string VerilatorSimCtrl::GetName() const {
   if (top_) {
     return top_->name();
@@ -461,10 +993,48 @@ void VerilatorSimCtrl::Trace() {
   }
 
   if (!tracer_.isOpen()) {
-    tracer_.open(GetTraceFileName().c_str());
-    std::cout << "Writing simulation traces to " << GetTraceFileName()
-              << std::endl;
+    if (trace_ring_cycles_) {
+      OpenTraceFile(GetTraceRingFileName(trace_ring_segment_));
+      trace_ring_switch_time_ = time_ + 2 * trace_ring_cycles_;
+      std::cout << "Writing the last " << trace_ring_cycles_
+                << " cycles of simulation traces to "
+                << GetTraceRingFileName(0) << " and "
+                << GetTraceRingFileName(1) << std::endl;
+    } else {
+      OpenTraceFile(GetTraceFileName());
+      std::cout << "Writing simulation traces to " << GetTraceFileName()
+                << std::endl;
+    }
+  } else if (trace_ring_cycles_ && time_ >= trace_ring_switch_time_) {
+    // Start the other segment, overwriting what it held before. The one we
+    // just finished holds the last trace_ring_cycles_ cycles.
+    tracer_.close();
+    trace_ring_segment_ ^= 1;
+    trace_ring_wrapped_ = true;
+    OpenTraceFile(GetTraceRingFileName(trace_ring_segment_));
+    trace_ring_switch_time_ = time_ + 2 * trace_ring_cycles_;
   }
 
   tracer_.dump(GetTime());
 }
+
+void VerilatorSimCtrl::OpenTraceFile(const std::string &path) {
+  // Opening the trace file starts the trace writer threads (if any)
+  std::vector<pid_t> old_threads;
+  if (!trace_cpu_affinity_.empty()) {
+    old_threads = SimCtrlGetThreadIds();
+  }
+
+  tracer_.open(path.c_str());
+
+  if (!trace_cpu_affinity_.empty()) {
+    std::vector<pid_t> trace_threads;
+    for (pid_t tid : SimCtrlGetThreadIds()) {
+      if (std::find(old_threads.begin(), old_threads.end(), tid) ==
+          old_threads.end()) {
+        trace_threads.push_back(tid);
+      }
+    }
+    SimCtrlPinThreads(trace_threads, trace_cpu_affinity_);
+  }
+}
@@ -6,10 +6,14 @@
 #define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATOR_SIM_CTRL_H_
 
 #include <chrono>
+#include <cstdint>
+#include <poll.h>
 #include <string>
 #include <vector>
 
 #include "sim_ctrl_extension.h"
+#include "sim_ctrl_threads.h"
+#include "sim_ctrl_timer_wheel.h"
 #include "verilated_toplevel.h"
 
 enum VerilatorSimCtrlFlags {
@@ -116,6 +120,119 @@ class VerilatorSimCtrl {
    */
   void RegisterExtension(SimCtrlExtension *ext);
 
+  /**
+   * Wake a registered extension, so that its OnClock() is called in |cycle|
+   *
+   * This only ever brings a wakeup forward: if the extension is already due
+   * to wake before |cycle|, it is unchanged. If |cycle| has already passed,
+   * the extension is woken in the next cycle.
+   */
+  void WakeExtension(SimCtrlExtension *ext, unsigned long cycle);
+
+  /**
+   * Wake a registered extension whenever |fd| is readable
+   *
+   * Watched file descriptors are polled together, without blocking, every
+   * few cycles (see SetFdPollInterval()). If |fd| is readable, |ext| is woken
+   * in that cycle.
+   */
+  void WatchFd(int fd, SimCtrlExtension *ext);
+
+  /**
+   * Stop watching |fd|
+   */
+  void UnwatchFd(int fd);
+
+  /**
+   * Set the number of clock cycles between polls of watched file descriptors
+   */
+  void SetFdPollInterval(unsigned int cycles);
+
+  /**
+   * Pin the simulation threads to |cpus|
+   *
+   * The simulation threads are the thread calling Run() (which evaluates the
+   * design) and the worker threads of a model verilated with --threads. They
+   * are pinned, one per CPU, in that order when the simulation starts.
+   * Threads started later (for example, by DPI models) inherit the affinity
+   * of the thread that starts them. An empty list leaves affinity alone.
+   *
+   * This can be overridden with the --cpu-affinity command-line argument.
+   */
+  void SetCpuAffinity(const std::vector<int> &cpus);
+
+  /**
+   * Pin the trace writer threads to |cpus|
+   *
+   * A model verilated with --trace-threads writes the trace file from
+   * separate threads, which are started when tracing is first enabled. An
+   * empty list leaves them with the affinity of the thread calling Run().
+   *
+   * This can be overridden with the --trace-cpu-affinity command-line
+   * argument.
+   */
+  void SetTraceCpuAffinity(const std::vector<int> &cpus);
+
+  /**
+   * Trace cycles |start| up to (but not including) |stop|
+   *
+   * Pass kNoCycle as |stop| to trace until the end of the simulation. This
+   * can be overridden with the --trace-start and --trace-stop command-line
+   * arguments.
+   */
+  void SetTraceWindow(unsigned long start, unsigned long stop);
+
+  /**
+   * Only trace |hier| and the scopes below it
+   *
+   * |hier| is the name of a scope as it appears in the trace (for example,
+   * "TOP.chip_sim_tb.u_dut"). Call this more than once to trace several
+   * scopes. This needs Verilator 5, and must be called before tracing
+   * starts.
+   */
+  void AddTraceScope(const std::string &hier);
+
+  /**
+   * Only keep the last |cycles| cycles of the trace, and only if the
+   * simulation fails or times out
+   *
+   * The trace is written to two files, which take turns to hold |cycles|
+   * cycles each. When the simulation ends, they hold at least the last
+   * |cycles| cycles. They are deleted if the simulation succeeded. Zero
+   * (the default) writes a single trace file as normal.
+   */
+  void SetTraceRing(unsigned long cycles);
+
+  /**
+   * Arm the trace trigger called |name|, to start tracing when it fires
+   *
+   * Triggers are instances of the sim_trace_trigger module in the design. A
+   * trigger armed without a value fires the first time its valid input is
+   * high. A trigger armed with |value| fires the first time its value input
+   * matches while valid.
+   */
+  void AddTraceTrigger(const std::string &name);
+  void AddTraceTrigger(const std::string &name, uint64_t value);
+
+  /**
+   * Look up an armed trace trigger
+   *
+   * @return false if no trigger called |name| has been armed. Otherwise,
+   *         |has_value| and |value| say what value (if any) it matches.
+   */
+  bool GetTraceTrigger(const std::string &name, bool *has_value,
+                       uint64_t *value) const;
+
+  /**
+   * Start tracing because the trigger called |name| fired
+   */
+  void FireTraceTrigger(const std::string &name);
+
+  /**
+   * A cycle number meaning "never" (see SetTraceWindow())
+   */
+  static const unsigned long kNoCycle = ~0UL;
+
   /**
    * Get the current time in ticks
    */
@@ -138,9 +255,45 @@ class VerilatorSimCtrl {
   volatile bool simulation_success_;
   std::chrono::steady_clock::time_point time_begin_;
   std::chrono::steady_clock::time_point time_end_;
+  double cpu_time_begin_;
+  double cpu_time_end_;
   VerilatedTracer tracer_;
   unsigned long term_after_cycles_;
   std::vector<SimCtrlExtension *> extension_array_;
+  bool checkpoint_possible_;
+  bool save_checkpoint_;
+  unsigned long save_checkpoint_cycle_;
+  std::string save_checkpoint_path_;
+  std::string restore_checkpoint_path_;
+  // The cycle that each extension will next be woken in (or kNoWakeup)
+  std::vector<unsigned long> ext_wakeup_cycles_;
+  SimCtrlTimerWheel ext_wakeups_;
+  std::vector<size_t> due_exts_;
+  std::vector<struct pollfd> watched_fds_;
+  std::vector<size_t> watched_fd_exts_;
+  unsigned int fd_poll_interval_;
+  unsigned long next_fd_poll_cycle_;
+  // The first cycle that needs more than evaluating the design
+  unsigned long next_event_cycle_;
+  std::vector<int> cpu_affinity_;
+  std::vector<int> trace_cpu_affinity_;
+  unsigned int num_sim_threads_;
+  unsigned long trace_start_cycle_;
+  unsigned long trace_stop_cycle_;
+  std::vector<std::string> trace_scopes_;
+  struct TraceTriggerSpec {
+    std::string name;
+    bool has_value;
+    uint64_t value;
+  };
+  std::vector<TraceTriggerSpec> trace_triggers_;
+  // In ring mode, the segment being written (0 or 1), whether the other one
+  // has been written yet, and the time to switch.
+  unsigned long trace_ring_cycles_;
+  unsigned int trace_ring_segment_;
+  bool trace_ring_wrapped_;
+  unsigned long trace_ring_switch_time_;
+  bool timed_out_;
 
   /**
    * Default constructor
@@ -166,6 +319,14 @@ class VerilatorSimCtrl {
    */
   void PrintHelp() const;
 
+  /**
+   * Handle one of the --trace-* command-line arguments that take a value
+   *
+   * @param c The short option that getopt_long() returned for it
+   * @return false (after printing an error) if |arg| isn't valid
+   */
+  bool ParseTraceArg(int c, const char *arg);
+
   /**
    * Enable tracing (if possible)
    *
@@ -210,6 +371,56 @@ class VerilatorSimCtrl {
    */
   std::string GetTraceFileName() const;
 
+  /**
+   * Get the file name of a trace ring segment (0 or 1)
+   *
+   * This is the trace file name with the segment number inserted before the
+   * extension, e.g. "sim.1.fst".
+   */
+  std::string GetTraceRingFileName(unsigned int segment) const;
+
+  /**
+   * Open the trace file at |path|, pinning any trace writer threads that
+   * this starts
+   */
+  void OpenTraceFile(const std::string &path);
+
+  /**
+   * Delete the ring trace if the simulation succeeded, otherwise say where
+   * to find it.
+   */
+  void FinishTraceRing();
+
+  /**
+   * Is checkpointing support compiled into the simulation?
+   *
+   * This needs the design to be verilated with --savable, and VM_SAVABLE to
+   * be defined when compiling.
+   */
+  bool CheckpointPossible() const { return checkpoint_possible_; }
+
+  /**
+   * Save the simulation state to a checkpoint file
+   *
+   * This saves the design, the simulation time and the state of all
+   * registered extensions. It must be called between clock cycles, from the
+   * main loop.
+   *
+   * @return true on success. On failure, an error has been printed.
+   */
+  bool SaveCheckpoint(const std::string &path);
+
+  /**
+   * Restore the simulation state from a checkpoint file
+   *
+   * The checkpoint must have been saved by the same simulation binary, with
+   * the same extensions registered. This must be called after the initial
+   * blocks have been evaluated.
+   *
+   * @return true on success. On failure, an error has been printed.
+   */
+  bool RestoreCheckpoint(const std::string &path);
+
   /**
    * Run the main loop of the simulation
    *
@@ -217,6 +428,31 @@ class VerilatorSimCtrl {
    */
   void Run();
 
+  /**
+   * Get the index of a registered extension in extension_array_
+   */
+  size_t GetExtensionIndex(SimCtrlExtension *ext) const;
+
+  /**
+   * Schedule the extension at |idx| in extension_array_ to wake in |cycle|
+   */
+  void ScheduleExtension(size_t idx, unsigned long cycle);
+
+  /**
+   * Poll watched file descriptors (if due) and call OnClock() for the
+   * extensions that are awake in |cycle|
+   */
+  void RunExtensions(unsigned long cycle);
+
+  /**
+   * Get the first cycle at or after |cycle| in which something other than
+   * evaluating the design has to happen (reset, a wakeup, polling watched
+   * file descriptors, saving a checkpoint or the timeout)
+   */
+  unsigned long GetNextEventCycle(unsigned long cycle,
+                                  unsigned long start_reset_cycle,
+                                  unsigned long end_reset_cycle) const;
+
   /**
    * Get a name for this simulation
    *
@@ -0,0 +1,23 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// DPI functions that let a testbench talk to VerilatorSimCtrl.
+
+#include "verilator_sim_ctrl.h"
+
+extern "C" {
+
+/**
+ * Mark the simulation as failed and ask for it to stop.
+ *
+ * Unlike $error, this doesn't stop the simulation straight away, so the
+ * testbench can still call $finish and the simulation controller shuts down
+ * as usual (closing the trace and keeping a --trace-ring trace). The
+ * simulation then exits with an error.
+ */
+void simutil_report_failure(void) {
+  VerilatorSimCtrl::GetInstance().RequestStop(false);
+}
+
+}  // extern "C"
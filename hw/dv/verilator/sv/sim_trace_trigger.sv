@@ -0,0 +1,40 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// A named trigger that starts tracing in a Verilator simulation.
+//
+// The trigger is armed with --trace-trigger=NAME or --trace-trigger=NAME=VALUE on the simulation
+// command line. Without a value, it fires on the first clock edge where valid_i is high. With a
+// value, it fires on the first clock edge where valid_i is high and value_i equals the value (for
+// example, when the core retires the instruction at a given PC). Triggers that aren't armed cost a
+// single compare per cycle. Values are compared as 64 bits, so Width should be at most 64.
+module sim_trace_trigger #(
+  parameter string Name  = "",
+  parameter int    Width = 32
+) (
+  input logic             clk_i,
+  input logic             valid_i,
+  input logic [Width-1:0] value_i
+);
+  import "DPI-C" function
+    bit simutil_get_trace_trigger(input string name, output bit has_value, output longint value);
+
+  import "DPI-C" function
+    void simutil_fire_trace_trigger(input string name);
+
+  bit     armed;
+  bit     has_value;
+  longint value;
+
+  initial begin
+    armed = simutil_get_trace_trigger(Name, has_value, value);
+  end
+
+  always @(posedge clk_i) begin
+    if (armed && valid_i && (!has_value || 64'(value_i) == value)) begin
+      simutil_fire_trace_trigger(Name);
+      armed <= 1'b0;
+    end
+  end
+endmodule
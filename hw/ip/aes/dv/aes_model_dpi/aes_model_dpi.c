@@ -10,7 +10,9 @@
 #include <string.h>
 
 #include "aes.h"
+#include "aes_fast.h"
 #include "crypto.h"
+#include "dpi_array.h"
 #include "svdpi.h"
 
 void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
@@ -118,6 +120,125 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
   return;
 }
 
+// Context for c_dpi_aes_crypt_message() with the C model, and a buffer for
+// messages, kept from one call to the next to avoid allocating them each time.
+static aes_fast_ctx_t msg_ctx;
+static unsigned char *msg_buf;
+static int msg_buf_len;
+
+/**
+ * Get a buffer for len bytes of message data, only reallocating it when a
+ * message is longer than any before.
+ */
+static unsigned char *aes_msg_buf(int len) {
+  if (len > msg_buf_len) {
+    msg_buf = (unsigned char *)realloc(msg_buf, len);
+    assert(msg_buf);
+    msg_buf_len = len;
+  }
+  return msg_buf;
+}
+
+/**
+ * Get the key length in bytes from its one-hot encoding.
+ */
+static int aes_key_len_get(const svBitVecVal *key_len_i) {
+  if ((*key_len_i & key_len_mask) == 0x1) {
+    return 16;
+  } else if ((*key_len_i & key_len_mask) == 0x2) {
+    return 24;
+  } else {  // 0x4
+    return 32;
+  }
+}
+
+/**
+ * Convert a 1D array of words (2D packed array in SV) to bytes.
+ */
+static void aes_words_get(unsigned char *data, const svBitVecVal *words_i,
+                          int num_words) {
+  for (int i = 0; i < num_words; ++i) {
+    svBitVecVal value = words_i[i];
+    data[4 * i + 0] = (unsigned char)(value >> 0);
+    data[4 * i + 1] = (unsigned char)(value >> 8);
+    data[4 * i + 2] = (unsigned char)(value >> 16);
+    data[4 * i + 3] = (unsigned char)(value >> 24);
+  }
+}
+
+/**
+ * Copy len bytes of unpacked data from simulation.
+ */
+static void aes_msg_get(unsigned char *data, const svOpenArrayHandle data_i,
+                        int len) {
+  size_t stride = dpi_array_byte_stride(data_i, len);
+  if (stride == 1) {
+    memcpy(data, svGetArrayPtr(data_i), len);
+  } else if (stride) {
+    const svBitVecVal *values = (const svBitVecVal *)svGetArrayPtr(data_i);
+    for (int i = 0; i < len; i++) {
+      data[i] = (unsigned char)values[i];
+    }
+  } else {
+    svBitVecVal value;
+    for (int i = 0; i < len; i++) {
+      svGetBitArrElem1VecVal(&value, data_i, i);
+      data[i] = (unsigned char)value;
+    }
+  }
+}
+
+/**
+ * Copy up to len bytes of unpacked data to simulation, limited by the size of
+ * the SV array.
+ */
+static void aes_msg_put(const svOpenArrayHandle data_o,
+                        const unsigned char *data, int len) {
+  if (len > svSize(data_o, 1)) {
+    len = svSize(data_o, 1);
+  }
+  size_t stride = dpi_array_byte_stride(data_o, len);
+  if (stride == 1) {
+    memcpy(svGetArrayPtr(data_o), data, len);
+  } else if (stride) {
+    svBitVecVal *values = (svBitVecVal *)svGetArrayPtr(data_o);
+    for (int i = 0; i < len; i++) {
+      values[i] = (svBitVecVal)data[i];
+    }
+  } else {
+    svBitVecVal value;
+    for (int i = 0; i < len; i++) {
+      value = (svBitVecVal)data[i];
+      svPutBitArrElem1VecVal(data_o, &value, i);
+    }
+  }
+}
+
+/**
+ * Set up a fast C model context from the simulator's arguments.
+ *
+ * @return 0 on success, -1 for an unsupported mode
+ */
+static int aes_ctx_setup(aes_fast_ctx_t *ctx, unsigned char op_i,
+                         const svBitVecVal *mode_i, const svBitVecVal *iv_i,
+                         const svBitVecVal *key_len_i,
+                         const svBitVecVal *key_i) {
+  // Mask out unused bits as their value is undetermined.
+  const unsigned char op = op_i & op_mask;
+  const crypto_mode_t mode = (crypto_mode_t)(*mode_i & mode_mask);
+
+  unsigned char key[32];
+  unsigned char iv[16];
+  aes_words_get(key, key_i, 8);
+  aes_words_get(iv, iv_i, 4);
+
+  if (aes_fast_init(ctx, op, mode, key, aes_key_len_get(key_len_i), iv)) {
+    printf("ERROR: Mode %#x not supported by the AES C model\n", mode);
+    return -1;
+  }
+  return 0;
+}
+
 void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
                              const svBitVecVal *mode_i, const svBitVecVal *iv_i,
                              const svBitVecVal *key_len_i,
@@ -134,69 +255,41 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
     return;
   }
 
-  // key_len_i is one-hot encoded.
-  int key_len;
-  if ((*key_len_i & key_len_mask) == 0x1) {
-    key_len = 16;
-  } else if ((*key_len_i & key_len_mask) == 0x2) {
-    key_len = 24;
-  } else {  // 0x4
-    key_len = 32;
-  }
-
-  if (impl == 0) {
-    // The C model is currently not supported.
-    printf(
-        "ERROR: c_dpi_aes_crypt_message() currently supports OpenSSL/BoringSSL "
-        "only\n");
-    return;
-  }
-
-  // Get key from simulator.
-  unsigned char *key = aes_key_get(key_i);
-
-  // Modes other than ECB require an IV from the simulator.
-  unsigned char *iv = (unsigned char *)malloc(16 * sizeof(unsigned char));
-  assert(iv);
-  if (mode != kCryptoAesEcb) {
-    // iv_i is a 1D array of words (4x32bit), but we need 16 bytes.
-    svBitVecVal value;
-    for (int i = 0; i < 4; ++i) {
-      value = iv_i[i];
-      iv[4 * i + 0] = (unsigned char)(value >> 0);
-      iv[4 * i + 1] = (unsigned char)(value >> 8);
-      iv[4 * i + 2] = (unsigned char)(value >> 16);
-      iv[4 * i + 3] = (unsigned char)(value >> 24);
-    }
-  } else {
-    memset(iv, 0, 16);
-  }
-
   // Get message length.
   int data_len = svSize(data_i, 1);
-
-  // Get input data from simulator.
-  unsigned char *ref_in = aes_data_unpacked_get(data_i);
-
-  // Allocate output buffer.
-  unsigned char *ref_out =
-      (unsigned char *)malloc(data_len * sizeof(unsigned char));
-  assert(ref_out);
-
-  // OpenSSL/BoringSSL
-  if ((int)data_len % 16) {
+  if (data_len % 16) {
     printf(
         "ERROR: Message length must be a multiple of 16 bytes (the block "
         "size).\n");
     return;
   }
 
+  // Get input data from simulator, into the first half of the buffer. The
+  // output goes into the second half.
+  unsigned char *ref_in = aes_msg_buf(2 * data_len);
+  unsigned char *ref_out = ref_in + data_len;
+  aes_msg_get(ref_in, data_i, data_len);
+
   if (impl == 0) {
-    // The C model is currently not supported.
-    printf(
-        "ERROR: c_dpi_aes_crypt_message() currently supports OpenSSL/BoringSSL "
-        "only\n");
+    // C model
+    if (aes_ctx_setup(&msg_ctx, op_i, mode_i, iv_i, key_len_i, key_i)) {
+      return;
+    }
+    aes_fast_update(&msg_ctx, ref_out, ref_in, data_len);
   } else {  // OpenSSL/BoringSSL
+    int key_len = aes_key_len_get(key_len_i);
+    unsigned char key[32];
+    aes_words_get(key, key_i, 8);
+
+    // Modes other than ECB require an IV from the simulator.
+    unsigned char iv[16];
+    if (mode != kCryptoAesEcb) {
+      // iv_i is a 1D array of words (4x32bit), but we need 16 bytes.
+      aes_words_get(iv, iv_i, 4);
+    } else {
+      memset(iv, 0, 16);
+    }
+
     if (!op) {
       crypto_encrypt(ref_out, iv, ref_in, data_len, key, key_len, mode);
     } else {
@@ -204,14 +297,44 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
     }
   }
 
-  // Write output data back to simulator, free ref_out.
-  aes_data_unpacked_put(data_o, ref_out);
+  // Write output data back to simulator.
+  aes_msg_put(data_o, ref_out, data_len);
+}
 
-  // Free memory.
-  free(iv);
-  free(key);
+void *c_dpi_aes_ctx_new(void) {
+  aes_fast_ctx_t *ctx = (aes_fast_ctx_t *)calloc(1, sizeof(aes_fast_ctx_t));
+  assert(ctx);
+  return ctx;
+}
+
+int c_dpi_aes_ctx_init(void *ctx, unsigned char op_i,
+                       const svBitVecVal *mode_i, const svBitVecVal *iv_i,
+                       const svBitVecVal *key_len_i, const svBitVecVal *key_i) {
+  assert(ctx);
+  return aes_ctx_setup((aes_fast_ctx_t *)ctx, op_i, mode_i, iv_i, key_len_i,
+                       key_i);
 }
 
+void c_dpi_aes_ctx_update(void *ctx, const svOpenArrayHandle data_i,
+                          svOpenArrayHandle data_o) {
+  assert(ctx);
+  int data_len = svSize(data_i, 1);
+  if (data_len % 16) {
+    printf(
+        "ERROR: Message length must be a multiple of 16 bytes (the block "
+        "size).\n");
+    return;
+  }
+
+  // Encrypt/decrypt in place.
+  unsigned char *data = aes_msg_buf(data_len);
+  aes_msg_get(data, data_i, data_len);
+  aes_fast_update((aes_fast_ctx_t *)ctx, data, data, data_len);
+  aes_msg_put(data_o, data, data_len);
+}
+
+void c_dpi_aes_ctx_free(void *ctx) { free(ctx); }
+
 void c_dpi_aes_sub_bytes(const unsigned char op_i, const svBitVecVal *data_i,
                          svBitVecVal *data_o) {
   // get input data from simulator
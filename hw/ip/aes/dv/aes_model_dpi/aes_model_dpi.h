@@ -41,7 +41,10 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
                            svBitVecVal *data_o);
 
 /**
- * Perform encryption/decryption of an entire message using OpenSSL/BoringSSL.
+ * Perform encryption/decryption of an entire message.
+ *
+ * The C model used for impl_i = 0 is the fast model (aes_fast.h), which
+ * supports all cipher modes.
  *
  * @param  impl_i    Select reference impl.: 0 = C model, 1 = OpenSSL/BoringSSL
  * @param  op_i      Operation: 0 = encrypt, 1 = decrypt
@@ -62,6 +65,51 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
                              const svOpenArrayHandle data_i,
                              svOpenArrayHandle data_o);
 
+/**
+ * Create a context for encryption/decryption of messages with the fast C
+ * model, which may be passed in several parts. A context can be reused for any
+ * number of messages by calling c_dpi_aes_ctx_init() for each one.
+ *
+ * @return Context handle, to be freed with c_dpi_aes_ctx_free()
+ */
+void *c_dpi_aes_ctx_new(void);
+
+/**
+ * Start a new message with a context.
+ *
+ * @param  ctx       Context from c_dpi_aes_ctx_new()
+ * @param  op_i      Operation: 0 = encrypt, 1 = decrypt
+ * @param  mode_i    Cipher mode: 6'b00_0001 = ECB, 6'00_b0010 = CBC,
+ *                                6'b00_0100 = CFB, 6'b00_1000 = OFB,
+ *                                6'b01_0000 = CTR
+ * @param  iv_i      Initialization vector: 1D array of words (2D packed array
+ *                   in SV)
+ * @param  key_len_i Key length: 3'b001 = 128b, 3'b010 = 192b, 3'b100 = 256b
+ * @param  key_i     Full input key, 1D array of words (2D packed array in SV)
+ * @return 0 on success, -1 for an unsupported mode
+ */
+int c_dpi_aes_ctx_init(void *ctx, unsigned char op_i,
+                       const svBitVecVal *mode_i, const svBitVecVal *iv_i,
+                       const svBitVecVal *key_len_i, const svBitVecVal *key_i);
+
+/**
+ * Encrypt/decrypt the next part of the current message of a context.
+ *
+ * @param  ctx    Context from c_dpi_aes_ctx_new()
+ * @param  data_i Input data, 1D byte array (open array in SV), a multiple of
+ *                16 bytes
+ * @param  data_o Output data, 1D byte array (open array in SV)
+ */
+void c_dpi_aes_ctx_update(void *ctx, const svOpenArrayHandle data_i,
+                          svOpenArrayHandle data_o);
+
+/**
+ * Free a context.
+ *
+ * @param  ctx Context from c_dpi_aes_ctx_new()
+ */
+void c_dpi_aes_ctx_free(void *ctx);
+
 /**
  * Perform sub bytes operation for forward/inverse cipher operation.
  *
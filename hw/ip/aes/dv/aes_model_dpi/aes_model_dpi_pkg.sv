@@ -30,6 +30,31 @@ package aes_model_dpi_pkg;
     output bit        [7:0] data_o[]
   );
 
+  // Context for messages passed in several parts, using the C model only. Create a context with
+  // c_dpi_aes_ctx_new(), start each message with c_dpi_aes_ctx_init() and pass the message through
+  // c_dpi_aes_ctx_update() in parts of any multiple of 16 bytes.
+  import "DPI-C" context function chandle c_dpi_aes_ctx_new();
+
+  import "DPI-C" context function int c_dpi_aes_ctx_init(
+    input  chandle          ctx,
+    input  bit              op_i,      // 0 = encrypt, 1 = decrypt
+    input  bit        [5:0] mode_i,    // 6'b00_0001 = ECB, 6'00_b0010 = CBC, 6'b00_0100 = CFB,
+                                       // 6'b00_1000 = OFB, 6'b01_0000 = CTR
+    input  bit  [3:0][31:0] iv_i,
+    input  bit        [2:0] key_len_i, // 3'b001 = 128b, 3'b010 = 192b, 3'b100 = 256b
+    input  bit  [7:0][31:0] key_i
+  );
+
+  import "DPI-C" context function void c_dpi_aes_ctx_update(
+    input  chandle          ctx,
+    input  bit        [7:0] data_i[],
+    output bit        [7:0] data_o[]
+  );
+
+  import "DPI-C" context function void c_dpi_aes_ctx_free(
+    input  chandle          ctx
+  );
+
   import "DPI-C" context function void c_dpi_aes_sub_bytes(
     input  bit                op_i, // 0 = encrypt, 1 = decrypt
     input  bit[3:0][3:0][7:0] data_i,
@@ -0,0 +1,355 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "aes_fast.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "aes.h"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(AES_FAST_NO_AESNI)
+#define AES_FAST_AESNI 1
+#include <wmmintrin.h>
+#endif
+
+// T-tables, filled in on first use: Te combines SubBytes and MixColumns for
+// one byte of a column, and Td combines InvSubBytes and InvMixColumns. The
+// tables for the other bytes of a column are rotations of these.
+static uint32_t te[256];
+static uint32_t td[256];
+static int tables_ready;
+
+static const unsigned char rcon_table[10] = {0x01, 0x02, 0x04, 0x08, 0x10,
+                                             0x20, 0x40, 0x80, 0x1b, 0x36};
+
+static unsigned char xtime(unsigned char x) {
+  return (unsigned char)((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+static unsigned char gf_mul(unsigned char a, unsigned char b) {
+  unsigned char p = 0;
+  while (b) {
+    if (b & 1) {
+      p ^= a;
+    }
+    a = xtime(a);
+    b >>= 1;
+  }
+  return p;
+}
+
+static void make_tables(void) {
+  for (int i = 0; i < 256; i++) {
+    unsigned char s = sbox[i];
+    te[i] = ((uint32_t)xtime(s) << 24) | ((uint32_t)s << 16) |
+            ((uint32_t)s << 8) | (uint32_t)(xtime(s) ^ s);
+    unsigned char is = inv_sbox[i];
+    td[i] = ((uint32_t)gf_mul(is, 0x0e) << 24) |
+            ((uint32_t)gf_mul(is, 0x09) << 16) |
+            ((uint32_t)gf_mul(is, 0x0d) << 8) | (uint32_t)gf_mul(is, 0x0b);
+  }
+  tables_ready = 1;
+}
+
+static inline uint32_t ror32(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void store_be32(unsigned char *p, uint32_t x) {
+  p[0] = (unsigned char)(x >> 24);
+  p[1] = (unsigned char)(x >> 16);
+  p[2] = (unsigned char)(x >> 8);
+  p[3] = (unsigned char)x;
+}
+
+static inline uint32_t sub_word(uint32_t w) {
+  return ((uint32_t)sbox[w >> 24] << 24) |
+         ((uint32_t)sbox[(w >> 16) & 0xff] << 16) |
+         ((uint32_t)sbox[(w >> 8) & 0xff] << 8) | (uint32_t)sbox[w & 0xff];
+}
+
+// One column of a T-table round. For encryption a, b, c and d are the state
+// columns in ShiftRows order, and for decryption in InvShiftRows order.
+static inline uint32_t table_col(const uint32_t *table, uint32_t a, uint32_t b,
+                                 uint32_t c, uint32_t d) {
+  return table[a >> 24] ^ ror32(table[(b >> 16) & 0xff], 8) ^
+         ror32(table[(c >> 8) & 0xff], 16) ^ ror32(table[d & 0xff], 24);
+}
+
+// One column of the last round, which has no (Inv)MixColumns
+static inline uint32_t sbox_col(const unsigned char *box, uint32_t a,
+                                uint32_t b, uint32_t c, uint32_t d) {
+  return ((uint32_t)box[a >> 24] << 24) |
+         ((uint32_t)box[(b >> 16) & 0xff] << 16) |
+         ((uint32_t)box[(c >> 8) & 0xff] << 8) | (uint32_t)box[d & 0xff];
+}
+
+static void ttable_encrypt_block(const aes_fast_ctx_t *ctx,
+                                 const unsigned char *in, unsigned char *out) {
+  const uint32_t *rk = ctx->enc_rk;
+  uint32_t s0 = load_be32(in) ^ rk[0];
+  uint32_t s1 = load_be32(in + 4) ^ rk[1];
+  uint32_t s2 = load_be32(in + 8) ^ rk[2];
+  uint32_t s3 = load_be32(in + 12) ^ rk[3];
+  uint32_t t0, t1, t2, t3;
+
+  for (int rnd = 1; rnd < ctx->num_rounds; rnd++) {
+    rk += 4;
+    t0 = table_col(te, s0, s1, s2, s3) ^ rk[0];
+    t1 = table_col(te, s1, s2, s3, s0) ^ rk[1];
+    t2 = table_col(te, s2, s3, s0, s1) ^ rk[2];
+    t3 = table_col(te, s3, s0, s1, s2) ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+
+  rk += 4;
+  store_be32(out, sbox_col(sbox, s0, s1, s2, s3) ^ rk[0]);
+  store_be32(out + 4, sbox_col(sbox, s1, s2, s3, s0) ^ rk[1]);
+  store_be32(out + 8, sbox_col(sbox, s2, s3, s0, s1) ^ rk[2]);
+  store_be32(out + 12, sbox_col(sbox, s3, s0, s1, s2) ^ rk[3]);
+}
+
+static void ttable_decrypt_block(const aes_fast_ctx_t *ctx,
+                                 const unsigned char *in, unsigned char *out) {
+  const uint32_t *rk = ctx->dec_rk;
+  uint32_t s0 = load_be32(in) ^ rk[0];
+  uint32_t s1 = load_be32(in + 4) ^ rk[1];
+  uint32_t s2 = load_be32(in + 8) ^ rk[2];
+  uint32_t s3 = load_be32(in + 12) ^ rk[3];
+  uint32_t t0, t1, t2, t3;
+
+  for (int rnd = 1; rnd < ctx->num_rounds; rnd++) {
+    rk += 4;
+    t0 = table_col(td, s0, s3, s2, s1) ^ rk[0];
+    t1 = table_col(td, s1, s0, s3, s2) ^ rk[1];
+    t2 = table_col(td, s2, s1, s0, s3) ^ rk[2];
+    t3 = table_col(td, s3, s2, s1, s0) ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+
+  rk += 4;
+  store_be32(out, sbox_col(inv_sbox, s0, s3, s2, s1) ^ rk[0]);
+  store_be32(out + 4, sbox_col(inv_sbox, s1, s0, s3, s2) ^ rk[1]);
+  store_be32(out + 8, sbox_col(inv_sbox, s2, s1, s0, s3) ^ rk[2]);
+  store_be32(out + 12, sbox_col(inv_sbox, s3, s2, s1, s0) ^ rk[3]);
+}
+
+#ifdef AES_FAST_AESNI
+__attribute__((target("aes,sse2"))) static void aesni_encrypt_block(
+    const aes_fast_ctx_t *ctx, const unsigned char *in, unsigned char *out) {
+  const __m128i *rk = (const __m128i *)ctx->enc_rk_bytes;
+  __m128i s = _mm_loadu_si128((const __m128i *)in);
+  s = _mm_xor_si128(s, _mm_loadu_si128(&rk[0]));
+  for (int rnd = 1; rnd < ctx->num_rounds; rnd++) {
+    s = _mm_aesenc_si128(s, _mm_loadu_si128(&rk[rnd]));
+  }
+  s = _mm_aesenclast_si128(s, _mm_loadu_si128(&rk[ctx->num_rounds]));
+  _mm_storeu_si128((__m128i *)out, s);
+}
+
+__attribute__((target("aes,sse2"))) static void aesni_decrypt_block(
+    const aes_fast_ctx_t *ctx, const unsigned char *in, unsigned char *out) {
+  const __m128i *rk = (const __m128i *)ctx->dec_rk_bytes;
+  __m128i s = _mm_loadu_si128((const __m128i *)in);
+  s = _mm_xor_si128(s, _mm_loadu_si128(&rk[0]));
+  for (int rnd = 1; rnd < ctx->num_rounds; rnd++) {
+    s = _mm_aesdec_si128(s, _mm_loadu_si128(&rk[rnd]));
+  }
+  s = _mm_aesdeclast_si128(s, _mm_loadu_si128(&rk[ctx->num_rounds]));
+  _mm_storeu_si128((__m128i *)out, s);
+}
+#endif
+
+static int force_ttable = 0;
+
+void aes_fast_force_ttable(int force) { force_ttable = force; }
+
+int aes_fast_have_aesni(void) {
+#ifdef AES_FAST_AESNI
+  static int have_aesni = -1;
+  if (have_aesni < 0) {
+    __builtin_cpu_init();
+    have_aesni = __builtin_cpu_supports("aes") ? 1 : 0;
+  }
+  return have_aesni;
+#else
+  return 0;
+#endif
+}
+
+static inline void encrypt_block(const aes_fast_ctx_t *ctx,
+                                 const unsigned char *in, unsigned char *out) {
+#ifdef AES_FAST_AESNI
+  if (ctx->use_aesni) {
+    aesni_encrypt_block(ctx, in, out);
+    return;
+  }
+#endif
+  ttable_encrypt_block(ctx, in, out);
+}
+
+static inline void decrypt_block(const aes_fast_ctx_t *ctx,
+                                 const unsigned char *in, unsigned char *out) {
+#ifdef AES_FAST_AESNI
+  if (ctx->use_aesni) {
+    aesni_decrypt_block(ctx, in, out);
+    return;
+  }
+#endif
+  ttable_decrypt_block(ctx, in, out);
+}
+
+static inline void xor_block(unsigned char *out, const unsigned char *a,
+                             const unsigned char *b) {
+  for (int i = 0; i < 16; i++) {
+    out[i] = a[i] ^ b[i];
+  }
+}
+
+int aes_fast_init(aes_fast_ctx_t *ctx, int op, crypto_mode_t mode,
+                  const unsigned char *key, int key_len,
+                  const unsigned char *iv) {
+  if (mode != kCryptoAesEcb && mode != kCryptoAesCbc && mode != kCryptoAesCfb &&
+      mode != kCryptoAesOfb && mode != kCryptoAesCtr) {
+    return -EINVAL;
+  }
+  if (key_len != 16 && key_len != 24 && key_len != 32) {
+    return -EINVAL;
+  }
+  if (!tables_ready) {
+    make_tables();
+  }
+
+  const int nk = key_len / 4;
+  ctx->num_rounds = nk + 6;
+  ctx->use_aesni = !force_ttable && aes_fast_have_aesni();
+  ctx->op = op;
+  ctx->mode = mode;
+  if (mode == kCryptoAesEcb) {
+    memset(ctx->iv, 0, 16);
+  } else {
+    memcpy(ctx->iv, iv, 16);
+  }
+
+  // Key expansion (FIPS 197, section 5.2)
+  const int num_words = 4 * (ctx->num_rounds + 1);
+  uint32_t *w = ctx->enc_rk;
+  for (int i = 0; i < nk; i++) {
+    w[i] = load_be32(&key[4 * i]);
+  }
+  for (int i = nk; i < num_words; i++) {
+    uint32_t temp = w[i - 1];
+    if (i % nk == 0) {
+      temp = sub_word(ror32(temp, 24)) ^
+             ((uint32_t)rcon_table[i / nk - 1] << 24);
+    } else if (nk > 6 && i % nk == 4) {
+      temp = sub_word(temp);
+    }
+    w[i] = w[i - nk] ^ temp;
+  }
+
+  // Round keys for the Equivalent Inverse Cipher (FIPS 197, section 5.3.5):
+  // in reverse order, and with InvMixColumns applied to all but the first and
+  // last. td[sbox[x]] is InvMixColumns of byte x on its own.
+  for (int rnd = 0; rnd <= ctx->num_rounds; rnd++) {
+    for (int col = 0; col < 4; col++) {
+      uint32_t k = w[4 * (ctx->num_rounds - rnd) + col];
+      if (rnd > 0 && rnd < ctx->num_rounds) {
+        k = td[sbox[k >> 24]] ^ ror32(td[sbox[(k >> 16) & 0xff]], 8) ^
+            ror32(td[sbox[(k >> 8) & 0xff]], 16) ^
+            ror32(td[sbox[k & 0xff]], 24);
+      }
+      ctx->dec_rk[4 * rnd + col] = k;
+    }
+  }
+
+  for (int i = 0; i < num_words; i++) {
+    store_be32(&ctx->enc_rk_bytes[4 * i], ctx->enc_rk[i]);
+    store_be32(&ctx->dec_rk_bytes[4 * i], ctx->dec_rk[i]);
+  }
+
+  return 0;
+}
+
+int aes_fast_update(aes_fast_ctx_t *ctx, unsigned char *output,
+                    const unsigned char *input, int len) {
+  if (len < 0 || len % 16) {
+    return -EINVAL;
+  }
+
+  unsigned char block[16];
+  for (int pos = 0; pos < len; pos += 16) {
+    const unsigned char *in = &input[pos];
+    unsigned char *out = &output[pos];
+
+    switch (ctx->mode) {
+      case kCryptoAesEcb:
+        if (!ctx->op) {
+          encrypt_block(ctx, in, out);
+        } else {
+          decrypt_block(ctx, in, out);
+        }
+        break;
+
+      case kCryptoAesCbc:
+        if (!ctx->op) {
+          // The cipher text is the IV for the next block
+          xor_block(block, in, ctx->iv);
+          encrypt_block(ctx, block, ctx->iv);
+          memcpy(out, ctx->iv, 16);
+        } else {
+          // Keep the cipher text, in case in and out are the same
+          decrypt_block(ctx, in, block);
+          xor_block(block, block, ctx->iv);
+          memcpy(ctx->iv, in, 16);
+          memcpy(out, block, 16);
+        }
+        break;
+
+      case kCryptoAesCfb:
+        encrypt_block(ctx, ctx->iv, block);
+        if (!ctx->op) {
+          xor_block(out, in, block);
+          memcpy(ctx->iv, out, 16);
+        } else {
+          memcpy(ctx->iv, in, 16);
+          xor_block(out, in, block);
+        }
+        break;
+
+      case kCryptoAesOfb:
+        encrypt_block(ctx, ctx->iv, ctx->iv);
+        xor_block(out, in, ctx->iv);
+        break;
+
+      case kCryptoAesCtr:
+        encrypt_block(ctx, ctx->iv, block);
+        xor_block(out, in, block);
+        // The counter is the whole IV, as a 128-bit big-endian number
+        for (int i = 15; i >= 0; i--) {
+          if (++ctx->iv[i]) {
+            break;
+          }
+        }
+        break;
+
+      default:
+        return -EINVAL;
+    }
+  }
+
+  return len;
+}
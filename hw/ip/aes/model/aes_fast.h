@@ -0,0 +1,91 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
+#define OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
+
+#include <stdint.h>
+
+#include "crypto.h"
+
+/**
+ * Fast AES model for whole messages
+ *
+ * Unlike the model in aes.c, which follows the structure of the cipher core
+ * to make intermediate results visible, this one is written for speed. It
+ * uses T-tables, or the AES-NI instructions on x86 hosts that have them, and
+ * expands the key once for a whole message. It supports all of the cipher
+ * modes of the AES unit, and messages may be processed in several parts.
+ *
+ * Building with AES_FAST_NO_AESNI defined leaves out the AES-NI code, and
+ * aes_fast_force_ttable() selects the T-tables at runtime.
+ */
+typedef struct aes_fast_ctx {
+  // Round keys for encryption and (for the Equivalent Inverse Cipher)
+  // decryption, as big-endian words
+  uint32_t enc_rk[60];
+  uint32_t dec_rk[60];
+  // The same round keys as bytes, for AES-NI
+  unsigned char enc_rk_bytes[240];
+  unsigned char dec_rk_bytes[240];
+  int num_rounds;
+  int use_aesni;
+  // 0 = encrypt, 1 = decrypt
+  int op;
+  crypto_mode_t mode;
+  // IV (for CBC and CFB), output block (for OFB) or counter (for CTR) to use
+  // for the next block
+  unsigned char iv[16];
+} aes_fast_ctx_t;
+
+/**
+ * Set up a context for a new message.
+ *
+ * This expands the key, so a context may be reused for any number of
+ * messages without further allocation.
+ *
+ * @param  ctx     Context to set up
+ * @param  op      Operation: 0 = encrypt, 1 = decrypt
+ * @param  mode    AES cipher mode @see crypto_mode, other than kCryptoAesNone
+ * @param  key     Encryption key
+ * @param  key_len Encryption key length in bytes (16, 24, 32)
+ * @param  iv      16-byte initialization vector, ignored for ECB
+ * @return 0 on success, -EINVAL for an unsupported mode or key length
+ */
+int aes_fast_init(aes_fast_ctx_t *ctx, int op, crypto_mode_t mode,
+                  const unsigned char *key, int key_len,
+                  const unsigned char *iv);
+
+/**
+ * Encrypt or decrypt the next part of a message.
+ *
+ * The input and output may be the same buffer.
+ *
+ * @param  ctx    Context set up by aes_fast_init()
+ * @param  output Output text, must be a multiple of 16 bytes
+ * @param  input  Input text, must be a multiple of 16 bytes
+ * @param  len    Length of the input text in bytes, must be a multiple of 16
+ * @return Length of the output text in bytes, -EINVAL in case of error
+ */
+int aes_fast_update(aes_fast_ctx_t *ctx, unsigned char *output,
+                    const unsigned char *input, int len);
+
+/**
+ * Check whether the fast model uses the AES-NI instructions on this host.
+ *
+ * @return 1 if AES-NI is used, 0 if the T-tables are used
+ */
+int aes_fast_have_aesni(void);
+
+/**
+ * Make contexts set up from now on use the T-tables even if AES-NI is
+ * available, so that both implementations can be checked on the same host.
+ *
+ * Contexts that are already set up keep their implementation.
+ *
+ * @param force 1 to always use the T-tables, 0 to use AES-NI where available
+ */
+void aes_fast_force_ttable(int force);
+
+#endif  // OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "aes.h"
+#include "aes_fast.h"
 #include "crypto.h"
 
 #ifdef USE_BORING_SSL
@@ -118,6 +119,56 @@ static int crypto_compare(const unsigned char *cipher_text,
   return 0;
 }
 
+static int fast_model_compare(const unsigned char *cipher_text,
+                              const unsigned char *iv,
+                              const unsigned char *plain_text, int len,
+                              const unsigned char *key, int key_len,
+                              crypto_mode_t mode) {
+  aes_fast_ctx_t ctx;
+  unsigned char data_out[64];
+  if (len > (int)sizeof(data_out)) {
+    printf("ERROR: len = %i too long\n", len);
+    return 1;
+  }
+
+  // Check the T-tables, and AES-NI as well if this host has it.
+  for (int use_aesni = 0; use_aesni <= aes_fast_have_aesni(); ++use_aesni) {
+    const char *impl = use_aesni ? "AES-NI" : "T-table";
+    aes_fast_force_ttable(!use_aesni);
+
+    // Process each message in two parts, to check that the chaining state is
+    // carried over from one to the next.
+    for (int op = 0; op < 2; ++op) {
+      const unsigned char *data_in = op ? cipher_text : plain_text;
+      const unsigned char *expected = op ? plain_text : cipher_text;
+      if (aes_fast_init(&ctx, op, mode, key, key_len, iv) ||
+          ctx.use_aesni != use_aesni ||
+          aes_fast_update(&ctx, data_out, data_in, 16) != 16 ||
+          aes_fast_update(&ctx, &data_out[16], &data_in[16], len - 16) !=
+              len - 16) {
+        printf("ERROR: Fast model (%s) failed\n", impl);
+        aes_fast_force_ttable(0);
+        return 1;
+      }
+
+      for (int j = 0; j < len / 16; ++j) {
+        if (check_block(&data_out[j * 16], &expected[j * 16], 1)) {
+          printf(
+              "ERROR: Fast model (%s) %s output does not match NIST example\n",
+              impl, op ? "decrypt" : "encrypt");
+          aes_fast_force_ttable(0);
+          return 1;
+        }
+      }
+      printf("SUCCESS: Fast model (%s) %s output matches NIST example\n",
+             impl, op ? "decrypt" : "encrypt");
+    }
+  }
+  aes_fast_force_ttable(0);
+
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   const int len = 64;
   int key_len;
@@ -154,6 +205,10 @@ int main(int argc, char *argv[]) {
                        mode)) {
       return 1;
     }
+    if (fast_model_compare(cipher_text, iv, kAesModesPlainText, len, key,
+                           key_len, mode)) {
+      return 1;
+    }
   }
 
   /////////
@@ -184,6 +239,10 @@ int main(int argc, char *argv[]) {
                        mode)) {
       return 1;
     }
+    if (fast_model_compare(cipher_text, iv, kAesModesPlainText, len, key,
+                           key_len, mode)) {
+      return 1;
+    }
   }
 
   /////////
@@ -215,6 +274,10 @@ int main(int argc, char *argv[]) {
                        mode)) {
       return 1;
     }
+    if (fast_model_compare(cipher_text, iv, kAesModesPlainText, len, key,
+                           key_len, mode)) {
+      return 1;
+    }
   }
 
   /////////
@@ -245,6 +308,10 @@ int main(int argc, char *argv[]) {
                        mode)) {
       return 1;
     }
+    if (fast_model_compare(cipher_text, iv, kAesModesPlainText, len, key,
+                           key_len, mode)) {
+      return 1;
+    }
   }
 
   /////////
@@ -275,6 +342,10 @@ int main(int argc, char *argv[]) {
                        mode)) {
       return 1;
     }
+    if (fast_model_compare(cipher_text, iv, kAesModesPlainText, len, key,
+                           key_len, mode)) {
+      return 1;
+    }
   }
 
   return 0;
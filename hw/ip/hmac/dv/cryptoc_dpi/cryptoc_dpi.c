@@ -6,7 +6,9 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "dpi_array.h"
 #include "hmac.h"
 #include "hmac_wrap.h"
 #include "sha.h"
@@ -17,9 +19,22 @@
 // SystemVerilog DPI definitions
 #include "svdpi.h"
 
+// Buffer that is reused from one call to the next, so that marshalling a
+// message costs no more than a copy
+typedef struct scratch_buf {
+  uint8_t *data;
+  size_t size;
+} scratch_buf_t;
+
+static scratch_buf_t msg_buf;
+static scratch_buf_t key_buf;
+
 // Gather the elements of the open array to form a C-style array of contiguous
-// bytes
-static uint8_t *collect_bytes(const svOpenArrayHandle arg, uint64_t len) {
+// bytes. Where the simulator already stores the array as bytes this returns
+// its storage directly; otherwise the bytes are gathered into `buf`, so the
+// result is valid only until the next call with the same buffer.
+static const uint8_t *collect_bytes(const svOpenArrayHandle arg, uint64_t len,
+                                    scratch_buf_t *buf) {
   // Note: alas when passed an open array that is empty we are unable even to
   //       query svSize() of the single dimension without inducing a E,MEMALC
   //       error from xcelium, so we must pass supplied with the length.
@@ -28,27 +43,35 @@ static uint8_t *collect_bytes(const svOpenArrayHandle arg, uint64_t len) {
   assert(1 == svDimensions(arg));
   assert(len <= svSize(arg, 1));
 
-  uint8_t *arr = (uint8_t *)malloc(len);
-  if (arr) {
-    const svBitVecVal *ptr = (svBitVecVal *)svGetArrayPtr(arg);
-    if (ptr) {
-      // C-style layout
-      for (uint64_t idx = 0u; idx < len; ++idx) {
-        arr[idx] = (uint8_t)ptr[idx];
-      }
-    } else {
-      // The implementation-independent way to access open arrays is to use the
-      // SystemVerilog array bounds/indexes.
-      const int high = svHigh(arg, 1);
-      const int low = svLow(arg, 1);
-
-      printf("bounds [%d:%d]\n", high, low);
-
-      for (int idx = low; idx <= high; ++idx) {
-        uint8_t *ptr = (uint8_t *)svGetArrElemPtr1(arg, idx);
-        assert(ptr);
-        arr[idx] = (uint8_t)*ptr;
-      }
+  const size_t stride = dpi_array_byte_stride(arg, len);
+  if (stride == 1u) {
+    return (const uint8_t *)svGetArrayPtr(arg);
+  }
+
+  if (buf->size < len) {
+    uint8_t *data = (uint8_t *)realloc(buf->data, len);
+    if (!data) {
+      return NULL;
+    }
+    buf->data = data;
+    buf->size = len;
+  }
+  uint8_t *arr = buf->data;
+
+  if (stride == sizeof(svBitVecVal)) {
+    // C-style layout, one element per word
+    const svBitVecVal *ptr = (const svBitVecVal *)svGetArrayPtr(arg);
+    for (uint64_t idx = 0u; idx < len; ++idx) {
+      arr[idx] = (uint8_t)ptr[idx];
+    }
+  } else {
+    // The implementation-independent way to access open arrays is to use the
+    // SystemVerilog array bounds/indexes.
+    const int low = svLow(arg, 1);
+    for (uint64_t idx = 0u; idx < len; ++idx) {
+      const uint8_t *ptr = (uint8_t *)svGetArrElemPtr1(arg, low + (int)idx);
+      assert(ptr);
+      arr[idx] = *ptr;
     }
   }
 
@@ -58,26 +81,22 @@ static uint8_t *collect_bytes(const svOpenArrayHandle arg, uint64_t len) {
 extern void c_dpi_SHA_hash(const svOpenArrayHandle msg, uint64_t len,
                            uint32_t hash[8]) {
   if (len > 0u) {
-    uint8_t *arr = collect_bytes(msg, len);
+    const uint8_t *arr = collect_bytes(msg, len, &msg_buf);
     assert(arr);
 
     // compute SHA hash
     SHA_hash(arr, len, (uint8_t *)hash);
-
-    free(arr);
   }
 }
 
 extern void c_dpi_SHA256_hash(const svOpenArrayHandle msg, uint64_t len,
                               uint32_t hash[8]) {
   if (len > 0u) {
-    uint8_t *arr = collect_bytes(msg, len);
+    const uint8_t *arr = collect_bytes(msg, len, &msg_buf);
     assert(arr);
 
     // compute SHA256 hash
     SHA256_hash(arr, len, (uint8_t *)hash);
-
-    free(arr);
   } else {
     // compute SHA256 hash when msg is empty
     SHA256_hash(NULL, 0u, (uint8_t *)hash);
@@ -87,13 +106,11 @@ extern void c_dpi_SHA256_hash(const svOpenArrayHandle msg, uint64_t len,
 extern void c_dpi_SHA384_hash(const svOpenArrayHandle msg, uint64_t len,
                               uint32_t hash[12]) {
   if (len > 0u) {
-    uint8_t *arr = collect_bytes(msg, len);
+    const uint8_t *arr = collect_bytes(msg, len, &msg_buf);
     assert(arr);
 
     // compute SHA384 hash
     SHA384_hash(arr, len, (uint8_t *)hash);
-
-    free(arr);
   } else {
     // compute SHA384 hash when msg is empty
     SHA384_hash(NULL, 0u, (uint8_t *)hash);
@@ -103,13 +120,11 @@ extern void c_dpi_SHA384_hash(const svOpenArrayHandle msg, uint64_t len,
 extern void c_dpi_SHA512_hash(const svOpenArrayHandle msg, uint64_t len,
                               uint32_t hash[16]) {
   if (len > 0u) {
-    uint8_t *arr = collect_bytes(msg, len);
+    const uint8_t *arr = collect_bytes(msg, len, &msg_buf);
     assert(arr);
 
     // compute SHA512 hash
     SHA512_hash(arr, len, (uint8_t *)hash);
-
-    free(arr);
   } else {
     // compute SHA512 hash when msg is empty
     SHA512_hash(NULL, 0u, (uint8_t *)hash);
@@ -120,81 +135,238 @@ extern void c_dpi_HMAC_SHA(const svOpenArrayHandle key, uint64_t key_len,
                            const svOpenArrayHandle msg, uint64_t msg_len,
                            uint32_t hmac[8]) {
   if (msg_len > 0u) {
-    uint8_t *msg_arr = collect_bytes(msg, msg_len);
+    const uint8_t *msg_arr = collect_bytes(msg, msg_len, &msg_buf);
     assert(msg_arr);
 
-    uint8_t *key_arr = collect_bytes(key, key_len);
+    const uint8_t *key_arr = collect_bytes(key, key_len, &key_buf);
     assert(key_arr);
 
     // compute SHA hash
     HMAC_SHA(key_arr, key_len, msg_arr, msg_len, (uint8_t *)hmac);
-
-    free(msg_arr);
-    free(key_arr);
   }
 }
 
 extern void c_dpi_HMAC_SHA256(const svOpenArrayHandle key, uint64_t key_len,
                               const svOpenArrayHandle msg, uint64_t msg_len,
                               uint32_t hmac[8]) {
-  uint8_t *key_arr = collect_bytes(key, key_len);
+  const uint8_t *key_arr = collect_bytes(key, key_len, &key_buf);
   assert(key_arr);
 
   if (msg_len > 0u) {
-    uint8_t *msg_arr = collect_bytes(msg, msg_len);
+    const uint8_t *msg_arr = collect_bytes(msg, msg_len, &msg_buf);
     assert(msg_arr);
 
     // compute SHA256 hash
     HMAC_SHA256(key_arr, key_len, msg_arr, msg_len, (uint8_t *)hmac);
-
-    free(msg_arr);
   } else {
     // compute SHA256 hash when msg is empty
     HMAC_SHA256(key_arr, key_len, NULL, 0u, (uint8_t *)hmac);
   }
-
-  free(key_arr);
 }
 extern void c_dpi_HMAC_SHA384(const svOpenArrayHandle key, uint64_t key_len,
                               const svOpenArrayHandle msg, uint64_t msg_len,
                               uint32_t hmac[12]) {
-  uint8_t *key_arr = collect_bytes(key, key_len);
+  const uint8_t *key_arr = collect_bytes(key, key_len, &key_buf);
   assert(key_arr);
 
   if (msg_len > 0u) {
-    uint8_t *msg_arr = collect_bytes(msg, msg_len);
+    const uint8_t *msg_arr = collect_bytes(msg, msg_len, &msg_buf);
     assert(msg_arr);
 
     // compute SHA384 hash
     HMAC_SHA384(key_arr, key_len, msg_arr, msg_len, (uint8_t *)hmac);
-
-    free(msg_arr);
   } else {
     // compute SHA384 hash when msg is empty
     HMAC_SHA384(key_arr, key_len, NULL, 0u, (uint8_t *)hmac);
   }
-
-  free(key_arr);
 }
 
 extern void c_dpi_HMAC_SHA512(const svOpenArrayHandle key, uint64_t key_len,
                               const svOpenArrayHandle msg, uint64_t msg_len,
                               uint32_t hmac[16]) {
-  uint8_t *key_arr = collect_bytes(key, key_len);
+  const uint8_t *key_arr = collect_bytes(key, key_len, &key_buf);
   assert(key_arr);
 
   if (msg_len > 0u) {
-    uint8_t *msg_arr = collect_bytes(msg, msg_len);
+    const uint8_t *msg_arr = collect_bytes(msg, msg_len, &msg_buf);
     assert(msg_arr);
 
     // compute SHA512 hash
     HMAC_SHA512(key_arr, key_len, msg_arr, msg_len, (uint8_t *)hmac);
-
-    free(msg_arr);
   } else {
     // compute SHA512 hash when msg is empty
     HMAC_SHA512(key_arr, key_len, NULL, 0u, (uint8_t *)hmac);
   }
+}
+
+// Hash functions supported by the context-based interface below; these must
+// match cryptoc_dpi_pkg::cryptoc_alg_e
+typedef enum cryptoc_dpi_alg {
+  kCryptocDpiSha256 = 0,
+  kCryptocDpiSha384 = 1,
+  kCryptocDpiSha512 = 2,
+} cryptoc_dpi_alg_t;
+
+// Context for hashing a message in parts, with or without HMAC
+typedef struct cryptoc_dpi_ctx {
+  cryptoc_dpi_alg_t alg;
+  int hmac_en;
+  // The hash context is at the start of each of these
+  union {
+    HASH_CTX hash;
+    LITE_HMAC_CTX lite;
+    HMAC_CTX full;
+  } u;
+} cryptoc_dpi_ctx_t;
+
+static unsigned ctx_block_size(const cryptoc_dpi_ctx_t *ctx) {
+  return (ctx->alg == kCryptocDpiSha256) ? 64u : 128u;
+}
+
+extern void *c_dpi_hash_init(unsigned alg, unsigned char hmac_en,
+                             const svOpenArrayHandle key, uint64_t key_len) {
+  if (alg > kCryptocDpiSha512) {
+    fprintf(stderr, "cryptoc_dpi: unsupported hash function %u\n", alg);
+    return NULL;
+  }
+
+  cryptoc_dpi_ctx_t *ctx =
+      (cryptoc_dpi_ctx_t *)calloc(1u, sizeof(cryptoc_dpi_ctx_t));
+  assert(ctx);
+  ctx->alg = (cryptoc_dpi_alg_t)alg;
+  ctx->hmac_en = hmac_en != 0u;
+
+  if (ctx->hmac_en) {
+    const uint8_t *key_arr = NULL;
+    if (key_len > 0u) {
+      key_arr = collect_bytes(key, key_len, &key_buf);
+      assert(key_arr);
+    }
+    switch (ctx->alg) {
+      case kCryptocDpiSha256:
+        HMAC_SHA256_init(&ctx->u.lite, key_arr, key_len);
+        break;
+      case kCryptocDpiSha384:
+        HMAC_SHA384_init(&ctx->u.full, key_arr, key_len);
+        break;
+      default:
+        HMAC_SHA512_init(&ctx->u.full, key_arr, key_len);
+        break;
+    }
+  } else {
+    switch (ctx->alg) {
+      case kCryptocDpiSha256:
+        SHA256_init(&ctx->u.hash);
+        break;
+      case kCryptocDpiSha384:
+        SHA384_init(&ctx->u.hash);
+        break;
+      default:
+        SHA512_init(&ctx->u.hash);
+        break;
+    }
+  }
 
-  free(key_arr);
+  return ctx;
+}
+
+extern void c_dpi_hash_update(void *handle, const svOpenArrayHandle msg,
+                              uint64_t len) {
+  cryptoc_dpi_ctx_t *ctx = (cryptoc_dpi_ctx_t *)handle;
+  assert(ctx);
+  if (len > 0u) {
+    const uint8_t *arr = collect_bytes(msg, len, &msg_buf);
+    assert(arr);
+    HASH_update(&ctx->u.hash, arr, len);
+  }
+}
+
+// The digest of the message so far. This finishes a copy of the context, so
+// the message may be continued afterwards.
+extern void c_dpi_hash_final(void *handle, uint32_t digest[16]) {
+  const cryptoc_dpi_ctx_t *ctx = (const cryptoc_dpi_ctx_t *)handle;
+  assert(ctx);
+
+  cryptoc_dpi_ctx_t tmp = *ctx;
+  const uint8_t *result;
+  if (!tmp.hmac_en) {
+    result = HASH_final(&tmp.u.hash);
+  } else if (tmp.alg == kCryptocDpiSha256) {
+    result = HMAC_final_LITE(&tmp.u.lite);
+  } else {
+    result = HMAC_final(&tmp.u.full);
+  }
+  memcpy(digest, result, HASH_size(&tmp.u.hash));
+}
+
+// Save the context in the form that the HMAC IP exposes it: the hash state as
+// it would be read from DIGEST_0..15 (the most significant half first for the
+// 64-bit words of SHA-384/512) and the message length in bits, which for HMAC
+// does not include the inner key block. As with the IP, this is only possible
+// at a block boundary; otherwise the return value is -1.
+extern int c_dpi_hash_export(void *handle, uint32_t state[16],
+                             uint64_t *msg_len) {
+  const cryptoc_dpi_ctx_t *ctx = (const cryptoc_dpi_ctx_t *)handle;
+  assert(ctx);
+
+  const unsigned block_size = ctx_block_size(ctx);
+  if (ctx->u.hash.count % block_size) {
+    return -1;
+  }
+
+  for (unsigned idx = 0u; idx < 8u; ++idx) {
+    const uint64_t word = ctx->u.hash.state[idx];
+    if (ctx->alg == kCryptocDpiSha256) {
+      state[idx] = (uint32_t)word;
+      state[idx + 8u] = 0u;
+    } else {
+      state[2u * idx] = (uint32_t)(word >> 32);
+      state[2u * idx + 1u] = (uint32_t)word;
+    }
+  }
+
+  uint64_t count = ctx->u.hash.count;
+  if (ctx->hmac_en) {
+    count -= block_size;
+  }
+  *msg_len = count * 8u;
+  return 0;
+}
+
+// Restore a context saved by c_dpi_hash_export (or read from the IP) into a
+// context set up by c_dpi_hash_init with the same hash function and key.
+// Returns -1 if the message length is not a whole number of blocks.
+extern int c_dpi_hash_import(void *handle, const uint32_t state[16],
+                             uint64_t msg_len) {
+  cryptoc_dpi_ctx_t *ctx = (cryptoc_dpi_ctx_t *)handle;
+  assert(ctx);
+
+  const unsigned block_size = ctx_block_size(ctx);
+  if (msg_len % (8u * block_size)) {
+    return -1;
+  }
+
+  for (unsigned idx = 0u; idx < 8u; ++idx) {
+    if (ctx->alg == kCryptocDpiSha256) {
+      ctx->u.hash.state[idx] = state[idx];
+    } else {
+      ctx->u.hash.state[idx] =
+          ((uint64_t)state[2u * idx] << 32) | state[2u * idx + 1u];
+    }
+  }
+
+  ctx->u.hash.count = msg_len / 8u;
+  if (ctx->hmac_en) {
+    ctx->u.hash.count += block_size;
+  }
+  return 0;
+}
+
+extern void c_dpi_hash_free(void *handle) {
+  cryptoc_dpi_ctx_t *ctx = (cryptoc_dpi_ctx_t *)handle;
+  if (ctx) {
+    // The context holds the HMAC key
+    memset(ctx, 0, sizeof(*ctx));
+    free(ctx);
+  }
 }
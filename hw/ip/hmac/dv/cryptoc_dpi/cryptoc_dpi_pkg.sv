@@ -54,6 +54,39 @@ package cryptoc_dpi_pkg;
                                                          input longint unsigned msg_len,
                                                          output int unsigned hmac[16]);
 
+  // Context-based interface, for hashing a message in parts and for saving and restoring the
+  // context in the form that the HMAC IP exposes it (DIGEST_0..15 and MSG_LENGTH in bits, which
+  // for HMAC excludes the inner key block). c_dpi_hash_final may be called at any point, and the
+  // message continued afterwards. c_dpi_hash_export/import return -1 unless the context is at a
+  // block boundary; import requires a context set up with the same hash function and key.
+  typedef enum int unsigned {
+    CryptocSha256 = 0,
+    CryptocSha384 = 1,
+    CryptocSha512 = 2
+  } cryptoc_alg_e;
+
+  import "DPI-C" context function chandle c_dpi_hash_init(input int unsigned alg,
+                                                          input bit hmac_en,
+                                                          input bit[7:0] key[],
+                                                          input longint unsigned key_len);
+
+  import "DPI-C" context function void c_dpi_hash_update(input chandle ctx,
+                                                         input bit[7:0] msg[],
+                                                         input longint unsigned len);
+
+  import "DPI-C" context function void c_dpi_hash_final(input chandle ctx,
+                                                        output int unsigned digest[16]);
+
+  import "DPI-C" context function int c_dpi_hash_export(input chandle ctx,
+                                                        output int unsigned state[16],
+                                                        output longint unsigned msg_len);
+
+  import "DPI-C" context function int c_dpi_hash_import(input chandle ctx,
+                                                        input int unsigned state[16],
+                                                        input longint unsigned msg_len);
+
+  import "DPI-C" context function void c_dpi_hash_free(input chandle ctx);
+
   // sv wrapper functions
   function automatic void sv_dpi_get_sha_digest(input bit[7:0] msg[],
                                                 output int unsigned hash[8]);
@@ -115,4 +148,19 @@ package cryptoc_dpi_pkg;
     c_dpi_HMAC_SHA512(ckey, ckey.size(), msg, msg.size(), hmac);
   endfunction
 
+  function automatic chandle sv_dpi_hash_init(input cryptoc_alg_e alg,
+                                              input bit hmac_en = 1'b0,
+                                              input bit[31:0] key[] = '{});
+    bit [7:0] ckey[];
+    int ckey_size_bytes = $bits(key) / 8;
+    ckey = new[ckey_size_bytes];
+    {>>{ckey}} = key;
+    return c_dpi_hash_init(alg, hmac_en, ckey, ckey.size());
+  endfunction
+
+  function automatic void sv_dpi_hash_update(input chandle ctx,
+                                             input bit[7:0] msg[]);
+    c_dpi_hash_update(ctx, msg, msg.size());
+  endfunction
+
 endpackage
@@ -2,48 +2,99 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <list>
+#include <vector>
 
+#include "dpi_array.h"
 #include "svdpi.h"
 #include "vendor/kerukuro_digestpp/algorithm/kmac.hpp"
 #include "vendor/kerukuro_digestpp/algorithm/sha3.hpp"
 #include "vendor/kerukuro_digestpp/algorithm/shake.hpp"
 
-extern "C" {
-
 //////////////////////
 // HELPER FUNCTIONS //
 //////////////////////
 
+// Scratch buffers for messages, keys and digests, kept from one call to the
+// next so that each call doesn't need a fresh allocation.
+static std::vector<uint8_t> msg_buf, key_buf, digest_buf;
+
 /**
- * Generic function to load an unsized array from SV memory into C memory.
+ * Get the first `len` elements of an unsized array from SV memory.
+ *
+ * Returns a pointer to the array itself if the simulator stores it as
+ * contiguous bytes, and otherwise copies it into `buf`.
  */
-static void load_arr_from_simulator(const svOpenArrayHandle arr,
-                                    uint8_t *array_out, uint64_t array_len) {
-  for (uint64_t i = 0; i < array_len; i++) {
-    svBitVecVal val;
-    svGetBitArrElem1VecVal(&val, arr, i);
-    array_out[i] = (uint8_t)val;
+static const uint8_t *get_arr_from_simulator(const svOpenArrayHandle arr,
+                                             uint64_t len,
+                                             std::vector<uint8_t> &buf) {
+  static const uint8_t empty = 0;
+  if (!len) {
+    return &empty;
   }
+
+  size_t stride = dpi_array_byte_stride(arr, len);
+  if (stride == 1) {
+    return (const uint8_t *)svGetArrayPtr(arr);
+  }
+
+  buf.resize(len);
+  if (stride) {
+    const svBitVecVal *vals = (const svBitVecVal *)svGetArrayPtr(arr);
+    for (uint64_t i = 0; i < len; i++) {
+      buf[i] = (uint8_t)vals[i];
+    }
+  } else {
+    for (uint64_t i = 0; i < len; i++) {
+      svBitVecVal val;
+      svGetBitArrElem1VecVal(&val, arr, i);
+      buf[i] = (uint8_t)val;
+    }
+  }
+  return buf.data();
 }
 
 /**
- * Generic function to write an unsized array from C memory into SV memory.
+ * Write `len` bytes from C memory into an unsized array in SV memory.
+ *
+ * Writes no more than the size of the SV array.
  */
 static void write_array_to_simulator(const svOpenArrayHandle arr,
-                                     uint8_t *data) {
+                                     const uint8_t *data, uint64_t len) {
   uint64_t arr_len = svSize(arr, 1);
+  if (len > arr_len) {
+    len = arr_len;
+  }
 
-  for (uint64_t i = 0; i < arr_len; ++i) {
-    svBitVecVal data_val = (svBitVecVal)data[i];
-    svPutBitArrElem1VecVal(arr, &data_val, i);
+  size_t stride = dpi_array_byte_stride(arr, len);
+  if (stride == 1) {
+    memcpy(svGetArrayPtr(arr), data, len);
+  } else if (stride) {
+    svBitVecVal *vals = (svBitVecVal *)svGetArrayPtr(arr);
+    for (uint64_t i = 0; i < len; ++i) {
+      vals[i] = (svBitVecVal)data[i];
+    }
+  } else {
+    for (uint64_t i = 0; i < len; ++i) {
+      svBitVecVal data_val = (svBitVecVal)data[i];
+      svPutBitArrElem1VecVal(arr, &data_val, i);
+    }
   }
 }
 
+/**
+ * Return a scratch buffer of `len` bytes for a digest.
+ */
+static uint8_t *get_digest_buf(uint64_t len) {
+  // Always have at least one byte, so that data() is never null
+  digest_buf.resize(len ? len : 1);
+  return digest_buf.data();
+}
+
 /**
  * Helper function to calculate generic length SHA3 algorithm.
  *
@@ -55,26 +106,151 @@ static void get_sha3_digest(uint64_t sha_len, const svOpenArrayHandle msg,
                             uint64_t msg_len, svOpenArrayHandle digest) {
   // Number of bytes in result digest
   uint64_t digest_len = sha_len / 8;
+  uint8_t *digest_arr = get_digest_buf(digest_len);
 
-  uint8_t digest_arr[digest_len];
+  // Compute the digest, reading the message straight from SV memory if we can
+  digestpp::sha3 sha3(sha_len);
+  sha3.absorb(get_arr_from_simulator(msg, msg_len, msg_buf), msg_len);
+  sha3.digest(digest_arr, digest_len);
 
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
+  // Return the digest array so that SV can access it
+  write_array_to_simulator(digest, digest_arr, digest_len);
+}
 
-  // Compute the digest
-  digestpp::sha3 sha3(sha_len);
-  sha3.absorb(msg_arr, msg_len);
-  sha3.digest(digest_arr, sizeof(digest_arr));
+/**
+ * Helper function to calculate SHAKE and cSHAKE digests.
+ */
+template <class H>
+static void get_xof_digest(H &shake, const svOpenArrayHandle msg,
+                           uint64_t msg_len, uint64_t output_len,
+                           svOpenArrayHandle digest) {
+  uint8_t *digest_arr = get_digest_buf(output_len);
+
+  shake.absorb(get_arr_from_simulator(msg, msg_len, msg_buf), msg_len);
+  shake.squeeze(digest_arr, output_len);
+
+  write_array_to_simulator(digest, digest_arr, output_len);
+}
+
+/**
+ * Helper function to set up a KMAC computation and absorb its message.
+ *
+ * The caller then gets the output with digest() or, for KMAC-XOF, squeeze().
+ */
+template <class H>
+static void absorb_kmac_msg(H &kmac, const svOpenArrayHandle msg,
+                            uint64_t msg_len, const svOpenArrayHandle key,
+                            uint64_t key_len, const char *customization_str) {
+  kmac.set_customization(customization_str, strlen(customization_str));
+  kmac.set_key(get_arr_from_simulator(key, key_len, key_buf), key_len);
+  kmac.absorb(get_arr_from_simulator(msg, msg_len, msg_buf), msg_len);
+}
+
+/////////////////////
+// INCREMENTAL API //
+/////////////////////
+
+// Algorithms for c_dpi_digestpp_init, which must match digestpp_alg_e in
+// digestpp_dpi_pkg.sv
+enum digestpp_alg_e {
+  kDigestppSha3 = 0,
+  kDigestppShake = 1,
+  kDigestppCShake = 2,
+  kDigestppKmac = 3,
+  kDigestppKmacXof = 4,
+};
 
-  if (msg_arr != nullptr) {
-    free(msg_arr);
+/**
+ * State of an incremental hash computation, which SV refers to by a chandle.
+ */
+class DigestppCtx {
+ public:
+  virtual ~DigestppCtx() {}
+  // Returns false if no more data can be absorbed.
+  virtual bool absorb(const uint8_t *data, size_t len) = 0;
+  virtual void squeeze(uint8_t *out, size_t len) = 0;
+};
+
+/**
+ * Incremental SHAKE, cSHAKE and KMAC-XOF.
+ *
+ * Each squeeze continues the output from where the previous one stopped.
+ */
+template <class H>
+class DigestppXofCtx : public DigestppCtx {
+ public:
+  bool absorb(const uint8_t *data, size_t len) override {
+    // Absorbing after a squeeze would corrupt the sponge state.
+    if (squeezed) {
+      return false;
+    }
+    hasher.absorb(data, len);
+    return true;
+  }
+  void squeeze(uint8_t *out, size_t len) override {
+    squeezed = true;
+    hasher.squeeze(out, len);
   }
 
-  // Return the digest array so that SV can access it
-  write_array_to_simulator(digest, digest_arr);
+  H hasher;
+
+ private:
+  bool squeezed = false;
+};
+
+/**
+ * Incremental SHA3 and fixed length KMAC.
+ *
+ * Each squeeze returns the digest of all of the data absorbed so far, and more
+ * data can be absorbed afterwards.
+ */
+template <class H>
+class DigestppHashCtx : public DigestppCtx {
+ public:
+  explicit DigestppHashCtx(size_t hash_bits)
+      : hasher(hash_bits), hash_len(hash_bits / 8) {}
+
+  bool absorb(const uint8_t *data, size_t len) override {
+    hasher.absorb(data, len);
+    return true;
+  }
+  void squeeze(uint8_t *out, size_t len) override {
+    if (len < hash_len) {
+      // digest() can't return part of the digest
+      std::vector<uint8_t> full(hash_len);
+      hasher.digest(full.data(), hash_len);
+      memcpy(out, full.data(), len);
+    } else {
+      memset(out + hash_len, 0, len - hash_len);
+      hasher.digest(out, hash_len);
+    }
+  }
+
+  H hasher;
+
+ private:
+  size_t hash_len;
+};
+
+template <class H>
+static DigestppCtx *new_cshake_ctx(const char *function_name,
+                                   const char *customization_str) {
+  DigestppXofCtx<H> *ctx = new DigestppXofCtx<H>();
+  ctx->hasher.set_function_name(function_name, strlen(function_name));
+  ctx->hasher.set_customization(customization_str, strlen(customization_str));
+  return ctx;
+}
+
+template <class C>
+static DigestppCtx *init_kmac_ctx(C *ctx, const uint8_t *key, uint64_t key_len,
+                                  const char *customization_str) {
+  ctx->hasher.set_customization(customization_str, strlen(customization_str));
+  ctx->hasher.set_key(key, key_len);
+  return ctx;
 }
 
+extern "C" {
+
 //////////////
 // SHA3-224 //
 //////////////
@@ -112,23 +288,8 @@ extern void c_dpi_sha3_512(const svOpenArrayHandle msg, uint64_t msg_len,
 //////////////
 extern void c_dpi_shake128(const svOpenArrayHandle msg, uint64_t msg_len,
                            uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::shake128 shake;
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(shake, msg, msg_len, output_len, digest);
 }
 
 //////////////
@@ -136,23 +297,8 @@ extern void c_dpi_shake128(const svOpenArrayHandle msg, uint64_t msg_len,
 //////////////
 extern void c_dpi_shake256(const svOpenArrayHandle msg, uint64_t msg_len,
                            uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::shake256 shake;
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(shake, msg, msg_len, output_len, digest);
 }
 
 ///////////////
@@ -162,25 +308,10 @@ extern void c_dpi_cshake128(const svOpenArrayHandle msg,
                             const char *function_name,
                             const char *customization_str, uint64_t msg_len,
                             uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::cshake128 shake;
   shake.set_function_name(function_name, strlen(function_name));
   shake.set_customization(customization_str, strlen(customization_str));
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(shake, msg, msg_len, output_len, digest);
 }
 
 ///////////////
@@ -190,25 +321,10 @@ extern void c_dpi_cshake256(const svOpenArrayHandle msg,
                             const char *function_name,
                             const char *customization_str, uint64_t msg_len,
                             uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::cshake256 shake;
   shake.set_function_name(function_name, strlen(function_name));
   shake.set_customization(customization_str, strlen(customization_str));
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(shake, msg, msg_len, output_len, digest);
 }
 
 /////////////
@@ -217,36 +333,12 @@ extern void c_dpi_cshake256(const svOpenArrayHandle msg,
 extern void c_dpi_kmac128(const svOpenArrayHandle msg, uint64_t msg_len,
                           const svOpenArrayHandle key, uint64_t key_len,
                           const char *customization_str, uint64_t output_len,
-                          svBitVecVal *digest) {
-  uint64_t output_len_bits = output_len * 8;
-
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
-  digestpp::kmac128 kmac(output_len_bits);
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.digest(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+                          svOpenArrayHandle digest) {
+  digestpp::kmac128 kmac(output_len * 8);
+  uint8_t *digest_arr = get_digest_buf(output_len);
+  absorb_kmac_msg(kmac, msg, msg_len, key, key_len, customization_str);
+  kmac.digest(digest_arr, output_len);
+  write_array_to_simulator(digest, digest_arr, output_len);
 }
 
 /////////////////
@@ -255,34 +347,12 @@ extern void c_dpi_kmac128(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac128_xof(const svOpenArrayHandle msg, uint64_t msg_len,
                               const svOpenArrayHandle key, uint64_t key_len,
                               const char *customization_str,
-                              uint64_t output_len, svBitVecVal *digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
+                              uint64_t output_len, svOpenArrayHandle digest) {
   digestpp::kmac128_xof kmac;
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.squeeze(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  uint8_t *digest_arr = get_digest_buf(output_len);
+  absorb_kmac_msg(kmac, msg, msg_len, key, key_len, customization_str);
+  kmac.squeeze(digest_arr, output_len);
+  write_array_to_simulator(digest, digest_arr, output_len);
 }
 
 /////////////
@@ -291,36 +361,12 @@ extern void c_dpi_kmac128_xof(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac256(const svOpenArrayHandle msg, uint64_t msg_len,
                           const svOpenArrayHandle key, uint64_t key_len,
                           const char *customization_str, uint64_t output_len,
-                          svBitVecVal *digest) {
-  uint64_t output_len_bits = output_len * 8;
-
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
-  digestpp::kmac256 kmac(output_len_bits);
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.digest(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+                          svOpenArrayHandle digest) {
+  digestpp::kmac256 kmac(output_len * 8);
+  uint8_t *digest_arr = get_digest_buf(output_len);
+  absorb_kmac_msg(kmac, msg, msg_len, key, key_len, customization_str);
+  kmac.digest(digest_arr, output_len);
+  write_array_to_simulator(digest, digest_arr, output_len);
 }
 
 /////////////////
@@ -329,33 +375,131 @@ extern void c_dpi_kmac256(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac256_xof(const svOpenArrayHandle msg, uint64_t msg_len,
                               const svOpenArrayHandle key, uint64_t key_len,
                               const char *customization_str,
-                              uint64_t output_len, svBitVecVal *digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
+                              uint64_t output_len, svOpenArrayHandle digest) {
+  digestpp::kmac256_xof kmac;
+  uint8_t *digest_arr = get_digest_buf(output_len);
+  absorb_kmac_msg(kmac, msg, msg_len, key, key_len, customization_str);
+  kmac.squeeze(digest_arr, output_len);
+  write_array_to_simulator(digest, digest_arr, output_len);
+}
 
-  uint8_t digest_arr[output_len];
+/////////////////////
+// INCREMENTAL API //
+/////////////////////
 
-  // Compute the digest
-  digestpp::kmac256_xof kmac;
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.squeeze(digest_arr, sizeof(digest_arr));
+/**
+ * Start an incremental hash computation.
+ *
+ * `strength` is the digest length in bits for SHA3 (224, 256, 384 or 512) and
+ * the security strength for the others (128 or 256). `function_name` is used
+ * only by cSHAKE, `customization_str` by cSHAKE and KMAC, and the key only by
+ * KMAC. `output_len` is the length in bytes of the fixed length KMAC digest,
+ * which is part of its input.
+ *
+ * Returns a handle for the other c_dpi_digestpp_* functions, or null if the
+ * algorithm or strength isn't supported. Free it with c_dpi_digestpp_free.
+ */
+extern void *c_dpi_digestpp_init(uint32_t alg, uint32_t strength,
+                                 const char *function_name,
+                                 const char *customization_str,
+                                 const svOpenArrayHandle key, uint64_t key_len,
+                                 uint64_t output_len) {
+  DigestppCtx *ctx = nullptr;
+  const uint8_t *key_arr;
+
+  switch (alg) {
+    case kDigestppSha3:
+      if (strength == 224 || strength == 256 || strength == 384 ||
+          strength == 512) {
+        ctx = new DigestppHashCtx<digestpp::sha3>(strength);
+      }
+      break;
+    case kDigestppShake:
+      if (strength == 128) {
+        ctx = new DigestppXofCtx<digestpp::shake128>();
+      } else if (strength == 256) {
+        ctx = new DigestppXofCtx<digestpp::shake256>();
+      }
+      break;
+    case kDigestppCShake:
+      if (strength == 128) {
+        ctx = new_cshake_ctx<digestpp::cshake128>(function_name,
+                                                  customization_str);
+      } else if (strength == 256) {
+        ctx = new_cshake_ctx<digestpp::cshake256>(function_name,
+                                                  customization_str);
+      }
+      break;
+    case kDigestppKmac:
+      key_arr = get_arr_from_simulator(key, key_len, key_buf);
+      if (strength == 128) {
+        ctx = init_kmac_ctx(
+            new DigestppHashCtx<digestpp::kmac128>(output_len * 8), key_arr,
+            key_len, customization_str);
+      } else if (strength == 256) {
+        ctx = init_kmac_ctx(
+            new DigestppHashCtx<digestpp::kmac256>(output_len * 8), key_arr,
+            key_len, customization_str);
+      }
+      break;
+    case kDigestppKmacXof:
+      key_arr = get_arr_from_simulator(key, key_len, key_buf);
+      if (strength == 128) {
+        ctx = init_kmac_ctx(new DigestppXofCtx<digestpp::kmac128_xof>(),
+                            key_arr, key_len, customization_str);
+      } else if (strength == 256) {
+        ctx = init_kmac_ctx(new DigestppXofCtx<digestpp::kmac256_xof>(),
+                            key_arr, key_len, customization_str);
+      }
+      break;
+    default:
+      break;
+  }
 
-  if (msg_arr != nullptr) {
-    free(msg_arr);
+  if (!ctx) {
+    fprintf(stderr, "digestpp_dpi: Unsupported algorithm %u, strength %u\n",
+            alg, strength);
   }
+  return ctx;
+}
 
-  if (key_arr != nullptr) {
-    free(key_arr);
+/**
+ * Absorb the first `msg_len` bytes of `msg` into an incremental hash.
+ *
+ * Returns 0 on success, or -1 if the hash is an XOF that has already been
+ * squeezed (in which case nothing is absorbed).
+ */
+extern int c_dpi_digestpp_absorb(void *ctx_void, const svOpenArrayHandle msg,
+                                 uint64_t msg_len) {
+  DigestppCtx *ctx = (DigestppCtx *)ctx_void;
+  assert(ctx);
+  if (!ctx->absorb(get_arr_from_simulator(msg, msg_len, msg_buf), msg_len)) {
+    fprintf(stderr, "digestpp_dpi: Cannot absorb into an XOF after squeeze\n");
+    return -1;
   }
+  return 0;
+}
+
+/**
+ * Write `output_len` bytes of output from an incremental hash to `digest`.
+ *
+ * For the XOFs each call continues the output from the previous one, and
+ * c_dpi_digestpp_absorb fails once the first call has been made. For SHA3 and
+ * fixed length KMAC each call returns the digest of the data so far.
+ */
+extern void c_dpi_digestpp_squeeze(void *ctx_void, uint64_t output_len,
+                                   svOpenArrayHandle digest) {
+  DigestppCtx *ctx = (DigestppCtx *)ctx_void;
+  assert(ctx);
+  uint8_t *digest_arr = get_digest_buf(output_len);
+  ctx->squeeze(digest_arr, output_len);
+  write_array_to_simulator(digest, digest_arr, output_len);
+}
 
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+/**
+ * Free the state of an incremental hash.
+ */
+extern void c_dpi_digestpp_free(void *ctx_void) {
+  delete (DigestppCtx *)ctx_void;
 }
 }
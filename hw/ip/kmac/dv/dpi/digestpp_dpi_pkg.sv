@@ -10,6 +10,16 @@ package digestpp_dpi_pkg;
 
   // parameters
 
+  // Algorithms for the incremental interface (c_dpi_digestpp_*), which must match
+  // digestpp_alg_e in digestpp_dpi.cc
+  typedef enum int unsigned {
+    DigestppSha3    = 0,
+    DigestppShake   = 1,
+    DigestppCShake  = 2,
+    DigestppKmac    = 3,
+    DigestppKmacXof = 4
+  } digestpp_alg_e;
+
   // DPI-C imports
   import "DPI-C" context function void c_dpi_sha3_224(
     input bit[7:0]          msg[],
@@ -107,4 +117,39 @@ package digestpp_dpi_pkg;
     output bit[7:0]         digest[]
   );
 
+  // Incremental interface
+  //
+  // c_dpi_digestpp_init returns a handle for a hash computation (or null if the algorithm and
+  // strength aren't supported), which can absorb a message in chunks of any size and then
+  // squeeze as much output as needed, without marshalling the whole message in one go. See
+  // digestpp_dpi.cc for the meaning of each argument. Each handle must be freed with
+  // c_dpi_digestpp_free.
+  import "DPI-C" context function chandle c_dpi_digestpp_init(
+    input int unsigned      alg,
+    input int unsigned      strength,
+    input string            function_name,
+    input string            customization_str,
+    input bit[7:0]          key[],
+    input longint unsigned  key_len,
+    input longint unsigned  output_len
+  );
+
+  // c_dpi_digestpp_absorb returns 0 on success, or -1 if the handle is for an XOF that has
+  // already been squeezed.
+  import "DPI-C" context function int c_dpi_digestpp_absorb(
+    input chandle           ctx,
+    input bit[7:0]          msg[],
+    input longint unsigned  msg_len
+  );
+
+  import "DPI-C" context function void c_dpi_digestpp_squeeze(
+    input chandle           ctx,
+    input longint unsigned  output_len,
+    output bit[7:0]         digest[]
+  );
+
+  import "DPI-C" context function void c_dpi_digestpp_free(
+    input chandle           ctx
+  );
+
 endpackage
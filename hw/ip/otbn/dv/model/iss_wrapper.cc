@@ -17,6 +17,7 @@
 #include <regex>
 #include <signal.h>
 #include <sstream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 
@@ -105,6 +106,77 @@ struct TmpDir {
   }
 };
 
+// Layout of the shared memory region. The first page holds a snapshot of the
+// register file: 32 GPRs as little-endian 32-bit words, followed by 32 WDRs as
+// little-endian 256-bit words. After that is a memory image, where each
+// 32-bit word is stored as 5 bytes: a validity byte (0 or 1), followed by the
+// word itself in little-endian byte order. This is the same format as the
+// files written by load_d / load_i.
+static const size_t kShmGprsOffset = 0;
+static const size_t kShmWdrsOffset = kShmGprsOffset + 32 * 4;
+static const size_t kShmMemOffset = 4096;
+static const size_t kShmMaxMemWords = 1 << 16;
+static const size_t kShmSize = kShmMemOffset + 5 * kShmMaxMemWords;
+
+// Guard class to create, map and release an anonymous shared memory region.
+// The file descriptor is inherited by the ISS process (see the constructor of
+// ISSWrapper), which maps the same region.
+struct ShmRegion {
+  int fd;
+  size_t size;
+  uint8_t *data;
+
+  explicit ShmRegion(size_t size) : fd(ShmRegion::make_fd()), size(size) {
+    if (ftruncate(fd, size) != 0) {
+      std::ostringstream oss;
+      oss << "Cannot resize shared memory region for OTBN simulation: "
+          << strerror(errno);
+      close(fd);
+      throw std::runtime_error(oss.str());
+    }
+
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      std::ostringstream oss;
+      oss << "Cannot map shared memory region for OTBN simulation: "
+          << strerror(errno);
+      close(fd);
+      throw std::runtime_error(oss.str());
+    }
+    data = static_cast<uint8_t *>(ptr);
+  }
+
+  ~ShmRegion() {
+    munmap(data, size);
+    close(fd);
+  }
+
+ private:
+  // Create a file descriptor for an anonymous memory file. On Linux, this uses
+  // memfd_create. MacOS doesn't have that, so use shm_open and then unlink the
+  // name immediately. In both cases, the fd has FD_CLOEXEC set.
+  static int make_fd() {
+#ifndef __MACH__
+    int fd = memfd_create("otbn_iss", MFD_CLOEXEC);
+#else
+    std::ostringstream name;
+    name << "/otbn_iss." << getpid();
+    int fd = shm_open(name.str().c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+      shm_unlink(name.str().c_str());
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (fd < 0) {
+      std::ostringstream oss;
+      oss << "Cannot create shared memory region for OTBN simulation: "
+          << strerror(errno);
+      throw std::runtime_error(oss.str());
+    }
+    return fd;
+  }
+};
+
 // Find the top of the OpenTitan repository
 //
 // If REPO_TOP is defined, use that. Otherwise, this will only work if we're
@@ -210,6 +282,12 @@ static uint32_t read_hex_32(const char *str) {
   return strtoul(buf, nullptr, 16);
 }
 
+// Read a little-endian 32-bit word from buf.
+static uint32_t read_le_32(const uint8_t *buf) {
+  return (uint32_t)buf[0] | (uint32_t)buf[1] << 8 | (uint32_t)buf[2] << 16 |
+         (uint32_t)buf[3] << 24;
+}
+
 // Read through trace output (in the lines argument) to pick up any write to
 // the named CSR register, updating *dest.
 static void read_ext_reg(const std::string &reg_name,
@@ -266,9 +344,35 @@ void MirroredRegs::reset() {
   wipe_start = false;
 }
 
-ISSWrapper::ISSWrapper() : tmpdir(new TmpDir()) {
+// Return the number of cycles that the ISS may run ahead, from the
+// OTBN_MODEL_RUN_AHEAD environment variable. If it isn't set, return 1 (so we
+// step in lockstep).
+static uint32_t get_run_ahead_from_env() {
+  const char *run_ahead_str = getenv("OTBN_MODEL_RUN_AHEAD");
+  if (!run_ahead_str)
+    return 1;
+
+  char *end;
+  unsigned long run_ahead = strtoul(run_ahead_str, &end, 0);
+  if (*end || run_ahead == 0 || run_ahead > UINT32_MAX) {
+    std::ostringstream oss;
+    oss << "Invalid value for OTBN_MODEL_RUN_AHEAD (`" << run_ahead_str
+        << "'): expected a positive integer.";
+    throw std::runtime_error(oss.str());
+  }
+  return run_ahead;
+}
+
+ISSWrapper::ISSWrapper()
+    : shm(new ShmRegion(kShmSize)), run_ahead_(get_run_ahead_from_env()) {
   std::string model_path(find_otbn_model());
 
+  // The ISS maps the shared memory region through an fd that it inherits from
+  // us. Tell it which fd that is (and how big the region is) on its command
+  // line.
+  std::string shm_fd_arg = "--shm-fd=" + std::to_string(shm->fd);
+  std::string shm_size_arg = "--shm-size=" + std::to_string(shm->size);
+
   // We want two pipes: one for writing to the child process, and the other for
   // reading from it. We set the O_CLOEXEC flag so that the child process will
   // drop all the fds when it execs.
@@ -314,9 +418,12 @@ ISSWrapper::ISSWrapper() : tmpdir(new TmpDir()) {
                 << "\n";
       abort();
     }
+    // Clear FD_CLOEXEC on the shared memory fd so that the ISS inherits it.
+    fcntl(shm->fd, F_SETFD, 0);
+
     // Finally, exec the ISS
     execl("/usr/bin/env", "/usr/bin/env", "python3", "-u", model_path.c_str(),
-          NULL);
+          shm_fd_arg.c_str(), shm_size_arg.c_str(), NULL);
   }
 
   // We are the parent process and pid is the PID of the child. Close the pipe
@@ -363,6 +470,14 @@ void ISSWrapper::load_i(const std::string &path) {
   run_command(oss.str(), nullptr);
 }
 
+void ISSWrapper::load_d(const std::vector<mem_word_t> &words) {
+  load_words_shm("load_d_shm", words);
+}
+
+void ISSWrapper::load_i(const std::vector<mem_word_t> &words) {
+  load_words_shm("load_i_shm", words);
+}
+
 void ISSWrapper::add_loop_warp(uint32_t addr, uint32_t from_cnt,
                                uint32_t to_cnt) {
   std::ostringstream oss;
@@ -381,6 +496,42 @@ void ISSWrapper::dump_d(const std::string &path) const {
   run_command(oss.str(), nullptr);
 }
 
+std::vector<ISSWrapper::mem_word_t> ISSWrapper::dump_d(
+    size_t num_words) const {
+  if (num_words > kShmMaxMemWords) {
+    std::ostringstream oss;
+    oss << "Cannot dump " << num_words
+        << " words of DMEM through shared memory (the maximum is "
+        << kShmMaxMemWords << ").";
+    throw std::runtime_error(oss.str());
+  }
+
+  std::ostringstream oss;
+  oss << "dump_d_shm " << num_words << "\n";
+  run_command(oss.str(), nullptr);
+
+  std::vector<mem_word_t> ret;
+  ret.reserve(num_words);
+
+  const uint8_t *src = shm->data + kShmMemOffset;
+  for (size_t i = 0; i < num_words; ++i, src += 5) {
+    if (src[0] > 1) {
+      std::ostringstream oss;
+      oss << "Word " << i << " of DMEM from the ISS had a validity byte with "
+          << "value " << (int)src[0] << "; not 0 or 1.";
+      throw std::runtime_error(oss.str());
+    }
+
+    uint32_t word = 0;
+    for (int j = 0; j < 4; ++j) {
+      word |= (uint32_t)src[j + 1] << 8 * j;
+    }
+    ret.push_back(std::make_pair(src[0] == 1, word));
+  }
+
+  return ret;
+}
+
 void ISSWrapper::start_operation(command_t command) {
   std::ostringstream cmd_stream;
 
@@ -453,7 +604,15 @@ void ISSWrapper::set_keymgr_value(const std::array<uint32_t, 12> &key0_arr,
 int ISSWrapper::step(bool gen_trace) {
   std::vector<std::string> lines;
 
-  run_command("step\n", &lines);
+  if (run_ahead_ > 1) {
+    if (pending_cycles_.empty())
+      fetch_batch();
+    assert(!pending_cycles_.empty());
+    lines.swap(pending_cycles_.front());
+    pending_cycles_.pop_front();
+  } else {
+    run_command("step\n", &lines);
+  }
   if (gen_trace && lines.size()) {
     if (!OtbnTraceChecker::get().OnIssTrace(lines)) {
       return -1;
@@ -523,6 +682,10 @@ void ISSWrapper::reset(bool gen_trace) {
   if (gen_trace)
     OtbnTraceChecker::get().Flush();
 
+  // The ISS gets replaced with a fresh simulation, so any cycles that it ran
+  // ahead are irrelevant.
+  pending_cycles_.clear();
+
   run_command("reset\n", nullptr);
 
   // Reset all mirrored registers.
@@ -546,80 +709,20 @@ void ISSWrapper::get_regs(std::array<uint32_t, 32> *gprs,
                           std::array<u256_t, 32> *wdrs) {
   assert(gprs && wdrs);
 
-  std::vector<std::string> lines;
-  run_command("print_regs\n", &lines);
-
-  // A record of which registers we've seen (to check we see each
-  // register exactly once). GPR i sets bit i. WDR i sets bit 32 + i.
-  uint64_t seen_mask = 0;
-
-  // Lines look like
-  //
-  //  x3  = 0x12345678
-  //  w10 = 0x0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef
-
-  std::regex re("\\s*([wx][0-9]{1,2})\\s*=\\s*0x([0-9a-f]+)");
-  std::smatch match;
-
-  for (const std::string &line : lines) {
-    if (line == "PRINT_REGS")
-      continue;
+  run_command("dump_regs_shm\n", nullptr);
 
-    if (!std::regex_match(line, match, re)) {
-      std::ostringstream oss;
-      oss << "Invalid line in ISS print_register output (`" << line << "').";
-      throw std::runtime_error(oss.str());
-    }
-
-    assert(match.size() == 3);
-
-    std::string reg_name = match[1].str();
-    std::string str_value = match[2].str();
-
-    assert(reg_name.size() <= 3);
-    assert(reg_name[0] == 'w' || reg_name[0] == 'x');
-    bool is_wide = reg_name[0] == 'w';
-    int reg_idx = atoi(reg_name.c_str() + 1);
-
-    assert(reg_idx >= 0);
-    if (reg_idx >= 32) {
-      std::ostringstream oss;
-      oss << "Invalid register name in ISS output (`" << reg_name
-          << "'). Line was `" << line << "'.";
-      throw std::runtime_error(oss.str());
-    }
-
-    unsigned idx_seen = reg_idx + (is_wide ? 32 : 0);
-    if ((seen_mask >> idx_seen) & 1) {
-      std::ostringstream oss;
-      oss << "Duplicate lines writing register " << reg_name << ".";
-      throw std::runtime_error(oss.str());
-    }
-
-    unsigned num_u32s = is_wide ? 8 : 1;
-    unsigned expected_value_len = 8 * num_u32s;
-    if (str_value.size() != expected_value_len) {
-      std::ostringstream oss;
-      oss << "Value for register " << reg_name << " has " << str_value.size()
-          << " hex characters, but we expected " << expected_value_len << ".";
-      throw std::runtime_error(oss.str());
-    }
-
-    uint32_t *dst = is_wide ? &(*wdrs)[reg_idx].words[7] : &(*gprs)[reg_idx];
-    for (unsigned i = 0; i < num_u32s; ++i) {
-      *dst = read_hex_32(&str_value[8 * i]);
-      --dst;
-    }
-
-    seen_mask |= ((uint64_t)1 << idx_seen);
+  // Registers are stored as little-endian words, starting with the least
+  // significant 32 bits of each WDR.
+  const uint8_t *src = shm->data + kShmGprsOffset;
+  for (int i = 0; i < 32; ++i, src += 4) {
+    (*gprs)[i] = read_le_32(src);
   }
 
-  // Check that we've seen all the registers
-  if (~seen_mask) {
-    std::ostringstream oss;
-    oss << "Some registers were missing from print_register output. Mask: 0x"
-        << std::hex << seen_mask << ".";
-    throw std::runtime_error(oss.str());
+  src = shm->data + kShmWdrsOffset;
+  for (int i = 0; i < 32; ++i) {
+    for (int j = 0; j < 8; ++j, src += 4) {
+      (*wdrs)[i].words[j] = read_le_32(src);
+    }
   }
 }
 
@@ -661,6 +764,8 @@ std::vector<uint32_t> ISSWrapper::get_call_stack() {
 }
 
 std::string ISSWrapper::make_tmp_path(const std::string &relative) const {
+  if (!tmpdir)
+    tmpdir.reset(new TmpDir());
   return tmpdir->path + "/" + relative;
 }
 
@@ -718,6 +823,15 @@ void ISSWrapper::run_command(const std::string &cmd,
   assert(cmd.size() > 0);
   assert(cmd.back() == '\n');
 
+  if (!pending_cycles_.empty()) {
+    std::ostringstream oss;
+    std::string cmd_line = cmd.substr(0, cmd.size() - 1);
+    oss << "Cannot run command '" << cmd_line << "': the ISS has run "
+        << pending_cycles_.size()
+        << " cycles ahead. Unset OTBN_MODEL_RUN_AHEAD for this test.";
+    throw std::runtime_error(oss.str());
+  }
+
   fputs(cmd.c_str(), child_write_file);
   fflush(child_write_file);
   if (!read_child_response(dst)) {
@@ -727,3 +841,51 @@ void ISSWrapper::run_command(const std::string &cmd,
     throw std::runtime_error(oss.str());
   }
 }
+
+void ISSWrapper::fetch_batch() {
+  std::vector<std::string> lines;
+
+  std::ostringstream oss;
+  oss << "step_batch " << run_ahead_ << "\n";
+  run_command(oss.str(), &lines);
+
+  // The output for each cycle is terminated by a line containing just "-".
+  std::vector<std::string> cycle_lines;
+  for (std::string &line : lines) {
+    if (line == "-") {
+      pending_cycles_.emplace_back();
+      pending_cycles_.back().swap(cycle_lines);
+    } else {
+      cycle_lines.push_back(std::move(line));
+    }
+  }
+
+  if (!cycle_lines.empty() || pending_cycles_.empty()) {
+    throw std::runtime_error(
+        "Malformed response from ISS for step_batch command.");
+  }
+}
+
+void ISSWrapper::load_words_shm(const char *verb,
+                                const std::vector<mem_word_t> &words) {
+  if (words.size() > kShmMaxMemWords) {
+    std::ostringstream oss;
+    oss << "Cannot load " << words.size()
+        << " words through shared memory (the maximum is " << kShmMaxMemWords
+        << ").";
+    throw std::runtime_error(oss.str());
+  }
+
+  uint8_t *dst = shm->data + kShmMemOffset;
+  for (const mem_word_t &word : words) {
+    dst[0] = word.first ? 1 : 0;
+    for (int j = 0; j < 4; ++j) {
+      dst[j + 1] = (word.second >> (8 * j)) & 0xff;
+    }
+    dst += 5;
+  }
+
+  std::ostringstream oss;
+  oss << verb << " " << words.size() << "\n";
+  run_command(oss.str(), nullptr);
+}
@@ -7,13 +7,16 @@
 #include <array>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
-// Forward declaration (the implementation is private in iss_wrapper.cc)
+// Forward declarations (the implementations are private in iss_wrapper.cc)
 struct TmpDir;
+struct ShmRegion;
 
 // OTBN has some externally visible CSRs that can be updated by hardware
 // (without explicit writes from software). The ISSWrapper mirrors the ISS's
@@ -52,15 +55,24 @@ struct ISSWrapper {
     uint32_t words[256 / 32];
   };
 
+  // A 32-bit memory word, together with a flag that says whether its
+  // integrity bits are valid.
+  typedef std::pair<bool, uint32_t> mem_word_t;
+
   enum command_t { Execute, DmemWipe, ImemWipe };
 
   ISSWrapper();
   ~ISSWrapper();
 
-  // Load new contents of DMEM / IMEM
+  // Load new contents of DMEM / IMEM from a file
   void load_d(const std::string &path);
   void load_i(const std::string &path);
 
+  // Load new contents of DMEM / IMEM. The words are passed to the ISS through
+  // shared memory, so this doesn't touch the filesystem.
+  void load_d(const std::vector<mem_word_t> &words);
+  void load_i(const std::vector<mem_word_t> &words);
+
   // Add a loop warp instruction to the simulation
   void add_loop_warp(uint32_t addr, uint32_t from_cnt, uint32_t to_cnt);
 
@@ -70,6 +82,9 @@ struct ISSWrapper {
   // Dump the contents of DMEM to a file
   void dump_d(const std::string &path) const;
 
+  // Read the first num_words words of DMEM through shared memory
+  std::vector<mem_word_t> dump_d(size_t num_words) const;
+
   // Start an operation (execute, dmem wipe or imem wipe)
   void start_operation(command_t command);
 
@@ -99,6 +114,20 @@ struct ISSWrapper {
   // Signals 256b EDN random number for URND seed is valid in the RTL.
   void edn_urnd_cdc_done();
 
+  // Set the maximum number of cycles that the ISS may run ahead of the
+  // caller. If this is more than 1, step() asks the ISS for a batch of up to
+  // max_cycles cycles at a time and hands them out one per call. The ISS ends
+  // a batch early on any externally visible event (a change to STATUS,
+  // ERR_BITS, STOP_PC, RND_REQ or WIPE_START) and whenever the next cycle
+  // might depend on an input from the caller, so the trace and mirrored
+  // registers seen by the caller are the same as when stepping one cycle at a
+  // time.
+  //
+  // Sending any other command while cycles from a batch are still buffered
+  // raises a runtime_error, because the ISS has already run past the point
+  // where the command should have taken effect.
+  void set_run_ahead(uint32_t max_cycles) { run_ahead_ = max_cycles; }
+
   // Run simulation for a single cycle.
   //
   // If gen_trace is true, pass trace data to the (singleton) OtbnTraceChecker
@@ -143,7 +172,7 @@ struct ISSWrapper {
 
   const MirroredRegs &get_mirrored() const { return mirrored_; }
 
-  // Read contents of the register file
+  // Read contents of the register file (through shared memory)
   void get_regs(std::array<uint32_t, 32> *gprs, std::array<u256_t, 32> *wdrs);
 
   // Read the contents of the call stack
@@ -164,15 +193,35 @@ struct ISSWrapper {
   // response, raise a runtime_error.
   void run_command(const std::string &cmd, std::vector<std::string> *dst) const;
 
+  // Ask the ISS to run a batch of cycles and append the trace lines for each
+  // cycle to pending_cycles_.
+  void fetch_batch();
+
+  // Copy words into the shared memory region and then run a command that
+  // tells the ISS to load them.
+  void load_words_shm(const char *verb, const std::vector<mem_word_t> &words);
+
   pid_t child_pid;
   FILE *child_write_file;
   FILE *child_read_file;
 
-  // A temporary directory for communicating with the child process
-  std::unique_ptr<TmpDir> tmpdir;
+  // A temporary directory for communicating with the child process. This is
+  // only created the first time that make_tmp_path is called.
+  mutable std::unique_ptr<TmpDir> tmpdir;
+
+  // A shared memory region, mapped by both us and the child process, that is
+  // used to pass memory images and register snapshots.
+  std::unique_ptr<ShmRegion> shm;
 
   // Mirrored copies of registers
   MirroredRegs mirrored_;
+
+  // The maximum number of cycles to run ahead (see set_run_ahead)
+  uint32_t run_ahead_;
+
+  // Trace lines for cycles that the ISS has run but that haven't yet been
+  // consumed by step(). The front entry is the next cycle.
+  std::deque<std::vector<std::string>> pending_cycles_;
 };
 
 #endif  // OPENTITAN_HW_IP_OTBN_DV_MODEL_ISS_WRAPPER_H_
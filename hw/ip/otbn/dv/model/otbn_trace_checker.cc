@@ -40,7 +40,8 @@ OtbnTraceChecker &OtbnTraceChecker::get() {
   return *trace_checker;
 }
 
-void OtbnTraceChecker::AcceptTraceString(const std::string &trace,
+void OtbnTraceChecker::AcceptTraceRecord(const OtbnTraceRecord &record,
+                                         const std::string *err_desc,
                                          unsigned int cycle_count) {
   assert(!(rtl_pending_ && iss_pending_));
 
@@ -48,11 +49,14 @@ void OtbnTraceChecker::AcceptTraceString(const std::string &trace,
     return;
 
   done_ = false;
-  OtbnTraceEntry trace_entry;
-  if (!trace_entry.from_rtl_trace(trace)) {
+  if (err_desc) {
+    std::cerr << "OTBN trace from RTL is not valid: " << *err_desc << "\n";
     seen_err_ = true;
     return;
   }
+
+  OtbnTraceEntry trace_entry;
+  trace_entry.from_rtl_trace(record);
   if (trace_entry.trace_type() == OtbnTraceEntry::Invalid) {
     std::cerr << "ERROR: Invalid RTL trace entry with invalid header:\n";
     trace_entry.print("  ", std::cerr);
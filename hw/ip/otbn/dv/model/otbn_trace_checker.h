@@ -50,9 +50,13 @@ class OtbnTraceChecker : public OtbnTraceListener {
   // Get the singleton object
   static OtbnTraceChecker &get();
 
+  // The checker works on parsed trace records from the wrapped RTL
+  bool WantsTraceRecords() const override { return true; }
+
   // Take a trace entry from the wrapped RTL. Any mismatch error is stored
   // until the next call to an API function that can respond with the error.
-  void AcceptTraceString(const std::string &trace,
+  void AcceptTraceRecord(const OtbnTraceRecord &record,
+                         const std::string *err_desc,
                          unsigned int cycle_count) override;
 
   // Take a trace entry from the wrapped ISS.
@@ -4,88 +4,24 @@
 
 #include "otbn_trace_entry.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
-#include <regex>
+#include <iterator>
 #include <sstream>
 
-bool OtbnTraceBodyLine::fill_from_string(const std::string &src,
-                                         const std::string &line) {
-  // A valid line matches the following regex
-  std::regex re("(.) ([^:]+): (.+)");
-  std::smatch match;
-
-  if (!std::regex_match(line, match, re)) {
-    std::cerr << "OTBN trace body line from " << src
-              << " does not have expected format. Saw: `" << line << "'.\n";
-    return false;
-  }
-
-  assert(match.size() == 4);
-
-  raw_ = line;
-  type_ = match[1].str()[0];
-  loc_ = match[2].str();
-  value_ = match[3].str();
-  return true;
-}
-
-bool OtbnTraceBodyLine::operator==(const OtbnTraceBodyLine &other) const {
-  // If the raw lines are identical, the two objects are identical and no
-  // further checks are required.
-  if (raw_ == other.raw_) {
-    return true;
-  }
-
-  // If the raw lines are not identical, the two objects can be identical if one
-  // of them contains unknown values.
-
-  // Type and location have to be identical, though.
-  if (type_ != other.type_ || loc_ != other.loc_) {
-    return false;
-  }
-
-  // The values have to be of identical length.
-  if (value_.size() != other.value_.size()) {
-    return false;
-  }
-
-  // Compare values digit by digit and treat `x` as unknown value, which is
-  // identical to any other value.
-  std::string::const_iterator other_it = other.value_.begin();
-  for (std::string::const_iterator it = value_.begin(); it != value_.end();
-       it++) {
-    if (*it != *other_it && !(*it == 'x' || *other_it == 'x')) {
-      return false;
-    }
-    other_it++;
-  }
-  return true;
-}
-
-bool OtbnTraceEntry::from_rtl_trace(const std::string &trace) {
-  size_t eol = trace.find('\n');
-  hdr_ = trace.substr(0, eol);
+void OtbnTraceEntry::from_rtl_trace(const OtbnTraceRecord &record) {
+  hdr_ = record.hdr;
   trace_type_ = hdr_to_trace_type(hdr_);
 
-  while (eol != std::string::npos) {
-    size_t bol = eol + 1;
-    eol = trace.find('\n', bol);
-    size_t line_len =
-        (eol == std::string::npos) ? std::string::npos : eol - bol;
-    std::string line = trace.substr(bol, line_len);
-
-    // We're only interested in register writes
-    if (!(line.size() > 0 && line[0] == '>'))
-      continue;
-
-    OtbnTraceBodyLine parsed_line;
-    if (!parsed_line.fill_from_string("RTL", line)) {
-      return false;
-    }
-    writes_[parsed_line.get_loc()].push_back(parsed_line);
+  // We're only interested in register writes
+  writes_.clear();
+  for (const OtbnTraceBodyItem &item : record.body) {
+    if (item.is_reg_write())
+      writes_.push_back(item);
   }
-  return true;
+  sort_writes();
 }
 
 bool OtbnTraceEntry::compare_rtl_iss_entries(const OtbnTraceEntry &other,
@@ -98,26 +34,49 @@ bool OtbnTraceEntry::compare_rtl_iss_entries(const OtbnTraceEntry &other,
     return false;
   }
 
-  for (const auto &rtlptr : writes_) {
-    auto isskey = other.writes_.find(rtlptr.first);
-    if (isskey == other.writes_.end()) {
+  // Both lists of writes are sorted by location, so we can walk through them
+  // together, a location at a time.
+  size_t rtl_locs = 0, iss_locs = 0;
+  write_iter_t iss_it = other.writes_.begin();
+  for (write_iter_t rtl_it = writes_.begin(); rtl_it != writes_.end();) {
+    write_iter_t rtl_run_end = loc_run_end(rtl_it, writes_.end());
+    ++rtl_locs;
+
+    // Skip over any ISS locations that come before this one.
+    while (iss_it != other.writes_.end() && iss_it->loc < rtl_it->loc) {
+      iss_it = loc_run_end(iss_it, other.writes_.end());
+      ++iss_locs;
+    }
+
+    if (iss_it == other.writes_.end() || iss_it->loc != rtl_it->loc) {
       std::ostringstream oss;
-      oss << "RTL had a write to `" << rtlptr.first
+      oss << "RTL had a write to `" << OtbnTraceLocs::Name(rtl_it->loc)
           << "', but the ISS doesn't have a write to that location.";
       *err_desc = oss.str();
       return false;
     }
-    // compare rtlptr.second and isskey.second
-    if (!check_entries_compatible(trace_type_, rtlptr.first, rtlptr.second,
-                                  isskey->second, no_sec_wipe_data_chk,
+
+    write_iter_t iss_run_end = loc_run_end(iss_it, other.writes_.end());
+    ++iss_locs;
+
+    if (!check_entries_compatible(trace_type_, rtl_it, rtl_run_end, iss_it,
+                                  iss_run_end, no_sec_wipe_data_chk,
                                   err_desc))
       return false;
+
+    rtl_it = rtl_run_end;
+    iss_it = iss_run_end;
   }
 
-  if (writes_.size() != other.writes_.size()) {
+  while (iss_it != other.writes_.end()) {
+    iss_it = loc_run_end(iss_it, other.writes_.end());
+    ++iss_locs;
+  }
+
+  if (rtl_locs != iss_locs) {
     std::ostringstream oss;
-    oss << "RTL wrote to " << writes_.size() << " locations; the ISS wrote to "
-        << other.writes_.size() << ".";
+    oss << "RTL wrote to " << rtl_locs << " locations; the ISS wrote to "
+        << iss_locs << ".";
     *err_desc = oss.str();
     return false;
   }
@@ -127,30 +86,30 @@ bool OtbnTraceEntry::compare_rtl_iss_entries(const OtbnTraceEntry &other,
 
 void OtbnTraceEntry::print(const std::string &indent, std::ostream &os) const {
   os << indent << hdr_ << "\n";
-  for (const auto &pr : writes_) {
-    for (const auto &line : pr.second) {
-      os << indent << line.get_string() << "\n";
-    }
+  for (const auto &item : writes_) {
+    os << indent << item.ToString() << "\n";
   }
 }
 
 void OtbnTraceEntry::take_writes(const OtbnTraceEntry &other,
                                  bool other_first) {
-  for (const auto &pr : other.writes_) {
-    std::vector<OtbnTraceBodyLine> &so_far = writes_[pr.first];
-    if (other_first) {
-      // If other_first is true, we should prepend the writes from other. We do
-      // so by creating a temporary vector (with a copy of the writes from
-      // other) and then appending any writes we had before.
-      std::vector<OtbnTraceBodyLine> tmp(pr.second);
-      tmp.insert(tmp.end(), so_far.begin(), so_far.end());
-      writes_[pr.first] = tmp;
-    } else {
-      // If other_first is false, we should append the writes from other. We
-      // can do that with just a call to insert.
-      so_far.insert(so_far.end(), pr.second.begin(), pr.second.end());
-    }
+  // Both lists of writes are sorted by location. Merge them, putting the
+  // writes from other before or after ours for each location (std::merge
+  // takes equal elements from its first range first).
+  auto loc_lt = [](const OtbnTraceBodyItem &a, const OtbnTraceBodyItem &b) {
+    return a.loc < b.loc;
+  };
+
+  std::vector<OtbnTraceBodyItem> merged;
+  merged.reserve(writes_.size() + other.writes_.size());
+  if (other_first) {
+    std::merge(other.writes_.begin(), other.writes_.end(), writes_.begin(),
+               writes_.end(), std::back_inserter(merged), loc_lt);
+  } else {
+    std::merge(writes_.begin(), writes_.end(), other.writes_.begin(),
+               other.writes_.end(), std::back_inserter(merged), loc_lt);
   }
+  writes_.swap(merged);
 }
 
 bool OtbnTraceEntry::is_compatible(const OtbnTraceEntry &prev) const {
@@ -222,22 +181,24 @@ bool OtbnTraceEntry::is_final() const {
 }
 
 bool OtbnTraceEntry::check_entries_compatible(
-    trace_type_t type, const std::string &key,
-    const std::vector<OtbnTraceBodyLine> &rtl_lines,
-    const std::vector<OtbnTraceBodyLine> &iss_lines, bool no_sec_wipe_data_chk,
+    trace_type_t type, write_iter_t rtl_begin, write_iter_t rtl_end,
+    write_iter_t iss_begin, write_iter_t iss_end, bool no_sec_wipe_data_chk,
     std::string *err_desc) {
-  assert(rtl_lines.size() && iss_lines.size());
+  assert(rtl_begin != rtl_end && iss_begin != iss_end);
   assert(type == WipeComplete || type == Exec);
   assert(err_desc);
 
+  const std::string &key = OtbnTraceLocs::Name(rtl_begin->loc);
+  size_t num_rtl_lines = rtl_end - rtl_begin;
+
   if (type == WipeComplete && key != "FLAGS0" && key != "FLAGS1") {
     // As a quick check: make sure that there are at least 2 lines for
     // the key. We will also check that they are different, but
     // debugging is probably easier if the error message comments that
     // there aren't two lines *to* be different.
-    if (rtl_lines.size() < 2) {
+    if (num_rtl_lines < 2) {
       std::ostringstream oss;
-      oss << "There are " << rtl_lines.size() << " RTL lines for key `" << key
+      oss << "There are " << num_rtl_lines << " RTL lines for key `" << key
           << "'; we expected at least 2.";
       *err_desc = oss.str();
       return false;
@@ -247,8 +208,8 @@ bool OtbnTraceEntry::check_entries_compatible(
     // different values. This checks that we don't (e.g.) just write
     // zero to the key many times.
     bool seen_change = false;
-    for (size_t i = 1; i < rtl_lines.size(); i++) {
-      if (!(rtl_lines[i] == rtl_lines[0])) {
+    for (write_iter_t it = rtl_begin + 1; it != rtl_end; ++it) {
+      if (!(*it == *rtl_begin)) {
         seen_change = true;
         break;
       }
@@ -262,7 +223,7 @@ bool OtbnTraceEntry::check_entries_compatible(
     }
   }
 
-  if (!(rtl_lines.back() == iss_lines.back())) {
+  if (!(*(rtl_end - 1) == *(iss_end - 1))) {
     std::ostringstream oss;
     oss << "Final values of ISS and RTL don't match for key `" << key << "'.";
     *err_desc = oss.str();
@@ -272,6 +233,23 @@ bool OtbnTraceEntry::check_entries_compatible(
   return true;
 }
 
+OtbnTraceEntry::write_iter_t OtbnTraceEntry::loc_run_end(write_iter_t begin,
+                                                         write_iter_t end) {
+  assert(begin != end);
+  write_iter_t it = begin + 1;
+  while (it != end && it->loc == begin->loc)
+    ++it;
+  return it;
+}
+
+void OtbnTraceEntry::sort_writes() {
+  std::stable_sort(
+      writes_.begin(), writes_.end(),
+      [](const OtbnTraceBodyItem &a, const OtbnTraceBodyItem &b) {
+        return a.loc < b.loc;
+      });
+}
+
 OtbnTraceEntry::trace_type_t OtbnTraceEntry::hdr_to_trace_type(
     const std::string &hdr) {
   if (hdr.empty()) {
@@ -299,8 +277,7 @@ bool OtbnIssTraceEntry::from_iss_trace(const std::vector<std::string> &lines) {
   // lines); state 2 = read writes
   int state = 0;
 
-  std::regex re("# @0x([0-9a-f]{8}): (.*)");
-  std::smatch match;
+  writes_.clear();
 
   for (const std::string &line : lines) {
     switch (state) {
@@ -310,7 +287,7 @@ bool OtbnIssTraceEntry::from_iss_trace(const std::vector<std::string> &lines) {
         state = (!line.empty() && line[0] == 'E') ? 1 : 2;
         break;
 
-      case 1:
+      case 1: {
         // This some "special" extra data from the ISS that we use for
         // functional coverage calculations. The line should be of the form
         //
@@ -318,17 +295,27 @@ bool OtbnIssTraceEntry::from_iss_trace(const std::vector<std::string> &lines) {
         //
         // where ADDR is an 8-digit instruction address (in hex) and mnemonic
         // is the string mnemonic.
-        if (!std::regex_match(line, match, re)) {
+        static const char prefix[] = "# @0x";
+        const size_t prefix_len = sizeof(prefix) - 1;
+        const size_t addr_end = prefix_len + 8;
+        bool good = line.size() >= addr_end + 2 &&
+                    line.compare(0, prefix_len, prefix) == 0 &&
+                    line.compare(addr_end, 2, ": ") == 0;
+        for (size_t i = prefix_len; good && i < addr_end; ++i) {
+          char c = line[i];
+          good = ('0' <= c && c <= '9') || ('a' <= c && c <= 'f');
+        }
+        if (!good) {
           std::cerr << "Bad 'special' line for ISS trace with header `" << hdr_
                     << "': `" << line << "'.\n";
           return false;
         }
-        assert(match.size() == 3);
-        data_.insn_addr =
-            (uint32_t)strtoul(match[1].str().c_str(), nullptr, 16);
-        data_.mnemonic = match[2].str();
+        data_.insn_addr = (uint32_t)strtoul(
+            line.substr(prefix_len, 8).c_str(), nullptr, 16);
+        data_.mnemonic = line.substr(addr_end + 2);
         state = 2;
         break;
+      }
 
       default: {
         assert(state == 2);
@@ -336,11 +323,13 @@ bool OtbnIssTraceEntry::from_iss_trace(const std::vector<std::string> &lines) {
         // external register changes, not tracked by the RTL core simulation)
         bool is_bang = (line.size() > 0 && line[0] == '!');
         if (!is_bang) {
-          OtbnTraceBodyLine parsed_line;
-          if (!parsed_line.fill_from_string("ISS", line)) {
+          std::string err_desc;
+          writes_.emplace_back();
+          if (!writes_.back().Parse(line.data(), line.size(), &err_desc)) {
+            std::cerr << "OTBN trace body line from ISS is not valid: "
+                      << err_desc << "\n";
             return false;
           }
-          writes_[parsed_line.get_loc()].push_back(parsed_line);
         }
         break;
       }
@@ -355,5 +344,6 @@ bool OtbnIssTraceEntry::from_iss_trace(const std::vector<std::string> &lines) {
     return false;
   }
 
+  sort_writes();
   return true;
 }
@@ -5,39 +5,11 @@
 #define OPENTITAN_HW_IP_OTBN_DV_MODEL_OTBN_TRACE_ENTRY_H_
 
 #include <cstdint>
-#include <map>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
-// This models a body line in an OTBN trace entry (type '<', '>', 'R' or 'W').
-// Each of these lines is of the format
-//
-//   TYPE ' ' LOC ': ' VALUE
-//
-// and we parse them accordingly here. The point is that we want to merge
-// successive writes to the same location and thus need to unpack things enough
-// to see them.
-class OtbnTraceBodyLine {
- public:
-  // Parse a line into this object, based on the format above. On success,
-  // return true. On failure, write an error message to stderr (using src to
-  // say where the line came from) and return false.
-  bool fill_from_string(const std::string &src, const std::string &line);
-
-  bool operator==(const OtbnTraceBodyLine &other) const;
-
-  // Return the location that is being read or written
-  const std::string &get_loc() const { return loc_; }
-
-  // Return the original string format for the entry
-  const std::string &get_string() const { return raw_; }
-
- private:
-  std::string raw_;
-  char type_;
-  std::string loc_;
-  std::string value_;
-};
+#include "otbn_trace_record.h"
 
 class OtbnTraceEntry {
  public:
@@ -52,9 +24,9 @@ class OtbnTraceEntry {
 
   virtual ~OtbnTraceEntry(){};
 
-  // Parse a trace entry from the RTL into this object. On an error, print a
-  // message to stderr and return false.
-  bool from_rtl_trace(const std::string &trace);
+  // Fill this object from a trace record from the RTL. Only register writes
+  // are kept.
+  void from_rtl_trace(const OtbnTraceRecord &record);
 
   bool compare_rtl_iss_entries(const OtbnTraceEntry &other,
                                bool no_sec_wipe_data_chk,
@@ -77,18 +49,30 @@ class OtbnTraceEntry {
   bool is_final() const;
 
  protected:
+  typedef std::vector<OtbnTraceBodyItem>::const_iterator write_iter_t;
+
+  // Check the writes to a single location. The RTL writes are in the range
+  // [rtl_begin, rtl_end) and the ISS writes in [iss_begin, iss_end). Both
+  // ranges are non-empty.
   static bool check_entries_compatible(
-      trace_type_t type, const std::string &key,
-      const std::vector<OtbnTraceBodyLine> &rtl_lines,
-      const std::vector<OtbnTraceBodyLine> &iss_lines,
-      bool no_sec_wipe_data_chk, std::string *err_desc);
+      trace_type_t type, write_iter_t rtl_begin, write_iter_t rtl_end,
+      write_iter_t iss_begin, write_iter_t iss_end, bool no_sec_wipe_data_chk,
+      std::string *err_desc);
+
+  // Return the end of the run of writes to the same location that starts at
+  // begin.
+  static write_iter_t loc_run_end(write_iter_t begin, write_iter_t end);
+
+  // Sort writes_ by location, keeping the order of writes to each location.
+  void sort_writes();
 
   static trace_type_t hdr_to_trace_type(const std::string &hdr);
 
   trace_type_t trace_type_;
   std::string hdr_;
-  // The register writes for this trace entry, keyed by destination
-  std::map<std::string, std::vector<OtbnTraceBodyLine>> writes_;
+  // The register writes for this trace entry, sorted by location. Writes to
+  // the same location are in the order that they happened.
+  std::vector<OtbnTraceBodyItem> writes_;
 };
 
 class OtbnIssTraceEntry : public OtbnTraceEntry {
@@ -17,6 +17,14 @@ prefixed with "0x" if they are hexadecimal.
     step                    Run one instruction. Print trace information to
                             stdout.
 
+    step_batch <n>          Run up to <n> cycles. Print trace information for
+                            each cycle to stdout, followed by a line with a
+                            single '-'. Stop early after a cycle that changes
+                            an external register other than INSN_CNT, or if
+                            the next cycle might depend on an external input
+                            (because we aren't executing, or are waiting for
+                            EDN data).
+
     load_elf <path>         Load the ELF file at <path>, replacing current
                             contents of DMEM and IMEM.
 
@@ -37,8 +45,22 @@ prefixed with "0x" if they are hexadecimal.
     dump_d <path>           Write the current contents of DMEM to <path> (same
                             format as for load).
 
+    load_d_shm <n>          Replace the current contents of DMEM with the
+                            first <n> words of the memory image in the shared
+                            memory region.
+
+    load_i_shm <n>          Replace the current contents of IMEM with the
+                            first <n> words of the memory image in the shared
+                            memory region.
+
+    dump_d_shm <n>          Write the first <n> words of DMEM to the memory
+                            image in the shared memory region.
+
     print_regs              Write the hex contents of all registers to stdout
 
+    dump_regs_shm           Write the contents of all registers to the
+                            register snapshot in the shared memory region.
+
     edn_rnd_step            Send 32b RND Data to the model.
 
     edn_rnd_cdc_done        Finish the RND data write process by signalling RTL
@@ -70,15 +92,55 @@ prefixed with "0x" if they are hexadecimal.
     send_err_escalation     React to an injected error.
 
     set_software_errs_fatal Set software_errs_fatal bit.
+
+The *_shm commands use a shared memory region, which is passed as an inherited
+file descriptor with the --shm-fd and --shm-size arguments. The region starts
+with a register snapshot (32 GPRs as little-endian 32-bit words, followed by 32
+WDRs as little-endian 256-bit words). At offset SHM_MEM_OFFSET, there is a
+memory image in the same 5-byte per word format used by load_d and dump_d.
+This layout must match the one in hw/ip/otbn/dv/model/iss_wrapper.cc.
 '''
 
+import argparse
 import binascii
+import mmap
+import struct
 import sys
 from typing import List, Optional
 
-from sim.decode import decode_file
+from sim.decode import decode_bytes, decode_file
 from sim.load_elf import load_elf
 from sim.sim import OTBNSim
+from sim.state import FsmState
+
+
+SHM_GPRS_OFFSET = 0
+SHM_WDRS_OFFSET = SHM_GPRS_OFFSET + 32 * 4
+SHM_MEM_OFFSET = 4096
+
+# The line that ends the trace output for each cycle in step_batch
+BATCH_CYCLE_END = '-'
+
+# The shared memory region, if we were given one on the command line
+_SHM = None  # type: Optional[mmap.mmap]
+
+
+def get_shm(cmd: str) -> mmap.mmap:
+    '''Return the shared memory region, or raise an error if there is none'''
+    if _SHM is None:
+        raise RuntimeError(f'Cannot run {cmd}: no shared memory region.')
+    return _SHM
+
+
+def read_shm_mem(cmd: str, arg: str) -> bytes:
+    '''Read the memory image from shared memory for a *_shm command'''
+    shm = get_shm(cmd)
+    num_words = read_word('num_words', arg, 32)
+    end = SHM_MEM_OFFSET + 5 * num_words
+    if end > len(shm):
+        raise ValueError(f'Cannot read {num_words} words from shared memory '
+                         f'with size {len(shm)}.')
+    return shm[SHM_MEM_OFFSET:end]
 
 
 def read_word(arg_name: str, word_data: str, bits: int) -> int:
@@ -132,10 +194,8 @@ def on_start_operation(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     return None
 
 
-def on_step(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
-    '''Step one instruction'''
-    check_arg_count('step', 0, args)
-
+def step_once(sim: OTBNSim) -> List[str]:
+    '''Step one cycle, returning the lines of trace output for the cycle'''
     pc = sim.state.pc
     assert 0 == pc & 3
 
@@ -174,10 +234,67 @@ def on_step(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     if hdr is None and rtl_changes:
         hdr = 'STALL'
 
-    if hdr is not None:
-        print(hdr)
-        for rt in rtl_changes:
-            print(rt)
+    if hdr is None:
+        return []
+
+    return [hdr] + rtl_changes
+
+
+def on_step(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Step one instruction'''
+    check_arg_count('step', 0, args)
+
+    for line in step_once(sim):
+        print(line)
+
+    return None
+
+
+def can_run_ahead(sim: OTBNSim) -> bool:
+    '''Return true if the next cycle can't depend on any external input
+
+    This is true when we are executing, URND has been seeded and there is no
+    outstanding RND request. Inputs like error escalations can still arrive at
+    any time: the caller is responsible for not sending them while cycles from
+    a batch are unconsumed.
+
+    '''
+    state = sim.state
+    return (state.get_fsm_state() == FsmState.EXEC and
+            state.wsrs.URND.running and
+            not state.pending_halt and
+            state.ext_regs.read('RND_REQ', True) == 0)
+
+
+def is_ext_event(line: str) -> bool:
+    '''Return true if a trace line shows an externally visible event
+
+    This is an update to any external register apart from INSN_CNT (which
+    changes on almost every cycle and doesn't need anything from the caller).
+
+    '''
+    return (line.startswith('! otbn.') and
+            not line.startswith('! otbn.INSN_CNT:'))
+
+
+def on_step_batch(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Step up to the given number of cycles, stopping early on events'''
+    check_arg_count('step_batch', 1, args)
+
+    max_cycles = read_word('max_cycles', args[0], 32)
+    if max_cycles == 0:
+        raise ValueError('step_batch needs a positive number of cycles.')
+
+    for _ in range(max_cycles):
+        lines = step_once(sim)
+        for line in lines:
+            print(line)
+        print(BATCH_CYCLE_END)
+
+        if any(is_ext_event(line) for line in lines):
+            break
+        if not can_run_ahead(sim):
+            break
 
     return None
 
@@ -266,6 +383,48 @@ def on_dump_d(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     return None
 
 
+def on_load_d_shm(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Load contents of data memory from the shared memory region'''
+    check_arg_count('load_d_shm', 1, args)
+
+    print('LOAD_D_SHM')
+    sim.load_data(read_shm_mem('load_d_shm', args[0]), has_validity=True)
+
+    return None
+
+
+def on_load_i_shm(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Load contents of insn memory from the shared memory region'''
+    check_arg_count('load_i_shm', 1, args)
+
+    print('LOAD_I_SHM')
+    sim.load_program(decode_bytes(0, read_shm_mem('load_i_shm', args[0]),
+                                  'shared memory'))
+
+    return None
+
+
+def on_dump_d_shm(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Dump contents of data memory to the shared memory region'''
+    check_arg_count('dump_d_shm', 1, args)
+
+    shm = get_shm('dump_d_shm')
+    num_words = read_word('num_words', args[0], 32)
+
+    print('DUMP_D_SHM')
+    data = sim.state.dmem.dump_le_words()
+    if len(data) != 5 * num_words:
+        raise ValueError(f'Cannot dump {num_words} words of DMEM: DMEM '
+                         f'has {len(data) // 5} words.')
+    if SHM_MEM_OFFSET + len(data) > len(shm):
+        raise ValueError(f'Cannot dump {num_words} words to shared memory '
+                         f'with size {len(shm)}.')
+
+    shm[SHM_MEM_OFFSET:SHM_MEM_OFFSET + len(data)] = data
+
+    return None
+
+
 def on_print_regs(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     '''Print registers to stdout'''
     check_arg_count('print_regs', 0, args)
@@ -279,6 +438,23 @@ def on_print_regs(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     return None
 
 
+def on_dump_regs_shm(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
+    '''Write registers to the shared memory region'''
+    check_arg_count('dump_regs_shm', 0, args)
+
+    shm = get_shm('dump_regs_shm')
+
+    gprs = sim.state.gprs.peek_unsigned_values()
+    wdrs = sim.state.wdrs.peek_unsigned_values()
+    assert len(gprs) == 32 and len(wdrs) == 32
+
+    shm[SHM_GPRS_OFFSET:SHM_GPRS_OFFSET + 32 * 4] = struct.pack('<32I', *gprs)
+    shm[SHM_WDRS_OFFSET:SHM_WDRS_OFFSET + 32 * 32] = \
+        b''.join(value.to_bytes(32, 'little') for value in wdrs)
+
+    return None
+
+
 def on_print_call_stack(sim: OTBNSim, args: List[str]) -> Optional[OTBNSim]:
     '''Print call stack to stdout. First element is the bottom of the stack'''
     check_arg_count('print_call_stack', 0, args)
@@ -407,13 +583,18 @@ _HANDLERS = {
     'start_operation': on_start_operation,
     'otp_key_cdc_done': on_otp_cdc_done,
     'step': on_step,
+    'step_batch': on_step_batch,
     'load_elf': on_load_elf,
     'add_loop_warp': on_add_loop_warp,
     'clear_loop_warps': on_clear_loop_warps,
     'load_d': on_load_d,
     'load_i': on_load_i,
     'dump_d': on_dump_d,
+    'load_d_shm': on_load_d_shm,
+    'load_i_shm': on_load_i_shm,
+    'dump_d_shm': on_dump_d_shm,
     'print_regs': on_print_regs,
+    'dump_regs_shm': on_dump_regs_shm,
     'print_call_stack': on_print_call_stack,
     'reset': on_reset,
     'edn_rnd_step': on_edn_rnd_step,
@@ -453,6 +634,21 @@ def on_input(sim: OTBNSim, line: str) -> Optional[OTBNSim]:
 
 
 def main() -> int:
+    global _SHM
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--shm-fd', type=int,
+                        help='An inherited file descriptor for a shared '
+                             'memory region used by the *_shm commands')
+    parser.add_argument('--shm-size', type=int,
+                        help='The size of the shared memory region')
+    args = parser.parse_args()
+
+    if (args.shm_fd is None) != (args.shm_size is None):
+        parser.error('--shm-fd and --shm-size must be given together.')
+    if args.shm_fd is not None:
+        _SHM = mmap.mmap(args.shm_fd, args.shm_size)
+
     sim = OTBNSim()
     try:
         for line in sys.stdin:
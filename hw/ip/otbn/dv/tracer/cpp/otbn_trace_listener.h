@@ -9,6 +9,8 @@
 #include <string>
 #include <vector>
 
+#include "otbn_trace_record.h"
+
 /**
  * Base class for anything that wants to examine trace output from OTBN. The
  * simulation that hosts the tracer is responsible for setting up listeners and
@@ -41,8 +43,28 @@ class OtbnTraceListener {
    * @param trace Trace output from OTBN
    * @param cycle_count The cycle count associated with the trace output
    */
-  virtual void AcceptTraceString(const std::string &trace,
-                                 unsigned int cycle_count) = 0;
+  virtual void AcceptTraceString(const std::string & /*trace*/,
+                                 unsigned int /*cycle_count*/) {}
+
+  /**
+   * True if this listener wants parsed trace records (passed to
+   * AcceptTraceRecord) as well as trace strings. The trace source only parses
+   * the trace if some listener asks for records.
+   */
+  virtual bool WantsTraceRecords() const { return false; }
+
+  /**
+   * Called to process a parsed OTBN trace output, called a maximum of once
+   * per cycle (and only if WantsTraceRecords() is true)
+   *
+   * @param record Parsed trace output from OTBN
+   * @param err_desc If not null, the trace couldn't be parsed and this
+   *                 describes why. In this case, record is incomplete.
+   * @param cycle_count The cycle count associated with the trace output
+   */
+  virtual void AcceptTraceRecord(const OtbnTraceRecord & /*record*/,
+                                 const std::string * /*err_desc*/,
+                                 unsigned int /*cycle_count*/) {}
   virtual ~OtbnTraceListener() {}
 };
 
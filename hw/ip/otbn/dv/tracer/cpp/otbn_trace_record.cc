@@ -0,0 +1,268 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "otbn_trace_record.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+struct LocTable {
+  std::unordered_map<std::string, uint16_t> ids;
+  std::vector<std::string> names;
+};
+
+LocTable &get_loc_table() {
+  static LocTable table;
+  return table;
+}
+
+// Return the value of a hex digit, or -1 if c isn't one
+int hex_digit_value(char c) {
+  if ('0' <= c && c <= '9')
+    return c - '0';
+  if ('a' <= c && c <= 'f')
+    return c - 'a' + 10;
+  if ('A' <= c && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Parse a hex value of the form 0x0123_4567 (where digits may also be 'x'),
+// from str[0] to str[len - 1]. Returns false if the value has some other form
+// or is too wide.
+bool parse_hex_value(const char *str, size_t len, OtbnTraceBodyItem *item) {
+  if (len < 3 || str[0] != '0' || str[1] != 'x')
+    return false;
+
+  memset(item->value, 0, sizeof(item->value));
+  memset(item->x_mask, 0, sizeof(item->x_mask));
+
+  unsigned num_digits = 0;
+  for (size_t i = len; i > 2; --i) {
+    char c = str[i - 1];
+    if (c == '_')
+      continue;
+
+    if (num_digits == 64)
+      return false;
+
+    unsigned word = num_digits / 8;
+    unsigned shift = 4 * (num_digits % 8);
+    if (c == 'x') {
+      item->x_mask[word] |= 0xfu << shift;
+    } else {
+      int digit = hex_digit_value(c);
+      if (digit < 0)
+        return false;
+      item->value[word] |= (uint32_t)digit << shift;
+    }
+    ++num_digits;
+  }
+
+  if (num_digits == 0)
+    return false;
+
+  item->kind = OtbnTraceBodyItem::Hex;
+  item->num_digits = num_digits;
+  return true;
+}
+
+// Parse a flags value of the form "{C: 1, M: 0, L: 1, Z: 0}"
+bool parse_flags_value(const char *str, size_t len, OtbnTraceBodyItem *item) {
+  static const char kTemplate[] = "{C: ?, M: ?, L: ?, Z: ?}";
+  if (len != sizeof(kTemplate) - 1)
+    return false;
+
+  uint32_t flags = 0;
+  unsigned flag_idx = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (kTemplate[i] == '?') {
+      if (str[i] != '0' && str[i] != '1')
+        return false;
+      flags |= (uint32_t)(str[i] - '0') << flag_idx++;
+    } else if (str[i] != kTemplate[i]) {
+      return false;
+    }
+  }
+
+  memset(item->value, 0, sizeof(item->value));
+  memset(item->x_mask, 0, sizeof(item->x_mask));
+  item->value[0] = flags;
+  item->kind = OtbnTraceBodyItem::Flags;
+  item->num_digits = 0;
+  return true;
+}
+
+// Parse a memory location of the form "[0x00000020]"
+bool parse_mem_loc(const char *str, size_t len, uint32_t *addr) {
+  if (len != 12 || str[0] != '[' || str[1] != '0' || str[2] != 'x' ||
+      str[11] != ']')
+    return false;
+
+  uint32_t ret = 0;
+  for (size_t i = 3; i < 11; ++i) {
+    int digit = hex_digit_value(str[i]);
+    if (digit < 0)
+      return false;
+    ret = (ret << 4) | digit;
+  }
+  *addr = ret;
+  return true;
+}
+}  // namespace
+
+uint16_t OtbnTraceLocs::Intern(const std::string &name) {
+  LocTable &table = get_loc_table();
+
+  auto it = table.ids.find(name);
+  if (it != table.ids.end())
+    return it->second;
+
+  assert(table.names.size() < kMemLoc);
+  uint16_t id = table.names.size();
+  table.names.push_back(name);
+  table.ids.emplace(name, id);
+  return id;
+}
+
+const std::string &OtbnTraceLocs::Name(uint16_t id) {
+  const LocTable &table = get_loc_table();
+  assert(id < table.names.size());
+  return table.names[id];
+}
+
+bool OtbnTraceBodyItem::Parse(const char *line, size_t len,
+                              std::string *err_desc) {
+  assert(err_desc);
+
+  // A valid line is TYPE ' ' LOC ': ' VALUE, where LOC contains no colon and
+  // VALUE is not empty.
+  const char *colon =
+      len > 2 ? static_cast<const char *>(memchr(line + 2, ':', len - 2))
+              : nullptr;
+  if (len < 2 || line[1] != ' ' || !colon || colon == line + 2 ||
+      colon + 2 >= line + len || colon[1] != ' ') {
+    *err_desc = "Body line does not have expected format. Saw: `" +
+                std::string(line, len) + "'.";
+    return false;
+  }
+
+  type = line[0];
+
+  const char *loc_str = line + 2;
+  size_t loc_len = colon - loc_str;
+  if (type == 'R' || type == 'W') {
+    loc = OtbnTraceLocs::kMemLoc;
+    if (!parse_mem_loc(loc_str, loc_len, &addr)) {
+      *err_desc = "Bad memory address in body line. Saw: `" +
+                  std::string(line, len) + "'.";
+      return false;
+    }
+  } else {
+    loc = OtbnTraceLocs::Intern(std::string(loc_str, loc_len));
+    addr = 0;
+  }
+
+  const char *val_str = colon + 2;
+  size_t val_len = (line + len) - val_str;
+  text.clear();
+  if (!parse_hex_value(val_str, val_len, this) &&
+      !parse_flags_value(val_str, val_len, this)) {
+    kind = Text;
+    num_digits = 0;
+    memset(value, 0, sizeof(value));
+    memset(x_mask, 0, sizeof(x_mask));
+    text.assign(val_str, val_len);
+  }
+
+  return true;
+}
+
+std::string OtbnTraceBodyItem::ToString() const {
+  std::ostringstream oss;
+  oss << type << ' ';
+  if (loc == OtbnTraceLocs::kMemLoc) {
+    char buf[13];
+    snprintf(buf, sizeof buf, "[0x%08x]", addr);
+    oss << buf;
+  } else {
+    oss << OtbnTraceLocs::Name(loc);
+  }
+  oss << ": ";
+
+  switch (kind) {
+    case Hex:
+      oss << "0x";
+      for (unsigned i = num_digits; i > 0; --i) {
+        unsigned idx = i - 1;
+        unsigned word = idx / 8;
+        unsigned shift = 4 * (idx % 8);
+        if ((x_mask[word] >> shift) & 0xf) {
+          oss << 'x';
+        } else {
+          oss << "0123456789abcdef"[(value[word] >> shift) & 0xf];
+        }
+        // Separate 32-bit words with underscores
+        if (idx && idx % 8 == 0)
+          oss << '_';
+      }
+      break;
+
+    case Flags:
+      oss << "{C: " << (value[0] & 1) << ", M: " << ((value[0] >> 1) & 1)
+          << ", L: " << ((value[0] >> 2) & 1) << ", Z: " << ((value[0] >> 3) & 1)
+          << "}";
+      break;
+
+    default:
+      oss << text;
+  }
+
+  return oss.str();
+}
+
+bool OtbnTraceBodyItem::operator==(const OtbnTraceBodyItem &other) const {
+  if (type != other.type || loc != other.loc || addr != other.addr ||
+      kind != other.kind || num_digits != other.num_digits) {
+    return false;
+  }
+
+  if (kind == Text)
+    return text == other.text;
+
+  for (int i = 0; i < 8; ++i) {
+    uint32_t known = ~(x_mask[i] | other.x_mask[i]);
+    if ((value[i] ^ other.value[i]) & known)
+      return false;
+  }
+  return true;
+}
+
+bool OtbnTraceRecord::Parse(const std::string &trace, std::string *err_desc) {
+  size_t eol = trace.find('\n');
+  hdr.assign(trace, 0, eol);
+  body.clear();
+
+  while (eol != std::string::npos) {
+    size_t bol = eol + 1;
+    eol = trace.find('\n', bol);
+    size_t line_len =
+        (eol == std::string::npos) ? trace.size() - bol : eol - bol;
+    if (line_len == 0)
+      continue;
+
+    char type = trace[bol];
+    if (type != '<' && type != '>' && type != 'R' && type != 'W')
+      continue;
+
+    body.emplace_back();
+    if (!body.back().Parse(trace.data() + bol, line_len, err_desc))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,98 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_RECORD_H_
+#define OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_RECORD_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Interned names for the locations that appear in OTBN trace body lines (such
+ * as "x03", "w12", "FLAGS0" or "MOD").
+ *
+ * Each distinct name gets a small integer ID the first time it is seen, so
+ * trace entries can store and compare locations without holding strings.
+ */
+class OtbnTraceLocs {
+ public:
+  /** The location ID used for memory accesses ('R' and 'W' lines) */
+  static const uint16_t kMemLoc = 0xffff;
+
+  /** Return the ID for a location name, allocating one if necessary */
+  static uint16_t Intern(const std::string &name);
+
+  /** Return the name for an ID that was returned by Intern() */
+  static const std::string &Name(uint16_t id);
+};
+
+/**
+ * A single body line of an OTBN trace record (type '<', '>', 'R' or 'W').
+ *
+ * Each of these lines is of the format
+ *
+ *   TYPE ' ' LOC ': ' VALUE
+ *
+ * Register locations are interned with OtbnTraceLocs. Memory locations look
+ * like "[0x00000020]" and are stored as an address.
+ *
+ * Values are stored as up to 256 bits, least significant word first. A hex
+ * value may contain 'x' digits, which mark nibbles whose value is unknown;
+ * these are tracked in x_mask and match anything. Flags values ("{C: 1, M: 0,
+ * L: 1, Z: 0}") are stored with C, M, L and Z in bits 0 to 3. Anything else
+ * is kept as text and compared exactly.
+ */
+struct OtbnTraceBodyItem {
+  enum value_kind_t { Hex, Flags, Text };
+
+  char type;
+  uint16_t loc;
+  uint32_t addr;
+
+  value_kind_t kind;
+  // For Hex values, the number of hex digits in the value
+  uint8_t num_digits;
+  uint32_t value[8];
+  uint32_t x_mask[8];
+  std::string text;
+
+  /**
+   * Parse a body line. On failure, return false and write a description of
+   * the problem to *err_desc.
+   */
+  bool Parse(const char *line, size_t len, std::string *err_desc);
+
+  /** True if this is a write to a register ('>') */
+  bool is_reg_write() const { return type == '>'; }
+
+  /** Render the item in the textual trace format */
+  std::string ToString() const;
+
+  /**
+   * Equality, treating unknown digits in either value as a match for
+   * anything.
+   */
+  bool operator==(const OtbnTraceBodyItem &other) const;
+};
+
+/**
+ * A parsed OTBN trace record: the header line, followed by the body lines.
+ *
+ * OtbnTraceSource parses the trace string from the simulation into one of
+ * these once per cycle and passes it to listeners that ask for records.
+ */
+struct OtbnTraceRecord {
+  std::string hdr;
+  std::vector<OtbnTraceBodyItem> body;
+
+  /**
+   * Parse a trace string into this record, replacing its contents. Lines that
+   * aren't body lines after the first are ignored. On failure, return false
+   * and write a description of the problem to *err_desc.
+   */
+  bool Parse(const std::string &trace, std::string *err_desc);
+};
+
+#endif  // OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_RECORD_H_
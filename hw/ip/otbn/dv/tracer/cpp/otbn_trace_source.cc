@@ -19,18 +19,33 @@ OtbnTraceSource &OtbnTraceSource::get() {
 
 void OtbnTraceSource::AddListener(OtbnTraceListener *listener) {
   listeners_.push_back(listener);
+  if (listener->WantsTraceRecords())
+    ++record_listeners_;
 }
 
 void OtbnTraceSource::RemoveListener(const OtbnTraceListener *listener) {
   auto it = std::find(listeners_.begin(), listeners_.end(), listener);
   assert(it != listeners_.end());
+  if (listener->WantsTraceRecords()) {
+    assert(record_listeners_ > 0);
+    --record_listeners_;
+  }
   listeners_.erase(it);
 }
 
 void OtbnTraceSource::Broadcast(const std::string &trace,
                                 unsigned cycle_count) {
+  const std::string *err_desc = nullptr;
+  if (record_listeners_) {
+    record_err_.clear();
+    if (!record_.Parse(trace, &record_err_))
+      err_desc = &record_err_;
+  }
+
   for (OtbnTraceListener *listener : listeners_) {
     listener->AcceptTraceString(trace, cycle_count);
+    if (listener->WantsTraceRecords())
+      listener->AcceptTraceRecord(record_, err_desc, cycle_count);
   }
 }
 
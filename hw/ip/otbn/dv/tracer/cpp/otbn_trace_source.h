@@ -4,9 +4,11 @@
 #ifndef OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_SOURCE_H_
 #define OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_SOURCE_H_
 
+#include <string>
 #include <vector>
 
 #include "otbn_trace_listener.h"
+#include "otbn_trace_record.h"
 
 // A source for simulation trace data.
 //
@@ -15,7 +17,8 @@
 //
 // The object is in charge of taking trace data from the simulation (which is
 // sent by calling the accept_otbn_trace_string DPI function) and passing it
-// out to registered listeners.
+// out to registered listeners. If any listener wants parsed trace records, the
+// trace is parsed once here and the same record goes to each of them.
 
 class OtbnTraceSource {
  public:
@@ -33,6 +36,14 @@ class OtbnTraceSource {
 
  private:
   std::vector<OtbnTraceListener *> listeners_;
+
+  // The number of listeners in listeners_ that want parsed records
+  unsigned record_listeners_ = 0;
+
+  // The most recently parsed record. This is kept between calls to Broadcast
+  // so that its storage can be reused.
+  OtbnTraceRecord record_;
+  std::string record_err_;
 };
 
 #endif  // OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_OTBN_TRACE_SOURCE_H_
@@ -90,6 +90,12 @@ class OtbnTraceUtil : public SimCtrlExtension {
     return true;
   }
 
+  // Trace entries are pushed to the listener by the design, so there is
+  // nothing to do on the clock
+  virtual unsigned long NextWakeupCycle(unsigned long cycle) {
+    return kNoWakeup;
+  }
+
   ~OtbnTraceUtil() {
     if (log_trace_listener_)
       OtbnTraceSource::get().RemoveListener(log_trace_listener_.get());
@@ -318,6 +318,18 @@ std::vector<uint8_t> scramble_addr(const std::vector<uint8_t> &addr_in,
                                  kNumAddrSubstPermRounds);
 }
 
+std::vector<uint8_t> scramble_keystream(const std::vector<uint8_t> &addr,
+                                        uint32_t addr_width,
+                                        const std::vector<uint8_t> &nonce,
+                                        const std::vector<uint8_t> &key,
+                                        uint32_t keystream_width,
+                                        bool repeat_keystream) {
+  assert(addr.size() == ((addr_width + 7) / 8));
+
+  return scramble_gen_keystream(addr, addr_width, nonce, key, keystream_width,
+                                kNumPrinceHalfRounds, repeat_keystream);
+}
+
 std::vector<uint8_t> scramble_encrypt_data(
     const std::vector<uint8_t> &data_in, uint32_t data_width,
     uint32_t subst_perm_width, const std::vector<uint8_t> &addr,
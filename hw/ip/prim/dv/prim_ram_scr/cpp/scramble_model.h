@@ -28,6 +28,31 @@ std::vector<uint8_t> scramble_addr(const std::vector<uint8_t> &addr_in,
                                    const std::vector<uint8_t> &nonce,
                                    uint32_t nonce_width);
 
+/** Generate the keystream that is XORed with data at a given address
+ *
+ * When the S&P layer is disabled, scramble_encrypt_data() and
+ * scramble_decrypt_data() just XOR their input with this keystream. Callers
+ * that scramble many words with the same key and nonce can compute the
+ * keystream once per address and reuse it.
+ *
+ * @param addr             Byte vector of data address
+ * @param addr_width       Width of the address in bits
+ * @param nonce            Byte vector of scrambling nonce
+ * @param key              Byte vector of scrambling key
+ * @param keystream_width  Width of the keystream in bits (the data width)
+ * @param repeat_keystream Repeat the keystream of one single PRINCE instance if
+ *                         set to true. Otherwise multiple PRINCE instances are
+ *                         used.
+ * @return Byte vector with the keystream. Unused bits at the top of the last
+ *         byte are zero.
+ */
+std::vector<uint8_t> scramble_keystream(const std::vector<uint8_t> &addr,
+                                        uint32_t addr_width,
+                                        const std::vector<uint8_t> &nonce,
+                                        const std::vector<uint8_t> &key,
+                                        uint32_t keystream_width,
+                                        bool repeat_keystream);
+
 /** Decrypt scrambled data
  * @param data_in          Byte vector of data to decrypt
  * @param data_width       Width of data in bits
@@ -0,0 +1,187 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Differential tests that check the fixed-width scrambling model in
+// scramble_model_u64.h against the byte vector reference model in
+// scramble_model.h.
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scramble_model.h"
+#include "scramble_model_u64.h"
+
+namespace scramble_model_test {
+namespace {
+
+class ScrambleModelTest : public testing::Test {
+ protected:
+  std::vector<uint8_t> RandomBytes(size_t len) {
+    std::vector<uint8_t> ret(len);
+    for (uint8_t &byte : ret) {
+      byte = rng_() & 0xff;
+    }
+    return ret;
+  }
+
+  uint64_t RandomBits(uint32_t width) {
+    uint64_t ret = ((uint64_t)rng_() << 32) | rng_();
+    return width == 64 ? ret : ret & (((uint64_t)1 << width) - 1);
+  }
+
+  static std::vector<uint8_t> ToBytes(uint64_t value, uint32_t width) {
+    std::vector<uint8_t> ret((width + 7) / 8);
+    for (size_t i = 0; i < ret.size(); ++i) {
+      ret[i] = (value >> (8 * i)) & 0xff;
+    }
+    return ret;
+  }
+
+  static uint64_t FromBytes(const std::vector<uint8_t> &bytes) {
+    uint64_t ret = 0;
+    for (size_t i = 0; i < bytes.size() && i < 8; ++i) {
+      ret |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return ret;
+  }
+
+  std::mt19937 rng_{0x5c7a3b1e};
+};
+
+TEST_F(ScrambleModelTest, ScrambleAddr) {
+  for (uint32_t addr_width = 1; addr_width <= 20; ++addr_width) {
+    for (uint32_t nonce_width : {64u, 128u, 320u}) {
+      std::vector<uint8_t> nonce = RandomBytes(nonce_width / 8);
+      for (int i = 0; i < 64; ++i) {
+        uint64_t addr = RandomBits(addr_width);
+        uint64_t exp = FromBytes(scramble_addr(ToBytes(addr, addr_width),
+                                               addr_width, nonce, nonce_width));
+        EXPECT_EQ(
+            scramble_addr_u64(addr, addr_width, nonce.data(), nonce_width),
+            exp)
+            << "addr_width: " << addr_width << ", addr: " << addr;
+      }
+    }
+  }
+}
+
+TEST_F(ScrambleModelTest, Keystream) {
+  for (uint32_t width_32 : {1u, 2u, 8u}) {
+    uint32_t keystream_width = 39 * width_32;
+    uint32_t num_words = scramble_keystream_words(keystream_width);
+
+    for (bool repeat_keystream : {true, false}) {
+      uint32_t addr_width = 14;
+      std::vector<uint8_t> key = RandomBytes(16);
+      std::vector<uint8_t> nonce =
+          RandomBytes(8 * (repeat_keystream ? 1 : num_words));
+      PrinceKey prince_key = prince_key_from_bytes(key.data());
+
+      std::vector<uint32_t> addrs(100);
+      for (uint32_t &addr : addrs) {
+        addr = RandomBits(addr_width);
+      }
+
+      std::vector<uint64_t> keystreams(addrs.size() * num_words);
+      scramble_keystream_batch(addrs.data(), addrs.size(), addr_width,
+                               nonce.data(), prince_key, keystream_width,
+                               repeat_keystream, keystreams.data());
+
+      for (size_t i = 0; i < addrs.size(); ++i) {
+        std::vector<uint8_t> exp =
+            scramble_keystream(ToBytes(addrs[i], addr_width), addr_width,
+                               nonce, key, keystream_width, repeat_keystream);
+        std::vector<uint8_t> got;
+        for (uint32_t w = 0; w < num_words; ++w) {
+          std::vector<uint8_t> word_bytes =
+              ToBytes(keystreams[i * num_words + w], 64);
+          got.insert(got.end(), word_bytes.begin(), word_bytes.end());
+        }
+        got.resize(exp.size());
+
+        EXPECT_EQ(got, exp) << "width: " << keystream_width
+                            << ", repeat: " << repeat_keystream
+                            << ", addr: " << addrs[i];
+      }
+    }
+  }
+}
+
+TEST_F(ScrambleModelTest, EncryptDecryptData) {
+  const uint32_t addr_width = 10;
+
+  for (uint32_t data_width : {32u, 39u, 64u}) {
+    // The reference model needs each S&P block to fill its bytes exactly, so
+    // use a single block for the whole data width.
+    uint32_t subst_perm_width = data_width;
+
+    for (bool use_sp_layer : {false, true}) {
+      std::vector<uint8_t> key = RandomBytes(16);
+      std::vector<uint8_t> nonce = RandomBytes(8);
+      PrinceKey prince_key = prince_key_from_bytes(key.data());
+
+      for (int i = 0; i < 64; ++i) {
+        uint32_t addr = RandomBits(addr_width);
+        uint64_t data = RandomBits(data_width);
+
+        uint64_t keystream;
+        scramble_keystream_batch(&addr, 1, addr_width, nonce.data(),
+                                 prince_key, data_width, true, &keystream);
+
+        uint64_t enc = scramble_diffuse_data_u64(data ^ keystream, data_width,
+                                                 subst_perm_width,
+                                                 use_sp_layer);
+        uint64_t exp_enc = FromBytes(scramble_encrypt_data(
+            ToBytes(data, data_width), data_width, subst_perm_width,
+            ToBytes(addr, addr_width), addr_width, nonce, key, true,
+            use_sp_layer));
+        EXPECT_EQ(enc, exp_enc) << "data_width: " << data_width;
+
+        uint64_t dec =
+            scramble_undiffuse_data_u64(enc, data_width, subst_perm_width,
+                                        use_sp_layer) ^
+            keystream;
+        uint64_t exp_dec = FromBytes(scramble_decrypt_data(
+            ToBytes(enc, data_width), data_width, subst_perm_width,
+            ToBytes(addr, addr_width), addr_width, nonce, key, true,
+            use_sp_layer));
+        EXPECT_EQ(dec, exp_dec) << "data_width: " << data_width;
+        EXPECT_EQ(dec, data) << "data_width: " << data_width;
+      }
+    }
+  }
+}
+
+TEST_F(ScrambleModelTest, SubstPermRoundTrip) {
+  for (uint32_t width = 1; width <= 64; ++width) {
+    for (int i = 0; i < 16; ++i) {
+      uint64_t data = RandomBits(width);
+      uint64_t key = RandomBits(width);
+      uint64_t enc = scramble_subst_perm_enc_u64(data, key, width, 2);
+      EXPECT_EQ(scramble_subst_perm_dec_u64(enc, key, width, 2), data)
+          << "width: " << width;
+    }
+  }
+}
+
+TEST_F(ScrambleModelTest, PrinceRoundTrip) {
+  PrinceKey key = {RandomBits(64), RandomBits(64)};
+  std::vector<uint64_t> blocks(32);
+  for (uint64_t &block : blocks) {
+    block = RandomBits(64);
+  }
+
+  for (int num_half_rounds = 0; num_half_rounds <= 5; ++num_half_rounds) {
+    std::vector<uint64_t> enc(blocks.size()), dec(blocks.size());
+    prince_enc_dec_batch(blocks.data(), enc.data(), blocks.size(), key, false,
+                         num_half_rounds);
+    prince_enc_dec_batch(enc.data(), dec.data(), enc.size(), key, true,
+                         num_half_rounds);
+    EXPECT_EQ(dec, blocks) << "num_half_rounds: " << num_half_rounds;
+  }
+}
+
+}  // namespace
+}  // namespace scramble_model_test
@@ -0,0 +1,431 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "scramble_model_u64.h"
+
+#include <cassert>
+
+static const uint8_t kPresentSbox4[16] = {0xc, 0x5, 0x6, 0xb, 0x9, 0x0,
+                                          0xa, 0xd, 0x3, 0xe, 0xf, 0x8,
+                                          0x4, 0x7, 0x1, 0x2};
+
+static const uint8_t kPresentSbox4Inv[16] = {0x5, 0xe, 0xf, 0x8, 0xc, 0x1,
+                                             0x2, 0xd, 0xb, 0x4, 0x6, 0x3,
+                                             0x0, 0x7, 0x9, 0xa};
+
+static const uint8_t kPrinceSbox4[16] = {0xb, 0xf, 0x3, 0x2, 0xa, 0xc,
+                                         0x9, 0x1, 0x6, 0x7, 0x8, 0x0,
+                                         0xe, 0x5, 0xd, 0x4};
+
+static const uint8_t kPrinceSbox4Inv[16] = {0xb, 0x7, 0x3, 0x2, 0xf, 0xd,
+                                            0x8, 0x9, 0xa, 0x6, 0x4, 0x0,
+                                            0x5, 0xe, 0xc, 0x1};
+
+static const uint64_t kPrinceRoundConstants[12] = {
+    0x0000000000000000, 0x13198a2e03707344, 0xa4093822299f31d0,
+    0x082efa98ec4e6c89, 0x452821e638d01377, 0xbe5466cf34e90c6c,
+    0x7ef84f78fd955cb1, 0x85840851f1ac43aa, 0xc882d32f25323c54,
+    0x64a51195e0e3610d, 0xd3b5a399ca0c2399, 0xc0ac29b7c97c50dd};
+
+static const uint64_t kPrinceAlpha = 0xc0ac29b7c97c50dd;
+
+static const uint32_t kNumAddrSubstPermRounds = 2;
+static const uint32_t kNumDataSubstPermRounds = 2;
+static const int kNumPrinceHalfRounds = 3;
+
+// A mask with the bottom width bits set (for width in [0, 64])
+static inline uint64_t low_mask(uint32_t width) {
+  assert(width <= 64);
+  return width == 64 ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+}
+
+// Read count bits (at most 64) from a little endian byte vector, starting at
+// bit_pos.
+static uint64_t read_bits(const uint8_t *bytes, uint32_t bit_pos,
+                          uint32_t count) {
+  assert(count <= 64);
+
+  uint64_t ret = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t pos = bit_pos + i;
+    ret |= (uint64_t)((bytes[pos / 8] >> (pos % 8)) & 1) << i;
+  }
+  return ret;
+}
+
+// Tables applying a 4-bit S-box to both nibbles of a byte
+struct SboxTables {
+  uint8_t present[256];
+  uint8_t present_inv[256];
+  uint8_t prince[256];
+  uint8_t prince_inv[256];
+
+  SboxTables() {
+    for (uint32_t b = 0; b < 256; ++b) {
+      present[b] = kPresentSbox4[b & 0xf] | (kPresentSbox4[b >> 4] << 4);
+      present_inv[b] =
+          kPresentSbox4Inv[b & 0xf] | (kPresentSbox4Inv[b >> 4] << 4);
+      prince[b] = kPrinceSbox4[b & 0xf] | (kPrinceSbox4[b >> 4] << 4);
+      prince_inv[b] = kPrinceSbox4Inv[b & 0xf] | (kPrinceSbox4Inv[b >> 4] << 4);
+    }
+  }
+};
+
+static const SboxTables &sbox_tables() {
+  static const SboxTables tables;
+  return tables;
+}
+
+// Apply a byte-wise S-box table to all 8 bytes of x
+static inline uint64_t sbox_bytes(uint64_t x, const uint8_t table[256]) {
+  uint64_t out = 0;
+  for (uint32_t i = 0; i < 8; ++i) {
+    out |= (uint64_t)table[(x >> (8 * i)) & 0xff] << (8 * i);
+  }
+  return out;
+}
+
+// The M' layer of PRINCE (see prince_m_prime_layer in prince_ref.h)
+static uint64_t prince_m_prime(uint64_t in) {
+  static const uint64_t m16[2][16] = {
+      {0x0111, 0x2220, 0x4404, 0x8088, 0x1011, 0x0222, 0x4440, 0x8808, 0x1101,
+       0x2022, 0x0444, 0x8880, 0x1110, 0x2202, 0x4044, 0x0888},
+      {0x1110, 0x2202, 0x4044, 0x0888, 0x0111, 0x2220, 0x4404, 0x8088, 0x1011,
+       0x0222, 0x4440, 0x8808, 0x1101, 0x2022, 0x0444, 0x8880}};
+  static const int chunk_mat[4] = {0, 1, 1, 0};
+
+  uint64_t out = 0;
+  for (uint32_t c = 0; c < 4; ++c) {
+    uint64_t chunk_in = in >> (16 * c);
+    uint64_t chunk_out = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+      if ((chunk_in >> i) & 1) {
+        chunk_out ^= m16[chunk_mat[c]][i];
+      }
+    }
+    out |= chunk_out << (16 * c);
+  }
+  return out;
+}
+
+// The shift rows step of PRINCE (see prince_shift_rows in prince_ref.h)
+static uint64_t prince_shift_rows(uint64_t in, bool inverse) {
+  const uint64_t row_mask = 0xF000F000F000F000;
+  uint64_t out = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    uint64_t row = in & (row_mask >> (4 * i));
+    uint32_t shift = inverse ? i * 16 : 64 - i * 16;
+    // A rotation by 0 or 64 is the identity (and would be undefined below)
+    out |= (shift % 64) ? ((row >> shift) | (row << (64 - shift))) : row;
+  }
+  return out;
+}
+
+// Tables for the PRINCE rounds. The linear layers are applied by XORing one
+// table entry for each byte of the state.
+//
+//  - fwd[i][b] is SR(M'(S(b << 8i))), a full forward round (before the key
+//    addition). This works because S acts on each nibble separately and
+//    SR(M'(.)) is linear.
+//
+//  - mid[i][b] is M'(S(b << 8i)), the first two steps of the middle round.
+//
+//  - inv[i][b] is M'(SR^-1(b << 8i)), the linear part of an inverse round.
+struct PrinceTables {
+  uint64_t fwd[8][256];
+  uint64_t mid[8][256];
+  uint64_t inv[8][256];
+
+  PrinceTables() {
+    const SboxTables &sboxes = sbox_tables();
+    for (uint32_t i = 0; i < 8; ++i) {
+      for (uint32_t b = 0; b < 256; ++b) {
+        uint64_t s_out = (uint64_t)sboxes.prince[b] << (8 * i);
+        fwd[i][b] = prince_shift_rows(prince_m_prime(s_out), false);
+        mid[i][b] = prince_m_prime(s_out);
+        inv[i][b] =
+            prince_m_prime(prince_shift_rows((uint64_t)b << (8 * i), true));
+      }
+    }
+  }
+};
+
+static const PrinceTables &prince_tables() {
+  static const PrinceTables tables;
+  return tables;
+}
+
+static inline uint64_t apply_table(uint64_t x, const uint64_t table[8][256]) {
+  uint64_t out = 0;
+  for (uint32_t i = 0; i < 8; ++i) {
+    out ^= table[i][(x >> (8 * i)) & 0xff];
+  }
+  return out;
+}
+
+PrinceKey prince_key_from_bytes(const uint8_t key[16]) {
+  PrinceKey ret = {0, 0};
+  for (uint32_t i = 0; i < 8; ++i) {
+    ret.k1 |= (uint64_t)key[i] << (8 * i);
+    ret.k0 |= (uint64_t)key[8 + i] << (8 * i);
+  }
+  return ret;
+}
+
+void prince_enc_dec_batch(const uint64_t *in, uint64_t *out, size_t n,
+                          const PrinceKey &key, bool decrypt,
+                          int num_half_rounds) {
+  assert(0 <= num_half_rounds && num_half_rounds <= 5);
+
+  const PrinceTables &tables = prince_tables();
+  const SboxTables &sboxes = sbox_tables();
+
+  // Key schedule, as in prince_enc_dec_uint64 (with the new key schedule)
+  uint64_t k1 = key.k1 ^ (decrypt ? kPrinceAlpha : 0);
+  uint64_t k0_new = key.k0 ^ (decrypt ? kPrinceAlpha : 0);
+  uint64_t enc_k0_prime = ((key.k0 >> 1) | (key.k0 << 63)) ^ (key.k0 >> 63);
+  uint64_t k0 = decrypt ? enc_k0_prime : key.k0;
+  uint64_t k0_prime = decrypt ? key.k0 : enc_k0_prime;
+
+  // Round keys, with round constants folded in
+  uint64_t fwd_keys[6], inv_keys[6];
+  for (int round = 1; round <= num_half_rounds; ++round) {
+    fwd_keys[round] =
+        ((round % 2 == 1) ? k0_new : k1) ^ kPrinceRoundConstants[round];
+    int constant_idx = 10 - num_half_rounds + round;
+    inv_keys[round] = (((num_half_rounds + round + 1) % 2 == 1) ? k0_new : k1) ^
+                      kPrinceRoundConstants[constant_idx];
+  }
+
+  for (size_t blk = 0; blk < n; ++blk) {
+    uint64_t state = in[blk] ^ k0 ^ k1 ^ kPrinceRoundConstants[0];
+
+    for (int round = 1; round <= num_half_rounds; ++round) {
+      state = apply_table(state, tables.fwd) ^ fwd_keys[round];
+    }
+
+    state = sbox_bytes(apply_table(state, tables.mid), sboxes.prince_inv);
+
+    for (int round = 1; round <= num_half_rounds; ++round) {
+      state = sbox_bytes(apply_table(state ^ inv_keys[round], tables.inv),
+                         sboxes.prince_inv);
+    }
+
+    out[blk] = state ^ k1 ^ kPrinceRoundConstants[11] ^ k0_prime;
+  }
+}
+
+// Run each complete 4-bit chunk of the bottom bit_width bits of in through an
+// S-box. Where bit_width isn't a multiple of 4, the remaining bits are copied
+// straight through.
+static uint64_t sbox_layer(uint64_t in, uint32_t bit_width,
+                           const uint8_t sbox8[256], const uint8_t sbox4[16]) {
+  uint32_t num_nibbles = bit_width / 4;
+  uint64_t out = 0;
+
+  uint32_t i = 0;
+  for (; i + 2 <= num_nibbles; i += 2) {
+    out |= (uint64_t)sbox8[(in >> (4 * i)) & 0xff] << (4 * i);
+  }
+  if (i < num_nibbles) {
+    out |= (uint64_t)sbox4[(in >> (4 * i)) & 0xf] << (4 * i);
+  }
+
+  return out | (in & low_mask(bit_width) & ~low_mask(4 * num_nibbles));
+}
+
+// Reverse the bottom bit_width bits of in
+static uint64_t flip_layer(uint64_t in, uint32_t bit_width) {
+  assert(0 < bit_width && bit_width <= 64);
+
+  uint64_t x = in;
+  x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+  x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+  x = ((x >> 4) & 0x0f0f0f0f0f0f0f0f) | ((x & 0x0f0f0f0f0f0f0f0f) << 4);
+  x = ((x >> 8) & 0x00ff00ff00ff00ff) | ((x & 0x00ff00ff00ff00ff) << 8);
+  x = ((x >> 16) & 0x0000ffff0000ffff) | ((x & 0x0000ffff0000ffff) << 16);
+  x = (x >> 32) | (x << 32);
+
+  return x >> (64 - bit_width);
+}
+
+// Gather the even bits of x into the bottom half
+static uint64_t compress_even_bits(uint64_t x) {
+  x &= 0x5555555555555555;
+  x = (x | (x >> 1)) & 0x3333333333333333;
+  x = (x | (x >> 2)) & 0x0f0f0f0f0f0f0f0f;
+  x = (x | (x >> 4)) & 0x00ff00ff00ff00ff;
+  x = (x | (x >> 8)) & 0x0000ffff0000ffff;
+  x = (x | (x >> 16)) & 0x00000000ffffffff;
+  return x;
+}
+
+// Spread the bottom 32 bits of x into the even bits (inverse of
+// compress_even_bits)
+static uint64_t spread_even_bits(uint64_t x) {
+  x &= 0x00000000ffffffff;
+  x = (x | (x << 16)) & 0x0000ffff0000ffff;
+  x = (x | (x << 8)) & 0x00ff00ff00ff00ff;
+  x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0f;
+  x = (x | (x << 2)) & 0x3333333333333333;
+  x = (x | (x << 1)) & 0x5555555555555555;
+  return x;
+}
+
+// Apply butterfly to the bottom bit_width bits of in. Even bits are placed in
+// the lower half of the output, odd bits are placed in the upper half of the
+// output. Where bit_width is odd, the final bit stays where it is.
+static uint64_t perm_layer(uint64_t in, uint32_t bit_width, bool invert) {
+  uint32_t half = bit_width / 2;
+  uint64_t out;
+
+  if (invert) {
+    out = spread_even_bits(in & low_mask(half)) |
+          (spread_even_bits((in >> half) & low_mask(half)) << 1);
+  } else {
+    uint64_t body = in & low_mask(2 * half);
+    out = compress_even_bits(body) | (compress_even_bits(body >> 1) << half);
+  }
+
+  if (bit_width % 2) {
+    out |= in & ((uint64_t)1 << (bit_width - 1));
+  }
+
+  return out;
+}
+
+uint64_t scramble_subst_perm_enc_u64(uint64_t in, uint64_t key,
+                                     uint32_t bit_width, uint32_t num_rounds) {
+  assert(0 < bit_width && bit_width <= 64);
+
+  const SboxTables &sboxes = sbox_tables();
+  uint64_t state = in & low_mask(bit_width);
+  key &= low_mask(bit_width);
+
+  for (uint32_t i = 0; i < num_rounds; ++i) {
+    state ^= key;
+
+    state = sbox_layer(state, bit_width, sboxes.present, kPresentSbox4);
+    state = flip_layer(state, bit_width);
+    state = perm_layer(state, bit_width, false);
+  }
+
+  return state ^ key;
+}
+
+uint64_t scramble_subst_perm_dec_u64(uint64_t in, uint64_t key,
+                                     uint32_t bit_width, uint32_t num_rounds) {
+  assert(0 < bit_width && bit_width <= 64);
+
+  const SboxTables &sboxes = sbox_tables();
+  uint64_t state = in & low_mask(bit_width);
+  key &= low_mask(bit_width);
+
+  for (uint32_t i = 0; i < num_rounds; ++i) {
+    state ^= key;
+
+    state = perm_layer(state, bit_width, true);
+    state = flip_layer(state, bit_width);
+    state = sbox_layer(state, bit_width, sboxes.present_inv, kPresentSbox4Inv);
+  }
+
+  return state ^ key;
+}
+
+uint64_t scramble_addr_u64(uint64_t addr, uint32_t addr_width,
+                           const uint8_t *nonce, uint32_t nonce_width) {
+  assert(0 < addr_width && addr_width <= 64);
+  assert(addr_width <= nonce_width);
+
+  // Address is scrambled by using substitution/permutation layer with the top
+  // addr_width bits of the nonce used as a key.
+  uint64_t key = read_bits(nonce, nonce_width - addr_width, addr_width);
+
+  return scramble_subst_perm_enc_u64(addr, key, addr_width,
+                                     kNumAddrSubstPermRounds);
+}
+
+void scramble_keystream_batch(const uint32_t *addrs, size_t n,
+                              uint32_t addr_width, const uint8_t *nonce,
+                              const PrinceKey &key, uint32_t keystream_width,
+                              bool repeat_keystream, uint64_t *out) {
+  assert(0 < addr_width && addr_width < 64);
+  assert(keystream_width > 0);
+
+  uint32_t num_words = scramble_keystream_words(keystream_width);
+  uint32_t num_princes = repeat_keystream ? 1 : num_words;
+  uint64_t top_mask = low_mask(keystream_width - 64 * (num_words - 1));
+
+  // Encrypt in small batches. Each PRINCE instance i has its own nonce bits,
+  // which form the top of the IV above the address.
+  const size_t kBatch = 64;
+  uint64_t ivs[kBatch];
+
+  for (uint32_t i = 0; i < num_princes; ++i) {
+    uint32_t nonce_bits = 64 - addr_width;
+    uint64_t iv_top = read_bits(nonce, i * nonce_bits, nonce_bits)
+                      << addr_width;
+
+    for (size_t base = 0; base < n; base += kBatch) {
+      size_t count = (n - base < kBatch) ? n - base : kBatch;
+
+      for (size_t j = 0; j < count; ++j) {
+        ivs[j] = iv_top | (addrs[base + j] & low_mask(addr_width));
+      }
+      prince_enc_dec_batch(ivs, ivs, count, key, false, kNumPrinceHalfRounds);
+
+      for (size_t j = 0; j < count; ++j) {
+        uint64_t *dst = &out[(base + j) * num_words];
+        if (repeat_keystream) {
+          for (uint32_t w = 0; w < num_words; ++w) {
+            dst[w] = ivs[j];
+          }
+        } else {
+          dst[i] = ivs[j];
+        }
+        dst[num_words - 1] &= top_mask;
+      }
+    }
+  }
+}
+
+// Split data into subst_perm_width chunks and apply the data S&P network to
+// each one.
+static uint64_t subst_perm_full_width(uint64_t data, uint32_t data_width,
+                                      uint32_t subst_perm_width, bool enc) {
+  assert(0 < data_width && data_width <= 64);
+  assert(subst_perm_width > 0);
+
+  uint64_t out = 0;
+  for (uint32_t lsb = 0; lsb < data_width; lsb += subst_perm_width) {
+    uint32_t block_width = data_width - lsb < subst_perm_width
+                               ? data_width - lsb
+                               : subst_perm_width;
+    uint64_t block = (data >> lsb) & low_mask(block_width);
+    block = enc ? scramble_subst_perm_enc_u64(block, 0, block_width,
+                                              kNumDataSubstPermRounds)
+                : scramble_subst_perm_dec_u64(block, 0, block_width,
+                                              kNumDataSubstPermRounds);
+    out |= block << lsb;
+  }
+  return out;
+}
+
+uint64_t scramble_diffuse_data_u64(uint64_t data, uint32_t data_width,
+                                   uint32_t subst_perm_width,
+                                   bool use_sp_layer) {
+  if (!use_sp_layer) {
+    return data;
+  }
+  return subst_perm_full_width(data, data_width, subst_perm_width, true);
+}
+
+uint64_t scramble_undiffuse_data_u64(uint64_t data, uint32_t data_width,
+                                     uint32_t subst_perm_width,
+                                     bool use_sp_layer) {
+  if (!use_sp_layer) {
+    return data;
+  }
+  return subst_perm_full_width(data, data_width, subst_perm_width, false);
+}
@@ -0,0 +1,126 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_PRIM_DV_PRIM_RAM_SCR_CPP_SCRAMBLE_MODEL_U64_H_
+#define OPENTITAN_HW_IP_PRIM_DV_PRIM_RAM_SCR_CPP_SCRAMBLE_MODEL_U64_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-width C++ model of memory scrambling.
+//
+// This computes the same results as the functions in scramble_model.h, but
+// works on uint64_t values and never allocates. Bit i of a value corresponds
+// to bit i of the little endian byte vectors used by scramble_model.h. PRINCE
+// is table driven and can be run over a batch of blocks that share a key.
+//
+// The byte vector model in scramble_model.h is the reference implementation
+// and scramble_model_test.cc checks that the two agree.
+
+/** A PRINCE key, split into its two 64-bit halves */
+struct PrinceKey {
+  uint64_t k0;
+  uint64_t k1;
+};
+
+/** Convert a little endian byte vector of a scrambling key (as passed to
+ * scramble_encrypt_data) into a PrinceKey.
+ *
+ * @param key 16 bytes of key, least significant byte first
+ */
+PrinceKey prince_key_from_bytes(const uint8_t key[16]);
+
+/** Encrypt or decrypt a batch of blocks with PRINCE under the same key
+ *
+ * This matches prince_enc_dec_uint64() from prince_ref.h with the new key
+ * schedule. It is safe for \p in and \p out to be the same array.
+ *
+ * @param in              Array of n input blocks
+ * @param out             Array of n output blocks
+ * @param n               Number of blocks
+ * @param key             PRINCE key
+ * @param decrypt         Decrypt rather than encrypt
+ * @param num_half_rounds Number of half rounds (at most 5)
+ */
+void prince_enc_dec_batch(const uint64_t *in, uint64_t *out, size_t n,
+                          const PrinceKey &key, bool decrypt,
+                          int num_half_rounds);
+
+/** Apply num_rounds rounds of the substitution/permutation network
+ *
+ * @param in         Input, at most 64 bits wide
+ * @param key        Key, applied before each round and at the end
+ * @param bit_width  Width of the input and key in bits (1 to 64)
+ * @param num_rounds Number of rounds
+ */
+uint64_t scramble_subst_perm_enc_u64(uint64_t in, uint64_t key,
+                                     uint32_t bit_width, uint32_t num_rounds);
+
+/** Invert scramble_subst_perm_enc_u64 */
+uint64_t scramble_subst_perm_dec_u64(uint64_t in, uint64_t key,
+                                     uint32_t bit_width, uint32_t num_rounds);
+
+/** Scramble an address to give the physical address used to access the
+ * scrambled memory. See scramble_addr() in scramble_model.h.
+ *
+ * @param addr         Address
+ * @param addr_width   Width of the address in bits (1 to 64)
+ * @param nonce        Little endian byte vector of scrambling nonce
+ * @param nonce_width  Width of scramble nonce in bits
+ * @return Scrambled address
+ */
+uint64_t scramble_addr_u64(uint64_t addr, uint32_t addr_width,
+                           const uint8_t *nonce, uint32_t nonce_width);
+
+/** Number of uint64_t words of keystream generated for each address by
+ * scramble_keystream_batch for a keystream of the given width.
+ */
+static inline uint32_t scramble_keystream_words(uint32_t keystream_width) {
+  return (keystream_width + 63) / 64;
+}
+
+/** Generate keystreams for a batch of addresses
+ *
+ * This matches scramble_keystream() in scramble_model.h. The keystream for
+ * addrs[i] is written to out[i * w] to out[i * w + w - 1], where w is
+ * scramble_keystream_words(keystream_width). Unused bits at the top of the
+ * last word are zero.
+ *
+ * @param addrs            Array of n addresses
+ * @param n                Number of addresses
+ * @param addr_width       Width of each address in bits
+ * @param nonce            Little endian byte vector of scrambling nonce
+ * @param key              PRINCE key
+ * @param keystream_width  Width of the keystream in bits
+ * @param repeat_keystream Repeat the keystream of one single PRINCE instance if
+ *                         set to true. Otherwise multiple PRINCE instances are
+ *                         used.
+ * @param out              Output array
+ */
+void scramble_keystream_batch(const uint32_t *addrs, size_t n,
+                              uint32_t addr_width, const uint8_t *nonce,
+                              const PrinceKey &key, uint32_t keystream_width,
+                              bool repeat_keystream, uint64_t *out);
+
+/** Encrypt data that has already been XORed with its keystream
+ *
+ * If use_sp_layer is false, this returns data unchanged. Otherwise, it applies
+ * the data substitution/permutation network, as in scramble_encrypt_data().
+ *
+ * @param data             Data (at most 64 bits wide)
+ * @param data_width       Width of data in bits
+ * @param subst_perm_width Width over which the substitution/permutation network
+ *                         is applied
+ * @param use_sp_layer     Use the S&P layer for data diffusion
+ */
+uint64_t scramble_diffuse_data_u64(uint64_t data, uint32_t data_width,
+                                   uint32_t subst_perm_width,
+                                   bool use_sp_layer);
+
+/** Invert scramble_diffuse_data_u64 */
+uint64_t scramble_undiffuse_data_u64(uint64_t data, uint32_t data_width,
+                                     uint32_t subst_perm_width,
+                                     bool use_sp_layer);
+
+#endif  // OPENTITAN_HW_IP_PRIM_DV_PRIM_RAM_SCR_CPP_SCRAMBLE_MODEL_U64_H_
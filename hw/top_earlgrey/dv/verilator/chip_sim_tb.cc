@@ -8,12 +8,14 @@
 #include <vector>
 
 #include "verilated_toplevel.h"
+#include "verilator_dpi_checkpoint.h"
 #include "verilator_memutil.h"
 #include "verilator_sim_ctrl.h"
 
 int main(int argc, char **argv) {
   chip_sim_tb top;
   VerilatorMemUtil memutil;
+  VerilatorDpiCheckpoint dpi_checkpoint;
   VerilatorSimCtrl &simctrl = VerilatorSimCtrl::GetInstance();
   simctrl.SetTop(&top, &top.clk_i, &top.rst_ni,
                  VerilatorSimCtrlFlags::ResetPolarityNegative);
@@ -49,6 +51,7 @@ int main(int argc, char **argv) {
   memutil.RegisterMemoryArea("flash1", 0x20080000u, &flash1);
   memutil.RegisterMemoryArea("otp", 0x40000000u /* (bogus LMA) */, &otp);
   simctrl.RegisterExtension(&memutil);
+  simctrl.RegisterExtension(&dpi_checkpoint);
 
   // The initial reset delay must be long enough such that pwr/rst/clkmgr will
   // release clocks to the entire design.  This allows for synchronous resets
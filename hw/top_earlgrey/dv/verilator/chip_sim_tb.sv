@@ -199,15 +199,36 @@ module chip_sim_tb (
     u_sw_test_status_if.sw_test_status_addr = `SIM_SRAM_IF.start_addr;
   end
 
+  import "DPI-C" function void simutil_report_failure();
+
   always @(posedge clk_i) begin
     if (u_sw_test_status_if.sw_test_done) begin
       $display("Verilator sim termination requested");
       $display("Your simulation wrote to 0x%h", u_sw_test_status_if.sw_test_status_addr);
       dv_test_status_pkg::dv_test_status(u_sw_test_status_if.sw_test_passed);
+      // Tell the simulation controller about a failure too, so that it
+      // exits with an error and keeps a --trace-ring trace. This can't use
+      // $error, which aborts the simulation before $finish can shut it down.
+      if (!u_sw_test_status_if.sw_test_passed) begin
+        simutil_report_failure();
+      end
       $finish;
     end
   end
 
+`ifdef RVFI
+  // Start tracing when the core retires the instruction at a given PC, with
+  // --trace-trigger=pc=ADDR.
+  sim_trace_trigger #(
+    .Name  ("pc"),
+    .Width (32)
+  ) u_trace_trigger_pc (
+    .clk_i   (`RV_CORE_IBEX.clk_i),
+    .valid_i (`RV_CORE_IBEX.rvfi_valid),
+    .value_i (`RV_CORE_IBEX.rvfi_pc_rdata)
+  );
+`endif
+
   `undef RV_CORE_IBEX
   `undef SIM_SRAM_IF
 
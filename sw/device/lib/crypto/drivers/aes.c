@@ -343,6 +343,88 @@ status_t aes_update(aes_block_t *dest, const aes_block_t *src) {
   return OTCRYPTO_OK;
 }
 
+/**
+ * Writes one block from memory to the data input registers.
+ *
+ * @param base AES base address.
+ * @param src Input block, which need not be word-aligned.
+ */
+static void data_in_write(uint32_t base, const uint8_t *src) {
+  uint32_t offset = base + AES_DATA_IN_0_REG_OFFSET;
+  size_t i;
+  for (i = 0; launder32(i) < kAesBlockNumWords; ++i) {
+    abs_mmio_write32(offset + i * sizeof(uint32_t),
+                     read_32(&src[i * sizeof(uint32_t)]));
+  }
+  // Check that the loop ran for the correct number of iterations.
+  HARDENED_CHECK_EQ(i, kAesBlockNumWords);
+}
+
+/**
+ * Reads one block from the data output registers to memory.
+ *
+ * @param base AES base address.
+ * @param[out] dest Output block, which need not be word-aligned.
+ */
+static void data_out_read(uint32_t base, uint8_t *dest) {
+  uint32_t offset = base + AES_DATA_OUT_0_REG_OFFSET;
+  size_t i;
+  for (i = 0; launder32(i) < kAesBlockNumWords; ++i) {
+    write_32(abs_mmio_read32(offset + i * sizeof(uint32_t)),
+             &dest[i * sizeof(uint32_t)]);
+  }
+  // Check that the loop ran for the correct number of iterations.
+  HARDENED_CHECK_EQ(i, kAesBlockNumWords);
+}
+
+status_t aes_update_blocks(uint8_t *dest, const uint8_t *src,
+                           size_t num_blocks) {
+  if (num_blocks == 0) {
+    return OTCRYPTO_OK;
+  }
+  if (dest == NULL || src == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+
+  // No output may be pending from earlier calls.
+  const uint32_t base = aes_base();
+  uint32_t reg = abs_mmio_read32(base + AES_STATUS_REG_OFFSET);
+  if (bitfield_bit32_read(reg, AES_STATUS_OUTPUT_VALID_BIT)) {
+    return OTCRYPTO_RECOV_ERR;
+  }
+
+  // Keep up to three blocks in flight, as `aes_update` callers do: software
+  // reads block x-1 from the output registers while the hardware processes
+  // block x and block x+1 waits in the input registers.
+  const size_t block_offset = num_blocks >= 3 ? 2 : 1;
+  size_t in;
+  for (in = 0; launder32(in) < block_offset; ++in) {
+    HARDENED_TRY(spin_until(AES_STATUS_INPUT_READY_BIT));
+    data_in_write(base, &src[in * kAesBlockNumBytes]);
+  }
+  HARDENED_CHECK_EQ(in, block_offset);
+
+  size_t out;
+  for (out = 0; launder32(out) < num_blocks; ++out) {
+    HARDENED_TRY(spin_until(AES_STATUS_OUTPUT_VALID_BIT));
+    data_out_read(base, &dest[out * kAesBlockNumBytes]);
+
+    // Reading the output lets the hardware take the next input block, which
+    // frees the input registers.
+    if (launder32(in) < num_blocks) {
+      HARDENED_CHECK_LT(in, num_blocks);
+      HARDENED_TRY(spin_until(AES_STATUS_INPUT_READY_BIT));
+      data_in_write(base, &src[in * kAesBlockNumBytes]);
+      ++in;
+    }
+  }
+  // Check that all blocks went in and came out.
+  HARDENED_CHECK_EQ(out, num_blocks);
+  HARDENED_CHECK_EQ(in, num_blocks);
+
+  return OTCRYPTO_OK;
+}
+
 status_t aes_end(aes_block_t *iv) {
   uint32_t ctrl_reg = AES_CTRL_SHADOWED_REG_RESVAL;
   ctrl_reg = bitfield_bit32_write(ctrl_reg,
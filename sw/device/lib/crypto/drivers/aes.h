@@ -161,6 +161,31 @@ status_t aes_decrypt_begin(const aes_key_t key, const aes_block_t *iv);
 OT_WARN_UNUSED_RESULT
 status_t aes_update(aes_block_t *dest, const aes_block_t *src);
 
+/**
+ * Encrypts or decrypts a number of consecutive blocks.
+ *
+ * This keeps the input and output pipelines of the hardware full across all
+ * of the blocks, in the same way as the sequence of `aes_update` calls shown
+ * above, but moves the data directly between the buffers and the hardware
+ * registers.
+ *
+ * No blocks may be in flight when this function is called (i.e. any input fed
+ * in with `aes_update` must have been read back out), and none are left in
+ * flight when it returns, so the session may be continued with `aes_update`
+ * or further calls to this function.
+ *
+ * `dest` may be equal to `src` for in-place operation, but the buffers must
+ * not otherwise overlap. Neither needs to be word-aligned.
+ *
+ * @param[out] dest Output buffer, `num_blocks` blocks long.
+ * @param src Input buffer, `num_blocks` blocks long.
+ * @param num_blocks Number of blocks to process.
+ * @return The result of the operation.
+ */
+OT_WARN_UNUSED_RESULT
+status_t aes_update_blocks(uint8_t *dest, const uint8_t *src,
+                           size_t num_blocks);
+
 /**
  * Completes an AES session by clearing control settings and key material.
  *
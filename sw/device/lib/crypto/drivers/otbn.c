@@ -66,6 +66,37 @@ typedef enum otbn_status {
   kOtbnStatusLocked = 0xFF,
 } otbn_status_t;
 
+/**
+ * The application that is known to be in IMEM, for app residency mode.
+ */
+typedef struct otbn_resident_app {
+  /**
+   * `kHardenedBoolTrue` if the fields below describe the contents of IMEM.
+   */
+  hardened_bool_t valid;
+  /**
+   * Identity of the resident application.
+   */
+  const uint32_t *imem_start;
+  const uint32_t *imem_end;
+  uint32_t checksum;
+  /**
+   * Value of the LOAD_CHECKSUM register after IMEM was written, before the
+   * data section was written to DMEM.
+   */
+  uint32_t imem_checksum;
+} otbn_resident_app_t;
+
+static hardened_bool_t app_residency_enabled = kHardenedBoolFalse;
+static otbn_resident_app_t resident_app = {.valid = kHardenedBoolFalse};
+
+/**
+ * Forgets the resident application, so that the next load rewrites IMEM.
+ */
+static void resident_app_forget(void) {
+  resident_app = (otbn_resident_app_t){.valid = kHardenedBoolFalse};
+}
+
 /**
  * Ensures that a memory access fits within the given memory size.
  *
@@ -232,6 +263,9 @@ status_t otbn_busy_wait_for_done(void) {
     return res;
   }
 
+  // OTBN may have wiped its memories, so the app must be loaded again.
+  resident_app_forget();
+
   // If OTBN is idle (not locked), then return a recoverable error.
   if (launder32(status) == kOtbnStatusIdle) {
     HARDENED_CHECK_EQ(status, kOtbnStatusIdle);
@@ -243,6 +277,25 @@ status_t otbn_busy_wait_for_done(void) {
   return OTCRYPTO_FATAL_ERR;
 }
 
+hardened_bool_t otbn_is_busy(void) {
+  uint32_t status = abs_mmio_read32(otbn_base() + OTBN_STATUS_REG_OFFSET);
+  if (launder32(status) == kOtbnStatusIdle ||
+      launder32(status) == kOtbnStatusLocked) {
+    return kHardenedBoolFalse;
+  }
+  return kHardenedBoolTrue;
+}
+
+void otbn_irq_done_enable(bool enable) {
+  abs_mmio_write32(otbn_base() + OTBN_INTR_ENABLE_REG_OFFSET,
+                   enable ? 1u << OTBN_INTR_COMMON_DONE_BIT : 0);
+}
+
+void otbn_irq_done_acknowledge(void) {
+  abs_mmio_write32(otbn_base() + OTBN_INTR_STATE_REG_OFFSET,
+                   1u << OTBN_INTR_COMMON_DONE_BIT);
+}
+
 uint32_t otbn_err_bits_get(void) {
   return abs_mmio_read32(otbn_base() + OTBN_ERR_BITS_REG_OFFSET);
 }
@@ -253,6 +306,7 @@ uint32_t otbn_instruction_count_get(void) {
 
 status_t otbn_imem_sec_wipe(void) {
   HARDENED_TRY(otbn_assert_idle());
+  resident_app_forget();
   abs_mmio_write32(otbn_base() + OTBN_CMD_REG_OFFSET, kOtbnCmdSecWipeImem);
   HARDENED_TRY(otbn_busy_wait_for_done());
   return OTCRYPTO_OK;
@@ -310,59 +364,114 @@ static status_t check_app_address_ranges(const otbn_app_t *app) {
   return OTCRYPTO_OK;
 }
 
-status_t otbn_load_app(const otbn_app_t app) {
-  HARDENED_TRY(check_app_address_ranges(&app));
-
-  // Ensure OTBN is idle.
-  HARDENED_TRY(otbn_assert_idle());
-
-  const size_t imem_num_words = (size_t)(app.imem_end - app.imem_start);
+/**
+ * Writes the data section of an OTBN application to DMEM.
+ *
+ * @param app the OTBN application to load
+ * @return Result of the operation.
+ */
+static status_t load_dmem_data(const otbn_app_t *app) {
   const size_t data_num_words =
-      (size_t)(app.dmem_data_end - app.dmem_data_start);
-
-  HARDENED_TRY(otbn_imem_sec_wipe());
-  HARDENED_TRY(otbn_dmem_sec_wipe());
+      (size_t)(app->dmem_data_end - app->dmem_data_start);
 
-  // Reset the LOAD_CHECKSUM register.
-  abs_mmio_write32(otbn_base() + OTBN_LOAD_CHECKSUM_REG_OFFSET, 0);
-
-  // Ensure that the IMEM section fits in IMEM and the data section fits in
-  // DMEM.
-  HARDENED_TRY(check_offset_len(app.dmem_data_start_addr, data_num_words,
-                                kOtbnDMemSizeBytes));
-
-  // Write to IMEM. Always starts at zero on the OTBN side.
-  otbn_addr_t imem_offset = 0;
-  HARDENED_TRY(
-      check_offset_len(imem_offset, imem_num_words, kOtbnIMemSizeBytes));
-  uint32_t imem_start_addr = otbn_base() + OTBN_IMEM_REG_OFFSET + imem_offset;
-  uint32_t i = 0;
-  for (; launder32(i) < imem_num_words; i++) {
-    HARDENED_CHECK_LT(i, imem_num_words);
-    abs_mmio_write32(imem_start_addr + i * sizeof(uint32_t), app.imem_start[i]);
-  }
-  HARDENED_CHECK_EQ(i, imem_num_words);
-
-  // Write the data portion to DMEM.
-  otbn_addr_t data_offset = app.dmem_data_start_addr;
+  // Ensure that the data section fits in DMEM.
+  otbn_addr_t data_offset = app->dmem_data_start_addr;
   HARDENED_TRY(
       check_offset_len(data_offset, data_num_words, kOtbnDMemSizeBytes));
   uint32_t data_start_addr = otbn_base() + OTBN_DMEM_REG_OFFSET + data_offset;
-  i = 0;
+  uint32_t i = 0;
   for (; launder32(i) < data_num_words; i++) {
     HARDENED_CHECK_LT(i, data_num_words);
     abs_mmio_write32(data_start_addr + i * sizeof(uint32_t),
-                     app.dmem_data_start[i]);
+                     app->dmem_data_start[i]);
   }
   HARDENED_CHECK_EQ(i, data_num_words);
 
+  return OTCRYPTO_OK;
+}
+
+/**
+ * Checks whether the given application is resident in IMEM.
+ *
+ * @param app the OTBN application to check
+ * @return `kHardenedBoolTrue` if the app can be reused without loading IMEM.
+ */
+static hardened_bool_t app_is_resident(const otbn_app_t *app) {
+  if (launder32(app_residency_enabled) != kHardenedBoolTrue ||
+      launder32(resident_app.valid) != kHardenedBoolTrue) {
+    return kHardenedBoolFalse;
+  }
+  if (resident_app.imem_start != app->imem_start ||
+      resident_app.imem_end != app->imem_end ||
+      resident_app.checksum != app->checksum) {
+    return kHardenedBoolFalse;
+  }
+  return kHardenedBoolTrue;
+}
+
+void otbn_set_app_residency(bool enable) {
+  resident_app_forget();
+  app_residency_enabled = enable ? kHardenedBoolTrue : kHardenedBoolFalse;
+}
+
+status_t otbn_load_app(const otbn_app_t app) {
+  HARDENED_TRY(check_app_address_ranges(&app));
+
+  // Ensure OTBN is idle.
+  HARDENED_TRY(otbn_assert_idle());
+
+  if (app_is_resident(&app) == kHardenedBoolTrue) {
+    // Only DMEM needs to be wiped and its data section restored. Resuming the
+    // checksum from the value it had after IMEM was loaded means that it can
+    // still be checked against the checksum of the whole app.
+    HARDENED_TRY(otbn_dmem_sec_wipe());
+    abs_mmio_write32(otbn_base() + OTBN_LOAD_CHECKSUM_REG_OFFSET,
+                     resident_app.imem_checksum);
+  } else {
+    const size_t imem_num_words = (size_t)(app.imem_end - app.imem_start);
+
+    resident_app_forget();
+    HARDENED_TRY(otbn_imem_sec_wipe());
+    HARDENED_TRY(otbn_dmem_sec_wipe());
+
+    // Reset the LOAD_CHECKSUM register.
+    abs_mmio_write32(otbn_base() + OTBN_LOAD_CHECKSUM_REG_OFFSET, 0);
+
+    // Write to IMEM. Always starts at zero on the OTBN side.
+    otbn_addr_t imem_offset = 0;
+    HARDENED_TRY(
+        check_offset_len(imem_offset, imem_num_words, kOtbnIMemSizeBytes));
+    uint32_t imem_start_addr = otbn_base() + OTBN_IMEM_REG_OFFSET + imem_offset;
+    uint32_t i = 0;
+    for (; launder32(i) < imem_num_words; i++) {
+      HARDENED_CHECK_LT(i, imem_num_words);
+      abs_mmio_write32(imem_start_addr + i * sizeof(uint32_t),
+                       app.imem_start[i]);
+    }
+    HARDENED_CHECK_EQ(i, imem_num_words);
+
+    resident_app.imem_checksum =
+        abs_mmio_read32(otbn_base() + OTBN_LOAD_CHECKSUM_REG_OFFSET);
+  }
+
+  // Write the data portion to DMEM.
+  HARDENED_TRY(load_dmem_data(&app));
+
   // Ensure that the checksum matches expectations.
   uint32_t checksum =
       abs_mmio_read32(otbn_base() + OTBN_LOAD_CHECKSUM_REG_OFFSET);
   if (launder32(checksum) != app.checksum) {
+    resident_app_forget();
     return OTCRYPTO_FATAL_ERR;
   }
   HARDENED_CHECK_EQ(checksum, app.checksum);
 
+  if (launder32(app_residency_enabled) == kHardenedBoolTrue) {
+    resident_app.imem_start = app.imem_start;
+    resident_app.imem_end = app.imem_end;
+    resident_app.checksum = app.checksum;
+    resident_app.valid = kHardenedBoolTrue;
+  }
+
   return OTCRYPTO_OK;
 }
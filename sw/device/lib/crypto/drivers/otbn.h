@@ -283,6 +283,31 @@ status_t otbn_execute(void);
  */
 status_t otbn_busy_wait_for_done(void);
 
+/**
+ * Checks whether OTBN is busy, without blocking.
+ *
+ * OTBN is not busy once it is idle or locked. Call `otbn_busy_wait_for_done()`
+ * afterwards to check the result of the operation.
+ *
+ * @return `kHardenedBoolTrue` if OTBN is busy, `kHardenedBoolFalse` otherwise.
+ */
+hardened_bool_t otbn_is_busy(void);
+
+/**
+ * Enables or disables OTBN's `done` interrupt.
+ *
+ * The interrupt fires at the end of every OTBN command, including the secure
+ * wipes that are part of loading an app.
+ *
+ * @param enable Whether to enable the interrupt.
+ */
+void otbn_irq_done_enable(bool enable);
+
+/**
+ * Acknowledges OTBN's `done` interrupt.
+ */
+void otbn_irq_done_acknowledge(void);
+
 /**
  * Get the error bits set by the device if the operation failed.
  *
@@ -347,11 +372,32 @@ status_t otbn_dmem_sec_wipe(void);
  */
 status_t otbn_set_ctrl_software_errs_fatal(bool enable);
 
+/**
+ * Enables or disables app residency mode.
+ *
+ * In app residency mode, `otbn_load_app()` remembers which application it
+ * loaded. Loading the same application again then only wipes DMEM and
+ * restores the application's data section, instead of also wiping and
+ * rewriting IMEM. The load checksum is still checked against the checksum of
+ * the whole application.
+ *
+ * This mode relies on IMEM not being written other than through this driver
+ * while it is enabled. The resident application is forgotten when IMEM is
+ * wiped through `otbn_imem_sec_wipe()`, when an OTBN operation fails, and
+ * whenever this function is called.
+ *
+ * The mode is disabled at reset.
+ *
+ * @param enable Whether to keep track of the resident application.
+ */
+void otbn_set_app_residency(bool enable);
+
 /**
  * (Re-)loads the provided application into OTBN.
  *
  * Load the application image with both instruction and data segments into
- * OTBN.
+ * OTBN. In app residency mode, IMEM is not rewritten if the application is
+ * already loaded; see `otbn_set_app_residency()`.
  *
  * This function will return an error if called when OTBN is not idle.
  *
@@ -362,68 +362,29 @@ static otcrypto_status_t otcrypto_aes_impl(
   // avoid that multiple cases were executed.
   HARDENED_CHECK_EQ(launder32(aes_operation_started), aes_operation);
 
-  // Perform the cipher operation for all full blocks. The input and output are
-  // offset by `block_offset` number of blocks, where `block_offset` can be 1
-  // or 2. So if unrolled, these loops would look like:
-  //
-  // - block_offset == 1
-  //   aes_update(NULL, input[0]);
-  //   aes_update(output[0], input[1]);
-  //   aes_update(output[1], input[2]);
-  //   aes_update(output[2], NULL);
-  //
-  // - block_offset == 2
-  //   aes_update(NULL, input[0]);
-  //   aes_update(NULL, input[1]);
-  //   aes_update(output[0], input[2]); // The HW is processing input[1].
-  //   aes_update(output[1], input[3]); // The HW is processing input[2].
-  //   aes_update(output[2], NULL);
-  //   aes_update(output[3], NULL);
-  //
-  // Using a `block_offset` of 2 allows having 3 blocks in flight which is
-  // beneficial from a hardening and performance point of view:
-  // - Software retrieves Block x-1 from the data output registers.
-  // - Hardware processes Block x.
-  // - Software provides  Block x+1 via the data input registers.
-  //
-  // See the AES driver for details.
-  const size_t block_offset = input_nblocks >= 3 ? 2 : 1;
+  // Perform the cipher operation for all full blocks of input. The driver
+  // keeps up to three blocks in flight and moves the data directly between
+  // the buffers and the hardware.
+  const size_t full_nblocks = cipher_input.len / kAesBlockNumBytes;
+  HARDENED_CHECK_LE(full_nblocks, input_nblocks);
+  HARDENED_TRY(aes_update_blocks(cipher_output.data, cipher_input.data,
+                                 full_nblocks));
+
+  // Process the remaining block (if any) that needs padding.
   aes_block_t block_in;
   aes_block_t block_out;
   size_t i;
-
-  // Provide the first `block_offset` number of input blocks and call the AES
-  // cipher.
-  for (i = 0; launder32(i) < block_offset; ++i) {
-    HARDENED_TRY(get_block(cipher_input, aes_padding, i, &block_in));
-    HARDENED_TRY(aes_update(/*dest=*/NULL, &block_in));
-  }
-  // Check that the loop ran for the correct number of iterations.
-  HARDENED_CHECK_EQ(i, block_offset);
-
-  // Call the AES cipher while providing new input and copying data to the
-  // output buffer.
-  for (i = block_offset; launder32(i) < input_nblocks; ++i) {
+  for (i = full_nblocks; launder32(i) < input_nblocks; ++i) {
     HARDENED_TRY(get_block(cipher_input, aes_padding, i, &block_in));
     HARDENED_TRY(hardened_memshred(block_out.data, ARRAYSIZE(block_out.data)));
-    HARDENED_TRY(aes_update(&block_out, &block_in));
-    // TODO(#17711) Change to `hardened_memcpy`.
-    memcpy(&cipher_output.data[(i - block_offset) * kAesBlockNumBytes],
-           block_out.data, kAesBlockNumBytes);
-  }
-  // Check that the loop ran for the correct number of iterations.
-  HARDENED_CHECK_EQ(i, input_nblocks);
-
-  // Retrieve the output from the final `block_offset` blocks (providing no
-  // input).
-  for (i = block_offset; i > 0; --i) {
+    HARDENED_TRY(aes_update(/*dest=*/NULL, &block_in));
     HARDENED_TRY(aes_update(&block_out, /*src=*/NULL));
     // TODO(#17711) Change to `hardened_memcpy`.
-    memcpy(&cipher_output.data[(input_nblocks - i) * kAesBlockNumBytes],
-           block_out.data, kAesBlockNumBytes);
+    memcpy(&cipher_output.data[i * kAesBlockNumBytes], block_out.data,
+           kAesBlockNumBytes);
   }
   // Check that the loop ran for the correct number of iterations.
-  HARDENED_CHECK_EQ(launder32(i), 0);
+  HARDENED_CHECK_EQ(i, input_nblocks);
 
   // Verify the CTRL and CTRL_AUX registers.
 
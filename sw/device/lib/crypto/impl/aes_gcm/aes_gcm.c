@@ -121,6 +121,65 @@ static status_t gctr_process_block(const aes_key_t key, aes_block_t *iv,
   return OTCRYPTO_OK;
 }
 
+/**
+ * Run GCTR on a number of full blocks of input.
+ *
+ * Updates the IV in-place.
+ *
+ * For keys with a low security level, the blocks are processed in a single
+ * AES-CTR session with the whole pipeline of the hardware in use. The hardware
+ * increments the whole counter block rather than just its last 32 bits as
+ * inc32() does, so sessions end where the last word of the IV would wrap.
+ * Otherwise, each block is processed and checked separately.
+ *
+ * @param key The AES key
+ * @param iv Initialization vector, 128 bits
+ * @param num_blocks Number of blocks to process
+ * @param input Input buffer, `num_blocks` blocks long
+ * @param security_level Security level configuration
+ * @param[out] output Output buffer, `num_blocks` blocks long
+ */
+OT_WARN_UNUSED_RESULT
+static status_t gctr_process_blocks(
+    const aes_key_t key, aes_block_t *iv, size_t num_blocks,
+    const uint8_t *input, otcrypto_key_security_level_t security_level,
+    uint8_t *output) {
+  if (launder32(security_level) == kOtcryptoKeySecurityLevelLow) {
+    HARDENED_CHECK_EQ(security_level, kOtcryptoKeySecurityLevelLow);
+    while (num_blocks > 0) {
+      uint32_t ctr = __builtin_bswap32(iv->data[kAesBlockNumWords - 1]);
+      // Number of blocks before the counter wraps (zero means 2^32).
+      size_t session_blocks = num_blocks;
+      uint32_t blocks_to_wrap = 0 - ctr;
+      if (blocks_to_wrap != 0 && session_blocks > blocks_to_wrap) {
+        session_blocks = blocks_to_wrap;
+      }
+
+      HARDENED_TRY(aes_encrypt_begin(key, iv));
+      HARDENED_TRY(aes_update_blocks(output, input, session_blocks));
+      HARDENED_TRY(aes_end(NULL));
+
+      iv->data[kAesBlockNumWords - 1] =
+          __builtin_bswap32(ctr + (uint32_t)session_blocks);
+      input += session_blocks * kAesBlockNumBytes;
+      output += session_blocks * kAesBlockNumBytes;
+      num_blocks -= session_blocks;
+    }
+    return OTCRYPTO_OK;
+  }
+  HARDENED_CHECK_NE(security_level, kOtcryptoKeySecurityLevelLow);
+
+  aes_block_t block_in;
+  aes_block_t block_out;
+  for (size_t i = 0; i < num_blocks; i++) {
+    memcpy(block_in.data, &input[i * kAesBlockNumBytes], kAesBlockNumBytes);
+    HARDENED_TRY(
+        gctr_process_block(key, iv, &block_in, security_level, &block_out));
+    memcpy(&output[i * kAesBlockNumBytes], block_out.data, kAesBlockNumBytes);
+  }
+  return OTCRYPTO_OK;
+}
+
 /**
  * Implements the GCTR function as specified in SP800-38D, section 6.5.
  *
@@ -183,16 +242,13 @@ static status_t aes_gcm_gctr(const aes_key_t key, aes_block_t *iv,
     *output_len = kAesBlockNumBytes;
 
     // Process any remaining full blocks of input.
-    while (input_len >= kAesBlockNumBytes) {
-      memcpy(partial->data, input, kAesBlockNumBytes);
-      HARDENED_TRY(
-          gctr_process_block(key, iv, partial, security_level, &block_out));
-      memcpy(output, block_out.data, kAesBlockNumBytes);
-      output += kAesBlockNumBytes;
-      *output_len += kAesBlockNumBytes;
-      input += kAesBlockNumBytes;
-      input_len -= kAesBlockNumBytes;
-    }
+    size_t num_blocks = input_len / kAesBlockNumBytes;
+    HARDENED_TRY(gctr_process_blocks(key, iv, num_blocks, input,
+                                     security_level, output));
+    output += num_blocks * kAesBlockNumBytes;
+    *output_len += num_blocks * kAesBlockNumBytes;
+    input += num_blocks * kAesBlockNumBytes;
+    input_len -= num_blocks * kAesBlockNumBytes;
 
     // Copy any remaining input into the partial block.
     memcpy(partial->data, input, input_len);
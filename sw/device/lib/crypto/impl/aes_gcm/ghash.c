@@ -25,7 +25,31 @@ enum {
    * in a block.
    */
   kNumWindows = kGhashBlockNumBytes << 1,
+  /**
+   * Number of blocks processed together in the aggregated mode.
+   *
+   * Each block in a group is multiplied by a different power of the hash
+   * subkey, which needs its own product table for each share, so the stack
+   * usage grows with this value.
+   */
+  kGhashAggNumBlocks = 4,
+  /**
+   * Minimum number of full blocks for which the aggregated mode is used.
+   *
+   * Below this, the cost of computing the tables for the higher powers of the
+   * hash subkey is larger than what is saved by aggregating.
+   */
+  kGhashAggMinBlocks = 4 * kGhashAggNumBlocks,
 };
+
+// Whether the aggregated mode is used. Only the host benchmark changes this,
+// to compare against processing one block at a time.
+#ifdef OT_GHASH_BENCHMARK
+bool ghash_aggregation_enabled = true;
+#else
+static const bool ghash_aggregation_enabled = true;
+#endif
+
 static_assert(kGhashBlockNumBytes == (1 << kGhashBlockLog2NumBytes),
               "kGhashBlockLog2NumBytes does not match kGhashBlockNumBytes");
 
@@ -204,34 +228,41 @@ void ghash_init(ghash_context_t *ctx) {
 }
 
 /**
- * Multiply the GHASH state by the hash subkey.
+ * Multiply a number of blocks by powers of the hash subkey and sum them up.
  *
  * See NIST SP800-38D, section 6.3.
  *
  * The NIST documentation shows a very slow double-and-add algorithm, which
  * iterates through the first operand bit-by-bit. However, since the second
- * operand is always the hash subkey H, we can speed things up significantly
- * with precomputed tables.
+ * operand is always a (power of the) hash subkey, we can speed things up
+ * significantly with precomputed tables.
+ *
+ * Multiplication is linear, so the products for several blocks can share one
+ * chain of shifts and modular reductions; only the table lookups are done per
+ * block. This is what makes processing several blocks at once faster than
+ * processing them one at a time.
  *
  * This operation corresponds to multiplication in the Galois field with order
  * 2^128, modulo the polynomial x^128 +  x^8 + x^2 + x + 1
  *
- * @param state GHASH state.
- * @param tbl Product table for the masked hash subkey.
- * @return Multiplication of the state and the hash subkey.
+ * @param x Blocks to multiply (`n` blocks).
+ * @param tbl Product tables to multiply the blocks with; `x[i]` is multiplied
+ * with `tbl[i]`.
+ * @param n Number of blocks.
+ * @return Sum of the products.
  */
-static ghash_block_t galois_mul_state_key(ghash_block_t state,
-                                          ghash_block_t tbl[16]) {
+static ghash_block_t galois_mul_sum(const ghash_block_t *x,
+                                    ghash_block_t *const *tbl, size_t n) {
   // Initialize the multiplication result to 0.
   ghash_block_t result;
   memset(result.data, 0, kGhashBlockNumBytes);
 
-  // To compute the product, we iterate through the bytes of the input block,
+  // To compute the product, we iterate through the bytes of the input blocks,
   // considering the most significant (in polynomial terms) first. For each
   // byte b, we:
   //   * multiply `result` by x^8 (shift all coefficients to the right)
   //   * reduce the shifted `result` modulo the field modulus
-  //   * look up the product `b * H` and add it to `result`
+  //   * look up the products `b * H` and add them to `result`
   //
   // We can skip the shift and reduce steps on the first iteration, since
   // `result` is 0.
@@ -251,24 +282,39 @@ static ghash_block_t galois_mul_state_key(ghash_block_t state,
       result.data[0] ^= reduce_term;
     }
 
-    // Add the product of the next window and H to `result`. We process the
+    // Add the products of the next window and H to `result`. We process the
     // windows starting with the most significant polynomial terms, which means
     // starting from the last byte and proceeding to the first.
-    uint8_t tbl_index = block_byte_get(&state, (kNumWindows - 1 - i) >> 1);
-
-    // Select the less significant 4 bits if i is even, or the more significant
-    // 4 bits if i is odd. This does not need to be constant time, since the
-    // values of i in this loop are constant.
-    if ((i & 1) == 1) {
-      tbl_index >>= 4;
-    } else {
-      tbl_index &= 0x0f;
+    size_t byte_index = (kNumWindows - 1 - i) >> 1;
+    for (size_t j = 0; j < n; ++j) {
+      uint8_t tbl_index = block_byte_get(&x[j], byte_index);
+
+      // Select the less significant 4 bits if i is even, or the more
+      // significant 4 bits if i is odd. This does not need to be constant
+      // time, since the values of i in this loop are constant.
+      if ((i & 1) == 1) {
+        tbl_index >>= 4;
+      } else {
+        tbl_index &= 0x0f;
+      }
+      block_xor(&result, &tbl[j][tbl_index], &result);
     }
-    block_xor(&result, &tbl[tbl_index], &result);
   }
   return result;
 }
 
+/**
+ * Multiply the GHASH state by the hash subkey.
+ *
+ * @param state GHASH state.
+ * @param tbl Product table for the masked hash subkey.
+ * @return Multiplication of the state and the hash subkey.
+ */
+static ghash_block_t galois_mul_state_key(ghash_block_t state,
+                                          ghash_block_t tbl[16]) {
+  return galois_mul_sum(&state, &tbl, 1);
+}
+
 /**
  * Single-block update function for GHASH.
  *
@@ -346,9 +392,207 @@ static void ghash_process_block(ghash_context_t *ctx, ghash_block_t *block) {
   ctx->ghash_block_cnt++;
 }
 
-void ghash_process_full_blocks(ghash_context_t *ctx, size_t partial_len,
-                               ghash_block_t *partial, size_t input_len,
-                               const uint8_t *input) {
+/**
+ * Precomputed information for the aggregated mode.
+ *
+ * The powers H^2..H^n of the hash subkey are kept in two shares, like H
+ * itself, and each share has its own product table.
+ */
+typedef struct ghash_key_powers {
+  /**
+   * Product tables for share 0 of H^2..H^n.
+   */
+  ghash_block_t tbl0[kGhashAggNumBlocks - 1][16];
+  /**
+   * Product tables for share 1 of H^2..H^n.
+   */
+  ghash_block_t tbl1[kGhashAggNumBlocks - 1][16];
+  /**
+   * Share 0 product tables to use for each block of a group (H^n..H^1).
+   */
+  ghash_block_t *mul_tbl0[kGhashAggNumBlocks];
+  /**
+   * Share 1 product tables to use for each block of a group (H^n..H^1).
+   */
+  ghash_block_t *mul_tbl1[kGhashAggNumBlocks];
+  /**
+   * Correction term (S0 * (Hn0 + 1)) for state share 0.
+   */
+  ghash_block_t correction_term0;
+  /**
+   * Correction term (S0 * Hn1) for state share 1.
+   */
+  ghash_block_t correction_term1;
+  /**
+   * Integrity checksum over `tbl0` and `correction_term0`.
+   */
+  uint32_t checksum;
+} ghash_key_powers_t;
+
+/**
+ * Compute the integrity checksum of the precomputed powers.
+ *
+ * Like `ghash_context_integrity_checksum`, this only covers share 0.
+ *
+ * @param powers Precomputed powers.
+ * @return Checksum of the powers.
+ */
+static uint32_t ghash_key_powers_checksum(const ghash_key_powers_t *powers) {
+  uint32_t ctx;
+  crc32_init(&ctx);
+  crc32_add(&ctx, (unsigned char *)powers->tbl0, sizeof(powers->tbl0));
+  crc32_add(&ctx, (unsigned char *)&powers->correction_term0,
+            sizeof(powers->correction_term0));
+  return crc32_finish(&ctx);
+}
+
+/**
+ * Check the integrity checksum of the precomputed powers.
+ *
+ * @param powers Precomputed powers.
+ * @return Whether the checksum matches.
+ */
+static hardened_bool_t ghash_key_powers_checksum_check(
+    const ghash_key_powers_t *powers) {
+  if (powers->checksum == launder32(ghash_key_powers_checksum(powers))) {
+    return kHardenedBoolTrue;
+  }
+  return kHardenedBoolFalse;
+}
+
+/**
+ * Compute the powers of the hash subkey for the aggregated mode.
+ *
+ * Given the shares P0 and P1 of P = H^(k-1), the shares of H^k are computed as
+ *   share0 = P0 * H0 + P0 * H1 + R
+ *   share1 = P1 * H0 + P1 * H1 + R
+ * for a fresh random R, so that the two shares of P are never combined.
+ *
+ * @param ctx GHASH context.
+ * @param[out] powers Precomputed powers.
+ */
+static void ghash_key_powers_init(ghash_context_t *ctx,
+                                  ghash_key_powers_t *powers) {
+  // The table entry at index 8 holds 1 * H, i.e. the share itself.
+  ghash_block_t *prev0 = &ctx->tbl0[0x8];
+  ghash_block_t *prev1 = &ctx->tbl1[0x8];
+  for (size_t k = 0; k < kGhashAggNumBlocks - 1; ++k) {
+    ghash_block_t mask;
+    hardened_memshred(mask.data, kGhashBlockNumWords);
+
+    // share0 = P0 * H0 + P0 * H1 + R
+    ghash_block_t share0 = galois_mul_state_key(*prev0, ctx->tbl0);
+    ghash_block_t mul_tmp = galois_mul_state_key(*prev0, ctx->tbl1);
+    block_xor(&share0, &mul_tmp, &share0);
+    block_xor(&share0, &mask, &share0);
+
+    // Clear the RF before operating on the second share to avoid leakage
+    // between both shares.
+    ibex_clear_rf();
+
+    // share1 = P1 * H0 + P1 * H1 + R
+    ghash_block_t share1 = galois_mul_state_key(*prev1, ctx->tbl0);
+    mul_tmp = galois_mul_state_key(*prev1, ctx->tbl1);
+    block_xor(&share1, &mul_tmp, &share1);
+    block_xor(&share1, &mask, &share1);
+
+    ghash_init_subkey(share0.data, powers->tbl0[k]);
+    ghash_init_subkey(share1.data, powers->tbl1[k]);
+    prev0 = &powers->tbl0[k][0x8];
+    prev1 = &powers->tbl1[k][0x8];
+  }
+
+  // The first block of a group is multiplied with H^n and the last with H.
+  for (size_t i = 0; i < kGhashAggNumBlocks - 1; ++i) {
+    powers->mul_tbl0[i] = powers->tbl0[kGhashAggNumBlocks - 2 - i];
+    powers->mul_tbl1[i] = powers->tbl1[kGhashAggNumBlocks - 2 - i];
+  }
+  powers->mul_tbl0[kGhashAggNumBlocks - 1] = ctx->tbl0;
+  powers->mul_tbl1[kGhashAggNumBlocks - 1] = ctx->tbl1;
+
+  // correction_term0 = S0 * (Hn0 + 1).
+  ghash_block_t mul_tmp = galois_mul_state_key(ctx->enc_initial_counter_block0,
+                                               powers->mul_tbl0[0]);
+  block_xor(&mul_tmp, &ctx->enc_initial_counter_block0,
+            &powers->correction_term0);
+
+  // correction_term1 = S0 * Hn1.
+  powers->correction_term1 = galois_mul_state_key(
+      ctx->enc_initial_counter_block0, powers->mul_tbl1[0]);
+
+  powers->checksum = ghash_key_powers_checksum(powers);
+}
+
+/**
+ * Aggregated update function for GHASH.
+ *
+ * Processes `kGhashAggNumBlocks` blocks T1..Tn at once by computing
+ *   Y' = (Y + T1) * H^n + T2 * H^(n-1) + ... + Tn * H
+ * in the same masked form as `ghash_process_block`. Must not be used for the
+ * first block of a GHASH operation.
+ *
+ * @param ctx GHASH context.
+ * @param powers Precomputed powers of the hash subkey.
+ * @param blocks Blocks to incorporate; the first one is modified.
+ */
+static void ghash_process_blocks_aggregated(ghash_context_t *ctx,
+                                            ghash_key_powers_t *powers,
+                                            ghash_block_t *blocks) {
+  HARDENED_CHECK_NE(ctx->ghash_block_cnt, 0);
+
+  // T1 = (share0+T1)+share1
+  hardened_xor_in_place(blocks[0].data, ctx->state0.data, kGhashBlockNumWords);
+  hardened_xor_in_place(blocks[0].data, ctx->state1.data, kGhashBlockNumWords);
+
+  // Process share 0.
+  // share0_tmp = T1 * Hn0 + ... + Tn * H0
+  ghash_block_t s0_tmp =
+      galois_mul_sum(blocks, powers->mul_tbl0, kGhashAggNumBlocks);
+
+  // Apply the correction terms for state share 0.
+  // share0 = share0_tmp + (S0*(Hn0+1))
+  hardened_memcpy(ctx->state0.data, s0_tmp.data, kGhashBlockNumWords);
+  hardened_xor_in_place(ctx->state0.data, powers->correction_term0.data,
+                        kGhashBlockNumWords);
+
+  // Process share 1.
+  // share1_tmp = T1 * Hn1 + ... + Tn * H1
+  ghash_block_t s1_tmp =
+      galois_mul_sum(blocks, powers->mul_tbl1, kGhashAggNumBlocks);
+
+  // Apply the correction terms for state share 1.
+  // share1 = share1_tmp + (S0*Hn1)
+  hardened_memcpy(ctx->state1.data, s1_tmp.data, kGhashBlockNumWords);
+  hardened_xor_in_place(ctx->state1.data, powers->correction_term1.data,
+                        kGhashBlockNumWords);
+
+  // Check that the context's checksum is correct. The context does not change
+  // within a group, so once per group is enough.
+  HARDENED_CHECK_EQ(ghash_context_integrity_checksum_check(ctx),
+                    kHardenedBoolTrue);
+
+  // Increment the number of processed ghash block counter.
+  ctx->ghash_block_cnt += kGhashAggNumBlocks;
+}
+
+/**
+ * Process full blocks, optionally in the aggregated mode.
+ *
+ * See `ghash_process_full_blocks`.
+ *
+ * @param ctx GHASH context.
+ * @param partial_len Length of the partial block.
+ * @param partial Partial block.
+ * @param input_len Number of bytes in the input.
+ * @param input Pointer to input buffer.
+ * @param aggregate Whether the aggregated mode may be used.
+ */
+static void ghash_process_full_blocks_impl(ghash_context_t *ctx,
+                                           size_t partial_len,
+                                           ghash_block_t *partial,
+                                           size_t input_len,
+                                           const uint8_t *input,
+                                           bool aggregate) {
   if (input_len < kGhashBlockNumBytes - partial_len) {
     // Not enough data for a full block; copy into the partial block.
     unsigned char *partial_bytes = (unsigned char *)partial->data;
@@ -364,6 +608,26 @@ void ghash_process_full_blocks(ghash_context_t *ctx, size_t partial_len,
     // Process the block.
     ghash_process_block(ctx, partial);
 
+    // Process groups of full blocks in the aggregated mode if there are
+    // enough of them to make up for the precomputation.
+    if (aggregate && ghash_aggregation_enabled &&
+        input_len / kGhashBlockNumBytes >= kGhashAggMinBlocks) {
+      ghash_key_powers_t powers;
+      ghash_key_powers_init(ctx, &powers);
+      ghash_block_t blocks[kGhashAggNumBlocks];
+      while (input_len >= sizeof(blocks)) {
+        memcpy(blocks, input, sizeof(blocks));
+        ghash_process_blocks_aggregated(ctx, &powers, blocks);
+        input += sizeof(blocks);
+        input_len -= sizeof(blocks);
+      }
+      // The powers don't change after they are computed, so checking them
+      // once before they are discarded catches any corruption while in use.
+      HARDENED_CHECK_EQ(ghash_key_powers_checksum_check(&powers),
+                        kHardenedBoolTrue);
+      hardened_memshred((uint32_t *)&powers, sizeof(powers) / sizeof(uint32_t));
+    }
+
     // Process any remaining full blocks of input.
     while (input_len >= kGhashBlockNumBytes) {
       memcpy(partial->data, input, kGhashBlockNumBytes);
@@ -377,12 +641,30 @@ void ghash_process_full_blocks(ghash_context_t *ctx, size_t partial_len,
   }
 }
 
-void ghash_update(ghash_context_t *ctx, size_t input_len,
-                  const uint8_t *input) {
+void ghash_process_full_blocks(ghash_context_t *ctx, size_t partial_len,
+                               ghash_block_t *partial, size_t input_len,
+                               const uint8_t *input) {
+  ghash_process_full_blocks_impl(ctx, partial_len, partial, input_len, input,
+                                 /*aggregate=*/true);
+}
+
+/**
+ * Update function for GHASH, optionally in the aggregated mode.
+ *
+ * See `ghash_update`.
+ *
+ * @param ctx GHASH context.
+ * @param input_len Number of bytes in the input.
+ * @param input Pointer to input buffer.
+ * @param aggregate Whether the aggregated mode may be used.
+ */
+static void ghash_update_impl(ghash_context_t *ctx, size_t input_len,
+                              const uint8_t *input, bool aggregate) {
   // Process all full blocks and write the remaining non-full data into
   // `partial`.
   ghash_block_t partial = {.data = {0}};
-  ghash_process_full_blocks(ctx, 0, &partial, input_len, input);
+  ghash_process_full_blocks_impl(ctx, 0, &partial, input_len, input,
+                                 aggregate);
 
   // Check if there is data remaining, and process it if so.
   size_t partial_len = input_len % kGhashBlockNumBytes;
@@ -393,15 +675,23 @@ void ghash_update(ghash_context_t *ctx, size_t input_len,
   }
 }
 
+void ghash_update(ghash_context_t *ctx, size_t input_len,
+                  const uint8_t *input) {
+  ghash_update_impl(ctx, input_len, input, /*aggregate=*/true);
+}
+
 void ghash_update_redundant(ghash_context_t *ctx, size_t input_len,
                             const uint8_t *input) {
   // Copy ctx.
   ghash_context_t ctx_redundant;
   memcpy(&ctx_redundant, ctx, sizeof(ctx_redundant));
 
-  ghash_update(ctx, input_len, input);
+  // The aggregated mode masks the powers of the hash subkey with fresh
+  // randomness, so the two runs would end up with different shares. Process
+  // one block at a time instead, which is deterministic for a given context.
+  ghash_update_impl(ctx, input_len, input, /*aggregate=*/false);
 
-  ghash_update(&ctx_redundant, input_len, input);
+  ghash_update_impl(&ctx_redundant, input_len, input, /*aggregate=*/false);
 
   // Compare the GHASH state. Do this only at a single share to avoid
   // introducing SCA leakage. Use consttime_memeq_byte() to avoid DFA.
@@ -169,7 +169,8 @@ void ghash_update(ghash_context_t *ctx, size_t input_len, const uint8_t *input);
 /**
  * Redundant version of ghash_update().
  *
- * Creates a copy of ctx and executes ghash_update() twice.
+ * Creates a copy of ctx and executes ghash_update() twice. Both runs process
+ * one block at a time, so that they produce the same shares.
  * Compares the GHASH state stored in ctx after the redundant comparison.
  * The comparison is done on share s0 to avoid introducing SCA leakage.
  * If the comparison fails, trap.
@@ -4,6 +4,7 @@
 
 #include "sw/device/lib/crypto/impl/aes_gcm/ghash.h"
 
+#include <algorithm>
 #include <array>
 
 #include "gmock/gmock.h"
@@ -371,5 +372,129 @@ TEST(Ghash, McGrawViegaTestCase18) {
   EXPECT_THAT(result, testing::ElementsAreArray(exp_result));
 }
 
+TEST(Ghash, AggregatedMatchesSingleBlocks) {
+  // Hash a long input in one call, which uses the aggregated mode, and one
+  // block at a time, which does not, with non-trivial shares for both the
+  // hash subkey and the encrypted initial counter block.
+  std::array<uint32_t, 4> H0 = {
+      0x05f2beac,
+      0xebb8b479,
+      0xac9b88ce,
+      0xd7da3287,
+  };
+  std::array<uint32_t, 4> H1 = {
+      0xd44be966,
+      0x3b2c8aef,
+      0x59fa4c88,
+      0x2e2b34ca,
+  };
+  std::array<uint32_t, 4> S0 = {
+      0x2fef8d5a,
+      0xf1539e0c,
+      0x53785df7,
+      0x202a9e65,
+  };
+  std::array<uint32_t, 4> S1 = {
+      0xb7c3c00f,
+      0x4544f280,
+      0xf1eba32d,
+      0xde2cd8c5,
+  };
+  // 37 full blocks and a partial one.
+  std::array<uint8_t, 37 * kGhashBlockNumBytes + 5> input;
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<uint8_t>(i * 0x9d + 0x3b);
+  }
+
+  rom_test::MockCrc32 crc32_;
+  EXPECT_CALL(crc32_, Init(testing::NotNull())).Times(testing::AnyNumber());
+  EXPECT_CALL(crc32_, Add(testing::NotNull(), testing::_, testing::_))
+      .Times(testing::AnyNumber());
+  EXPECT_CALL(crc32_, Finish(testing::NotNull()))
+      .WillRepeatedly(testing::Return(0));
+
+  ghash_context_t ctx;
+  ghash_init_subkey(H0.data(), ctx.tbl0);
+  ghash_init_subkey(H1.data(), ctx.tbl1);
+  ghash_handle_enc_initial_counter_block(S0.data(), S1.data(), &ctx);
+  ghash_context_t ctx_single = ctx;
+
+  ghash_init(&ctx);
+  ghash_update(&ctx, input.size(), input.data());
+  uint32_t result[kGhashBlockNumWords];
+  ghash_final(&ctx, result);
+
+  ghash_init(&ctx_single);
+  for (size_t i = 0; i < input.size(); i += kGhashBlockNumBytes) {
+    ghash_update(&ctx_single,
+                 std::min<size_t>(kGhashBlockNumBytes, input.size() - i),
+                 &input[i]);
+  }
+  uint32_t exp_result[kGhashBlockNumWords];
+  ghash_final(&ctx_single, exp_result);
+
+  EXPECT_THAT(result, testing::ElementsAreArray(exp_result));
+}
+
+TEST(Ghash, RedundantUpdateLongInput) {
+  // The redundant update hashes the input twice and compares share 0 of the
+  // two results, so both runs must produce the same shares for an input long
+  // enough for the aggregated mode.
+  std::array<uint32_t, 4> H0 = {
+      0x05f2beac,
+      0xebb8b479,
+      0xac9b88ce,
+      0xd7da3287,
+  };
+  std::array<uint32_t, 4> H1 = {
+      0xd44be966,
+      0x3b2c8aef,
+      0x59fa4c88,
+      0x2e2b34ca,
+  };
+  std::array<uint32_t, 4> S0 = {
+      0x2fef8d5a,
+      0xf1539e0c,
+      0x53785df7,
+      0x202a9e65,
+  };
+  std::array<uint32_t, 4> S1 = {
+      0xb7c3c00f,
+      0x4544f280,
+      0xf1eba32d,
+      0xde2cd8c5,
+  };
+  // 65 full blocks.
+  std::array<uint8_t, 65 * kGhashBlockNumBytes> input;
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<uint8_t>(i * 0x6b + 0x11);
+  }
+
+  rom_test::MockCrc32 crc32_;
+  EXPECT_CALL(crc32_, Init(testing::NotNull())).Times(testing::AnyNumber());
+  EXPECT_CALL(crc32_, Add(testing::NotNull(), testing::_, testing::_))
+      .Times(testing::AnyNumber());
+  EXPECT_CALL(crc32_, Finish(testing::NotNull()))
+      .WillRepeatedly(testing::Return(0));
+
+  ghash_context_t ctx;
+  ghash_init_subkey(H0.data(), ctx.tbl0);
+  ghash_init_subkey(H1.data(), ctx.tbl1);
+  ghash_handle_enc_initial_counter_block(S0.data(), S1.data(), &ctx);
+  ghash_context_t ctx_plain = ctx;
+
+  ghash_init(&ctx);
+  ghash_update_redundant(&ctx, input.size(), input.data());
+  uint32_t result[kGhashBlockNumWords];
+  ghash_final(&ctx, result);
+
+  ghash_init(&ctx_plain);
+  ghash_update(&ctx_plain, input.size(), input.data());
+  uint32_t exp_result[kGhashBlockNumWords];
+  ghash_final(&ctx_plain, exp_result);
+
+  EXPECT_THAT(result, testing::ElementsAreArray(exp_result));
+}
+
 }  // namespace
 }  // namespace ghash_unittest
@@ -0,0 +1,235 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/lib/crypto/include/async_job.h"
+
+#include "sw/device/lib/base/csr.h"
+#include "sw/device/lib/base/hardened.h"
+#include "sw/device/lib/crypto/drivers/otbn.h"
+#include "sw/device/lib/crypto/impl/status.h"
+#include "sw/device/lib/crypto/include/datatypes.h"
+#include "sw/device/lib/runtime/hart.h"
+
+// Module ID for status codes.
+#define MODULE_ID MAKE_MODULE_ID('a', 'j', 'b')
+
+enum {
+  /**
+   * Global machine-mode interrupt enable bit (MIE) in the MSTATUS CSR.
+   */
+  kMstatusMieMask = 1 << 3,
+};
+
+/**
+ * Queue of submitted jobs that are not done yet.
+ *
+ * The job at the head is the only one that may be running on OTBN.
+ */
+static otcrypto_async_job_t *queue_head = NULL;
+static otcrypto_async_job_t *queue_tail = NULL;
+
+/**
+ * Whether the job at the head of the queue has been started.
+ */
+static hardened_bool_t head_running = kHardenedBoolFalse;
+
+/**
+ * Whether the queue is advanced from OTBN's `done` interrupt.
+ */
+static hardened_bool_t irq_enabled = kHardenedBoolFalse;
+
+/**
+ * Marks the job at the head of the queue as done and removes it.
+ *
+ * @param status Result of the job.
+ */
+static void queue_pop(otcrypto_status_t status) {
+  otcrypto_async_job_t *job = queue_head;
+  queue_head = job->next;
+  if (queue_head == NULL) {
+    queue_tail = NULL;
+  }
+  head_running = kHardenedBoolFalse;
+  job->next = NULL;
+  job->status = status;
+  job->done = kHardenedBoolTrue;
+}
+
+/**
+ * Finalizes the running job if OTBN is done and starts the following ones.
+ *
+ * Jobs whose `start` function fails are completed immediately with that
+ * error, and the next job is started in their place. If OTBN is busy with
+ * something that was not started from the queue, the head job waits.
+ *
+ * Must not be interrupted by `otcrypto_async_job_irq_handler`.
+ *
+ * @return OK if the queue is empty, `OTCRYPTO_ASYNC_INCOMPLETE` otherwise.
+ */
+static otcrypto_status_t queue_advance(void) {
+  while (queue_head != NULL) {
+    if (otbn_is_busy() == kHardenedBoolTrue) {
+      return OTCRYPTO_ASYNC_INCOMPLETE;
+    }
+    if (head_running == kHardenedBoolTrue) {
+      queue_pop(queue_head->finalize(queue_head->arg));
+      continue;
+    }
+    otcrypto_status_t err = queue_head->start(queue_head->arg);
+    if (!status_ok(err)) {
+      queue_pop(err);
+      continue;
+    }
+    head_running = kHardenedBoolTrue;
+  }
+  return OTCRYPTO_OK;
+}
+
+/**
+ * Masks OTBN's `done` interrupt while the queue is changed outside of it.
+ */
+static void queue_lock(void) {
+  if (irq_enabled == kHardenedBoolTrue) {
+    otbn_irq_done_enable(false);
+  }
+}
+
+/**
+ * Unmasks OTBN's `done` interrupt again after `queue_lock`.
+ *
+ * If OTBN finished in the meantime, the interrupt is still pending and fires
+ * right away.
+ */
+static void queue_unlock(void) {
+  if (irq_enabled == kHardenedBoolTrue) {
+    otbn_irq_done_enable(true);
+  }
+}
+
+/**
+ * Checks whether a job is in the queue.
+ *
+ * Must be called between `queue_lock` and `queue_unlock`.
+ *
+ * @param job Job to look for.
+ * @return True if the job has been submitted and is not done yet.
+ */
+static bool queue_contains(const otcrypto_async_job_t *job) {
+  for (const otcrypto_async_job_t *it = queue_head; it != NULL;
+       it = it->next) {
+    if (it == job) {
+      return true;
+    }
+  }
+  return false;
+}
+
+otcrypto_status_t otcrypto_async_job_submit(otcrypto_async_job_t *job,
+                                            otcrypto_async_job_fn_t start,
+                                            otcrypto_async_job_fn_t finalize,
+                                            void *arg) {
+  if (job == NULL || start == NULL || finalize == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+
+  queue_lock();
+  // Resubmitting a job that is still queued would link it into the queue a
+  // second time and could create a cycle.
+  if (queue_contains(job)) {
+    queue_unlock();
+    return OTCRYPTO_BAD_ARGS;
+  }
+  job->start = start;
+  job->finalize = finalize;
+  job->arg = arg;
+  job->done = kHardenedBoolFalse;
+  job->status = OTCRYPTO_ASYNC_INCOMPLETE;
+  job->next = NULL;
+
+  if (queue_tail == NULL) {
+    queue_head = job;
+  } else {
+    queue_tail->next = job;
+  }
+  queue_tail = job;
+  // Errors from starting the job are reported through the job itself.
+  queue_advance();
+  queue_unlock();
+  return OTCRYPTO_OK;
+}
+
+otcrypto_status_t otcrypto_async_job_poll(void) {
+  queue_lock();
+  otcrypto_status_t res = queue_advance();
+  queue_unlock();
+  return res;
+}
+
+/**
+ * Sleeps until an interrupt is pending, unless the job is already done.
+ *
+ * Interrupts are disabled while `done` is checked, so that the `done`
+ * interrupt cannot be taken between the check and `wfi`. `wfi` still wakes up
+ * on a pending interrupt in that state; the handler runs once interrupts are
+ * enabled again.
+ *
+ * @param job Job being waited for.
+ */
+static void queue_sleep(const otcrypto_async_job_t *job) {
+  uint32_t mstatus;
+  CSR_READ(CSR_REG_MSTATUS, &mstatus);
+  CSR_CLEAR_BITS(CSR_REG_MSTATUS, kMstatusMieMask);
+  if (job->done != kHardenedBoolTrue) {
+    wait_for_interrupt();
+  }
+  if ((mstatus & kMstatusMieMask) != 0) {
+    CSR_SET_BITS(CSR_REG_MSTATUS, kMstatusMieMask);
+  }
+}
+
+otcrypto_status_t otcrypto_async_job_wait(otcrypto_async_job_t *job) {
+  if (job == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  queue_lock();
+  bool queued = queue_contains(job);
+  queue_unlock();
+  if (!queued && job->done != kHardenedBoolTrue) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+
+  while (job->done != kHardenedBoolTrue) {
+    if (irq_enabled == kHardenedBoolTrue) {
+      queue_sleep(job);
+    } else {
+      // Without the interrupt, this thread has to advance the queue. The
+      // result is read from the job instead.
+      queue_lock();
+      queue_advance();
+      queue_unlock();
+    }
+  }
+  return job->status;
+}
+
+void otcrypto_async_job_irq_enable(hardened_bool_t enable) {
+  if (enable == kHardenedBoolTrue) {
+    // OTBN may already be done with the head job, in which case no further
+    // interrupt would come for it.
+    otbn_irq_done_acknowledge();
+    queue_advance();
+    irq_enabled = kHardenedBoolTrue;
+    otbn_irq_done_enable(true);
+  } else {
+    otbn_irq_done_enable(false);
+    irq_enabled = kHardenedBoolFalse;
+  }
+}
+
+void otcrypto_async_job_irq_handler(void) {
+  // Acknowledge first; if a job started below finishes before the handler
+  // returns, the interrupt is raised again instead of being lost.
+  otbn_irq_done_acknowledge();
+  queue_advance();
+}
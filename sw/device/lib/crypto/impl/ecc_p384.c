@@ -10,6 +10,7 @@
 #include "sw/device/lib/crypto/impl/ecc/p384.h"
 #include "sw/device/lib/crypto/impl/integrity.h"
 #include "sw/device/lib/crypto/impl/keyblob.h"
+#include "sw/device/lib/crypto/include/async_job.h"
 #include "sw/device/lib/crypto/include/datatypes.h"
 
 // Module ID for status codes.
@@ -595,3 +596,103 @@ otcrypto_status_t otcrypto_ecdh_p384_async_finalize(
   // Clear the OTBN sideload slot (in case the seed was sideloaded).
   return keymgr_sideload_clear_otbn();
 }
+
+static otcrypto_status_t ecdsa_p384_keygen_job_start(void *arg) {
+  otcrypto_ecdsa_p384_keygen_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_keygen_async_start(args->private_key);
+}
+
+static otcrypto_status_t ecdsa_p384_keygen_job_finalize(void *arg) {
+  otcrypto_ecdsa_p384_keygen_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_keygen_async_finalize(args->private_key,
+                                                   args->public_key);
+}
+
+otcrypto_status_t otcrypto_ecdsa_p384_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p384_keygen_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, ecdsa_p384_keygen_job_start,
+                                   ecdsa_p384_keygen_job_finalize, args);
+}
+
+static otcrypto_status_t ecdsa_p384_sign_job_start(void *arg) {
+  otcrypto_ecdsa_p384_sign_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_sign_async_start(args->private_key,
+                                              args->message_digest);
+}
+
+static otcrypto_status_t ecdsa_p384_sign_job_finalize(void *arg) {
+  otcrypto_ecdsa_p384_sign_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_sign_async_finalize(args->signature);
+}
+
+otcrypto_status_t otcrypto_ecdsa_p384_sign_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p384_sign_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, ecdsa_p384_sign_job_start,
+                                   ecdsa_p384_sign_job_finalize, args);
+}
+
+static otcrypto_status_t ecdsa_p384_verify_job_start(void *arg) {
+  otcrypto_ecdsa_p384_verify_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_verify_async_start(
+      args->public_key, args->message_digest, args->signature);
+}
+
+static otcrypto_status_t ecdsa_p384_verify_job_finalize(void *arg) {
+  otcrypto_ecdsa_p384_verify_job_args_t *args = arg;
+  return otcrypto_ecdsa_p384_verify_async_finalize(args->signature,
+                                                   args->verification_result);
+}
+
+otcrypto_status_t otcrypto_ecdsa_p384_verify_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p384_verify_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, ecdsa_p384_verify_job_start,
+                                   ecdsa_p384_verify_job_finalize, args);
+}
+
+static otcrypto_status_t ecdh_p384_keygen_job_start(void *arg) {
+  otcrypto_ecdh_p384_keygen_job_args_t *args = arg;
+  return otcrypto_ecdh_p384_keygen_async_start(args->private_key);
+}
+
+static otcrypto_status_t ecdh_p384_keygen_job_finalize(void *arg) {
+  otcrypto_ecdh_p384_keygen_job_args_t *args = arg;
+  return otcrypto_ecdh_p384_keygen_async_finalize(args->private_key,
+                                                  args->public_key);
+}
+
+otcrypto_status_t otcrypto_ecdh_p384_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdh_p384_keygen_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, ecdh_p384_keygen_job_start,
+                                   ecdh_p384_keygen_job_finalize, args);
+}
+
+static otcrypto_status_t ecdh_p384_job_start(void *arg) {
+  otcrypto_ecdh_p384_job_args_t *args = arg;
+  return otcrypto_ecdh_p384_async_start(args->private_key, args->public_key);
+}
+
+static otcrypto_status_t ecdh_p384_job_finalize(void *arg) {
+  otcrypto_ecdh_p384_job_args_t *args = arg;
+  return otcrypto_ecdh_p384_async_finalize(args->shared_secret);
+}
+
+otcrypto_status_t otcrypto_ecdh_p384_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdh_p384_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, ecdh_p384_job_start,
+                                   ecdh_p384_job_finalize, args);
+}
@@ -13,6 +13,7 @@
 #include "sw/device/lib/crypto/impl/rsa/run_rsa.h"
 #include "sw/device/lib/crypto/impl/rsa/run_rsa_key_from_cofactor.h"
 #include "sw/device/lib/crypto/impl/status.h"
+#include "sw/device/lib/crypto/include/async_job.h"
 #include "sw/device/lib/crypto/include/datatypes.h"
 
 // Module ID for status codes.
@@ -1051,3 +1052,127 @@ otcrypto_status_t otcrypto_rsa_decrypt_async_finalize(
 
   return OTCRYPTO_OK;
 }
+
+static otcrypto_status_t rsa_keygen_job_start(void *arg) {
+  otcrypto_rsa_keygen_job_args_t *args = arg;
+  return otcrypto_rsa_keygen_async_start(args->size);
+}
+
+static otcrypto_status_t rsa_keygen_job_finalize(void *arg) {
+  otcrypto_rsa_keygen_job_args_t *args = arg;
+  return otcrypto_rsa_keygen_async_finalize(args->public_key,
+                                            args->private_key);
+}
+
+otcrypto_status_t otcrypto_rsa_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_keygen_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_keygen_job_start,
+                                   rsa_keygen_job_finalize, args);
+}
+
+static otcrypto_status_t rsa_keypair_from_cofactor_job_start(void *arg) {
+  otcrypto_rsa_keypair_from_cofactor_job_args_t *args = arg;
+  return otcrypto_rsa_keypair_from_cofactor_async_start(
+      args->size, args->modulus, args->cofactor_share0,
+      args->cofactor_share1);
+}
+
+static otcrypto_status_t rsa_keypair_from_cofactor_job_finalize(void *arg) {
+  otcrypto_rsa_keypair_from_cofactor_job_args_t *args = arg;
+  return otcrypto_rsa_keypair_from_cofactor_async_finalize(args->public_key,
+                                                           args->private_key);
+}
+
+otcrypto_status_t otcrypto_rsa_keypair_from_cofactor_job_submit(
+    otcrypto_async_job_t *job,
+    otcrypto_rsa_keypair_from_cofactor_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_keypair_from_cofactor_job_start,
+                                   rsa_keypair_from_cofactor_job_finalize,
+                                   args);
+}
+
+static otcrypto_status_t rsa_sign_job_start(void *arg) {
+  otcrypto_rsa_sign_job_args_t *args = arg;
+  return otcrypto_rsa_sign_async_start(args->private_key, args->message_digest,
+                                       args->padding_mode);
+}
+
+static otcrypto_status_t rsa_sign_job_finalize(void *arg) {
+  otcrypto_rsa_sign_job_args_t *args = arg;
+  return otcrypto_rsa_sign_async_finalize(args->signature);
+}
+
+otcrypto_status_t otcrypto_rsa_sign_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_sign_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_sign_job_start,
+                                   rsa_sign_job_finalize, args);
+}
+
+static otcrypto_status_t rsa_verify_job_start(void *arg) {
+  otcrypto_rsa_verify_job_args_t *args = arg;
+  return otcrypto_rsa_verify_async_start(args->public_key, args->signature);
+}
+
+static otcrypto_status_t rsa_verify_job_finalize(void *arg) {
+  otcrypto_rsa_verify_job_args_t *args = arg;
+  return otcrypto_rsa_verify_async_finalize(
+      args->message_digest, args->padding_mode, args->verification_result);
+}
+
+otcrypto_status_t otcrypto_rsa_verify_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_verify_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_verify_job_start,
+                                   rsa_verify_job_finalize, args);
+}
+
+static otcrypto_status_t rsa_encrypt_job_start(void *arg) {
+  otcrypto_rsa_encrypt_job_args_t *args = arg;
+  return otcrypto_rsa_encrypt_async_start(args->public_key, args->hash_mode,
+                                          args->message, args->label);
+}
+
+static otcrypto_status_t rsa_encrypt_job_finalize(void *arg) {
+  otcrypto_rsa_encrypt_job_args_t *args = arg;
+  return otcrypto_rsa_encrypt_async_finalize(args->ciphertext);
+}
+
+otcrypto_status_t otcrypto_rsa_encrypt_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_encrypt_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_encrypt_job_start,
+                                   rsa_encrypt_job_finalize, args);
+}
+
+static otcrypto_status_t rsa_decrypt_job_start(void *arg) {
+  otcrypto_rsa_decrypt_job_args_t *args = arg;
+  return otcrypto_rsa_decrypt_async_start(args->private_key, args->ciphertext);
+}
+
+static otcrypto_status_t rsa_decrypt_job_finalize(void *arg) {
+  otcrypto_rsa_decrypt_job_args_t *args = arg;
+  return otcrypto_rsa_decrypt_async_finalize(
+      args->hash_mode, args->label, args->plaintext, args->plaintext_bytelen);
+}
+
+otcrypto_status_t otcrypto_rsa_decrypt_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_decrypt_job_args_t *args) {
+  if (args == NULL) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+  return otcrypto_async_job_submit(job, rsa_decrypt_job_start,
+                                   rsa_decrypt_job_finalize, args);
+}
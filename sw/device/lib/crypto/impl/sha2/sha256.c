@@ -15,16 +15,6 @@
 // Module ID for status codes.
 #define MODULE_ID MAKE_MODULE_ID('s', '2', '2')
 
-enum {
-  /**
-   * Maximum number of message chunks that the OTBN app can accept.
-   *
-   * This number is based on the DMEM size limit and usage by the SHA-256 app
-   * itself; see `run_sha256.s` for the detailed calculation.
-   */
-  kSha256MaxMessageChunksPerOtbnRun = 41,
-};
-
 /**
  * A type to hold message blocks.
  */
@@ -339,3 +329,193 @@ status_t sha256(const uint8_t *msg, const size_t msg_len, uint32_t *digest) {
   HARDENED_TRY(state_shred(&state));
   return OTCRYPTO_OK;
 }
+
+status_t sha256_stream_init(sha256_stream_t *stream) {
+  stream->buffer_len = 0;
+  stream->total_len = 0ull;
+  stream->otbn_loaded = kHardenedBoolFalse;
+  stream->otbn_running = kHardenedBoolFalse;
+  return OTCRYPTO_OK;
+}
+
+/**
+ * Wait for OTBN to finish the batch it is processing, if any.
+ *
+ * @param stream Context object (updated in place).
+ * @return Result of the operation.
+ */
+static status_t stream_wait(sha256_stream_t *stream) {
+  if (launder32(stream->otbn_running) == kHardenedBoolTrue) {
+    HARDENED_CHECK_EQ(stream->otbn_running, kHardenedBoolTrue);
+    HARDENED_TRY_WIPE_DMEM(otbn_busy_wait_for_done());
+    stream->otbn_running = kHardenedBoolFalse;
+  }
+  return OTCRYPTO_OK;
+}
+
+/**
+ * Load the SHA-256 app into OTBN, unless this operation already has.
+ *
+ * The hash state stays in DMEM after that, so this is the only step that can
+ * fail because OTBN is busy with something else. It has no other effect on
+ * the stream, so callers do it before they change the stream.
+ *
+ * @param stream Context object (updated in place).
+ * @return Result of the operation; OTCRYPTO_ASYNC_INCOMPLETE if OTBN is busy.
+ */
+static status_t stream_load_app(sha256_stream_t *stream) {
+  if (launder32(stream->otbn_loaded) != kHardenedBoolTrue) {
+    HARDENED_TRY(otbn_load_app(kOtbnAppSha256));
+    stream->otbn_loaded = kHardenedBoolTrue;
+  }
+  return OTCRYPTO_OK;
+}
+
+/**
+ * Hand the first blocks of the buffer to OTBN and start processing them.
+ *
+ * OTBN must not be running a batch of this operation. Loads the SHA-256 app
+ * for the first batch. Any data after the handed-over blocks is moved to the
+ * start of the buffer.
+ *
+ * @param stream Context object (updated in place).
+ * @param num_blocks Number of full blocks to process.
+ * @return Result of the operation.
+ */
+static status_t stream_start_batch(sha256_stream_t *stream,
+                                   size_t num_blocks) {
+  HARDENED_CHECK_NE(stream->otbn_running, kHardenedBoolTrue);
+  HARDENED_CHECK_LE(num_blocks, kSha256MaxMessageChunksPerOtbnRun);
+  HARDENED_CHECK_LE(num_blocks * kSha256MessageBlockBytes, stream->buffer_len);
+
+  // Load the SHA-256 app. Fails if OTBN is non-idle.
+  HARDENED_TRY(stream_load_app(stream));
+
+  // Copy the message blocks and their number into DMEM and run the program.
+  uint32_t num_msg_chunks = num_blocks;
+  HARDENED_TRY_WIPE_DMEM(otbn_dmem_write(num_blocks * kSha256MessageBlockWords,
+                                         stream->buffer, kOtbnVarSha256Msg));
+  HARDENED_TRY_WIPE_DMEM(
+      otbn_dmem_write(1, &num_msg_chunks, kOtbnVarSha256NumMsgChunks));
+  HARDENED_TRY_WIPE_DMEM(otbn_execute());
+  stream->otbn_running = kHardenedBoolTrue;
+
+  // Move the remaining partial data, if any, to the start of the buffer. It
+  // is shorter than a block, so the source and destination do not overlap.
+  size_t used_len = num_blocks * kSha256MessageBlockBytes;
+  stream->buffer_len -= used_len;
+  memcpy(stream->buffer, (unsigned char *)stream->buffer + used_len,
+         stream->buffer_len);
+  return OTCRYPTO_OK;
+}
+
+status_t sha256_stream_update(sha256_stream_t *stream, const uint8_t *msg,
+                              size_t msg_len) {
+  // Check the message length. SHA-256 messages must be less than 2^64 bits
+  // long in total.
+  uint64_t msg_bits = ((uint64_t)msg_len) << 3;
+  uint64_t max_msg_bits = UINT64_MAX - stream->total_len;
+  if (msg_bits > max_msg_bits) {
+    return OTCRYPTO_BAD_ARGS;
+  }
+
+  // If this message fills the buffer, a batch has to be started. Load the app
+  // first, so that if OTBN is busy with something else, nothing has been
+  // consumed yet and the call can be retried.
+  if (msg_len >= sizeof(stream->buffer) - stream->buffer_len) {
+    HARDENED_TRY(stream_load_app(stream));
+  }
+  stream->total_len += msg_bits;
+
+  while (msg_len > 0) {
+    size_t copy_len = sizeof(stream->buffer) - stream->buffer_len;
+    if (copy_len > msg_len) {
+      copy_len = msg_len;
+    }
+    memcpy((unsigned char *)stream->buffer + stream->buffer_len, msg,
+           copy_len);
+    stream->buffer_len += copy_len;
+    msg += copy_len;
+    msg_len -= copy_len;
+
+    // Once the buffer is full, hand it over as soon as OTBN has finished the
+    // previous batch.
+    if (stream->buffer_len == sizeof(stream->buffer)) {
+      HARDENED_TRY(stream_wait(stream));
+      HARDENED_TRY(
+          stream_start_batch(stream, kSha256MaxMessageChunksPerOtbnRun));
+    }
+  }
+  return OTCRYPTO_OK;
+}
+
+status_t sha256_stream_poll(sha256_stream_t *stream) {
+  if (launder32(stream->otbn_running) == kHardenedBoolTrue) {
+    if (otbn_is_busy() == kHardenedBoolTrue) {
+      return OTCRYPTO_ASYNC_INCOMPLETE;
+    }
+    HARDENED_TRY(stream_wait(stream));
+  }
+
+  size_t num_blocks = stream->buffer_len / kSha256MessageBlockBytes;
+  if (num_blocks > 0) {
+    HARDENED_TRY(stream_start_batch(stream, num_blocks));
+    return OTCRYPTO_ASYNC_INCOMPLETE;
+  }
+  return OTCRYPTO_OK;
+}
+
+status_t sha256_stream_final(sha256_stream_t *stream, uint32_t *digest) {
+  // Entropy complex needs to be initialized for `state_shred`.
+  HARDENED_TRY(entropy_complex_check());
+  HARDENED_TRY(stream_wait(stream));
+  // As in sha256_stream_update, load the app before changing the stream.
+  HARDENED_TRY(stream_load_app(stream));
+
+  // Padding (see FIPS 180-4, section 5.1.1) takes one or two blocks. If there
+  // is not enough space left for it, process the full blocks first.
+  size_t num_blocks = stream->buffer_len / kSha256MessageBlockBytes;
+  size_t partial_block_len = stream->buffer_len % kSha256MessageBlockBytes;
+  size_t num_padding_blocks = 1;
+  if (partial_block_len + 1 + sizeof(stream->total_len) >
+      kSha256MessageBlockBytes) {
+    num_padding_blocks = 2;
+  }
+  if (num_blocks + num_padding_blocks > kSha256MaxMessageChunksPerOtbnRun) {
+    HARDENED_TRY(stream_start_batch(stream, num_blocks));
+    HARDENED_TRY(stream_wait(stream));
+    num_blocks = 0;
+  }
+
+  // Fill the rest of the padding blocks with a 1 bit followed by zeroes, and
+  // set the last 64 bits to the bit-length in big-endian form.
+  num_blocks += num_padding_blocks;
+  unsigned char *data_end =
+      (unsigned char *)stream->buffer + stream->buffer_len;
+  size_t padded_len = num_blocks * kSha256MessageBlockBytes;
+  memset(data_end, 0, padded_len - stream->buffer_len);
+  memset(data_end, 0x80, 1);
+  size_t last_word = num_blocks * kSha256MessageBlockWords - 1;
+  stream->buffer[last_word] = __builtin_bswap32(stream->total_len & UINT32_MAX);
+  stream->buffer[last_word - 1] = __builtin_bswap32(stream->total_len >> 32);
+  stream->buffer_len = padded_len;
+
+  // Process the last blocks.
+  HARDENED_TRY(stream_start_batch(stream, num_blocks));
+  HARDENED_TRY(stream_wait(stream));
+
+  // Read the final state from OTBN dmem and clear OTBN's memory.
+  sha256_state_t state;
+  HARDENED_TRY_WIPE_DMEM(
+      otbn_dmem_read(kSha256StateWords, kOtbnVarSha256State, state.H));
+  HARDENED_TRY(otbn_dmem_sec_wipe());
+
+  // Retrieve the final digest and destroy the state.
+  HARDENED_TRY(digest_get(&state, digest));
+  HARDENED_TRY(state_shred(&state));
+  HARDENED_TRY(hardened_memshred(stream->buffer, ARRAYSIZE(stream->buffer)));
+  stream->buffer_len = 0;
+  stream->total_len = 0;
+  stream->otbn_loaded = kHardenedBoolFalse;
+  return OTCRYPTO_OK;
+}
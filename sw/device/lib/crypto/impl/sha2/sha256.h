@@ -50,6 +50,13 @@ enum {
    * SHA-256 digest size in words.
    */
   kSha256DigestWords = kSha256DigestBytes / sizeof(uint32_t),
+  /**
+   * Maximum number of message chunks that the OTBN app can accept.
+   *
+   * This number is based on the DMEM size limit and usage by the SHA-256 app
+   * itself; see `run_sha256.s` for the detailed calculation.
+   */
+  kSha256MaxMessageChunksPerOtbnRun = 41,
 };
 
 /**
@@ -143,6 +150,112 @@ status_t sha256_update(sha256_state_t *state, const uint8_t *msg,
 OT_WARN_UNUSED_RESULT
 status_t sha256_final(sha256_state_t *state, uint32_t *digest);
 
+/**
+ * A type that holds the context for a pipelined SHA-256 operation.
+ *
+ * OTBN's DMEM cannot be written while OTBN is running, so message data is
+ * collected in `buffer` while OTBN hashes the previous batch, and then copied
+ * into DMEM in one go. The hash state stays in DMEM for the whole operation.
+ */
+typedef struct sha256_stream {
+  /**
+   * Message data that has not been handed to OTBN yet.
+   */
+  uint32_t buffer[kSha256MaxMessageChunksPerOtbnRun * kSha256MessageBlockWords];
+  /**
+   * Number of bytes in `buffer`.
+   */
+  size_t buffer_len;
+  /**
+   * Total message length so far, in bits.
+   */
+  uint64_t total_len;
+  /**
+   * Whether the SHA-256 app has been loaded into OTBN for this operation.
+   */
+  hardened_bool_t otbn_loaded;
+  /**
+   * Whether OTBN may still be processing a batch of this operation.
+   */
+  hardened_bool_t otbn_running;
+} sha256_stream_t;
+
+/**
+ * Set up a pipelined SHA-256 hash computation.
+ *
+ * This interface expects the following sequence of calls:
+ * - one call to sha256_stream_init()
+ * - zero or more calls to sha256_stream_update() and sha256_stream_poll()
+ * - one call to sha256_stream_final()
+ *
+ * Unlike sha256_update(), the update function returns while OTBN may still
+ * be hashing, so the caller can, for instance, fetch the next part of the
+ * message in the meantime. OTBN must not be used for anything else until
+ * sha256_stream_final() has returned. If any call returns an error other
+ * than OTCRYPTO_ASYNC_INCOMPLETE, the operation must be abandoned.
+ *
+ * OTCRYPTO_ASYNC_INCOMPLETE from sha256_stream_update() or
+ * sha256_stream_final() means that OTBN was busy with something else when
+ * the SHA-256 app had to be loaded. The stream is then exactly as it was
+ * before the call, and the same call can be repeated later.
+ *
+ * Does not use OTBN.
+ *
+ * @param[out] stream Context object to initialize.
+ * @return Result of the operation (OK or error).
+ */
+OT_WARN_UNUSED_RESULT
+status_t sha256_stream_init(sha256_stream_t *stream);
+
+/**
+ * Process new message data for a pipelined SHA-256 hash computation.
+ *
+ * Only waits for OTBN when the buffer is full and OTBN is still hashing the
+ * previous batch. OTBN may be running when this returns.
+ *
+ * Returns OTCRYPTO_ASYNC_INCOMPLETE, without consuming any of the message, if
+ * the message would start the first batch and OTBN is busy with something
+ * else. The call can then be repeated with the same message.
+ *
+ * @param stream Context object; updated in-place.
+ * @param msg Input message.
+ * @param msg_len Input message length in bytes.
+ * @return Result of the operation (OK or error).
+ */
+OT_WARN_UNUSED_RESULT
+status_t sha256_stream_update(sha256_stream_t *stream, const uint8_t *msg,
+                              size_t msg_len);
+
+/**
+ * Advance a pipelined SHA-256 hash computation without blocking.
+ *
+ * If OTBN has finished its batch, hands any full blocks in the buffer to it.
+ *
+ * @param stream Context object; updated in-place.
+ * @return OTCRYPTO_ASYNC_INCOMPLETE while OTBN is hashing, OK once all full
+ * blocks received so far have been hashed, or an error.
+ */
+OT_WARN_UNUSED_RESULT
+status_t sha256_stream_poll(sha256_stream_t *stream);
+
+/**
+ * Finish a pipelined SHA-256 hash computation.
+ *
+ * Waits for OTBN, pads and hashes the remaining data, and wipes DMEM.
+ *
+ * Returns OTCRYPTO_ASYNC_INCOMPLETE, leaving the stream unchanged, if no batch
+ * has been started yet and OTBN is busy with something else.
+ *
+ * The caller must ensure that at least `kSha256DigestBytes` bytes of space are
+ * available at the location pointed to by `digest`.
+ *
+ * @param stream Context object.
+ * @param[out] digest Output buffer for digest.
+ * @return Result of the operation (OK or error).
+ */
+OT_WARN_UNUSED_RESULT
+status_t sha256_stream_final(sha256_stream_t *stream, uint32_t *digest);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
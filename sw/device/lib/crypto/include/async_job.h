@@ -0,0 +1,143 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_ASYNC_JOB_H_
+#define OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_ASYNC_JOB_H_
+
+#include "datatypes.h"
+
+/**
+ * @file
+ * @brief Queue of asynchronous jobs for OpenTitan cryptography library.
+ *
+ * Operations that run on OTBN (ECC, RSA) have `_async_start` and
+ * `_async_finalize` functions. This interface queues such start/finalize
+ * pairs as jobs and runs them one after the other on OTBN, so that the caller
+ * can do other work in the meantime. The queue is advanced either by polling
+ * or from OTBN's `done` interrupt.
+ *
+ * While jobs are queued, OTBN must not be used other than through the queue.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * Function to start or finalize an asynchronous operation.
+ *
+ * Typically a wrapper that calls an `_async_start` or `_async_finalize`
+ * function with arguments taken from `arg`.
+ *
+ * @param arg Argument given when the job was submitted.
+ * @return Result of the start or finalize operation.
+ */
+typedef otcrypto_status_t (*otcrypto_async_job_fn_t)(void *arg);
+
+/**
+ * An asynchronous job.
+ *
+ * The struct is owned by the caller and must stay valid until the job is done.
+ * Representation is internal to the queue, except that `done` and `status`
+ * may be read by the caller.
+ */
+typedef struct otcrypto_async_job {
+  /**
+   * Starts the operation on OTBN.
+   */
+  otcrypto_async_job_fn_t start;
+  /**
+   * Retrieves the results of the operation once OTBN is done.
+   */
+  otcrypto_async_job_fn_t finalize;
+  /**
+   * Argument for `start` and `finalize`.
+   */
+  void *arg;
+  /**
+   * Whether the job is done.
+   */
+  volatile hardened_bool_t done;
+  /**
+   * Result of the job, valid once `done` is `kHardenedBoolTrue`.
+   *
+   * This is the result of `start` if it failed, and of `finalize` otherwise.
+   */
+  otcrypto_status_t status;
+  /**
+   * Next job in the queue.
+   */
+  struct otcrypto_async_job *next;
+} otcrypto_async_job_t;
+
+/**
+ * Adds a job to the end of the queue.
+ *
+ * If OTBN is free, the job is started before this function returns. This
+ * function never waits for OTBN. A job can be submitted again once it is
+ * done, but not while it is still in the queue.
+ *
+ * @param[out] job Job to submit.
+ * @param start Function that starts the operation.
+ * @param finalize Function that finalizes the operation.
+ * @param arg Argument for `start` and `finalize`.
+ * @return Result of the submission; `OTCRYPTO_BAD_ARGS` if the job is already
+ * in the queue.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_async_job_submit(otcrypto_async_job_t *job,
+                                            otcrypto_async_job_fn_t start,
+                                            otcrypto_async_job_fn_t finalize,
+                                            void *arg);
+
+/**
+ * Advances the queue without blocking.
+ *
+ * Finalizes the running job if OTBN is done with it, and starts the next.
+ * Not needed while the `done` interrupt is enabled.
+ *
+ * @return OK if the queue is empty, `OTCRYPTO_ASYNC_INCOMPLETE` otherwise.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_async_job_poll(void);
+
+/**
+ * Blocks until a job is done.
+ *
+ * Jobs ahead of it in the queue are run first. Without the `done` interrupt,
+ * this function advances the queue itself; with it, the hart sleeps (`wfi`)
+ * until the interrupt handler has finished the job, so interrupts must be
+ * enabled.
+ *
+ * @param job Job to wait for.
+ * @return Result of the job, or `OTCRYPTO_BAD_ARGS` if the job was never
+ * submitted.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_async_job_wait(otcrypto_async_job_t *job);
+
+/**
+ * Enables or disables advancing the queue from OTBN's `done` interrupt.
+ *
+ * When enabled, the caller must route OTBN's `done` interrupt to
+ * `otcrypto_async_job_irq_handler` (and enable it at the interrupt
+ * controller). Jobs are then finalized and started from the interrupt handler
+ * and the caller only needs to check `done`.
+ *
+ * @param enable Whether to enable the interrupt.
+ */
+void otcrypto_async_job_irq_enable(hardened_bool_t enable);
+
+/**
+ * Handles OTBN's `done` interrupt.
+ *
+ * Acknowledges the interrupt and advances the queue.
+ */
+void otcrypto_async_job_irq_handler(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_ASYNC_JOB_H_
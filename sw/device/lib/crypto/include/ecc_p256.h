@@ -5,6 +5,7 @@
 #ifndef OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_ECC_P256_H_
 #define OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_ECC_P256_H_
 
+#include "async_job.h"
 #include "datatypes.h"
 
 /**
@@ -289,6 +290,177 @@ OT_WARN_UNUSED_RESULT
 otcrypto_status_t otcrypto_ecdh_p256_async_finalize(
     otcrypto_blinded_key_t *shared_secret);
 
+/**
+ * Arguments for an ECDSA/P-256 key generation job.
+ *
+ * See `otcrypto_ecdsa_p256_keygen` for requirements on the values.
+ */
+typedef struct otcrypto_ecdsa_p256_keygen_job_args {
+  /**
+   * Destination structure for private key, or key handle.
+   */
+  otcrypto_blinded_key_t *private_key;
+  /**
+   * Destination structure for the public key.
+   */
+  otcrypto_unblinded_key_t *public_key;
+} otcrypto_ecdsa_p256_keygen_job_args_t;
+
+/**
+ * Queues ECDSA/P-256 key generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_ecdsa_p256_keygen_async_start` and
+ * `otcrypto_ecdsa_p256_keygen_async_finalize`. The arguments must stay valid
+ * until the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_ecdsa_p256_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p256_keygen_job_args_t *args);
+
+/**
+ * Arguments for an ECDSA/P-256 signature job.
+ *
+ * See `otcrypto_ecdsa_p256_sign` for requirements on the values.
+ */
+typedef struct otcrypto_ecdsa_p256_sign_job_args {
+  /**
+   * Pointer to the blinded private key (d) struct.
+   */
+  const otcrypto_blinded_key_t *private_key;
+  /**
+   * Message digest to be signed (pre-hashed).
+   */
+  otcrypto_hash_digest_t message_digest;
+  /**
+   * Destination buffer for the signature (r, s).
+   */
+  otcrypto_word32_buf_t signature;
+} otcrypto_ecdsa_p256_sign_job_args_t;
+
+/**
+ * Queues ECDSA/P-256 signature generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_ecdsa_p256_sign_async_start` and
+ * `otcrypto_ecdsa_p256_sign_async_finalize`. The arguments must stay valid
+ * until the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_ecdsa_p256_sign_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p256_sign_job_args_t *args);
+
+/**
+ * Arguments for an ECDSA/P-256 signature verification job.
+ *
+ * See `otcrypto_ecdsa_p256_verify` for requirements on the values.
+ */
+typedef struct otcrypto_ecdsa_p256_verify_job_args {
+  /**
+   * Pointer to the unblinded public key (Q) struct.
+   */
+  const otcrypto_unblinded_key_t *public_key;
+  /**
+   * Message digest to be verified (pre-hashed).
+   */
+  otcrypto_hash_digest_t message_digest;
+  /**
+   * Signature to be verified.
+   */
+  otcrypto_const_word32_buf_t signature;
+  /**
+   * Destination for the verification result.
+   */
+  hardened_bool_t *verification_result;
+} otcrypto_ecdsa_p256_verify_job_args_t;
+
+/**
+ * Queues ECDSA/P-256 signature verification as an asynchronous job.
+ *
+ * The job runs `otcrypto_ecdsa_p256_verify_async_start` and
+ * `otcrypto_ecdsa_p256_verify_async_finalize`. The arguments must stay valid
+ * until the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_ecdsa_p256_verify_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdsa_p256_verify_job_args_t *args);
+
+/**
+ * Arguments for an ECDH/P-256 key generation job.
+ *
+ * See `otcrypto_ecdh_p256_keygen` for requirements on the values.
+ */
+typedef struct otcrypto_ecdh_p256_keygen_job_args {
+  /**
+   * Destination structure for private key, or key handle.
+   */
+  otcrypto_blinded_key_t *private_key;
+  /**
+   * Destination structure for the public key.
+   */
+  otcrypto_unblinded_key_t *public_key;
+} otcrypto_ecdh_p256_keygen_job_args_t;
+
+/**
+ * Queues ECDH/P-256 key generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_ecdh_p256_keygen_async_start` and
+ * `otcrypto_ecdh_p256_keygen_async_finalize`. The arguments must stay valid
+ * until the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_ecdh_p256_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdh_p256_keygen_job_args_t *args);
+
+/**
+ * Arguments for an ECDH/P-256 shared secret job.
+ *
+ * See `otcrypto_ecdh_p256` for requirements on the values.
+ */
+typedef struct otcrypto_ecdh_p256_job_args {
+  /**
+   * Pointer to the blinded private key (d) struct.
+   */
+  const otcrypto_blinded_key_t *private_key;
+  /**
+   * Pointer to the unblinded public key (Q) struct.
+   */
+  const otcrypto_unblinded_key_t *public_key;
+  /**
+   * Destination structure for the blinded shared secret.
+   */
+  otcrypto_blinded_key_t *shared_secret;
+} otcrypto_ecdh_p256_job_args_t;
+
+/**
+ * Queues ECDH/P-256 shared secret generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_ecdh_p256_async_start` and
+ * `otcrypto_ecdh_p256_async_finalize`. The arguments must stay valid until the
+ * job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_ecdh_p256_job_submit(
+    otcrypto_async_job_t *job, otcrypto_ecdh_p256_job_args_t *args);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
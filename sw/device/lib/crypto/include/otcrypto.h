@@ -7,6 +7,7 @@
 
 #include "aes.h"
 #include "aes_gcm.h"
+#include "async_job.h"
 #include "datatypes.h"
 #include "drbg.h"
 #include "ecc_p256.h"
@@ -5,6 +5,7 @@
 #ifndef OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_RSA_H_
 #define OPENTITAN_SW_DEVICE_LIB_CRYPTO_INCLUDE_RSA_H_
 
+#include "async_job.h"
 #include "datatypes.h"
 
 /**
@@ -446,6 +447,262 @@ otcrypto_status_t otcrypto_rsa_decrypt_async_finalize(
     const otcrypto_hash_mode_t hash_mode, otcrypto_const_byte_buf_t label,
     otcrypto_byte_buf_t plaintext, size_t *plaintext_bytelen);
 
+/**
+ * Arguments for an RSA key generation job.
+ *
+ * See `otcrypto_rsa_keygen` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_keygen_job_args {
+  /**
+   * RSA size parameter.
+   */
+  otcrypto_rsa_size_t size;
+  /**
+   * Destination public key struct.
+   */
+  otcrypto_unblinded_key_t *public_key;
+  /**
+   * Destination private key struct.
+   */
+  otcrypto_blinded_key_t *private_key;
+} otcrypto_rsa_keygen_job_args_t;
+
+/**
+ * Queues RSA key generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_rsa_keygen_async_start` and
+ * `otcrypto_rsa_keygen_async_finalize`. The arguments must stay valid until
+ * the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_keygen_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_keygen_job_args_t *args);
+
+/**
+ * Arguments for a job that constructs an RSA key pair from a cofactor.
+ *
+ * See `otcrypto_rsa_keypair_from_cofactor` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_keypair_from_cofactor_job_args {
+  /**
+   * RSA size parameter.
+   */
+  otcrypto_rsa_size_t size;
+  /**
+   * RSA modulus (n).
+   */
+  otcrypto_const_word32_buf_t modulus;
+  /**
+   * First share of the prime cofactor (p or q).
+   */
+  otcrypto_const_word32_buf_t cofactor_share0;
+  /**
+   * Second share of the prime cofactor (p or q).
+   */
+  otcrypto_const_word32_buf_t cofactor_share1;
+  /**
+   * Destination public key struct.
+   */
+  otcrypto_unblinded_key_t *public_key;
+  /**
+   * Destination private key struct.
+   */
+  otcrypto_blinded_key_t *private_key;
+} otcrypto_rsa_keypair_from_cofactor_job_args_t;
+
+/**
+ * Queues construction of an RSA key pair from a cofactor as an asynchronous
+ * job.
+ *
+ * The job runs `otcrypto_rsa_keypair_from_cofactor_async_start` and
+ * `otcrypto_rsa_keypair_from_cofactor_async_finalize`. The arguments must stay
+ * valid until the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_keypair_from_cofactor_job_submit(
+    otcrypto_async_job_t *job,
+    otcrypto_rsa_keypair_from_cofactor_job_args_t *args);
+
+/**
+ * Arguments for an RSA signature job.
+ *
+ * See `otcrypto_rsa_sign` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_sign_job_args {
+  /**
+   * Pointer to blinded private key struct.
+   */
+  const otcrypto_blinded_key_t *private_key;
+  /**
+   * Message digest to be signed (pre-hashed).
+   */
+  otcrypto_hash_digest_t message_digest;
+  /**
+   * Padding scheme to be used for the data.
+   */
+  otcrypto_rsa_padding_t padding_mode;
+  /**
+   * Buffer for the generated signature.
+   */
+  otcrypto_word32_buf_t signature;
+} otcrypto_rsa_sign_job_args_t;
+
+/**
+ * Queues RSA signature generation as an asynchronous job.
+ *
+ * The job runs `otcrypto_rsa_sign_async_start` and
+ * `otcrypto_rsa_sign_async_finalize`. The arguments must stay valid until the
+ * job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_sign_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_sign_job_args_t *args);
+
+/**
+ * Arguments for an RSA signature verification job.
+ *
+ * See `otcrypto_rsa_verify` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_verify_job_args {
+  /**
+   * Pointer to public key struct.
+   */
+  const otcrypto_unblinded_key_t *public_key;
+  /**
+   * Message digest to be verified (pre-hashed).
+   */
+  otcrypto_hash_digest_t message_digest;
+  /**
+   * Padding scheme to be used for the data.
+   */
+  otcrypto_rsa_padding_t padding_mode;
+  /**
+   * Signature to be verified.
+   */
+  otcrypto_const_word32_buf_t signature;
+  /**
+   * Destination for the verification result.
+   */
+  hardened_bool_t *verification_result;
+} otcrypto_rsa_verify_job_args_t;
+
+/**
+ * Queues RSA signature verification as an asynchronous job.
+ *
+ * The job runs `otcrypto_rsa_verify_async_start` and
+ * `otcrypto_rsa_verify_async_finalize`. The arguments must stay valid until
+ * the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_verify_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_verify_job_args_t *args);
+
+/**
+ * Arguments for an RSA encryption job.
+ *
+ * See `otcrypto_rsa_encrypt` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_encrypt_job_args {
+  /**
+   * Pointer to public key struct.
+   */
+  const otcrypto_unblinded_key_t *public_key;
+  /**
+   * Hash function to use for OAEP encoding.
+   */
+  otcrypto_hash_mode_t hash_mode;
+  /**
+   * Message to encrypt.
+   */
+  otcrypto_const_byte_buf_t message;
+  /**
+   * Label for OAEP encoding.
+   */
+  otcrypto_const_byte_buf_t label;
+  /**
+   * Buffer for the ciphertext.
+   */
+  otcrypto_word32_buf_t ciphertext;
+} otcrypto_rsa_encrypt_job_args_t;
+
+/**
+ * Queues RSA encryption as an asynchronous job.
+ *
+ * The job runs `otcrypto_rsa_encrypt_async_start` and
+ * `otcrypto_rsa_encrypt_async_finalize`. The arguments must stay valid until
+ * the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_encrypt_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_encrypt_job_args_t *args);
+
+/**
+ * Arguments for an RSA decryption job.
+ *
+ * See `otcrypto_rsa_decrypt` for requirements on the values.
+ */
+typedef struct otcrypto_rsa_decrypt_job_args {
+  /**
+   * Pointer to blinded private key struct.
+   */
+  const otcrypto_blinded_key_t *private_key;
+  /**
+   * Ciphertext to decrypt.
+   */
+  otcrypto_const_word32_buf_t ciphertext;
+  /**
+   * Hash function to use for OAEP encoding.
+   */
+  otcrypto_hash_mode_t hash_mode;
+  /**
+   * Label for OAEP encoding.
+   */
+  otcrypto_const_byte_buf_t label;
+  /**
+   * Buffer for the decrypted message.
+   */
+  otcrypto_byte_buf_t plaintext;
+  /**
+   * Destination for the recovered byte-length of the plaintext.
+   */
+  size_t *plaintext_bytelen;
+} otcrypto_rsa_decrypt_job_args_t;
+
+/**
+ * Queues RSA decryption as an asynchronous job.
+ *
+ * The job runs `otcrypto_rsa_decrypt_async_start` and
+ * `otcrypto_rsa_decrypt_async_finalize`. The arguments must stay valid until
+ * the job is done.
+ *
+ * @param[out] job Job to submit.
+ * @param args Arguments for the operation.
+ * @return Result of the submission.
+ */
+OT_WARN_UNUSED_RESULT
+otcrypto_status_t otcrypto_rsa_decrypt_job_submit(
+    otcrypto_async_job_t *job, otcrypto_rsa_decrypt_job_args_t *args);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
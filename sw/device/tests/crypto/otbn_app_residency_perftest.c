@@ -0,0 +1,109 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/lib/base/macros.h"
+#include "sw/device/lib/crypto/drivers/entropy.h"
+#include "sw/device/lib/crypto/drivers/otbn.h"
+#include "sw/device/lib/crypto/impl/ecc/p256.h"
+#include "sw/device/lib/crypto/impl/sha2/sha256.h"
+#include "sw/device/lib/runtime/log.h"
+#include "sw/device/lib/testing/profile.h"
+#include "sw/device/lib/testing/test_framework/check.h"
+#include "sw/device/lib/testing/test_framework/ottf_main.h"
+
+// Measures how long back-to-back OTBN operations take with and without OTBN
+// app residency mode, in which reloading the app that is already in IMEM only
+// wipes and reinitializes DMEM.
+
+enum {
+  // Number of back-to-back operations to time in each mode.
+  kNumOperations = 4,
+  // Length of the message hashed in SHA-256 block-sized chunks.
+  kSha256MsgBytes = 16 * kSha256MessageBlockBytes,
+};
+
+// Arbitrary digest to sign and verify.
+static const uint32_t kDigest[kP256ScalarWords] = {
+    0x9b2f7a4c, 0x1d05e3a8, 0x47c2b6f1, 0xe8a19d30,
+    0x5f6c0b27, 0x82d4e95a, 0x3a7f1c68, 0xc05b84d2,
+};
+
+static uint8_t sha256_msg[kSha256MsgBytes];
+
+/**
+ * Runs ECDSA verifications back-to-back and returns the total cycle count.
+ */
+static status_t time_p256_verify(const p256_ecdsa_signature_t *signature,
+                                 const p256_point_t *public_key,
+                                 uint32_t *cycles) {
+  uint64_t t_start = profile_start();
+  for (size_t i = 0; i < kNumOperations; i++) {
+    TRY(p256_ecdsa_verify_start(signature, kDigest, public_key));
+    hardened_bool_t result;
+    TRY(p256_ecdsa_verify_finalize(signature, &result));
+    TRY_CHECK(result == kHardenedBoolTrue);
+  }
+  *cycles = profile_end(t_start);
+  return OK_STATUS();
+}
+
+/**
+ * Hashes a message one block at a time and returns the total cycle count.
+ */
+static status_t time_sha256_chunks(uint32_t digest[kSha256DigestWords],
+                                   uint32_t *cycles) {
+  uint64_t t_start = profile_start();
+  sha256_state_t state;
+  TRY(sha256_init(&state));
+  for (size_t i = 0; i < kSha256MsgBytes; i += kSha256MessageBlockBytes) {
+    TRY(sha256_update(&state, &sha256_msg[i], kSha256MessageBlockBytes));
+  }
+  TRY(sha256_final(&state, digest));
+  *cycles = profile_end(t_start);
+  return OK_STATUS();
+}
+
+static status_t residency_perftest(void) {
+  for (size_t i = 0; i < ARRAYSIZE(sha256_msg); i++) {
+    sha256_msg[i] = (uint8_t)(i * 37);
+  }
+
+  // Generate a key pair and a signature to verify.
+  p256_masked_scalar_t private_key;
+  p256_point_t public_key;
+  TRY(p256_keygen_start());
+  TRY(p256_keygen_finalize(&private_key, &public_key));
+  p256_ecdsa_signature_t signature;
+  TRY(p256_ecdsa_sign_start(kDigest, &private_key));
+  TRY(p256_ecdsa_sign_finalize(&signature));
+
+  uint32_t verify_cycles[2];
+  uint32_t sha256_cycles[2];
+  uint32_t digests[2][kSha256DigestWords];
+  for (size_t resident = 0; resident < 2; resident++) {
+    otbn_set_app_residency(resident != 0);
+    TRY(time_p256_verify(&signature, &public_key, &verify_cycles[resident]));
+    TRY(time_sha256_chunks(digests[resident], &sha256_cycles[resident]));
+  }
+  otbn_set_app_residency(false);
+
+  // The mode must not change the results.
+  TRY_CHECK_ARRAYS_EQ(digests[1], digests[0], kSha256DigestWords);
+
+  LOG_INFO("%d P-256 ECDSA verifies: %d cycles, %d cycles with residency",
+           kNumOperations, verify_cycles[0], verify_cycles[1]);
+  LOG_INFO("SHA-256 of %d blocks: %d cycles, %d cycles with residency",
+           kSha256MsgBytes / kSha256MessageBlockBytes, sha256_cycles[0],
+           sha256_cycles[1]);
+  return OK_STATUS();
+}
+
+OTTF_DEFINE_TEST_CONFIG();
+
+bool test_main(void) {
+  CHECK_STATUS_OK(entropy_complex_init());
+  status_t result = OK_STATUS();
+  EXECUTE_TEST(result, residency_perftest);
+  return status_ok(result);
+}
@@ -0,0 +1,198 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/lib/base/macros.h"
+#include "sw/device/lib/base/memory.h"
+#include "sw/device/lib/crypto/impl/keyblob.h"
+#include "sw/device/lib/crypto/include/async_job.h"
+#include "sw/device/lib/crypto/include/datatypes.h"
+#include "sw/device/lib/crypto/include/ecc_p256.h"
+#include "sw/device/lib/dif/dif_rv_plic.h"
+#include "sw/device/lib/runtime/irq.h"
+#include "sw/device/lib/runtime/log.h"
+#include "sw/device/lib/testing/entropy_testutils.h"
+#include "sw/device/lib/testing/test_framework/check.h"
+#include "sw/device/lib/testing/test_framework/ottf_main.h"
+
+#include "hw/top_earlgrey/sw/autogen/top_earlgrey.h"
+
+// Queues several P-256 signatures as asynchronous jobs, one of which fails to
+// start, and checks their results. The queue is advanced once by polling and
+// once from OTBN's `done` interrupt.
+
+enum {
+  // Number of 32-bit words in a P-256 public key.
+  kP256PublicKeyWords = 512 / 32,
+  // Number of 32-bit words in a P-256 signature.
+  kP256SignatureWords = 512 / 32,
+  // Number of bytes in a P-256 private key.
+  kP256PrivateKeyBytes = 256 / 8,
+  // Number of 32-bit words in a SHA-256 digest.
+  kSha256DigestWords = 256 / 32,
+  // Number of jobs in the queue.
+  kNumJobs = 4,
+  // Index of the job whose `start` fails.
+  kBadJob = 2,
+};
+
+OTTF_DEFINE_TEST_CONFIG();
+
+static const otcrypto_key_config_t kPrivateKeyConfig = {
+    .version = kOtcryptoLibVersion1,
+    .key_mode = kOtcryptoKeyModeEcdsaP256,
+    .key_length = kP256PrivateKeyBytes,
+    .hw_backed = kHardenedBoolFalse,
+    .security_level = kOtcryptoKeySecurityLevelLow,
+};
+
+// Arbitrary digest to sign.
+static uint32_t digest_data[kSha256DigestWords] = {
+    0x3c0f5a91, 0xd2e84b17, 0x6a91c3fe, 0x05b7d248,
+    0xe4136f8c, 0x9f2a0d53, 0x71c8e6b4, 0x28d5a90f,
+};
+
+static const otcrypto_hash_digest_t kDigest = {
+    .mode = kOtcryptoHashModeSha256,
+    .data = digest_data,
+    .len = ARRAYSIZE(digest_data),
+};
+
+static dif_rv_plic_t plic;
+static volatile uint32_t otbn_irq_count;
+
+static uint32_t sigs[kNumJobs][kP256SignatureWords];
+static otcrypto_ecdsa_p256_sign_job_args_t sign_args[kNumJobs];
+static otcrypto_async_job_t sign_jobs[kNumJobs];
+
+/**
+ * Initialize PLIC and enable OTBN's `done` interrupt.
+ */
+static void plic_init_with_irqs(void) {
+  mmio_region_t base_addr =
+      mmio_region_from_addr(TOP_EARLGREY_RV_PLIC_BASE_ADDR);
+  CHECK_DIF_OK(dif_rv_plic_init(base_addr, &plic));
+
+  dif_rv_plic_irq_id_t irq_id = kTopEarlgreyPlicIrqIdOtbnDone;
+  CHECK_DIF_OK(dif_rv_plic_irq_set_priority(&plic, irq_id, 0x1));
+  CHECK_DIF_OK(dif_rv_plic_irq_set_enabled(
+      &plic, irq_id, kTopEarlgreyPlicTargetIbex0, kDifToggleEnabled));
+  CHECK_DIF_OK(dif_rv_plic_target_set_threshold(
+      &plic, kTopEarlgreyPlicTargetIbex0, 0x0));
+}
+
+/**
+ * The ISR for this test.
+ *
+ * This function overrides the default OTTF external ISR and hands OTBN's
+ * `done` interrupt to the job queue.
+ */
+void ottf_external_isr(uint32_t *exc_info) {
+  dif_rv_plic_irq_id_t irq_id;
+  CHECK_DIF_OK(
+      dif_rv_plic_irq_claim(&plic, kTopEarlgreyPlicTargetIbex0, &irq_id));
+  CHECK(irq_id == kTopEarlgreyPlicIrqIdOtbnDone,
+        "Unexpected interrupt: (exp: %d, obs: %d)",
+        kTopEarlgreyPlicIrqIdOtbnDone, irq_id);
+
+  otcrypto_async_job_irq_handler();
+  otbn_irq_count++;
+
+  CHECK_DIF_OK(
+      dif_rv_plic_irq_complete(&plic, kTopEarlgreyPlicTargetIbex0, irq_id));
+}
+
+/**
+ * Queues the signature jobs, waits for them and checks the results.
+ *
+ * @param irq Whether to advance the queue from the interrupt.
+ */
+static status_t sign_jobs_test(hardened_bool_t irq) {
+  uint32_t keyblob[keyblob_num_words(kPrivateKeyConfig)];
+  otcrypto_blinded_key_t private_key = {
+      .config = kPrivateKeyConfig,
+      .keyblob_length = sizeof(keyblob),
+      .keyblob = keyblob,
+  };
+  uint32_t pk[kP256PublicKeyWords] = {0};
+  otcrypto_unblinded_key_t public_key = {
+      .key_mode = kOtcryptoKeyModeEcdsaP256,
+      .key_length = sizeof(pk),
+      .key = pk,
+  };
+  TRY(otcrypto_ecdsa_p256_keygen(&private_key, &public_key));
+
+  for (size_t i = 0; i < kNumJobs; i++) {
+    memset(sigs[i], 0, sizeof(sigs[i]));
+    sign_args[i] = (otcrypto_ecdsa_p256_sign_job_args_t){
+        .private_key = &private_key,
+        .message_digest = kDigest,
+        .signature = {.data = sigs[i], .len = ARRAYSIZE(sigs[i])},
+    };
+  }
+  // A digest of the wrong length makes this job's `start` fail.
+  sign_args[kBadJob].message_digest.len = kDigest.len - 1;
+
+  otbn_irq_count = 0;
+  otcrypto_async_job_irq_enable(irq);
+  for (size_t i = 0; i < kNumJobs; i++) {
+    TRY(otcrypto_ecdsa_p256_sign_job_submit(&sign_jobs[i], &sign_args[i]));
+  }
+  // A job that is still queued cannot be submitted again.
+  TRY_CHECK(!status_ok(otcrypto_ecdsa_p256_sign_job_submit(
+      &sign_jobs[kNumJobs - 1], &sign_args[kNumJobs - 1])));
+  // Wait for the last job first, so that all of the jobs ahead of it have to
+  // be run by the queue.
+  TRY(otcrypto_async_job_wait(&sign_jobs[kNumJobs - 1]));
+  for (size_t i = 0; i < kNumJobs; i++) {
+    TRY_CHECK(sign_jobs[i].done == kHardenedBoolTrue);
+    otcrypto_status_t res = otcrypto_async_job_wait(&sign_jobs[i]);
+    if (i == kBadJob) {
+      TRY_CHECK(!status_ok(res));
+    } else {
+      TRY(res);
+    }
+  }
+  otcrypto_async_job_irq_enable(kHardenedBoolFalse);
+  if (irq == kHardenedBoolTrue) {
+    TRY_CHECK(otbn_irq_count > 0);
+  } else {
+    TRY_CHECK(otbn_irq_count == 0);
+  }
+
+  // A job that was never submitted is rejected.
+  otcrypto_async_job_t unknown_job = {0};
+  TRY_CHECK(!status_ok(otcrypto_async_job_wait(&unknown_job)));
+
+  for (size_t i = 0; i < kNumJobs; i++) {
+    if (i == kBadJob) {
+      continue;
+    }
+    hardened_bool_t result;
+    TRY(otcrypto_ecdsa_p256_verify(
+        &public_key, kDigest,
+        (otcrypto_const_word32_buf_t){.data = sigs[i],
+                                      .len = ARRAYSIZE(sigs[i])},
+        &result));
+    TRY_CHECK(result == kHardenedBoolTrue);
+  }
+  return OK_STATUS();
+}
+
+static status_t polling_test(void) {
+  return sign_jobs_test(kHardenedBoolFalse);
+}
+
+static status_t irq_test(void) { return sign_jobs_test(kHardenedBoolTrue); }
+
+bool test_main(void) {
+  CHECK_STATUS_OK(entropy_testutils_auto_mode_init());
+  plic_init_with_irqs();
+  irq_global_ctrl(true);
+  irq_external_ctrl(true);
+
+  status_t result = OK_STATUS();
+  EXECUTE_TEST(result, polling_test);
+  EXECUTE_TEST(result, irq_test);
+  return status_ok(result);
+}
@@ -0,0 +1,156 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/lib/base/crc32.h"
+#include "sw/device/lib/base/macros.h"
+#include "sw/device/lib/base/memory.h"
+#include "sw/device/lib/crypto/drivers/entropy.h"
+#include "sw/device/lib/crypto/impl/keyblob.h"
+#include "sw/device/lib/crypto/include/async_job.h"
+#include "sw/device/lib/crypto/include/datatypes.h"
+#include "sw/device/lib/crypto/include/ecc_p256.h"
+#include "sw/device/lib/runtime/log.h"
+#include "sw/device/lib/testing/profile.h"
+#include "sw/device/lib/testing/test_framework/check.h"
+#include "sw/device/lib/testing/test_framework/ottf_main.h"
+
+// Measures how long a batch of ECDSA signatures plus unrelated CPU work takes
+// when the two run one after the other, and when the signatures are queued as
+// asynchronous jobs so that OTBN and Ibex work at the same time.
+
+enum {
+  // Number of 32-bit words in a P-256 public key.
+  kP256PublicKeyWords = 512 / 32,
+  // Number of 32-bit words in a P-256 signature.
+  kP256SignatureWords = 512 / 32,
+  // Number of bytes in a P-256 private key.
+  kP256PrivateKeyBytes = 256 / 8,
+  // Number of 32-bit words in a SHA-256 digest.
+  kSha256DigestWords = 256 / 32,
+  // Number of signatures in a batch.
+  kNumSignatures = 4,
+  // CPU work is done in chunks of this many bytes, polling in between.
+  kWorkChunkBytes = 1024,
+  // Number of chunks of CPU work.
+  kWorkChunks = 64,
+};
+
+static const otcrypto_key_config_t kPrivateKeyConfig = {
+    .version = kOtcryptoLibVersion1,
+    .key_mode = kOtcryptoKeyModeEcdsaP256,
+    .key_length = kP256PrivateKeyBytes,
+    .hw_backed = kHardenedBoolFalse,
+    .security_level = kOtcryptoKeySecurityLevelLow,
+};
+
+// Arbitrary digest to sign.
+static uint32_t digest_data[kSha256DigestWords] = {
+    0x9b2f7a4c, 0x1d05e3a8, 0x47c2b6f1, 0xe8a19d30,
+    0x5f6c0b27, 0x82d4e95a, 0x3a7f1c68, 0xc05b84d2,
+};
+
+static const otcrypto_hash_digest_t kDigest = {
+    .mode = kOtcryptoHashModeSha256,
+    .data = digest_data,
+    .len = ARRAYSIZE(digest_data),
+};
+
+static uint8_t work_buf[kWorkChunkBytes];
+
+static uint32_t sigs[kNumSignatures][kP256SignatureWords];
+static otcrypto_ecdsa_p256_sign_job_args_t sign_args[kNumSignatures];
+static otcrypto_async_job_t sign_jobs[kNumSignatures];
+
+/**
+ * One chunk of CPU work that does not need OTBN.
+ */
+static uint32_t cpu_work_chunk(size_t i) {
+  work_buf[i % kWorkChunkBytes] ^= (uint8_t)i;
+  return crc32(work_buf, sizeof(work_buf));
+}
+
+static status_t check_signatures(const otcrypto_unblinded_key_t *public_key) {
+  for (size_t i = 0; i < kNumSignatures; i++) {
+    hardened_bool_t result;
+    TRY(otcrypto_ecdsa_p256_verify(
+        public_key, kDigest,
+        (otcrypto_const_word32_buf_t){.data = sigs[i],
+                                      .len = ARRAYSIZE(sigs[i])},
+        &result));
+    TRY_CHECK(result == kHardenedBoolTrue);
+  }
+  return OK_STATUS();
+}
+
+static status_t sign_batch_perftest(void) {
+  uint32_t keyblob[keyblob_num_words(kPrivateKeyConfig)];
+  otcrypto_blinded_key_t private_key = {
+      .config = kPrivateKeyConfig,
+      .keyblob_length = sizeof(keyblob),
+      .keyblob = keyblob,
+  };
+  uint32_t pk[kP256PublicKeyWords] = {0};
+  otcrypto_unblinded_key_t public_key = {
+      .key_mode = kOtcryptoKeyModeEcdsaP256,
+      .key_length = sizeof(pk),
+      .key = pk,
+  };
+  TRY(otcrypto_ecdsa_p256_keygen(&private_key, &public_key));
+  for (size_t i = 0; i < kNumSignatures; i++) {
+    sign_args[i] = (otcrypto_ecdsa_p256_sign_job_args_t){
+        .private_key = &private_key,
+        .message_digest = kDigest,
+        .signature = {.data = sigs[i], .len = ARRAYSIZE(sigs[i])},
+    };
+  }
+
+  // Blocking signatures, then the CPU work.
+  uint32_t crc_serial = 0;
+  uint64_t t_start = profile_start();
+  for (size_t i = 0; i < kNumSignatures; i++) {
+    TRY(otcrypto_ecdsa_p256_sign(
+        &private_key, kDigest,
+        (otcrypto_word32_buf_t){.data = sigs[i], .len = ARRAYSIZE(sigs[i])}));
+  }
+  for (size_t i = 0; i < kWorkChunks; i++) {
+    crc_serial ^= cpu_work_chunk(i);
+  }
+  uint32_t serial_cycles = profile_end(t_start);
+  TRY(check_signatures(&public_key));
+
+  // Queued signatures, with the CPU work done while OTBN runs them.
+  memset(work_buf, 0, sizeof(work_buf));
+  uint32_t crc_overlapped = 0;
+  t_start = profile_start();
+  for (size_t i = 0; i < kNumSignatures; i++) {
+    TRY(otcrypto_ecdsa_p256_sign_job_submit(&sign_jobs[i], &sign_args[i]));
+  }
+  bool queue_empty = false;
+  for (size_t i = 0; i < kWorkChunks; i++) {
+    crc_overlapped ^= cpu_work_chunk(i);
+    if (!queue_empty) {
+      queue_empty = status_ok(otcrypto_async_job_poll());
+    }
+  }
+  for (size_t i = 0; i < kNumSignatures; i++) {
+    TRY(otcrypto_async_job_wait(&sign_jobs[i]));
+  }
+  uint32_t overlapped_cycles = profile_end(t_start);
+  TRY(check_signatures(&public_key));
+  TRY_CHECK(crc_overlapped == crc_serial);
+
+  LOG_INFO("%d P-256 signatures and %d KiB of CRC32: %d cycles, %d queued",
+           kNumSignatures, kWorkChunks * kWorkChunkBytes / 1024,
+           serial_cycles, overlapped_cycles);
+  return OK_STATUS();
+}
+
+OTTF_DEFINE_TEST_CONFIG();
+
+bool test_main(void) {
+  CHECK_STATUS_OK(entropy_complex_init());
+  status_t result = OK_STATUS();
+  EXECUTE_TEST(result, sign_batch_perftest);
+  return status_ok(result);
+}
@@ -0,0 +1,128 @@
+// Copyright lowRISC contributors (OpenTitan project).
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/lib/base/macros.h"
+#include "sw/device/lib/base/memory.h"
+#include "sw/device/lib/crypto/drivers/entropy.h"
+#include "sw/device/lib/crypto/impl/sha2/sha256.h"
+#include "sw/device/lib/runtime/log.h"
+#include "sw/device/lib/testing/profile.h"
+#include "sw/device/lib/testing/test_framework/check.h"
+#include "sw/device/lib/testing/test_framework/ottf_main.h"
+
+// Checks the pipelined OTBN SHA-256 interface against the one-shot one, and
+// compares how long both take to hash a message that is fetched in chunks.
+
+enum {
+  // Length of the long test message; several OTBN batches and a partial one.
+  kLongMsgBytes =
+      3 * kSha256MaxMessageChunksPerOtbnRun * kSha256MessageBlockBytes + 37,
+  // Size of the chunks in which the message is fetched, like a flash page.
+  kFetchChunkBytes = 1024,
+};
+
+static uint8_t long_msg[kLongMsgBytes];
+static uint8_t fetch_buf[kFetchChunkBytes];
+static sha256_stream_t stream;
+
+/**
+ * Hash `msg` with the pipelined interface in updates of `update_len` bytes.
+ *
+ * @param poll Whether to poll between updates.
+ */
+static status_t stream_hash(const uint8_t *msg, size_t msg_len,
+                            size_t update_len, bool poll,
+                            uint32_t digest[kSha256DigestWords]) {
+  TRY(sha256_stream_init(&stream));
+  while (msg_len > 0) {
+    size_t len = msg_len < update_len ? msg_len : update_len;
+    TRY(sha256_stream_update(&stream, msg, len));
+    msg += len;
+    msg_len -= len;
+    if (poll) {
+      // Errors other than "still busy" fail the test.
+      status_t res = sha256_stream_poll(&stream);
+      TRY_CHECK(status_ok(res) || status_err(res) == kUnavailable);
+    }
+  }
+  TRY(sha256_stream_final(&stream, digest));
+  return OK_STATUS();
+}
+
+static status_t stream_matches_oneshot_test(void) {
+  const size_t kMsgLens[] = {
+      0,
+      1,
+      55,
+      56,
+      kSha256MessageBlockBytes,
+      kSha256MaxMessageChunksPerOtbnRun * kSha256MessageBlockBytes - 1,
+      kSha256MaxMessageChunksPerOtbnRun * kSha256MessageBlockBytes,
+      kSha256MaxMessageChunksPerOtbnRun * kSha256MessageBlockBytes + 60,
+      kLongMsgBytes,
+  };
+  const size_t kUpdateLens[] = {1, 63, 1000, kLongMsgBytes};
+  for (size_t i = 0; i < ARRAYSIZE(kMsgLens); i++) {
+    uint32_t exp_digest[kSha256DigestWords];
+    TRY(sha256(long_msg, kMsgLens[i], exp_digest));
+    for (size_t j = 0; j < ARRAYSIZE(kUpdateLens); j++) {
+      if (kUpdateLens[j] == 1 && kMsgLens[i] > kSha256MessageBlockBytes) {
+        // Too slow in simulation.
+        continue;
+      }
+      uint32_t act_digest[kSha256DigestWords];
+      TRY(stream_hash(long_msg, kMsgLens[i], kUpdateLens[j], j % 2 == 0,
+                      act_digest));
+      TRY_CHECK_ARRAYS_EQ(act_digest, exp_digest, kSha256DigestWords);
+    }
+  }
+  return OK_STATUS();
+}
+
+static status_t fetch_and_hash_perftest(void) {
+  // Fetch the message chunk by chunk and hash it with sha256_update().
+  uint32_t digests[2][kSha256DigestWords];
+  uint64_t t_start = profile_start();
+  sha256_state_t state;
+  TRY(sha256_init(&state));
+  for (size_t i = 0; i < kLongMsgBytes; i += kFetchChunkBytes) {
+    size_t len = kLongMsgBytes - i;
+    len = len < kFetchChunkBytes ? len : kFetchChunkBytes;
+    memcpy(fetch_buf, &long_msg[i], len);
+    TRY(sha256_update(&state, fetch_buf, len));
+  }
+  TRY(sha256_final(&state, digests[0]));
+  uint32_t blocking_cycles = profile_end(t_start);
+
+  // The same with the pipelined interface, which fetches the next chunk while
+  // OTBN hashes.
+  t_start = profile_start();
+  TRY(sha256_stream_init(&stream));
+  for (size_t i = 0; i < kLongMsgBytes; i += kFetchChunkBytes) {
+    size_t len = kLongMsgBytes - i;
+    len = len < kFetchChunkBytes ? len : kFetchChunkBytes;
+    memcpy(fetch_buf, &long_msg[i], len);
+    TRY(sha256_stream_update(&stream, fetch_buf, len));
+  }
+  TRY(sha256_stream_final(&stream, digests[1]));
+  uint32_t stream_cycles = profile_end(t_start);
+
+  TRY_CHECK_ARRAYS_EQ(digests[1], digests[0], kSha256DigestWords);
+  LOG_INFO("SHA-256 of %d bytes in %d-byte chunks: %d cycles, %d pipelined",
+           kLongMsgBytes, kFetchChunkBytes, blocking_cycles, stream_cycles);
+  return OK_STATUS();
+}
+
+OTTF_DEFINE_TEST_CONFIG();
+
+bool test_main(void) {
+  CHECK_STATUS_OK(entropy_complex_init());
+  for (size_t i = 0; i < ARRAYSIZE(long_msg); i++) {
+    long_msg[i] = (uint8_t)(i * 37 + (i >> 8));
+  }
+  status_t result = OK_STATUS();
+  EXECUTE_TEST(result, stream_matches_oneshot_test);
+  EXECUTE_TEST(result, fetch_and_hash_perftest);
+  return status_ok(result);
+}